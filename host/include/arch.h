@@ -0,0 +1,54 @@
+/**
+ * @file arch.h
+ * @brief Host replacement of the platform definitions, assertions are always checked.
+ */
+#ifndef _ARCH_H_
+#define _ARCH_H_
+
+#include <stdint.h>
+#include "compiler.h"
+
+/// Size of a CPU word in bytes
+#define CPU_WORD_SIZE   4
+
+/// Little endian CPU
+#define CPU_LE          1
+
+/// Assertions are checked on the host
+#define PLF_DEBUG       1
+
+void assert_err(const char *condition, const char *file, int line);
+void assert_param(int param0, int param1, const char *file, int line);
+void assert_warn(int param0, int param1, const char *file, int line);
+
+/// Assertion showing a critical error that could require a full system reset
+#define ASSERT_ERR(cond)                                        \
+    do {                                                        \
+        if (!(cond)) {                                          \
+            assert_err(#cond, __FILE__, __LINE__);              \
+        }                                                       \
+    } while(0)
+
+/// Assertion showing a critical error that could require a full system reset
+#define ASSERT_INFO(cond, param0, param1)                       \
+    do {                                                        \
+        if (!(cond)) {                                          \
+            assert_param((int)(param0), (int)(param1), __FILE__, __LINE__); \
+        }                                                       \
+    } while(0)
+
+/// Assertion showing a non-critical problem
+#define ASSERT_WARN(cond, param0, param1)                       \
+    do {                                                        \
+        if (!(cond)) {                                          \
+            assert_warn((int)(param0), (int)(param1), __FILE__, __LINE__); \
+        }                                                       \
+    } while(0)
+
+/// DUMP data array present in the SW
+#define DUMP_DATA(data, length)
+
+/// Object allocated in shared memory
+#define __SHARED
+
+#endif // _ARCH_H_
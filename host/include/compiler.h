@@ -0,0 +1,31 @@
+/**
+ * @file compiler.h
+ * @brief Host (gcc/clang) replacement of the Keil compiler abstraction.
+ */
+#ifndef _COMPILER_H_
+#define _COMPILER_H_
+
+#include <stdint.h>
+
+/// define the static keyword for this compiler
+#define __STATIC static
+
+/// define the force inlining attribute for this compiler
+#define __INLINE inline __attribute__((always_inline))
+
+/// define the static inline keywords for this compiler
+#define __STATIC_INLINE static inline
+
+/// define the IRQ handler attribute for this compiler
+#define __IRQ
+#define __BTIRQ
+#define __BLEIRQ
+#define __FIQ
+
+/// define size of an empty array (used to declare structure with an array size not defined)
+#define __ARRAY_EMPTY
+
+/// Put a variable in a memory maintained during deep sleep
+#define __LOWPOWER_SAVED
+
+#endif // _COMPILER_H_
@@ -0,0 +1,8 @@
+/**
+ * @file dfu_delay.h
+ * @brief Host replacement of the DFU delay header, the DFU sources built here use none of it.
+ */
+#ifndef __DFU_DELAY_H__
+#define __DFU_DELAY_H__
+
+#endif //__DFU_DELAY_H__
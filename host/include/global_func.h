@@ -0,0 +1,41 @@
+/**
+ * @file global_func.h
+ * @brief Host replacement of the stack wide include, without the ROM patch tables.
+ */
+#ifndef _GLOBAL_FUNC_H_
+#define _GLOBAL_FUNC_H_
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "n32wb03x.h"
+#include "global_var.h"
+#include "rwip_config.h"
+#include "compiler.h"
+#include "co_utils.h"
+#include "co_bt.h"
+#include "co_math.h"
+#include "arch.h"
+#include "rf.h"
+#include "rwip.h"
+#include "rwip_task.h"
+#include "ke.h"
+#include "ke_timer.h"
+#include "ke_mem.h"
+#include "ke_task.h"
+#include "prf.h"
+#include "gap.h"
+#include "gapm_task.h"
+#include "gapc.h"
+#include "gapc_task.h"
+#include "gattc_task.h"
+#define GLOBAL_INT_DISABLE()        \
+uint32_t ui32IntStatus = 0;         \
+do{                                 \
+    ui32IntStatus = __get_PRIMASK();\
+    __set_PRIMASK(1);               \
+}while(0)
+#define GLOBAL_INT_RESTORE()     \
+do{                              \
+    __set_PRIMASK(ui32IntStatus);\
+}while(0)
+#endif // _GLOBAL_FUNC_H_
@@ -0,0 +1,28 @@
+/**
+ * @file n32wb03x.h
+ * @brief Host replacement of the device header, only what the BLE and app sources use.
+ */
+#ifndef __N32WB03X_H__
+#define __N32WB03X_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define EXCHANGE_MEM_BASE   0x50000000
+#define BASEBAND_REG_BASE   0x50008000
+
+typedef struct GPIO_Module GPIO_Module;
+
+/* Interrupt mask, kept by the host kernel stub */
+uint32_t __get_PRIMASK(void);
+void __set_PRIMASK(uint32_t primask);
+void __disable_irq(void);
+void __enable_irq(void);
+
+/* System reset, counted by the host kernel stub */
+void NVIC_SystemReset(void);
+
+/* Flash driver, simulated by host/stubs/host_flash.c */
+#include "n32wb03x_qflash.h"
+
+#endif // __N32WB03X_H__
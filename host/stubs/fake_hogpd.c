@@ -0,0 +1,248 @@
+/**
+ * @file fake_hogpd.c
+ * @brief Fake HID over GATT device task for the host build.
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "fake_hogpd.h"
+#include <string.h>
+#include "host_ke.h"
+#include "global_func.h"
+#include "hogp/hogpd/api/hogpd_task.h"
+#include "hogp/hogpd/src/hogpd.h"
+#include "ns_msg_pool.h"
+
+/* Private variables ---------------------------------------------------------*/
+static ke_state_t fake_hogpd_state[BLE_CONNECTION_MAX];
+static struct fake_hogpd_report fake_hogpd_record[FAKE_HOGPD_RECORD_MAX];
+static uint32_t fake_hogpd_record_nb;
+static bool fake_hogpd_direct = true;
+static uint8_t fake_hogpd_cfm_status;
+
+/* Private functions ---------------------------------------------------------*/
+static ke_task_id_t fake_hogpd_task(uint8_t conidx)
+{
+    return KE_BUILD_ID(HOST_TASK_HOGPD, conidx);
+}
+
+static void fake_hogpd_record_add(uint8_t conidx, uint8_t idx, bool direct,
+                                  const uint8_t *value, uint16_t length)
+{
+    struct fake_hogpd_report *p_report;
+
+    ASSERT_ERR(fake_hogpd_record_nb < FAKE_HOGPD_RECORD_MAX);
+    ASSERT_ERR(length <= FAKE_HOGPD_VALUE_MAX);
+    if ((fake_hogpd_record_nb >= FAKE_HOGPD_RECORD_MAX) || (length > FAKE_HOGPD_VALUE_MAX))
+    {
+        return;
+    }
+
+    p_report = &fake_hogpd_record[fake_hogpd_record_nb++];
+    p_report->time_us = host_ke_now_us();
+    p_report->conidx = conidx;
+    p_report->idx    = idx;
+    p_report->direct = direct;
+    p_report->length = length;
+    memcpy(p_report->value, value, length);
+}
+
+static int fake_hogpd_enable_req_handler(ke_msg_id_t const msgid,
+                                         struct hogpd_enable_req const *param,
+                                         ke_task_id_t const dest_id,
+                                         ke_task_id_t const src_id)
+{
+    struct hogpd_enable_rsp *rsp = KE_MSG_ALLOC(HOGPD_ENABLE_RSP, src_id, dest_id, hogpd_enable_rsp);
+
+    rsp->conidx = param->conidx;
+    rsp->status = GAP_ERR_NO_ERROR;
+    ke_msg_send(rsp);
+
+    return (KE_MSG_CONSUMED);
+}
+
+static int fake_hogpd_report_upd_req_handler(ke_msg_id_t const msgid,
+                                             struct hogpd_report_upd_req const *param,
+                                             ke_task_id_t const dest_id,
+                                             ke_task_id_t const src_id)
+{
+    int msg_status = KE_MSG_CONSUMED;
+    uint8_t state = ke_state_get(dest_id);
+
+    if ((state & HOGPD_REQ_BUSY) == HOGPD_IDLE)
+    {
+        fake_hogpd_record_add(param->conidx, param->report.idx, false,
+                              param->report.value, param->report.length);
+        ke_state_set(dest_id, state | HOGPD_REQ_BUSY);
+    }
+    else
+    {
+        msg_status = KE_MSG_SAVED;
+    }
+
+    // a preallocated request goes back to its pool instead of the heap
+    if ((msg_status == KE_MSG_CONSUMED) && ns_msg_pool_release(param))
+    {
+        msg_status = KE_MSG_NO_FREE;
+    }
+
+    return (msg_status);
+}
+
+static int fake_hogpd_report_cfm_handler(ke_msg_id_t const msgid,
+                                         struct hogpd_report_cfm const *param,
+                                         ke_task_id_t const dest_id,
+                                         ke_task_id_t const src_id)
+{
+    fake_hogpd_cfm_status = param->status;
+
+    return (KE_MSG_CONSUMED);
+}
+
+/// Messages handled by the fake task
+static const struct ke_msg_handler fake_hogpd_msg_handler_tab[] =
+{
+    { HOGPD_ENABLE_REQ,              (ke_msg_func_t) fake_hogpd_enable_req_handler },
+    { HOGPD_REPORT_UPD_REQ,          (ke_msg_func_t) fake_hogpd_report_upd_req_handler },
+    { HOGPD_REPORT_CFM,              (ke_msg_func_t) fake_hogpd_report_cfm_handler },
+};
+
+static const struct ke_task_desc fake_hogpd_desc =
+{
+    fake_hogpd_msg_handler_tab,
+    fake_hogpd_state,
+    BLE_CONNECTION_MAX,
+    ARRAY_LEN(fake_hogpd_msg_handler_tab),
+};
+
+/* Public functions ----------------------------------------------------------*/
+void fake_hogpd_init(void)
+{
+    memset(fake_hogpd_state, HOGPD_IDLE, sizeof(fake_hogpd_state));
+    fake_hogpd_record_nb = 0;
+    fake_hogpd_direct = true;
+    ke_task_create(HOST_TASK_HOGPD, &fake_hogpd_desc);
+
+    ns_msg_pool_delete(HOGPD_REPORT_UPD_REQ);
+    #if (HOGPD_REPORT_POOL_NB)
+    ns_msg_pool_create(HOGPD_REPORT_UPD_REQ, sizeof(struct hogpd_report_upd_req) + HOGPD_REPORT_MAX_LEN,
+                       HOGPD_REPORT_POOL_NB);
+    #endif
+}
+
+void fake_hogpd_connect(uint8_t conidx)
+{
+    struct hogpd_ntf_cfg_ind *ind = KE_MSG_ALLOC(HOGPD_NTF_CFG_IND, TASK_APP, fake_hogpd_task(conidx),
+                                                 hogpd_ntf_cfg_ind);
+
+    ind->conidx = conidx;
+    ind->ntf_cfg[conidx] = HOGPD_CFG_REPORT_NTF_EN;
+    ke_msg_send(ind);
+    host_ke_run();
+}
+
+uint8_t fake_hogpd_report_write(uint8_t conidx, uint8_t idx, const uint8_t *value, uint16_t length)
+{
+    struct hogpd_report_req_ind *ind = KE_MSG_ALLOC_DYN(HOGPD_REPORT_REQ_IND, TASK_APP, fake_hogpd_task(conidx),
+                                                        hogpd_report_req_ind, length);
+
+    ind->conidx           = conidx;
+    ind->operation        = HOGPD_OP_REPORT_WRITE;
+    ind->report.hid_idx   = 0;
+    ind->report.type      = HOGPD_REPORT;
+    ind->report.idx       = idx;
+    ind->report.length    = length;
+    memcpy(&ind->report.value[0], value, length);
+    ke_msg_send(ind);
+
+    fake_hogpd_cfm_status = 0xFF;
+    host_ke_run();
+
+    return fake_hogpd_cfm_status;
+}
+
+bool fake_hogpd_complete(uint8_t status)
+{
+    for (uint8_t conidx = 0; conidx < BLE_CONNECTION_MAX; conidx++)
+    {
+        ke_task_id_t task = fake_hogpd_task(conidx);
+        uint8_t state = ke_state_get(task);
+
+        if ((state & HOGPD_REQ_BUSY) != HOGPD_IDLE)
+        {
+            struct hogpd_report_upd_rsp *rsp = KE_MSG_ALLOC(HOGPD_REPORT_UPD_RSP, TASK_APP, task,
+                                                            hogpd_report_upd_rsp);
+
+            rsp->conidx = conidx;
+            rsp->status = status;
+            ke_msg_send(rsp);
+            ke_state_set(task, state & ~HOGPD_REQ_BUSY);
+            host_ke_run();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+uint32_t fake_hogpd_complete_all(void)
+{
+    uint32_t count = 0;
+
+    while (fake_hogpd_complete(GAP_ERR_NO_ERROR))
+    {
+        count++;
+    }
+    return count;
+}
+
+void fake_hogpd_direct_enable(bool enable)
+{
+    fake_hogpd_direct = enable;
+}
+
+uint32_t fake_hogpd_count(void)
+{
+    return fake_hogpd_record_nb;
+}
+
+const struct fake_hogpd_report *fake_hogpd_get(uint32_t index)
+{
+    return (index < fake_hogpd_record_nb) ? &fake_hogpd_record[index] : NULL;
+}
+
+void fake_hogpd_clear(void)
+{
+    fake_hogpd_record_nb = 0;
+}
+
+/* Profile API ---------------------------------------------------------------*/
+uint8_t hogpd_report_send_direct(uint8_t conidx, uint8_t hid_idx, uint8_t type, uint8_t idx,
+                                 const uint8_t* value, uint16_t length)
+{
+    ke_task_id_t task;
+    uint8_t state;
+
+    if (conidx >= BLE_CONNECTION_MAX)
+    {
+        return (PRF_ERR_REQ_DISALLOWED);
+    }
+
+    task  = fake_hogpd_task(conidx);
+    state = ke_state_get(task);
+
+    // one notification at a time, the caller falls back on HOGPD_REPORT_UPD_REQ
+    if (!fake_hogpd_direct || ((state & HOGPD_REQ_BUSY) != HOGPD_IDLE))
+    {
+        return (GAP_ERR_COMMAND_DISALLOWED);
+    }
+
+    fake_hogpd_record_add(conidx, idx, true, value, length);
+    ke_state_set(task, state | HOGPD_REQ_BUSY);
+
+    return (GAP_ERR_NO_ERROR);
+}
+
+const struct prf_task_cbs* hogpd_prf_itf_get(void)
+{
+    return NULL;
+}
@@ -0,0 +1,83 @@
+/**
+ * @file fake_hogpd.h
+ * @brief Fake HID over GATT device task, records the reports instead of notifying them.
+ *
+ * Like the real profile it serves one notification at a time: hogpd_report_send_direct()
+ * is refused and HOGPD_REPORT_UPD_REQ is saved while a report waits for its completion,
+ * which the test gives with fake_hogpd_complete().
+ */
+#ifndef __FAKE_HOGPD_H__
+#define __FAKE_HOGPD_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/// Reports kept by the recorder
+#define FAKE_HOGPD_RECORD_MAX       512
+/// Longest report value kept
+#define FAKE_HOGPD_VALUE_MAX        32
+
+/// One report handed to the profile
+struct fake_hogpd_report
+{
+    uint64_t time_us;                           /**< host_ke_now_us() when handed over */
+    uint8_t  conidx;
+    uint8_t  idx;                               /**< Report instance */
+    bool     direct;                            /**< Sent with hogpd_report_send_direct() */
+    uint16_t length;
+    uint8_t  value[FAKE_HOGPD_VALUE_MAX];
+};
+
+/**
+ * @brief  Create the fake HOGPD task and the report request pool, clear the recorder.
+ * @note   Call after host_ke_reset().
+ */
+void fake_hogpd_init(void);
+
+/**
+ * @brief  Enable notifications of the Input Reports, the application becomes ready.
+ * @param  conidx Connection index
+ */
+void fake_hogpd_connect(uint8_t conidx);
+
+/**
+ * @brief  Write a report from the peer, as a GATT write of the report value would.
+ * @param  conidx Connection index
+ * @param  idx Report instance
+ * @return Status of the HOGPD_REPORT_CFM the application answered with, 0xFF without answer
+ */
+uint8_t fake_hogpd_report_write(uint8_t conidx, uint8_t idx, const uint8_t *value, uint16_t length);
+
+/**
+ * @brief  Complete the notification in progress with the given status.
+ * @return false if no notification was in progress
+ */
+bool fake_hogpd_complete(uint8_t status);
+
+/**
+ * @brief  Complete notifications until none is left.
+ * @return Number of notifications completed
+ */
+uint32_t fake_hogpd_complete_all(void);
+
+/**
+ * @brief  Refuse the direct path, every report has to go through HOGPD_REPORT_UPD_REQ.
+ */
+void fake_hogpd_direct_enable(bool enable);
+
+/**
+ * @brief  Number of reports recorded since the last fake_hogpd_clear().
+ */
+uint32_t fake_hogpd_count(void);
+
+/**
+ * @brief  Report recorded at the given position, in the order they were notified.
+ */
+const struct fake_hogpd_report *fake_hogpd_get(uint32_t index);
+
+/**
+ * @brief  Forget the recorded reports.
+ */
+void fake_hogpd_clear(void);
+
+#endif //__FAKE_HOGPD_H__
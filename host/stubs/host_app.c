@@ -0,0 +1,144 @@
+/**
+ * @file host_app.c
+ * @brief Host application task and BLE library stubs.
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "host_app.h"
+#include <string.h>
+#include "host_ke.h"
+#include "global_func.h"
+#include "ns_ble.h"
+#include "ns_ble_task.h"
+#include "ns_sec.h"
+#include "ns_sleep.h"
+#include "ns_timer.h"
+#include "app_ble.h"
+#include "app_hid.h"
+
+/* Private variables ---------------------------------------------------------*/
+static struct prf_task_t host_prf_task[BLE_NB_PROFILES];
+static uint8_t host_prf_num;
+static ke_state_t host_app_state[APP_IDX_MAX];
+static struct host_app_ble_calls host_app_calls;
+
+/* Private functions ---------------------------------------------------------*/
+static int host_app_subtask_handle(const struct app_subtask_handlers *handler_list_desc,
+                                   ke_msg_id_t msgid, void const *p_param, ke_task_id_t src_id)
+{
+    for (uint16_t counter = handler_list_desc->msg_cnt; 0 < counter; counter--)
+    {
+        const struct ke_msg_handler *handler = handler_list_desc->p_msg_handler_tab + counter - 1;
+
+        if ((handler->id == msgid) || (handler->id == KE_MSG_DEFAULT_HANDLER))
+        {
+            return handler->func(msgid, p_param, TASK_APP, src_id);
+        }
+    }
+    return (KE_MSG_CONSUMED);
+}
+
+static int host_app_entry_point_handler(ke_msg_id_t const msgid,
+                                        void const *param,
+                                        ke_task_id_t const dest_id,
+                                        ke_task_id_t const src_id)
+{
+    enum ke_msg_status_tag msg_ret = KE_MSG_CONSUMED;
+
+    ns_timer_api_process_handler(msgid, param, dest_id, src_id, &msg_ret);
+    if (msg_ret == KE_MSG_CONSUMED)
+    {
+        return (KE_MSG_CONSUMED);
+    }
+
+    for (uint8_t id = 0; id < host_prf_num; id++)
+    {
+        if (MSG_T(msgid) == host_prf_task[id].prf_task_id)
+        {
+            return host_app_subtask_handle(host_prf_task[id].prf_task_handler, msgid, param, src_id);
+        }
+    }
+
+    // What app_user_msg_handler() does with the messages of the HID application
+    if (msgid == APP_HID_MOUSE_TIMEOUT_TIMER)
+    {
+        app_hid_mouse_timeout_timer_handler(msgid, param);
+    }
+
+    return (KE_MSG_CONSUMED);
+}
+
+static const struct ke_msg_handler host_app_msg_handler_tab[] =
+{
+    {KE_MSG_DEFAULT_HANDLER,    (ke_msg_func_t)host_app_entry_point_handler},
+};
+
+static const struct ke_task_desc host_app_desc =
+{
+    host_app_msg_handler_tab,
+    host_app_state,
+    APP_IDX_MAX,
+    ARRAY_LEN(host_app_msg_handler_tab),
+};
+
+/* Public functions ----------------------------------------------------------*/
+void host_app_init(void)
+{
+    host_prf_num = 0;
+    memset(&host_app_calls, 0, sizeof(host_app_calls));
+    memset(host_app_state, 0, sizeof(host_app_state));
+    ke_task_create(TASK_APP, &host_app_desc);
+}
+
+const struct host_app_ble_calls *host_app_ble_calls_get(void)
+{
+    return &host_app_calls;
+}
+
+/* BLE library ---------------------------------------------------------------*/
+bool ns_ble_prf_task_register(struct prf_task_t *prf)
+{
+    if (host_prf_num < BLE_NB_PROFILES)
+    {
+        memcpy(&host_prf_task[host_prf_num], prf, sizeof(struct prf_task_t));
+        host_prf_num++;
+        return true;
+    }
+    return false;
+}
+
+bool prf_get_itf_func_register(struct prf_get_func_t *prf)
+{
+    return true;
+}
+
+ke_task_id_t prf_get_task_from_id(ke_msg_id_t id)
+{
+    if (KE_TYPE_GET(id) == TASK_ID_HOGPD)
+    {
+        return KE_BUILD_ID(HOST_TASK_HOGPD, KE_IDX_GET(id));
+    }
+    return TASK_NONE;
+}
+
+bool ns_ble_update_param(struct gapc_conn_param *conn_param)
+{
+    host_app_calls.update_param++;
+    return true;
+}
+
+void ns_ble_disconnect(void)
+{
+    host_app_calls.disconnect++;
+}
+
+/// Tests linking ns_sec.c get its bond status instead
+__attribute__((weak)) bool ns_sec_get_bond_status(void)
+{
+    return false;
+}
+
+void ns_sleep_report_event(void)
+{
+    host_app_calls.report_event++;
+}
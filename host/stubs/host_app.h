@@ -0,0 +1,29 @@
+/**
+ * @file host_app.h
+ * @brief Host application task, dispatches like app_entry_point_handler() without the GAP part.
+ */
+#ifndef __HOST_APP_H__
+#define __HOST_APP_H__
+
+#include <stdint.h>
+
+/// Calls the application made to the BLE library
+struct host_app_ble_calls
+{
+    uint32_t update_param;                      /**< ns_ble_update_param() */
+    uint32_t disconnect;                        /**< ns_ble_disconnect() */
+    uint32_t report_event;                      /**< ns_sleep_report_event() */
+};
+
+/**
+ * @brief  Create the application task and forget the registered profiles.
+ * @note   Call after host_ke_reset() and before the app_xxx_init() functions.
+ */
+void host_app_init(void);
+
+/**
+ * @brief  Calls made to the BLE library stubs since host_app_init().
+ */
+const struct host_app_ble_calls *host_app_ble_calls_get(void);
+
+#endif //__HOST_APP_H__
@@ -0,0 +1,243 @@
+/**
+ * @file host_dfu.c
+ * @brief DFU client of the host build and the application side of ns_dfu_ble.c.
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "host_dfu.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "host_ke.h"
+#include "host_flash.h"
+#include "global_func.h"
+#include "ns_ble.h"
+#include "ns_ble_task.h"
+#include "ns_crc.h"
+#include "ns_dfu_ble.h"
+#include "ns_dfu_boot.h"
+
+/* Private define ------------------------------------------------------------*/
+#define HOST_DFU_KEY_FILE               "vectors/dfu_ble.txt"
+
+#define OTA_CMD_VERSION                 3
+#define OTA_CMD_CREATE_OTA_SETTING      4
+#define OTA_CMD_CREATE_OTA_IMAGE        5
+#define OTA_CMD_VALIDATE_OTA_IMAGE      6
+#define OTA_CMD_ACTIVATE_OTA_IMAGE      7
+
+/* Private variables ---------------------------------------------------------*/
+static uint8_t host_dfu_data[HOST_DFU_IMAGE_MAX];
+static uint8_t host_dfu_setting_signature[64];
+static uint8_t host_dfu_image_signature[64];
+static uint8_t host_dfu_response[2];
+static bool host_dfu_responded;
+static ke_state_t host_dfu_app_state[APP_IDX_MAX];
+
+/* Application pieces of ns_dfu_ble.c ----------------------------------------*/
+struct app_env_tag app_env;
+NS_Bootsetting_t ns_bootsetting;
+
+extern int app_dfu_ble_reset_handler(ke_msg_id_t const msgid, void const *p_param, ke_task_id_t const dest_id, ke_task_id_t const src_id);
+extern int app_dfu_ble_flash_handler(ke_msg_id_t const msgid, void const *p_param, ke_task_id_t const dest_id, ke_task_id_t const src_id);
+
+static const struct ke_msg_handler host_dfu_app_handler_tab[] =
+{
+    {APP_DFU_BLE_RESET_TIMER,   (ke_msg_func_t)app_dfu_ble_reset_handler},
+    {APP_DFU_BLE_FLASH_EVT,     (ke_msg_func_t)app_dfu_ble_flash_handler},
+};
+
+static const struct ke_task_desc host_dfu_app_desc =
+{
+    host_dfu_app_handler_tab,
+    host_dfu_app_state,
+    APP_IDX_MAX,
+    ARRAY_LEN(host_dfu_app_handler_tab),
+};
+
+void ns_ble_mtu_set(uint16_t mtu)
+{
+}
+
+/// CC notification of the IUS service, only the responses to RC data come this way
+void ns_ble_ius_app_cc_send(uint8_t *p_data, uint16_t length)
+{
+    if (length == sizeof(host_dfu_response))
+    {
+        memcpy(host_dfu_response, p_data, length);
+        host_dfu_responded = true;
+    }
+}
+
+/* Private functions ---------------------------------------------------------*/
+static void host_dfu_hex(const char *hex, uint8_t *p_out, uint32_t len)
+{
+    for (uint32_t i = 0; i < len; i++)
+    {
+        sscanf(hex + 2 * i, "%2hhx", &p_out[i]);
+    }
+}
+
+static void host_dfu_keys_load(void)
+{
+    char name[32], hex[129];
+    FILE *f = fopen(HOST_DFU_KEY_FILE, "r");
+
+    if (f == NULL)
+    {
+        fprintf(stderr, "host_dfu: cannot open %s\n", HOST_DFU_KEY_FILE);
+        exit(1);
+    }
+    while (fscanf(f, "%31s %128s", name, hex) == 2)
+    {
+        if (strcmp(name, "public_key") == 0)
+        {
+            host_dfu_hex(hex, ns_bootsetting.public_key, 64);
+        }
+        else if (strcmp(name, "setting_signature") == 0)
+        {
+            host_dfu_hex(hex, host_dfu_setting_signature, 64);
+        }
+        else if (strcmp(name, "image_signature") == 0)
+        {
+            host_dfu_hex(hex, host_dfu_image_signature, 64);
+        }
+    }
+    fclose(f);
+}
+
+static void host_dfu_put32(uint8_t *p_out, uint32_t value)
+{
+    p_out[0] = value >> 24;
+    p_out[1] = value >> 16;
+    p_out[2] = value >> 8;
+    p_out[3] = value;
+}
+
+static uint8_t host_dfu_cc(uint8_t const *p_cmd, uint8_t len)
+{
+    uint8_t output[20];
+    uint8_t output_len = 0;
+
+    ns_dfu_ble_handler_cc(p_cmd, len, output, &output_len);
+    return (output_len >= 2) ? output[1] : HOST_DFU_NO_RESPONSE;
+}
+
+/* Public functions ----------------------------------------------------------*/
+void host_dfu_init(void)
+{
+    host_ke_reset();
+    host_flash_init();
+
+    for (uint32_t i = 0; i < HOST_DFU_IMAGE_MAX; i++)
+    {
+        host_dfu_data[i] = (uint8_t)((i * 7) ^ (i >> 7) ^ 0x5A);
+    }
+
+    memset(&ns_bootsetting, 0xFF, sizeof(ns_bootsetting));
+    ns_bootsetting.app1.version = 1;
+    host_dfu_keys_load();
+
+    memset(host_dfu_app_state, 0, sizeof(host_dfu_app_state));
+    ke_task_create(TASK_APP, &host_dfu_app_desc);
+    host_dfu_responded = false;
+}
+
+const uint8_t *host_dfu_image(void)
+{
+    return host_dfu_data;
+}
+
+uint8_t host_dfu_version(void)
+{
+    uint8_t cmd[17] = {OTA_CMD_VERSION};
+    uint8_t output[20];
+    uint8_t output_len = 0;
+
+    host_dfu_put32(&cmd[1], HOST_DFU_IMAGE_SIZE);
+    ns_dfu_ble_handler_cc(cmd, sizeof(cmd), output, &output_len);
+    return (output_len == 14) ? output[13] : 0;
+}
+
+uint8_t host_dfu_setting(uint32_t crc, bool image_signature, bool corrupt_signature)
+{
+    uint8_t packet[sizeof(Dfu_setting_t) + 64];
+    uint8_t cmd[5] = {OTA_CMD_CREATE_OTA_SETTING};
+    Dfu_setting_t setting;
+    uint32_t size = sizeof(Dfu_setting_t) + (image_signature ? 64 : 0);
+    uint8_t status = HOST_DFU_NO_RESPONSE;
+
+    memset(&setting, 0, sizeof(setting));
+    setting.app1.start_address = HOST_DFU_IMAGE_ADDRESS;
+    setting.app1.size = HOST_DFU_IMAGE_SIZE;
+    setting.app1.crc = crc;
+    setting.app1.version = HOST_DFU_IMAGE_VERSION;
+    memcpy(setting.signature, host_dfu_setting_signature, 64);
+    if (corrupt_signature)
+    {
+        setting.signature[10] ^= 0x01;
+    }
+    setting.crc = ns_crc32((uint8_t *)&setting.crc + 4, sizeof(Dfu_setting_t) - 4);
+    memcpy(packet, &setting, sizeof(setting));
+    memcpy(packet + sizeof(setting), host_dfu_image_signature, 64);
+
+    host_dfu_put32(&cmd[1], size);
+    host_dfu_cc(cmd, sizeof(cmd));
+    for (uint32_t done = 0; done < size; done += HOST_DFU_CHUNK_SIZE)
+    {
+        uint32_t len = (size - done < HOST_DFU_CHUNK_SIZE) ? (size - done) : HOST_DFU_CHUNK_SIZE;
+
+        status = host_dfu_rc(packet + done, len);
+    }
+    return status;
+}
+
+void host_dfu_block_create_raw(uint32_t offset, uint32_t size, uint32_t crc)
+{
+    uint8_t cmd[13] = {OTA_CMD_CREATE_OTA_IMAGE};
+
+    host_dfu_put32(&cmd[1], offset);
+    host_dfu_put32(&cmd[5], size);
+    host_dfu_put32(&cmd[9], crc);
+    host_dfu_cc(cmd, sizeof(cmd));
+}
+
+void host_dfu_block_create(uint32_t offset, uint32_t size)
+{
+    host_dfu_block_create_raw(offset, size, ns_crc32(host_dfu_data + offset, size));
+}
+
+uint8_t host_dfu_rc(const uint8_t *p_data, uint32_t len)
+{
+    host_dfu_responded = false;
+    ns_dfu_ble_handler_rc(p_data, len);
+    return host_dfu_responded ? host_dfu_response[1] : HOST_DFU_NO_RESPONSE;
+}
+
+uint8_t host_dfu_block(uint32_t offset, uint32_t size)
+{
+    uint8_t status = HOST_DFU_NO_RESPONSE;
+
+    host_dfu_block_create(offset, size);
+    for (uint32_t done = 0; done < size; done += HOST_DFU_CHUNK_SIZE)
+    {
+        uint32_t len = (size - done < HOST_DFU_CHUNK_SIZE) ? (size - done) : HOST_DFU_CHUNK_SIZE;
+
+        status = host_dfu_rc(host_dfu_data + offset + done, len);
+    }
+    return status;
+}
+
+uint8_t host_dfu_validate(void)
+{
+    uint8_t cmd[1] = {OTA_CMD_VALIDATE_OTA_IMAGE};
+
+    return host_dfu_cc(cmd, sizeof(cmd));
+}
+
+uint8_t host_dfu_activate(void)
+{
+    uint8_t cmd[1] = {OTA_CMD_ACTIVATE_OTA_IMAGE};
+
+    return host_dfu_cc(cmd, sizeof(cmd));
+}
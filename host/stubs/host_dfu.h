@@ -0,0 +1,88 @@
+/**
+ * @file host_dfu.h
+ * @brief DFU client of the host build driving ns_dfu_ble.c, with the application pieces it needs.
+ *
+ * The image is DFU_IMAGE_SIZE bytes that host_dfu_image() gives, going to app1 as an
+ * IMAGE_UPDATE build selects. Its signing key and signatures come from
+ * tests/vectors/dfu_ble.txt, see gen_dfu_ble.py there.
+ */
+#ifndef __HOST_DFU_H__
+#define __HOST_DFU_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/// Size of the signed image
+#define HOST_DFU_IMAGE_SIZE         20000
+/// host_dfu_image() goes on up to the end of app1, for longer transfers
+#define HOST_DFU_IMAGE_MAX          0x1C000
+#define HOST_DFU_IMAGE_ADDRESS      0x01004000
+#define HOST_DFU_IMAGE_VERSION      2
+/// Image block of the client, the size of one ns_dfu_ble receive buffer
+#define HOST_DFU_BLOCK_SIZE         2048
+/// RC write of the client, a 247 byte MTU
+#define HOST_DFU_CHUNK_SIZE         244
+
+/// No CREATE_OTA_SETTING or CREATE_OTA_IMAGE response was sent
+#define HOST_DFU_NO_RESPONSE        0xFF
+
+/**
+ * @brief  Reset the kernel and the flash, create the application task, load the signing key.
+ */
+void host_dfu_init(void);
+
+/**
+ * @brief  Image content, HOST_DFU_IMAGE_MAX bytes, the signed image is the start of it.
+ */
+const uint8_t *host_dfu_image(void);
+
+/**
+ * @brief  OTA_CMD_VERSION, starts a new transfer.
+ * @return Image selection of the reply, 1 for app1
+ */
+uint8_t host_dfu_version(void);
+
+/**
+ * @brief  OTA_CMD_CREATE_OTA_SETTING then the setting packet over RC.
+ * @param  crc image crc put in the setting
+ * @param  image_signature append the signature of the image to the setting
+ * @param  corrupt_signature flip a bit of the setting signature
+ * @return Error code of the response, HOST_DFU_NO_RESPONSE if none
+ */
+uint8_t host_dfu_setting(uint32_t crc, bool image_signature, bool corrupt_signature);
+
+/**
+ * @brief  OTA_CMD_CREATE_OTA_IMAGE for a block of the image, with its crc.
+ */
+void host_dfu_block_create(uint32_t offset, uint32_t size);
+
+/**
+ * @brief  OTA_CMD_CREATE_OTA_IMAGE with any values.
+ */
+void host_dfu_block_create_raw(uint32_t offset, uint32_t size, uint32_t crc);
+
+/**
+ * @brief  One RC write.
+ * @return Error code of the block response it triggered, HOST_DFU_NO_RESPONSE if none
+ */
+uint8_t host_dfu_rc(const uint8_t *p_data, uint32_t len);
+
+/**
+ * @brief  Send one image block: create, then RC writes of HOST_DFU_CHUNK_SIZE.
+ * @return Error code of the block response, HOST_DFU_NO_RESPONSE if none
+ */
+uint8_t host_dfu_block(uint32_t offset, uint32_t size);
+
+/**
+ * @brief  OTA_CMD_VALIDATE_OTA_IMAGE.
+ * @return Error code of the reply
+ */
+uint8_t host_dfu_validate(void);
+
+/**
+ * @brief  OTA_CMD_ACTIVATE_OTA_IMAGE.
+ * @return Error code of the reply
+ */
+uint8_t host_dfu_activate(void);
+
+#endif //__HOST_DFU_H__
@@ -0,0 +1,194 @@
+/**
+ * @file host_flash.c
+ * @brief Qflash driver of the host build, RAM mapped at the flash address.
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "host_flash.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include "host_ke.h"
+
+/* Private variables ---------------------------------------------------------*/
+static uint8_t *host_flash_mem;
+static uint32_t host_flash_ops;
+static uint32_t host_flash_erases[HOST_FLASH_SECTOR_NB];
+static uint32_t host_flash_fail_op = HOST_FLASH_NEVER;
+static uint32_t host_flash_cut_op = HOST_FLASH_NEVER;
+static uint32_t host_flash_torn;
+static bool host_flash_cut;
+static uint32_t host_flash_erase_us;
+static uint32_t host_flash_page_us;
+
+/* Private functions ---------------------------------------------------------*/
+static bool host_flash_range_ok(uint32_t address, uint32_t len)
+{
+    return (address >= HOST_FLASH_BASE) && (len <= HOST_FLASH_SIZE)
+        && (address - HOST_FLASH_BASE <= HOST_FLASH_SIZE - len);
+}
+
+/// What a Qflash call does under the planned faults
+enum host_flash_op
+{
+    HOST_FLASH_OP_RUN,
+    HOST_FLASH_OP_FAIL,
+    /// Interrupted by the power cut
+    HOST_FLASH_OP_TORN,
+    /// After the power cut, the code would not be running
+    HOST_FLASH_OP_LOST,
+};
+
+static enum host_flash_op host_flash_op_begin(void)
+{
+    uint32_t op;
+
+    if (host_flash_cut)
+    {
+        return HOST_FLASH_OP_LOST;
+    }
+
+    op = host_flash_ops++;
+    if (op == host_flash_cut_op)
+    {
+        host_flash_cut = true;
+        return HOST_FLASH_OP_TORN;
+    }
+    return (op == host_flash_fail_op) ? HOST_FLASH_OP_FAIL : HOST_FLASH_OP_RUN;
+}
+
+/* Public functions ----------------------------------------------------------*/
+void host_flash_init(void)
+{
+    if (host_flash_mem == NULL)
+    {
+        void *p = mmap((void *)(uintptr_t)HOST_FLASH_BASE, HOST_FLASH_SIZE, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+
+        if (p != (void *)(uintptr_t)HOST_FLASH_BASE)
+        {
+            fprintf(stderr, "host_flash: cannot map 0x%08X\n", HOST_FLASH_BASE);
+            exit(1);
+        }
+        host_flash_mem = p;
+    }
+
+    memset(host_flash_mem, 0xFF, HOST_FLASH_SIZE);
+    memset(host_flash_erases, 0, sizeof(host_flash_erases));
+    host_flash_ops = 0;
+    host_flash_power_on();
+}
+
+uint32_t host_flash_op_count(void)
+{
+    return host_flash_ops;
+}
+
+uint32_t host_flash_erase_count(uint32_t address)
+{
+    return host_flash_range_ok(address, 1) ? host_flash_erases[(address - HOST_FLASH_BASE) / FLASH_SECTOR_SIZE] : 0;
+}
+
+void host_flash_fail_at(uint32_t op)
+{
+    host_flash_fail_op = (op == HOST_FLASH_NEVER) ? op : (host_flash_ops + op);
+}
+
+void host_flash_cut_at(uint32_t op, uint32_t torn_bytes)
+{
+    host_flash_cut_op = (op == HOST_FLASH_NEVER) ? op : (host_flash_ops + op);
+    host_flash_torn = torn_bytes;
+}
+
+bool host_flash_is_cut(void)
+{
+    return host_flash_cut;
+}
+
+void host_flash_power_on(void)
+{
+    host_flash_cut = false;
+    host_flash_cut_op = HOST_FLASH_NEVER;
+    host_flash_fail_op = HOST_FLASH_NEVER;
+}
+
+void host_flash_timing_set(uint32_t erase_us, uint32_t page_write_us)
+{
+    host_flash_erase_us = erase_us;
+    host_flash_page_us = page_write_us;
+}
+
+/* Qflash driver -------------------------------------------------------------*/
+void Qflash_Init(void)
+{
+}
+
+uint32_t Qflash_Erase_Sector(uint32_t address)
+{
+    uint32_t sector = address & ~(uint32_t)(FLASH_SECTOR_SIZE - 1);
+    enum host_flash_op op;
+
+    if (!host_flash_range_ok(sector, FLASH_SECTOR_SIZE))
+    {
+        return FlashAddressInvalid;
+    }
+    op = host_flash_op_begin();
+    if (op == HOST_FLASH_OP_FAIL)
+    {
+        return FlashTimeOut;
+    }
+    if (op == HOST_FLASH_OP_LOST)
+    {
+        return FlashOperationSuccess;
+    }
+
+    host_ke_stall(host_flash_erase_us);
+    host_flash_erases[(sector - HOST_FLASH_BASE) / FLASH_SECTOR_SIZE]++;
+    //a cut erase leaves the first half of the sector erased and the rest as it was
+    memset(host_flash_mem + (sector - HOST_FLASH_BASE), 0xFF,
+           (op == HOST_FLASH_OP_RUN) ? FLASH_SECTOR_SIZE : (host_flash_torn ? FLASH_SECTOR_SIZE / 2 : 0));
+    return FlashOperationSuccess;
+}
+
+uint32_t Qflash_Write(uint32_t address, uint8_t *p_data, uint32_t len)
+{
+    uint8_t *p_flash = host_flash_mem + (address - HOST_FLASH_BASE);
+    enum host_flash_op op;
+
+    if (!host_flash_range_ok(address, len))
+    {
+        return FlashAddressInvalid;
+    }
+    op = host_flash_op_begin();
+    if (op == HOST_FLASH_OP_FAIL)
+    {
+        return FlashTimeOut;
+    }
+    if (op == HOST_FLASH_OP_LOST)
+    {
+        return FlashOperationSuccess;
+    }
+
+    host_ke_stall(host_flash_page_us * ((len + FLASH_PAGE_SIZE - 1) / FLASH_PAGE_SIZE));
+    if ((op == HOST_FLASH_OP_TORN) && (host_flash_torn < len))
+    {
+        len = host_flash_torn;
+    }
+    //programming only clears bits
+    for (uint32_t i = 0; i < len; i++)
+    {
+        p_flash[i] &= p_data[i];
+    }
+    return FlashOperationSuccess;
+}
+
+uint32_t Qflash_Read(uint32_t address, uint8_t *p_data, uint32_t len)
+{
+    if (!host_flash_range_ok(address, len))
+    {
+        return FlashAddressInvalid;
+    }
+    memcpy(p_data, host_flash_mem + (address - HOST_FLASH_BASE), len);
+    return FlashOperationSuccess;
+}
@@ -0,0 +1,70 @@
+/**
+ * @file host_flash.h
+ * @brief Host simulation of the Qflash driver over RAM mapped at the flash address.
+ *
+ * The flash is mapped at HOST_FLASH_BASE so that code reading it through pointers, as on
+ * target, runs unmodified. Writes only clear bits and erases set a whole sector to 0xFF,
+ * like NOR flash. Operations can be made to fail, to take simulated time, or to stop at a
+ * power cut, optionally leaving the interrupted one half done.
+ */
+#ifndef __HOST_FLASH_H__
+#define __HOST_FLASH_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "n32wb03x_qflash.h"
+
+#define HOST_FLASH_BASE             0x01000000
+#define HOST_FLASH_SIZE             0x40000
+#define HOST_FLASH_SECTOR_NB        (HOST_FLASH_SIZE / FLASH_SECTOR_SIZE)
+
+/// No fault planned, see host_flash_fail_at() and host_flash_cut_at()
+#define HOST_FLASH_NEVER            0xFFFFFFFF
+
+/**
+ * @brief  Map the flash on first use, erase all of it, clear the counters and the faults.
+ */
+void host_flash_init(void);
+
+/**
+ * @brief  Erases and writes done since host_flash_init(), the one cut by a power loss included.
+ */
+uint32_t host_flash_op_count(void);
+
+/**
+ * @brief  Erase count of one sector since host_flash_init().
+ * @param  address any address in the sector
+ */
+uint32_t host_flash_erase_count(uint32_t address);
+
+/**
+ * @brief  Make the operation of index op (0 is the next one) fail with FlashTimeOut and leave
+ *         the flash untouched, the following ones work again.
+ */
+void host_flash_fail_at(uint32_t op);
+
+/**
+ * @brief  Lose power during the operation of index op (0 is the next one).
+ *         The interrupted write keeps its first torn_bytes bytes, an interrupted erase
+ *         leaves the sector half erased when torn_bytes is not 0. Later operations are
+ *         ignored until host_flash_power_on().
+ */
+void host_flash_cut_at(uint32_t op, uint32_t torn_bytes);
+
+/**
+ * @brief  True once the planned power cut happened.
+ */
+bool host_flash_is_cut(void);
+
+/**
+ * @brief  Power back on after a cut, the flash keeps its content, no fault stays planned.
+ */
+void host_flash_power_on(void);
+
+/**
+ * @brief  Time each operation takes, the kernel clock is moved forward by it as the CPU
+ *         is stalled while Qflash runs. 0 for both (default) costs no time.
+ */
+void host_flash_timing_set(uint32_t erase_us, uint32_t page_write_us);
+
+#endif //__HOST_FLASH_H__
@@ -0,0 +1,467 @@
+/**
+ * @file host_ke.c
+ * @brief Host simulation of the RW kernel and of the platform services the app sources use.
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "host_ke.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "global_func.h"
+
+/* Private define ------------------------------------------------------------*/
+/// Kernel timers armed at the same time
+#define HOST_KE_TIMER_NB            16
+
+/* Private typedef -----------------------------------------------------------*/
+/// Simple FIFO of messages, chained through their header
+struct host_ke_queue
+{
+    struct ke_msg *first;
+    struct ke_msg *last;
+};
+
+/// Armed kernel timer
+struct host_ke_timer
+{
+    bool used;
+    ke_msg_id_t id;
+    ke_task_id_t task;
+    uint64_t expires;
+};
+
+/* Private variables ---------------------------------------------------------*/
+static const struct ke_task_desc *host_ke_task[TASK_MAX];
+static struct host_ke_queue host_ke_sent;
+static struct host_ke_queue host_ke_saved;
+static struct host_ke_timer host_ke_timer[HOST_KE_TIMER_NB];
+static uint64_t host_ke_now;
+static uint32_t host_ke_live;
+static uint32_t host_ke_asserts;
+static uint32_t host_primask;
+static uint32_t host_ke_resets;
+static uint32_t host_ke_sent_nb;
+static uint32_t host_ke_timer_op_nb;
+
+/* Private functions ---------------------------------------------------------*/
+static void host_ke_push(struct host_ke_queue *queue, struct ke_msg *msg)
+{
+    msg->hdr.next = NULL;
+    if (queue->last == NULL)
+    {
+        queue->first = msg;
+    }
+    else
+    {
+        queue->last->hdr.next = &msg->hdr;
+    }
+    queue->last = msg;
+}
+
+static struct ke_msg *host_ke_pop(struct host_ke_queue *queue)
+{
+    struct ke_msg *msg = queue->first;
+
+    if (msg != NULL)
+    {
+        queue->first = (struct ke_msg *)msg->hdr.next;
+        if (queue->first == NULL)
+        {
+            queue->last = NULL;
+        }
+    }
+    return msg;
+}
+
+static ke_msg_func_t host_ke_handler_get(const struct ke_task_desc *p_desc, ke_msg_id_t id)
+{
+    // Same search order as the kernel, the default handler is the first entry
+    for (uint16_t i = p_desc->msg_cnt; i > 0; i--)
+    {
+        const struct ke_msg_handler *handler = &p_desc->msg_handler_tab[i - 1];
+
+        if ((handler->id == id) || (handler->id == KE_MSG_DEFAULT_HANDLER))
+        {
+            return handler->func;
+        }
+    }
+    return NULL;
+}
+
+static void host_ke_deliver(struct ke_msg *msg)
+{
+    const struct ke_task_desc *p_desc = NULL;
+    ke_msg_func_t func = NULL;
+    int status = KE_MSG_CONSUMED;
+
+    if (KE_TYPE_GET(msg->dest_id) < TASK_MAX)
+    {
+        p_desc = host_ke_task[KE_TYPE_GET(msg->dest_id)];
+    }
+    if (p_desc != NULL)
+    {
+        func = host_ke_handler_get(p_desc, msg->id);
+    }
+
+    if (func != NULL)
+    {
+        status = func(msg->id, ke_msg2param(msg), msg->dest_id, msg->src_id);
+    }
+    else
+    {
+        fprintf(stderr, "host_ke: message 0x%04x to task 0x%04x dropped\n", msg->id, msg->dest_id);
+    }
+
+    switch (status)
+    {
+        case KE_MSG_CONSUMED:
+            ke_msg_free(msg);
+            break;
+        case KE_MSG_SAVED:
+            host_ke_push(&host_ke_saved, msg);
+            break;
+        default:
+            break;
+    }
+}
+
+static struct host_ke_timer *host_ke_timer_find(ke_msg_id_t id, ke_task_id_t task)
+{
+    for (int i = 0; i < HOST_KE_TIMER_NB; i++)
+    {
+        if (host_ke_timer[i].used && (host_ke_timer[i].id == id) && (host_ke_timer[i].task == task))
+        {
+            return &host_ke_timer[i];
+        }
+    }
+    return NULL;
+}
+
+static struct host_ke_timer *host_ke_timer_next(uint64_t until)
+{
+    struct host_ke_timer *next = NULL;
+
+    for (int i = 0; i < HOST_KE_TIMER_NB; i++)
+    {
+        if (host_ke_timer[i].used && (host_ke_timer[i].expires <= until)
+            && ((next == NULL) || (host_ke_timer[i].expires < next->expires)))
+        {
+            next = &host_ke_timer[i];
+        }
+    }
+    return next;
+}
+
+/* Public functions ----------------------------------------------------------*/
+void host_ke_reset(void)
+{
+    struct ke_msg *msg;
+
+    while ((msg = host_ke_pop(&host_ke_sent)) != NULL)
+    {
+        ke_msg_free(msg);
+    }
+    while ((msg = host_ke_pop(&host_ke_saved)) != NULL)
+    {
+        ke_msg_free(msg);
+    }
+    memset(host_ke_task, 0, sizeof(host_ke_task));
+    memset(host_ke_timer, 0, sizeof(host_ke_timer));
+    host_primask = 0;
+}
+
+bool host_ke_step(void)
+{
+    struct ke_msg *msg = host_ke_pop(&host_ke_sent);
+
+    if (msg == NULL)
+    {
+        return false;
+    }
+    host_ke_deliver(msg);
+    return true;
+}
+
+uint32_t host_ke_run(void)
+{
+    uint32_t count = 0;
+    struct ke_msg *msg;
+
+    while ((msg = host_ke_pop(&host_ke_sent)) != NULL)
+    {
+        host_ke_deliver(msg);
+        count++;
+    }
+    return count;
+}
+
+void host_ke_advance(uint32_t us)
+{
+    uint64_t until = host_ke_now + us;
+    struct host_ke_timer *timer;
+
+    host_ke_run();
+    while ((timer = host_ke_timer_next(until)) != NULL)
+    {
+        //a timer that expired while the CPU was stalled fires late
+        if (timer->expires > host_ke_now)
+        {
+            host_ke_now = timer->expires;
+        }
+        timer->used = false;
+        ke_msg_send_basic(timer->id, timer->task, TASK_NONE);
+        host_ke_run();
+    }
+    host_ke_now = until;
+}
+
+void host_ke_stall(uint32_t us)
+{
+    host_ke_now += us;
+}
+
+uint64_t host_ke_now_us(void)
+{
+    return host_ke_now;
+}
+
+uint32_t host_ke_msg_live(void)
+{
+    return host_ke_live;
+}
+
+uint32_t host_ke_assert_count(void)
+{
+    return host_ke_asserts;
+}
+
+uint32_t host_ke_system_reset_count(void)
+{
+    return host_ke_resets;
+}
+
+uint32_t host_ke_msg_sent_count(void)
+{
+    return host_ke_sent_nb;
+}
+
+uint32_t host_ke_timer_op_count(void)
+{
+    return host_ke_timer_op_nb;
+}
+
+/* Kernel API ----------------------------------------------------------------*/
+uint8_t ke_task_create(uint8_t task_type, struct ke_task_desc const *p_task_desc)
+{
+    if ((task_type >= TASK_MAX) || (host_ke_task[task_type] != NULL))
+    {
+        return KE_TASK_ALREADY_EXISTS;
+    }
+    host_ke_task[task_type] = p_task_desc;
+    return KE_TASK_OK;
+}
+
+uint8_t ke_task_delete(uint8_t task_type)
+{
+    if (task_type < TASK_MAX)
+    {
+        host_ke_task[task_type] = NULL;
+    }
+    return KE_TASK_OK;
+}
+
+ke_state_t ke_state_get(ke_task_id_t const id)
+{
+    const struct ke_task_desc *p_desc = host_ke_task[KE_TYPE_GET(id)];
+
+    if ((p_desc == NULL) || (p_desc->state == NULL) || (KE_IDX_GET(id) >= p_desc->idx_max))
+    {
+        return 0;
+    }
+    return p_desc->state[KE_IDX_GET(id)];
+}
+
+void ke_state_set(ke_task_id_t const id, ke_state_t const state_id)
+{
+    const struct ke_task_desc *p_desc = host_ke_task[KE_TYPE_GET(id)];
+    struct host_ke_queue kept = {NULL, NULL};
+    struct ke_msg *msg;
+
+    if ((p_desc == NULL) || (p_desc->state == NULL) || (KE_IDX_GET(id) >= p_desc->idx_max))
+    {
+        return;
+    }
+    if (p_desc->state[KE_IDX_GET(id)] == state_id)
+    {
+        return;
+    }
+    p_desc->state[KE_IDX_GET(id)] = state_id;
+
+    // A state change gives the saved messages of the task another chance, in their order
+    while ((msg = host_ke_pop(&host_ke_saved)) != NULL)
+    {
+        host_ke_push((msg->dest_id == id) ? &host_ke_sent : &kept, msg);
+    }
+    host_ke_saved = kept;
+}
+
+void *ke_msg_alloc(ke_msg_id_t const id, ke_task_id_t const dest_id,
+                   ke_task_id_t const src_id, uint16_t const param_len)
+{
+    struct ke_msg *msg = (struct ke_msg *)calloc(1, sizeof(struct ke_msg) + param_len);
+
+    ASSERT_ERR(msg != NULL);
+    msg->id        = id;
+    msg->dest_id   = dest_id;
+    msg->src_id    = src_id;
+    msg->param_len = param_len;
+    host_ke_live++;
+
+    return ke_msg2param(msg);
+}
+
+void ke_msg_send(void const *param_ptr)
+{
+    host_ke_sent_nb++;
+    host_ke_push(&host_ke_sent, ke_param2msg(param_ptr));
+}
+
+void ke_msg_send_basic(ke_msg_id_t const id, ke_task_id_t const dest_id, ke_task_id_t const src_id)
+{
+    ke_msg_send(ke_msg_alloc(id, dest_id, src_id, 0));
+}
+
+void ke_msg_forward(void const *param_ptr, ke_task_id_t const dest_id, ke_task_id_t const src_id)
+{
+    struct ke_msg *msg = ke_param2msg(param_ptr);
+
+    msg->dest_id = dest_id;
+    msg->src_id  = src_id;
+    ke_msg_send(param_ptr);
+}
+
+void ke_msg_free(struct ke_msg const *param)
+{
+    free((void *)param);
+    host_ke_live--;
+}
+
+void ke_timer_set(ke_msg_id_t const timer_id, ke_task_id_t const task, uint32_t delay)
+{
+    struct host_ke_timer *timer = host_ke_timer_find(timer_id, task);
+
+    host_ke_timer_op_nb++;
+    if (timer == NULL)
+    {
+        for (int i = 0; (i < HOST_KE_TIMER_NB) && (timer == NULL); i++)
+        {
+            if (!host_ke_timer[i].used)
+            {
+                timer = &host_ke_timer[i];
+            }
+        }
+    }
+    ASSERT_ERR(timer != NULL);
+
+    // A null delay expires on the next tick
+    if (delay == 0)
+    {
+        delay = 1;
+    }
+    timer->used    = true;
+    timer->id      = timer_id;
+    timer->task    = task;
+    timer->expires = host_ke_now + (uint64_t)delay * 1000;
+}
+
+void ke_timer_clear(ke_msg_id_t const timerid, ke_task_id_t const task)
+{
+    struct host_ke_timer *timer = host_ke_timer_find(timerid, task);
+
+    host_ke_timer_op_nb++;
+    if (timer != NULL)
+    {
+        timer->used = false;
+    }
+}
+
+bool ke_timer_active(ke_msg_id_t const timer_id, ke_task_id_t const task_id)
+{
+    return (host_ke_timer_find(timer_id, task_id) != NULL);
+}
+
+void *ke_malloc(uint32_t size, uint8_t type)
+{
+    return malloc(size);
+}
+
+bool ke_check_malloc(uint32_t size, uint8_t type)
+{
+    return true;
+}
+
+void ke_free(void *mem_ptr)
+{
+    free(mem_ptr);
+}
+
+/* Platform ------------------------------------------------------------------*/
+rwip_time_t rwip_time_get(void)
+{
+    rwip_time_t time;
+    // Half-slots of 312.5us, fraction in half-us
+    uint64_t half_us = host_ke_now * 2;
+
+    time.hs  = (uint32_t)((half_us / 625) & RWIP_MAX_CLOCK_TIME);
+    time.hus = (uint32_t)(half_us % 625);
+
+    return time;
+}
+
+uint32_t __get_PRIMASK(void)
+{
+    return host_primask;
+}
+
+void __set_PRIMASK(uint32_t primask)
+{
+    host_primask = primask;
+}
+
+void __disable_irq(void)
+{
+    host_primask = 1;
+}
+
+void __enable_irq(void)
+{
+    host_primask = 0;
+}
+
+void NVIC_SystemReset(void)
+{
+    host_ke_resets++;
+}
+
+void delay_n_ms(uint32_t count)
+{
+    host_ke_stall(count * 1000);
+}
+
+void assert_err(const char *condition, const char *file, int line)
+{
+    fprintf(stderr, "ASSERT_ERR(%s) %s:%d\n", condition, file, line);
+    host_ke_asserts++;
+}
+
+void assert_param(int param0, int param1, const char *file, int line)
+{
+    fprintf(stderr, "ASSERT_INFO(%d, %d) %s:%d\n", param0, param1, file, line);
+    host_ke_asserts++;
+}
+
+void assert_warn(int param0, int param1, const char *file, int line)
+{
+    fprintf(stderr, "ASSERT_WARN(%d, %d) %s:%d\n", param0, param1, file, line);
+}
@@ -0,0 +1,81 @@
+/**
+ * @file host_ke.h
+ * @brief Host simulation of the RW kernel: message queue, task states, timers and clock.
+ *
+ * Messages are delivered only from host_ke_run() and host_ke_advance(), never from
+ * ke_msg_send(), so the code under test sees the same ordering as on target.
+ */
+#ifndef __HOST_KE_H__
+#define __HOST_KE_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "ke_task.h"
+
+/// Task type of the fake HOGPD task, first profile task slot
+#define HOST_TASK_HOGPD             (TASK_GAPC + 1)
+
+/**
+ * @brief  Free every pending message and timer, delete the tasks.
+ * @note   The clock is not set back, modules that sampled it stay consistent.
+ * @note   Tasks are created with ke_task_create(), as on target.
+ */
+void host_ke_reset(void);
+
+/**
+ * @brief  Deliver the oldest queued message, timers are not checked.
+ * @return false if the queue was empty
+ */
+bool host_ke_step(void);
+
+/**
+ * @brief  Deliver queued messages until the queue is empty.
+ * @return Number of messages delivered
+ */
+uint32_t host_ke_run(void);
+
+/**
+ * @brief  Move the clock forward, firing the kernel timers in order and running the queue.
+ * @param  us Time to elapse in microseconds
+ */
+void host_ke_advance(uint32_t us);
+
+/**
+ * @brief  Move the clock forward with nothing running, as while the CPU is busy.
+ *         Timers that expire meanwhile fire late, from the next host_ke_advance().
+ * @param  us Time to elapse in microseconds
+ */
+void host_ke_stall(uint32_t us);
+
+/**
+ * @brief  Current simulated time.
+ * @return Time in microseconds since the program started
+ */
+uint64_t host_ke_now_us(void);
+
+/**
+ * @brief  Messages allocated by ke_msg_alloc() and not freed yet.
+ */
+uint32_t host_ke_msg_live(void);
+
+/**
+ * @brief  Number of assertions raised by ASSERT_ERR / ASSERT_INFO since the program started.
+ */
+uint32_t host_ke_assert_count(void);
+
+/**
+ * @brief  Number of NVIC_SystemReset() calls since the program started, the program goes on.
+ */
+uint32_t host_ke_system_reset_count(void);
+
+/**
+ * @brief  Number of ke_msg_send() calls since the program started, forwards included.
+ */
+uint32_t host_ke_msg_sent_count(void);
+
+/**
+ * @brief  Number of ke_timer_set() and ke_timer_clear() calls since the program started.
+ */
+uint32_t host_ke_timer_op_count(void);
+
+#endif //__HOST_KE_H__
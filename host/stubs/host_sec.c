@@ -0,0 +1,156 @@
+/**
+ * @file host_sec.c
+ * @brief Bond database of ns_sec.c on the host build, and the application side of it.
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "host_sec.h"
+#include <string.h>
+#include "host_ke.h"
+#include "ns_ble.h"
+#include "ns_ble_task.h"
+#include "gapc_task.h"
+#include "app_user_config.h"
+
+/* Private variables ---------------------------------------------------------*/
+static struct ns_sec_init_t host_sec_config;
+static uint8_t host_sec_peer_num;
+static struct gapc_encrypt_cfm host_sec_cfm;
+static bool host_sec_answered;
+static bool host_sec_store_failed;
+static ke_state_t host_sec_gapc_state[BLE_CONNECTION_MAX];
+
+/* Application pieces of ns_sec.c --------------------------------------------*/
+struct app_env_tag app_env;
+struct ns_gap_params_t gap_env;
+uint8_t key_enable;
+extern struct app_sec_bond_data_env_tag app_sec_bond_data;
+extern struct app_sec_env_tag app_sec_env;
+
+/// Target time of the store event, the register reads 0 here: the bond is stored at once
+uint32_t ip_clkntgt1_getf(void)
+{
+    return 0;
+}
+
+uint16_t ip_hmicrosectgt1_getf(void)
+{
+    return 0;
+}
+
+void ns_ble_list_set_ral(struct gap_ral_dev_info *ral_list, uint8_t ral_cnt)
+{
+}
+
+/* Private functions ---------------------------------------------------------*/
+static void host_sec_msg_handler(struct sec_msg_t const *p_msg)
+{
+    if (p_msg->msg_id == NS_SEC_BOND_STATE)
+    {
+        host_sec_peer_num = *p_msg->msg.peer_num;
+    }
+    else if (p_msg->msg_id == NS_SEC_BOND_STORE_FAILED)
+    {
+        host_sec_store_failed = true;
+    }
+}
+
+static int host_sec_encrypt_cfm_handler(ke_msg_id_t const msgid,
+                                        struct gapc_encrypt_cfm const *param,
+                                        ke_task_id_t const dest_id,
+                                        ke_task_id_t const src_id)
+{
+    host_sec_cfm = *param;
+    host_sec_answered = true;
+
+    return (KE_MSG_CONSUMED);
+}
+
+/// A missing key disconnects the peer
+static int host_sec_disconnect_cmd_handler(ke_msg_id_t const msgid,
+                                           struct gapc_disconnect_cmd const *param,
+                                           ke_task_id_t const dest_id,
+                                           ke_task_id_t const src_id)
+{
+    return (KE_MSG_CONSUMED);
+}
+
+/// GAPC side of the encryption request
+static const struct ke_msg_handler host_sec_gapc_handler_tab[] =
+{
+    { GAPC_ENCRYPT_CFM,              (ke_msg_func_t) host_sec_encrypt_cfm_handler },
+    { GAPC_DISCONNECT_CMD,           (ke_msg_func_t) host_sec_disconnect_cmd_handler },
+};
+
+static const struct ke_task_desc host_sec_gapc_desc =
+{
+    host_sec_gapc_handler_tab,
+    host_sec_gapc_state,
+    BLE_CONNECTION_MAX,
+    ARRAY_LEN(host_sec_gapc_handler_tab),
+};
+
+static ke_msg_func_t host_sec_handler_get(ke_msg_id_t msgid)
+{
+    for (uint16_t i = 0; i < app_sec_handlers.msg_cnt; i++)
+    {
+        if (app_sec_handlers.p_msg_handler_tab[i].id == msgid)
+        {
+            return app_sec_handlers.p_msg_handler_tab[i].func;
+        }
+    }
+    return NULL;
+}
+
+/* Public functions ----------------------------------------------------------*/
+uint8_t host_sec_init(uint8_t max_peer)
+{
+    host_ke_reset();
+    memset(host_sec_gapc_state, 0, sizeof(host_sec_gapc_state));
+    ke_task_create(TASK_GAPC, &host_sec_gapc_desc);
+
+    memset(&host_sec_config, 0, sizeof(host_sec_config));
+    host_sec_config.bond_enable = true;
+    host_sec_config.bond_max_peer = max_peer;
+    host_sec_config.bond_db_addr = BOND_DATA_BASE_ADDR;
+    host_sec_config.ns_sec_msg_handler = host_sec_msg_handler;
+    return host_sec_boot();
+}
+
+uint8_t host_sec_boot(void)
+{
+    host_sec_peer_num = 0xFF;
+    ns_sec_init(&host_sec_config);
+    return host_sec_peer_num;
+}
+
+bool host_sec_bond_store(struct app_sec_bond_data_env_tag const *p_bond)
+{
+    // GAPC_PAIRING_SUCCEED before the store event
+    app_sec_env.bonded = true;
+    app_sec_bond_data = *p_bond;
+    host_sec_store_failed = false;
+    ns_sec_bond_store_evt_handler(APP_BOND_STORE_EVT, NULL, TASK_APP, TASK_APP);
+    return !host_sec_store_failed;
+}
+
+bool host_sec_ltk_find(uint16_t ediv, uint8_t const *p_rand, struct gap_sec_key *p_ltk)
+{
+    struct gapc_encrypt_req_ind req;
+
+    req.ediv = ediv;
+    memcpy(req.rand_nb.nb, p_rand, GAP_RAND_NB_LEN);
+    host_sec_answered = false;
+    host_sec_handler_get(GAPC_ENCRYPT_REQ_IND)(GAPC_ENCRYPT_REQ_IND, &req, TASK_APP, KE_BUILD_ID(TASK_GAPC, 0));
+    host_ke_run();
+
+    if (!host_sec_answered || !host_sec_cfm.found)
+    {
+        return false;
+    }
+    if (p_ltk != NULL)
+    {
+        *p_ltk = host_sec_cfm.ltk;
+    }
+    return true;
+}
@@ -0,0 +1,43 @@
+/**
+ * @file host_sec.h
+ * @brief Bond database of ns_sec.c on the host build, over the simulated flash.
+ *
+ * Bonds are stored through ns_sec_bond_store_evt_handler() and looked up through the
+ * GAPC_ENCRYPT_REQ_IND handler, as the stack asks for them on an encryption request.
+ * A boot is ns_sec_init() as app_ble.c calls it, reading the database back from flash.
+ */
+#ifndef __HOST_SEC_H__
+#define __HOST_SEC_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "global_func.h"
+#include "ns_sec.h"
+
+/**
+ * @brief  Reset the kernel, create the task answering encryption requests and boot.
+ * @param  max_peer bond_max_peer of the security configuration
+ * @return Bonds found, as reported by NS_SEC_BOND_STATE
+ */
+uint8_t host_sec_init(uint8_t max_peer);
+
+/**
+ * @brief  Boot again with the same configuration, the flash is kept.
+ * @return Bonds found, as reported by NS_SEC_BOND_STATE
+ */
+uint8_t host_sec_boot(void);
+
+/**
+ * @brief  Store a bond as at the end of a pairing.
+ * @return false if ns_sec.c reported NS_SEC_BOND_STORE_FAILED
+ */
+bool host_sec_bond_store(struct app_sec_bond_data_env_tag const *p_bond);
+
+/**
+ * @brief  Encryption request of a peer.
+ * @param  p_ltk LTK of the bond found, may be NULL
+ * @return true if the bond was found
+ */
+bool host_sec_ltk_find(uint16_t ediv, uint8_t const *p_rand, struct gap_sec_key *p_ltk);
+
+#endif //__HOST_SEC_H__
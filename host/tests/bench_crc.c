@@ -0,0 +1,31 @@
+/**
+ * @file bench_crc.c
+ * @brief ns_crc tables against the bitwise CRCs they replaced, on a DFU sized and a record sized buffer.
+ */
+#include "host_bench.h"
+#include "crc_ref.h"
+#include "ns_crc.h"
+
+static volatile uint32_t bench_sink;
+static uint8_t buf[1024];
+
+int main(int argc, char *argv[])
+{
+    uint32_t n = host_bench_iterations(argc, argv, 200000);
+
+    for (uint32_t i = 0; i < sizeof(buf); i++)
+    {
+        buf[i] = (uint8_t)(i * 131 + 7);
+    }
+
+    HOST_BENCH("crc32 1024 B, bitwise", n, bench_sink = crc_ref_crc32(buf, sizeof(buf)));
+    HOST_BENCH("crc32 1024 B, slice-by-4", n, bench_sink = ns_crc32(buf, sizeof(buf)));
+    HOST_BENCH("crc32 20 B, bitwise", n, bench_sink = crc_ref_crc32(buf + (_i & 3), 20));
+    HOST_BENCH("crc32 20 B, slice-by-4", n, bench_sink = ns_crc32(buf + (_i & 3), 20));
+    HOST_BENCH("crc16 ccitt 40 B, bitwise", n, bench_sink = crc_ref_crc16_ccitt(0xFFFF, buf, 40));
+    HOST_BENCH("crc16 ccitt 40 B, table", n, bench_sink = ns_crc16_ccitt_update(0xFFFF, buf, 40));
+    HOST_BENCH("crc16 e2e 20 B, bitwise", n, bench_sink = crc_ref_e2e(buf, 20));
+    HOST_BENCH("crc16 e2e 20 B, table", n, bench_sink = ns_crc16_e2e(buf, 20));
+
+    return 0;
+}
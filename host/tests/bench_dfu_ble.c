@@ -0,0 +1,101 @@
+/**
+ * @file bench_dfu_ble.c
+ * @brief Image transfer rate of ns_dfu_ble.c over the simulated link and flash.
+ *
+ * The link model: a connection event every interval carries up to four RC writes, the
+ * client starts the next block in the event after a block ack. While the CPU is stalled
+ * on the flash the controller buffers fill and the events are lost. The flash takes the
+ * datasheet times, the background writer runs in the idle time between events.
+ * The rate is simulated time, the host speed does not enter it.
+ */
+#include "host_bench.h"
+#include "host_ke.h"
+#include "host_flash.h"
+#include "host_dfu.h"
+
+/// RC writes in one connection event
+#define LINK_PACKETS_PER_EVENT      4
+#define FLASH_ERASE_US              30000
+#define FLASH_PAGE_WRITE_US         1200
+
+static uint32_t link_interval_us;
+static uint64_t link_event_us;
+static uint32_t link_packets_left;
+static uint32_t link_events_lost;
+
+static void link_next_event(void)
+{
+    link_event_us += link_interval_us;
+    while ((host_ke_now_us() < link_event_us) && host_ke_step())
+    {
+    }
+    while (link_event_us < host_ke_now_us())
+    {
+        link_event_us += link_interval_us;
+        link_events_lost++;
+    }
+    host_ke_stall((uint32_t)(link_event_us - host_ke_now_us()));
+    link_packets_left = LINK_PACKETS_PER_EVENT;
+}
+
+static void link_packet(void)
+{
+    if (link_packets_left == 0)
+    {
+        link_next_event();
+    }
+    link_packets_left--;
+}
+
+static void bench_transfer(const char *name, uint32_t interval_us, bool flash_timing, uint32_t block_nb)
+{
+    const uint8_t *p_image = host_dfu_image();
+    uint64_t start_us;
+    uint8_t status;
+    uint32_t size = block_nb * HOST_DFU_BLOCK_SIZE;
+
+    host_dfu_init();
+    host_dfu_version();
+    host_dfu_setting(0, false, false);
+    host_flash_timing_set(flash_timing ? FLASH_ERASE_US : 0, flash_timing ? FLASH_PAGE_WRITE_US : 0);
+
+    link_interval_us = interval_us;
+    link_event_us = host_ke_now_us();
+    link_packets_left = 0;
+    link_events_lost = 0;
+    start_us = link_event_us;
+    for (uint32_t offset = 0; offset < size; offset += HOST_DFU_BLOCK_SIZE)
+    {
+        link_packet();
+        host_dfu_block_create(offset, HOST_DFU_BLOCK_SIZE);
+        for (uint32_t done = 0; done < HOST_DFU_BLOCK_SIZE; done += HOST_DFU_CHUNK_SIZE)
+        {
+            uint32_t len = (HOST_DFU_BLOCK_SIZE - done < HOST_DFU_CHUNK_SIZE) ? (HOST_DFU_BLOCK_SIZE - done) : HOST_DFU_CHUNK_SIZE;
+
+            link_packet();
+            status = host_dfu_rc(p_image + offset + done, len);
+            if ((done + len == HOST_DFU_BLOCK_SIZE) && (status != 0))
+            {
+                printf("%s: block at %u refused\n", name, (unsigned)offset);
+            }
+        }
+        link_packets_left = 0;
+    }
+    host_ke_run();
+
+    printf("%-40s %10.1f KB/s %6u events lost\n", name,
+           (double)size * 1000000 / 1024 / (double)(host_ke_now_us() - start_us), (unsigned)link_events_lost);
+    host_flash_timing_set(0, 0);
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t block_nb = host_bench_iterations(argc, argv, HOST_DFU_IMAGE_MAX / HOST_DFU_BLOCK_SIZE);
+
+    bench_transfer("7.5 ms interval, link only", 7500, false, block_nb);
+    bench_transfer("7.5 ms interval, flash", 7500, true, block_nb);
+    bench_transfer("15 ms interval, link only", 15000, false, block_nb);
+    bench_transfer("15 ms interval, flash", 15000, true, block_nb);
+
+    return 0;
+}
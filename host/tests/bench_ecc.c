@@ -0,0 +1,42 @@
+/**
+ * @file bench_ecc.c
+ * @brief One P-256 uECC_verify, accepted and rejected, with the multiply the build selects.
+ *
+ * bench_ecc_16x16 is the same program with uECC_MULT_16X16 forced on: the host ratio of the
+ * two shows what the 16 bit products cost, not what they save on the Cortex-M0.
+ */
+#include "host_bench.h"
+#include "uECC.h"
+
+static volatile int bench_sink;
+
+static void hex_be(const char *hex, uint8_t *p_out)
+{
+    for (uint32_t i = 0; i < 32; i++)
+    {
+        sscanf(hex + 2 * i, "%2hhx", &p_out[31 - i]);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t n = host_bench_iterations(argc, argv, 2000);
+    uint8_t pub[64], hash[32], bad_hash[32], sig[64], sig_zero[64];
+
+    //RFC 6979 A.2.5, P-256 with SHA-256, message "sample"
+    hex_be("60FED4BA255A9D31C961EB74C6356D68C049B8923B61FA6CE669622E60F29FB6", pub);
+    hex_be("7903FE1008B8BC99A41AE9E95628BC64F2F1B20C2D7E9F5177A3C294D4462299", pub + 32);
+    hex_be("AF2BDBE1AA9B6EC1E2ADE1D694F41FC71A831D0268E9891562113D8A62ADD1BF", hash);
+    hex_be("EFD48B2AACB6A8FD1140DD9CD45E81D69D2C877B56AAF991C34D0EA84EAF3716", sig);
+    hex_be("F7CB1C942D657C41D436C7A1B6E29F65F3E900DBB9AFF4064DC4AB2F843ACDA8", sig + 32);
+    memcpy(bad_hash, hash, 32);
+    bad_hash[0] ^= 1;
+    memcpy(sig_zero, sig, 64);
+    memset(sig_zero, 0, 32);
+
+    HOST_BENCH("verify, valid", n, bench_sink = uECC_verify(pub, hash, 32, sig, &curve_secp256r1));
+    HOST_BENCH("verify, wrong hash", n, bench_sink = uECC_verify(pub, bad_hash, 32, sig, &curve_secp256r1));
+    HOST_BENCH("verify, r = 0 (range check)", n, bench_sink = uECC_verify(pub, hash, 32, sig_zero, &curve_secp256r1));
+
+    return 0;
+}
@@ -0,0 +1,99 @@
+/**
+ * @file bench_hid_report.c
+ * @brief Report path of app_hid.c, straight to HOGPD against the HOGPD_REPORT_UPD_REQ hop,
+ *        for a keyboard and a touch report.
+ *
+ * The fake HOGPD records the report where the real one builds the GATT notification, so a
+ * row is what the two paths do not share: the request allocation, copy, queueing and
+ * dispatch, plus the completion both go through. The messages line holds on target, where
+ * both paths send one more, the GATT notification. Each message is a kernel allocation and
+ * a scheduler pass. Cycles of the Cortex-M0 are counted on the device with
+ * HOGPD_REPORT_CYCLES.
+ */
+#include <string.h>
+#include "host_bench.h"
+#include "host_ke.h"
+#include "host_app.h"
+#include "fake_hogpd.h"
+#include "global_func.h"
+#include "app_hid.h"
+#include "app_hid_touchscreen.h"
+
+extern struct app_hid_env_tag app_hid_env;
+
+/// Reports notified, direct ones
+static uint32_t bench_sent;
+static uint32_t bench_direct;
+
+static void setup(bool direct)
+{
+    host_ke_reset();
+    host_app_init();
+    fake_hogpd_init();
+    fake_hogpd_direct_enable(direct);
+    app_hid_init();
+    app_hid_enable_prf(0);
+    host_ke_run();
+    fake_hogpd_connect(0);
+    bench_sent = 0;
+    bench_direct = 0;
+}
+
+/// Send a report, run the kernel, complete the notification
+static void report_send(uint8_t report_idx, const uint8_t *report, uint16_t len)
+{
+    app_hid_send_report(report_idx, report, len);
+    host_ke_run();
+    fake_hogpd_complete_all();
+    for (uint32_t i = 0; i < fake_hogpd_count(); i++)
+    {
+        bench_direct += fake_hogpd_get(i)->direct;
+    }
+    bench_sent += fake_hogpd_count();
+    fake_hogpd_clear();
+}
+
+/// A new key each time, an unchanged report would be suppressed
+static void keyboard_send(uint32_t i)
+{
+    uint8_t report[APP_HID_KEYBOARD_REPORT_LEN] = {0};
+
+    report[2] = (uint8_t)(4 + (i & 0x1F));
+    report_send(APP_HID_KEYBOARD_REPORT_IDX, report, sizeof(report));
+}
+
+static void touch_send(uint32_t i)
+{
+    uint8_t report[APP_HID_MULTITOUCH_REPORT_LEN] = {0};
+
+    report[0] = 0x01;
+    co_write16p(&report[1], (uint16_t)(i & 0x3FF));
+    report_send(APP_HID_TOUCH_REPORT_IDX, report, sizeof(report));
+}
+
+static void bench_path(const char *name, bool direct, void (*send)(uint32_t), uint32_t n)
+{
+    uint32_t msg;
+
+    setup(direct);
+    msg = host_ke_msg_sent_count();
+    HOST_BENCH(name, n, send(_i));
+    printf("    kernel messages per report: %.2f\n", (double)(host_ke_msg_sent_count() - msg) / n);
+    if ((bench_sent != n) || (bench_direct != (direct ? n : 0)) || (app_hid_env.nb_out != 0))
+    {
+        printf("%u of %u reports notified, %u direct\n", (unsigned)bench_sent, (unsigned)n,
+               (unsigned)bench_direct);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t n = host_bench_iterations(argc, argv, 1000000);
+
+    bench_path("keyboard, HOGPD_REPORT_UPD_REQ", false, keyboard_send, n);
+    bench_path("keyboard, direct", true, keyboard_send, n);
+    bench_path("touch, HOGPD_REPORT_UPD_REQ", false, touch_send, n);
+    bench_path("touch, direct", true, touch_send, n);
+
+    return 0;
+}
@@ -0,0 +1,149 @@
+/**
+ * @file bench_timer.c
+ * @brief ns_timer on the timer wheel against the kernel timer per ns_timer it replaced,
+ *        with a few or all of the timers running.
+ *
+ * The running timers are far in the future, as the application keeps its idle and
+ * connection timers. The kernel list of the reference is a model of the ROM one, and the
+ * wheel pays for the simulated kernel of host_ke: compare the rows as an order of magnitude.
+ * The kernel work line under each row holds on target: every message is a heap allocation,
+ * every kernel timer call walks the kernel timer list, which held each running ns_timer.
+ */
+#include "host_bench.h"
+#include "host_ke.h"
+#include "host_app.h"
+#include "ns_timer.h"
+#include "timer_ref.h"
+
+static volatile uint32_t bench_fired;
+
+/// Kernel messages sent and kernel timer calls
+struct bench_work
+{
+    uint32_t msg;
+    uint32_t ke_timer;
+};
+
+static struct bench_work ref_work(void)
+{
+    return (struct bench_work){timer_ref.msg_nb, timer_ref.ke_timer_nb};
+}
+
+static struct bench_work wheel_work(void)
+{
+    return (struct bench_work){host_ke_msg_sent_count(), host_ke_timer_op_count()};
+}
+
+static void work_print(struct bench_work before, struct bench_work after, uint32_t n)
+{
+    printf("    kernel work per op: %.2f messages, %.2f timer set/clear\n",
+           (double)(after.msg - before.msg) / n, (double)(after.ke_timer - before.ke_timer) / n);
+}
+
+/// Time a statement and count the kernel work it does
+#define BENCH_WORK(name, n, work, stmt)                                         \
+    do {                                                                        \
+        struct bench_work _before = work();                                     \
+        HOST_BENCH(name, n, stmt);                                              \
+        work_print(_before, work(), n);                                         \
+    } while(0)
+
+static void bench_callback(void)
+{
+    bench_fired++;
+}
+
+static void wheel_setup(uint8_t running)
+{
+    ns_timer_cancel_all();
+    host_ke_reset();
+    host_app_init();
+    for (uint8_t i = 0; i < running; i++)
+    {
+        ns_timer_create(1000000 + i * 1000, bench_callback);
+    }
+}
+
+static void ref_setup(uint8_t running)
+{
+    timer_ref_init();
+    for (uint8_t i = 0; i < running; i++)
+    {
+        timer_ref_create(1000000 + i * 1000, bench_callback);
+    }
+}
+
+static void wheel_create_cancel(uint32_t i)
+{
+    ns_timer_cancel(ns_timer_create(50 + (i & 1023), bench_callback));
+    host_ke_run();
+}
+
+static void ref_create_cancel(uint32_t i)
+{
+    timer_ref_cancel(timer_ref_create(50 + (i & 1023), bench_callback));
+    timer_ref_run();
+}
+
+static void wheel_modify(uint32_t i)
+{
+    ns_timer_modify(0, 50 + (i & 1023));
+    host_ke_run();
+}
+
+static void ref_modify(uint32_t i)
+{
+    timer_ref_modify(0, 50 + (i & 1023));
+    timer_ref_run();
+}
+
+/// A 1 ms timer started and run to its expiry
+static void wheel_expiry(uint32_t i)
+{
+    ns_timer_create(1, bench_callback);
+    host_ke_advance(2000);
+}
+
+static void ref_expiry(uint32_t i)
+{
+    timer_ref_create(1, bench_callback);
+    timer_ref_advance(2);
+}
+
+static void bench_running(uint8_t running, uint32_t n)
+{
+    uint32_t fired;
+
+    printf("-- %u timers running\n", (unsigned)running);
+
+    ref_setup(running);
+    BENCH_WORK("create + cancel, kernel timers", n, ref_work, ref_create_cancel(_i));
+    wheel_setup(running);
+    BENCH_WORK("create + cancel, wheel", n, wheel_work, wheel_create_cancel(_i));
+
+    ref_setup(running);
+    BENCH_WORK("modify, kernel timers", n, ref_work, ref_modify(_i));
+    wheel_setup(running);
+    BENCH_WORK("modify, wheel", n, wheel_work, wheel_modify(_i));
+
+    ref_setup(running);
+    fired = bench_fired;
+    BENCH_WORK("1 ms expiry, kernel timers", n, ref_work, ref_expiry(_i));
+    wheel_setup(running);
+    BENCH_WORK("1 ms expiry, wheel", n, wheel_work, wheel_expiry(_i));
+    if (bench_fired - fired != 2 * n)
+    {
+        printf("%u of %u expiries\n", (unsigned)(bench_fired - fired), (unsigned)(2 * n));
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t n = host_bench_iterations(argc, argv, 200000);
+
+    bench_running(1, n);
+    bench_running(NS_TIMER_MAX_NUM / 2, n);
+    bench_running(NS_TIMER_MAX_NUM - 1, n);
+
+    return 0;
+}
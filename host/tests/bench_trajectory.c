@@ -0,0 +1,69 @@
+/**
+ * @file bench_trajectory.c
+ * @brief One gesture frame with the Q15 trajectory module against the float code it replaced.
+ *
+ * The host has an FPU, the float rows are only a reference here: on the Cortex-M0 each
+ * float operation is a library call, the comparison that matters is made on the target.
+ */
+#include <math.h>
+#include "host_bench.h"
+#include "app_trajectory.h"
+
+static volatile int32_t bench_sink;
+
+/// Pinch frame of the float implementation: float progress and interpolation
+static void frame_float_line(uint8_t i, uint8_t steps)
+{
+    float progress = (float)i / steps;
+    uint16_t x = 4000 + (int16_t)((28000 - 4000) * progress);
+    uint16_t y = 30000 + (int16_t)((2000 - 30000) * progress);
+
+    bench_sink = x + y;
+}
+
+static void frame_q15_line(uint8_t i, uint8_t steps)
+{
+    uint16_t t = app_traj_progress(i, steps);
+
+    bench_sink = app_traj_lerp(4000, 28000, t) + app_traj_lerp(30000, 2000, t);
+}
+
+/// Rotation frame in float, with a true circle as the Q15 version draws
+static void frame_float_arc(uint8_t i, uint8_t steps)
+{
+    float progress = (float)i / steps;
+    float angle = 90 * 3.14159f / 180.0f * progress;
+
+    bench_sink = (int32_t)(16000 + 8000 * cosf(angle)) + (int32_t)(16000 + 8000 * sinf(angle));
+}
+
+static void frame_q15_arc(uint8_t i, uint8_t steps)
+{
+    app_traj_point_t p;
+    uint16_t t = app_traj_ease(APP_TRAJ_EASE_IN_OUT, app_traj_progress(i, steps));
+
+    app_traj_arc(16000, 16000, 8000, app_traj_turn(90, t), &p);
+    bench_sink = p.x + p.y;
+}
+
+static void frame_q15_bezier(uint8_t i, uint8_t steps)
+{
+    static const app_traj_point_t ctrl[4] = {{1000, 30000}, {1000, 1000}, {31000, 1000}, {31000, 30000}};
+    app_traj_point_t p;
+
+    app_traj_bezier(ctrl, app_traj_progress(i, steps), &p);
+    bench_sink = p.x + p.y;
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t n = host_bench_iterations(argc, argv, 5000000);
+
+    HOST_BENCH("line, float", n, frame_float_line(_i % 31, 30));
+    HOST_BENCH("line, q15", n, frame_q15_line(_i % 31, 30));
+    HOST_BENCH("arc, float sinf/cosf", n, frame_float_arc(_i % 31, 30));
+    HOST_BENCH("arc, q15 eased", n, frame_q15_arc(_i % 31, 30));
+    HOST_BENCH("bezier, q15", n, frame_q15_bezier(_i % 31, 30));
+
+    return 0;
+}
@@ -0,0 +1,80 @@
+/**
+ * @file crc_ref.h
+ * @brief Bitwise CRCs the ns_crc tables replaced, kept as the reference of the host tests.
+ */
+#ifndef __CRC_REF_H__
+#define __CRC_REF_H__
+
+#include <stdint.h>
+
+/// dfu_crc32: reflected polynomial 0xEDB88320, seed and final xor 0xFFFFFFFF
+static inline uint32_t crc_ref_crc32_update(uint32_t crc, const uint8_t *p_data, uint32_t len)
+{
+    while (len--)
+    {
+        crc ^= *p_data++;
+        for (uint8_t i = 0; i < 8; i++)
+        {
+            crc = (crc & 1) ? ((crc >> 1) ^ 0xEDB88320) : (crc >> 1);
+        }
+    }
+    return crc;
+}
+
+static inline uint32_t crc_ref_crc32(const uint8_t *p_data, uint32_t len)
+{
+    return ~crc_ref_crc32_update(0xFFFFFFFF, p_data, len);
+}
+
+/// ns_bond_db_crc16 of the bond database: polynomial 0x1021 msb first
+static inline uint16_t crc_ref_crc16_ccitt(uint16_t crc, const uint8_t *p_data, uint32_t len)
+{
+    while (len--)
+    {
+        crc ^= (uint16_t)(*p_data++) << 8;
+        for (uint8_t i = 0; i < 8; i++)
+        {
+            crc = (crc & 0x8000) ? ((crc << 1) ^ 0x1021) : (crc << 1);
+        }
+    }
+    return crc;
+}
+
+/// prf_e2e_crc of the CGM profile, copied as it was
+static inline uint16_t crc_ref_e2e(const uint8_t *buf, uint16_t length)
+{
+    uint16_t crc_reg = 0xffff;
+    uint8_t reg;
+    uint16_t crc;
+    int i, j;
+
+    for (i = 0; i < length; i++)
+    {
+        reg = *buf++;
+        for (j = 0; j < 8; j++)
+        {
+            if ((reg & 1) != ((crc_reg >> 15) & 1))
+            {
+                crc_reg <<= 1;
+                crc_reg ^= (uint16_t)(1 << 12) | (1 << 5) | (1 << 0);
+            }
+            else
+            {
+                crc_reg <<= 1;
+            }
+            reg >>= 1;
+        }
+    }
+
+    crc = 0;
+    // result is in the order bits:->8 9 10 11 12 13 14 15 0 1 2 3 4 5 6 7
+    for (j = 0; j < 8; j++)
+    {
+        crc >>= 1;
+        crc |= crc_reg & ((1 << 15) | (1 << 7));
+        crc_reg <<= 1;
+    }
+    return crc;
+}
+
+#endif //__CRC_REF_H__
@@ -0,0 +1,50 @@
+/**
+ * @file host_bench.h
+ * @brief Timing helpers of the host benchmarks.
+ *
+ * Host timings only rank the implementations against each other, cycle counts of the
+ * Cortex-M0 have to be measured on the device. "--quick" runs a few iterations,
+ * enough for ctest to check that the benchmark still builds and runs.
+ */
+#ifndef __HOST_BENCH_H__
+#define __HOST_BENCH_H__
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+static inline uint64_t host_bench_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+/// Iterations to run, divided by 1000 with --quick
+static inline uint32_t host_bench_iterations(int argc, char *argv[], uint32_t full)
+{
+    if ((argc > 1) && (strcmp(argv[1], "--quick") == 0))
+    {
+        return (full / 1000) ? (full / 1000) : 1;
+    }
+    return full;
+}
+
+static inline void host_bench_print(const char *name, uint64_t ns, uint32_t iterations)
+{
+    printf("%-40s %10.1f ns/op\n", name, (double)ns / iterations);
+}
+
+/// Time a statement run `iterations` times
+#define HOST_BENCH(name, iterations, stmt)                                      \
+    do {                                                                        \
+        uint64_t _t0 = host_bench_ns();                                         \
+        for (uint32_t _i = 0; _i < (iterations); _i++) {                        \
+            stmt;                                                               \
+        }                                                                       \
+        host_bench_print((name), host_bench_ns() - _t0, (iterations));          \
+    } while(0)
+
+#endif //__HOST_BENCH_H__
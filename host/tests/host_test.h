@@ -0,0 +1,43 @@
+/**
+ * @file host_test.h
+ * @brief Minimal check macros of the host tests, a test program returns its failure count.
+ */
+#ifndef __HOST_TEST_H__
+#define __HOST_TEST_H__
+
+#include <stdio.h>
+#include <stdint.h>
+
+extern int host_test_failures;
+
+/// Define the failure counter, once per test program
+#define HOST_TEST_MAIN()    int host_test_failures
+
+#define CHECK(cond)                                                             \
+    do {                                                                        \
+        if (!(cond)) {                                                          \
+            printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond);     \
+            host_test_failures++;                                               \
+        }                                                                       \
+    } while(0)
+
+#define CHECK_EQ(a, b)                                                          \
+    do {                                                                        \
+        long long _a = (long long)(a);                                          \
+        long long _b = (long long)(b);                                          \
+        if (_a != _b) {                                                         \
+            printf("%s:%d: CHECK_EQ(%s, %s) failed: %lld != %lld\n",            \
+                   __FILE__, __LINE__, #a, #b, _a, _b);                         \
+            host_test_failures++;                                               \
+        }                                                                       \
+    } while(0)
+
+/// Run one test function and print its name
+#define RUN_TEST(fn)                                                            \
+    do {                                                                        \
+        int _before = host_test_failures;                                       \
+        fn();                                                                   \
+        printf("%-48s %s\n", #fn, (host_test_failures == _before) ? "ok" : "FAILED"); \
+    } while(0)
+
+#endif //__HOST_TEST_H__
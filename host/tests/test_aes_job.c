@@ -0,0 +1,221 @@
+/**
+ * @file test_aes_job.c
+ * @brief AES job queue on its software backend against the SP 800-38A CBC-AES128 and the
+ *        RFC 3610 CCM vectors, and ns_aes_cbc() built over it.
+ */
+#include <string.h>
+#include "host_test.h"
+#include "ns_aes.h"
+#include "ns_aes_job.h"
+
+HOST_TEST_MAIN();
+
+static uint32_t job_done;
+static uint8_t job_status;
+
+static void hex(const char *s, uint8_t *p_out)
+{
+    while (*s)
+    {
+        sscanf(s, "%2hhx", p_out++);
+        s += 2;
+    }
+}
+
+static void job_cb(struct ns_aes_job *job, uint8_t status)
+{
+    job_done++;
+    job_status = status;
+}
+
+/// SP 800-38A F.2.1 / F.2.2, CBC-AES128
+static uint8_t sp_key[16], sp_iv[16], sp_plain[64], sp_cipher[64];
+
+static void sp800_38a_load(void)
+{
+    hex("2b7e151628aed2a6abf7158809cf4f3c", sp_key);
+    hex("000102030405060708090a0b0c0d0e0f", sp_iv);
+    hex("6bc1bee22e409f96e93d7e117393172a" "ae2d8a571e03ac9c9eb76fac45af8e51"
+        "30c81c46a35ce411e5fbc1191a0a52ef" "f69f2445df4f9b17ad2b417be66c3710", sp_plain);
+    hex("7649abac8119b246cee98e9b12e9197d" "5086cb9b507219ee95db113a917678b2"
+        "73bed6b8e3c1743b7116e69e22229516" "3ff1caa1681fac09120eca307586e1a7", sp_cipher);
+}
+
+static uint8_t cbc_run(uint8_t mode, const uint8_t *p_in, uint8_t *p_out, uint16_t len)
+{
+    struct ns_aes_job job;
+    uint8_t status;
+
+    memset(&job, 0, sizeof(job));
+    job.mode = mode;
+    job.key = sp_key;
+    job.iv = sp_iv;
+    job.in = p_in;
+    job.out = p_out;
+    job.len = len;
+    job.cb = job_cb;
+    job_done = 0;
+    status = ns_aes_job_submit(&job);
+    if (status == NS_AES_JOB_OK)
+    {
+        CHECK_EQ(job_done, 1);
+        CHECK_EQ(job_status, NS_AES_JOB_OK);
+    }
+    return status;
+}
+
+/// Every prefix of the vector, each block is chained on the previous one
+static void test_cbc_sp800_38a(void)
+{
+    uint8_t out[64];
+
+    sp800_38a_load();
+    for (uint16_t len = 16; len <= 64; len += 16)
+    {
+        memset(out, 0, sizeof(out));
+        CHECK_EQ(cbc_run(NS_AES_JOB_CBC_ENCRYPT, sp_plain, out, len), NS_AES_JOB_OK);
+        CHECK(memcmp(out, sp_cipher, len) == 0);
+
+        memset(out, 0, sizeof(out));
+        CHECK_EQ(cbc_run(NS_AES_JOB_CBC_DECRYPT, sp_cipher, out, len), NS_AES_JOB_OK);
+        CHECK(memcmp(out, sp_plain, len) == 0);
+    }
+}
+
+static void test_cbc_in_place(void)
+{
+    uint8_t buf[64];
+
+    sp800_38a_load();
+    memcpy(buf, sp_plain, 64);
+    CHECK_EQ(cbc_run(NS_AES_JOB_CBC_ENCRYPT, buf, buf, 64), NS_AES_JOB_OK);
+    CHECK(memcmp(buf, sp_cipher, 64) == 0);
+    CHECK_EQ(cbc_run(NS_AES_JOB_CBC_DECRYPT, buf, buf, 64), NS_AES_JOB_OK);
+    CHECK(memcmp(buf, sp_plain, 64) == 0);
+}
+
+static void test_cbc_bad_length(void)
+{
+    uint8_t out[64];
+
+    sp800_38a_load();
+    job_done = 0;
+    CHECK_EQ(cbc_run(NS_AES_JOB_CBC_ENCRYPT, sp_plain, out, 0), NS_AES_JOB_ERR_PARAM);
+    CHECK_EQ(cbc_run(NS_AES_JOB_CBC_ENCRYPT, sp_plain, out, 17), NS_AES_JOB_ERR_PARAM);
+    CHECK_EQ(cbc_run(NS_AES_JOB_CBC_DECRYPT, sp_cipher, out, 63), NS_AES_JOB_ERR_PARAM);
+    CHECK_EQ(job_done, 0);
+}
+
+static uint8_t cbc_res_status;
+static uint8_t cbc_res_block[16];
+static bool cbc_res_null;
+static uint32_t cbc_res_count;
+
+static void cbc_res_cb(uint8_t status, const uint8_t *aes_res, uint32_t src_info)
+{
+    cbc_res_count++;
+    cbc_res_status = status;
+    cbc_res_null = (aes_res == NULL);
+    if (aes_res != NULL)
+    {
+        memcpy(cbc_res_block, aes_res, 16);
+    }
+}
+
+/// The wrapper gives the last output block, or an error and no block
+static void test_ns_aes_cbc(void)
+{
+    uint8_t out[64];
+
+    sp800_38a_load();
+    cbc_res_count = 0;
+    ns_aes_cbc(sp_key, sp_iv, sp_plain, out, true, 64, cbc_res_cb);
+    CHECK_EQ(cbc_res_count, 1);
+    CHECK_EQ(cbc_res_status, CO_ERROR_NO_ERROR);
+    CHECK(memcmp(out, sp_cipher, 64) == 0);
+    CHECK(memcmp(cbc_res_block, sp_cipher + 48, 16) == 0);
+
+    ns_aes_cbc(sp_key, sp_iv, sp_cipher, out, false, 64, cbc_res_cb);
+    CHECK_EQ(cbc_res_count, 2);
+    CHECK(memcmp(out, sp_plain, 64) == 0);
+
+    ns_aes_cbc(sp_key, sp_iv, sp_plain, out, true, 40, cbc_res_cb);
+    CHECK_EQ(cbc_res_count, 3);
+    CHECK_EQ(cbc_res_status, CO_ERROR_INVALID_HCI_PARAM);
+    CHECK(cbc_res_null);
+}
+
+/// RFC 3610 packet vectors 1 to 3: M = 8, L = 2, 8 bytes of header
+static void test_ccm_rfc3610(void)
+{
+    static const char *const nonce_hex[3] = {
+        "00000003020100a0a1a2a3a4a5", "00000004030201a0a1a2a3a4a5", "00000005040302a0a1a2a3a4a5",
+    };
+    static const char *const result_hex[3] = {
+        "588c979a61c663d2f066d0c2c0f989806d5f6b61dac38417e8d12cfdf926e0",
+        "72c91a36e135f8cf291ca894085c87e3cc15c439c9e43a3ba091d56e10400916",
+        "51b1e5f44a197d1da46b0f8e2d282ae871e838bb64da8596574adaa76fbd9fb0c5",
+    };
+    uint8_t key[16], nonce[13], aad[8], plain[25], expected[33], out[33];
+    struct ns_aes_job job;
+
+    hex("c0c1c2c3c4c5c6c7c8c9cacbcccdcecf", key);
+    hex("0001020304050607", aad);
+    for (uint8_t i = 0; i < sizeof(plain); i++)
+    {
+        plain[i] = 0x08 + i;
+    }
+
+    for (uint8_t v = 0; v < 3; v++)
+    {
+        uint16_t len = 23 + v;
+
+        hex(nonce_hex[v], nonce);
+        hex(result_hex[v], expected);
+
+        memset(&job, 0, sizeof(job));
+        job.mode = NS_AES_JOB_CCM_ENCRYPT;
+        job.key = key;
+        job.iv = nonce;
+        job.aad = aad;
+        job.aad_len = 8;
+        job.in = plain;
+        job.out = out;
+        job.len = len;
+        job.mic_len = 8;
+        job.cb = job_cb;
+        job_done = 0;
+        CHECK_EQ(ns_aes_job_submit(&job), NS_AES_JOB_OK);
+        CHECK_EQ(job_status, NS_AES_JOB_OK);
+        CHECK(memcmp(out, expected, len + 8) == 0);
+
+        //in place decryption, then with each bit of the MIC flipped in turn
+        job.mode = NS_AES_JOB_CCM_DECRYPT;
+        job.in = out;
+        CHECK_EQ(ns_aes_job_submit(&job), NS_AES_JOB_OK);
+        CHECK_EQ(job_status, NS_AES_JOB_OK);
+        CHECK(memcmp(out, plain, len) == 0);
+        for (uint8_t bit = 0; bit < 64; bit++)
+        {
+            memcpy(out, expected, len + 8);
+            out[len + bit / 8] ^= 1 << (bit % 8);
+            CHECK_EQ(ns_aes_job_submit(&job), NS_AES_JOB_OK);
+            CHECK_EQ(job_status, NS_AES_JOB_ERR_MIC);
+        }
+        memcpy(out, expected, len + 8);
+        out[v] ^= 0x80;
+        CHECK_EQ(ns_aes_job_submit(&job), NS_AES_JOB_OK);
+        CHECK_EQ(job_status, NS_AES_JOB_ERR_MIC);
+        CHECK_EQ(job_done, 2 + 64 + 1);
+    }
+}
+
+int main(void)
+{
+    RUN_TEST(test_cbc_sp800_38a);
+    RUN_TEST(test_cbc_in_place);
+    RUN_TEST(test_cbc_bad_length);
+    RUN_TEST(test_ns_aes_cbc);
+    RUN_TEST(test_ccm_rfc3610);
+    return host_test_failures;
+}
@@ -0,0 +1,439 @@
+/**
+ * @file test_app_hid.c
+ * @brief app_hid.c against the fake HOGPD: report path, ordering, credits and queue policies,
+ *        and the reports of the keyboard and enhanced multi-touch senders.
+ */
+#include <string.h>
+#include "host_test.h"
+#include "host_ke.h"
+#include "host_app.h"
+#include "fake_hogpd.h"
+#include "global_func.h"
+#include "app_hid.h"
+#include "app_hid_touchscreen.h"
+#include "app_hid_keyboard.h"
+
+HOST_TEST_MAIN();
+
+extern struct app_hid_env_tag app_hid_env;
+
+static void setup(void)
+{
+    host_ke_reset();
+    host_app_init();
+    fake_hogpd_init();
+    app_hid_init();
+    app_hid_enable_prf(0);
+    host_ke_run();
+    fake_hogpd_connect(0);
+}
+
+static void key_report(uint8_t *report, uint8_t key)
+{
+    memset(report, 0, APP_HID_KEYBOARD_REPORT_LEN);
+    report[2] = key;
+}
+
+static void touch_report(uint8_t *report, bool tip, uint16_t x)
+{
+    memset(report, 0, APP_HID_MULTITOUCH_REPORT_LEN);
+    report[0] = tip ? 0x01 : 0x00;
+    report[1] = x & 0xFF;
+    report[2] = x >> 8;
+}
+
+static void touch_send(bool tip, uint16_t x)
+{
+    uint8_t report[APP_HID_MULTITOUCH_REPORT_LEN];
+
+    touch_report(report, tip, x);
+    CHECK(app_hid_send_report(APP_HID_TOUCH_REPORT_IDX, report, sizeof(report)));
+    host_ke_run();
+}
+
+static void mouse_send(uint8_t buttons, int16_t x)
+{
+    uint8_t report[APP_HID_MOUSE_REPORT_LEN] = {0};
+
+    report[0] = buttons;
+    co_write16p(&report[1], x);
+    CHECK(app_hid_send_report(APP_HID_MOUSE_REPORT_IDX, report, sizeof(report)));
+    host_ke_run();
+}
+
+/// Use every credit with consumer reports that stay in flight
+static void credits_exhaust(void)
+{
+    uint8_t report[APP_HID_CONSUMER_REPORT_LEN] = {0};
+
+    for (uint16_t i = 0; i < APP_HID_NB_SEND_REPORT; i++)
+    {
+        report[0] = (uint8_t)i;
+        report[1] = (uint8_t)(i >> 8);
+        app_hid_send_report(APP_HID_CONSUMER_REPORT_IDX, report, sizeof(report));
+        host_ke_run();
+    }
+    CHECK_EQ(app_hid_env.nb_report, 0);
+}
+
+/// Touch reports the fake HOGPD received, tip switch and X
+static uint32_t touch_sent(uint8_t *tips, uint16_t *xs, uint32_t max)
+{
+    uint32_t nb = 0;
+
+    for (uint32_t i = 0; i < fake_hogpd_count(); i++)
+    {
+        const struct fake_hogpd_report *p_report = fake_hogpd_get(i);
+
+        if ((p_report->idx == APP_HID_TOUCH_REPORT_IDX) && (nb < max))
+        {
+            tips[nb] = p_report->value[0];
+            xs[nb]   = co_read16p(&p_report->value[1]);
+            nb++;
+        }
+    }
+    return nb;
+}
+
+static void test_ready_after_ntf_cfg(void)
+{
+    setup();
+    CHECK(is_app_hid_ready());
+    CHECK_EQ(app_hid_env.nb_report, APP_HID_NB_SEND_REPORT);
+}
+
+static void test_first_report_direct(void)
+{
+    uint8_t report[APP_HID_KEYBOARD_REPORT_LEN];
+
+    setup();
+    key_report(report, 0x04);
+    CHECK(app_hid_send_report(APP_HID_KEYBOARD_REPORT_IDX, report, sizeof(report)));
+    host_ke_run();
+
+    CHECK_EQ(fake_hogpd_count(), 1);
+    CHECK(fake_hogpd_get(0)->direct);
+    CHECK_EQ(fake_hogpd_get(0)->idx, APP_HID_KEYBOARD_REPORT_IDX);
+    CHECK_EQ(fake_hogpd_get(0)->length, sizeof(report));
+    CHECK(memcmp(fake_hogpd_get(0)->value, report, sizeof(report)) == 0);
+    CHECK_EQ(app_hid_env.nb_out, 1);
+    CHECK_EQ(app_hid_env.nb_req_out, 0);
+
+    CHECK_EQ(fake_hogpd_complete_all(), 1);
+    CHECK_EQ(app_hid_env.nb_out, 0);
+    CHECK_EQ(app_hid_env.nb_report, APP_HID_NB_SEND_REPORT);
+    CHECK_EQ(host_ke_msg_live(), 0);
+}
+
+static void test_busy_reports_keep_order(void)
+{
+    uint8_t report[APP_HID_KEYBOARD_REPORT_LEN];
+
+    setup();
+    for (uint8_t key = 1; key <= 6; key++)
+    {
+        key_report(report, key);
+        CHECK(app_hid_send_report(APP_HID_KEYBOARD_REPORT_IDX, report, sizeof(report)));
+        host_ke_run();
+    }
+    // One notification at a time, the others wait as requests
+    CHECK_EQ(fake_hogpd_count(), 1);
+    CHECK_EQ(app_hid_env.nb_out, 6);
+    CHECK_EQ(app_hid_env.nb_req_out, 5);
+
+    // HOGPD idle again, but a direct report would overtake the requests
+    CHECK(fake_hogpd_complete(GAP_ERR_NO_ERROR));
+    key_report(report, 7);
+    CHECK(app_hid_send_report(APP_HID_KEYBOARD_REPORT_IDX, report, sizeof(report)));
+    host_ke_run();
+
+    CHECK_EQ(fake_hogpd_complete_all(), 6);
+    CHECK_EQ(fake_hogpd_count(), 7);
+    for (uint32_t i = 0; i < fake_hogpd_count(); i++)
+    {
+        CHECK_EQ(fake_hogpd_get(i)->value[2], i + 1);
+        CHECK_EQ(fake_hogpd_get(i)->direct, (i == 0));
+    }
+    CHECK_EQ(app_hid_env.nb_out, 0);
+    CHECK_EQ(app_hid_env.nb_req_out, 0);
+    CHECK_EQ(host_ke_msg_live(), 0);
+}
+
+static void test_no_credit_queues_and_drops_oldest(void)
+{
+    uint8_t report[APP_HID_KEYBOARD_REPORT_LEN];
+    struct app_hid_queue_stats stats;
+    uint16_t total = APP_HID_NB_SEND_REPORT + APP_HID_QUEUE_DEPTH + 2;
+
+    setup();
+    for (uint16_t i = 0; i < total; i++)
+    {
+        // Alternate two keys so that nothing is suppressed as unchanged
+        key_report(report, (uint8_t)(i & 0xFF));
+        report[3] = (uint8_t)(i >> 8);
+        CHECK(app_hid_send_report(APP_HID_KEYBOARD_REPORT_IDX, report, sizeof(report)));
+        host_ke_run();
+    }
+    CHECK_EQ(app_hid_env.nb_report, 0);
+    CHECK_EQ(app_hid_queue_pending(), APP_HID_QUEUE_DEPTH);
+
+    app_hid_queue_get_stats(APP_HID_KEYBOARD_REPORT_IDX, &stats);
+    CHECK_EQ(stats.queued, APP_HID_QUEUE_DEPTH + 2);
+    CHECK_EQ(stats.dropped, 2);
+    CHECK_EQ(stats.max_depth, APP_HID_QUEUE_DEPTH);
+
+    fake_hogpd_complete_all();
+    CHECK_EQ(app_hid_queue_pending(), 0);
+    CHECK_EQ(fake_hogpd_count(), total - 2);
+    // The two oldest queued reports were the ones dropped
+    CHECK_EQ(fake_hogpd_get(APP_HID_NB_SEND_REPORT)->value[2], (APP_HID_NB_SEND_REPORT + 2) & 0xFF);
+    CHECK_EQ(fake_hogpd_get(fake_hogpd_count() - 1)->value[2], (total - 1) & 0xFF);
+    CHECK_EQ(app_hid_env.nb_report, APP_HID_NB_SEND_REPORT);
+    CHECK_EQ(host_ke_msg_live(), 0);
+}
+
+/// A failed report gives its credit back and leaves nothing in flight, direct or requested
+static void test_error_status_resets(void)
+{
+    uint8_t report[APP_HID_KEYBOARD_REPORT_LEN];
+
+    for (uint8_t direct = 0; direct < 2; direct++)
+    {
+        setup();
+        fake_hogpd_direct_enable(direct != 0);
+        key_report(report, 1);
+        app_hid_send_report(APP_HID_KEYBOARD_REPORT_IDX, report, sizeof(report));
+        host_ke_run();
+        CHECK_EQ(app_hid_env.nb_out, 1);
+        CHECK_EQ(app_hid_env.nb_req_out, direct ? 0 : 1);
+        CHECK_EQ(app_hid_env.nb_report, APP_HID_NB_SEND_REPORT - 1);
+
+        CHECK(fake_hogpd_complete(PRF_ERR_REQ_DISALLOWED));
+        CHECK(!is_app_hid_ready());
+        CHECK(!app_hid_send_report(APP_HID_KEYBOARD_REPORT_IDX, report, sizeof(report)));
+        CHECK_EQ(app_hid_env.nb_out, 0);
+        CHECK_EQ(app_hid_env.nb_req_out, 0);
+        CHECK_EQ(app_hid_env.nb_report, APP_HID_NB_SEND_REPORT);
+    }
+}
+
+static void test_invalid_report_refused(void)
+{
+    uint8_t report[APP_HID_QUEUE_REPORT_MAX_LEN + 1] = {0};
+
+    setup();
+    CHECK(!app_hid_send_report(APP_HID_REPORT_NB, report, 4));
+    CHECK(!app_hid_send_report(APP_HID_KEYBOARD_REPORT_IDX, report, sizeof(report)));
+    CHECK_EQ(fake_hogpd_count(), 0);
+}
+
+static void test_touch_coalesce_same_contacts(void)
+{
+    struct app_hid_queue_stats stats;
+    uint8_t tips[16];
+    uint16_t xs[16];
+
+    setup();
+    credits_exhaust();
+    for (uint16_t i = 0; i <= APP_HID_QUEUE_DEPTH; i++)
+    {
+        touch_send(true, 100 + i);
+    }
+    // The last move replaced the newest pending one
+    CHECK_EQ(app_hid_queue_pending(), APP_HID_QUEUE_DEPTH);
+    app_hid_queue_get_stats(APP_HID_TOUCH_REPORT_IDX, &stats);
+    CHECK_EQ(stats.coalesced, 1);
+    CHECK_EQ(stats.dropped, 0);
+
+    fake_hogpd_complete_all();
+    CHECK_EQ(touch_sent(tips, xs, 16), APP_HID_QUEUE_DEPTH);
+    CHECK_EQ(xs[0], 100);
+    CHECK_EQ(xs[APP_HID_QUEUE_DEPTH - 2], 100 + APP_HID_QUEUE_DEPTH - 2);
+    CHECK_EQ(xs[APP_HID_QUEUE_DEPTH - 1], 100 + APP_HID_QUEUE_DEPTH);
+}
+
+static void test_touch_lift_not_overwritten(void)
+{
+    struct app_hid_queue_stats stats;
+    uint8_t tips[16];
+    uint16_t xs[16];
+    uint32_t nb;
+
+    setup();
+    credits_exhaust();
+    for (uint16_t i = 0; i < APP_HID_QUEUE_DEPTH - 1; i++)
+    {
+        touch_send(true, 100 + i);
+    }
+    // Full queue, newest is the lift
+    touch_send(false, 200);
+    // A new touch must neither overwrite the lift nor be lost
+    touch_send(true, 300);
+    touch_send(true, 301);
+
+    app_hid_queue_get_stats(APP_HID_TOUCH_REPORT_IDX, &stats);
+    CHECK_EQ(stats.dropped, 0);
+
+    fake_hogpd_complete_all();
+    nb = touch_sent(tips, xs, 16);
+    CHECK_EQ(nb, APP_HID_QUEUE_DEPTH);
+    // Older moves went first, the lift and the new contact kept their order
+    CHECK_EQ(tips[0], 1);
+    CHECK_EQ(xs[0], 100 + 1);
+    CHECK_EQ(tips[nb - 3], 1);
+    CHECK_EQ(tips[nb - 2], 0);
+    CHECK_EQ(xs[nb - 2], 200);
+    CHECK_EQ(tips[nb - 1], 1);
+    CHECK_EQ(xs[nb - 1], 301);
+}
+
+static void test_touch_only_contact_changes_drop_oldest(void)
+{
+    struct app_hid_queue_stats stats;
+    uint8_t tips[16];
+    uint16_t xs[16];
+
+    setup();
+    credits_exhaust();
+    for (uint16_t i = 0; i <= APP_HID_QUEUE_DEPTH; i++)
+    {
+        touch_send((i & 1) == 0, 100 + i);
+    }
+    app_hid_queue_get_stats(APP_HID_TOUCH_REPORT_IDX, &stats);
+    CHECK_EQ(stats.dropped, 1);
+    CHECK_EQ(stats.coalesced, 0);
+
+    fake_hogpd_complete_all();
+    CHECK_EQ(touch_sent(tips, xs, 16), APP_HID_QUEUE_DEPTH);
+    CHECK_EQ(xs[0], 101);
+    CHECK_EQ(xs[APP_HID_QUEUE_DEPTH - 1], 100 + APP_HID_QUEUE_DEPTH);
+}
+
+/// A release sent to a full mouse queue is not merged into the pending press
+static void test_mouse_full_queue_keeps_release(void)
+{
+    struct app_hid_queue_stats stats;
+    const struct fake_hogpd_report *p_last = NULL;
+    const struct fake_hogpd_report *p_before = NULL;
+
+    setup();
+    credits_exhaust();
+    // Button edges only, the newest one a press
+    for (uint8_t i = 0; i < APP_HID_QUEUE_DEPTH; i++)
+    {
+        mouse_send(((APP_HID_QUEUE_DEPTH - 1 - i) & 1) ? 0 : 1, 1);
+    }
+    CHECK_EQ(app_hid_queue_pending(), APP_HID_QUEUE_DEPTH);
+
+    mouse_send(0, 1);
+    CHECK_EQ(app_hid_queue_pending(), APP_HID_QUEUE_DEPTH);
+    app_hid_queue_get_stats(APP_HID_MOUSE_REPORT_IDX, &stats);
+    CHECK_EQ(stats.dropped, 1);
+    CHECK_EQ(stats.coalesced, 0);
+
+    fake_hogpd_complete_all();
+    for (uint32_t i = 0; i < fake_hogpd_count(); i++)
+    {
+        if (fake_hogpd_get(i)->idx == APP_HID_MOUSE_REPORT_IDX)
+        {
+            p_before = p_last;
+            p_last = fake_hogpd_get(i);
+        }
+    }
+    CHECK((p_last != NULL) && (p_before != NULL));
+    CHECK_EQ(p_before->value[0], 1);
+    CHECK_EQ(p_last->value[0], 0);
+}
+
+/// Keyboard report of build_keyboard_report() sent with app_hid_send_keyboard_report()
+static void test_keyboard_report(void)
+{
+    uint8_t keys[7] = {HID_KEY_H, HID_KEY_E, HID_KEY_L, HID_KEY_L, HID_KEY_O, HID_KEY_1, HID_KEY_2};
+    hid_keyboard_report_t report;
+    const struct fake_hogpd_report *p_sent;
+
+    setup();
+    build_keyboard_report(&report, HID_MOD_LSHIFT, keys, sizeof(keys));
+    app_hid_send_keyboard_report((uint8_t *)&report);
+    build_keyboard_report(&report, 0, NULL, 0);
+    app_hid_send_keyboard_report((uint8_t *)&report);
+    host_ke_run();
+    fake_hogpd_complete_all();
+
+    CHECK_EQ(fake_hogpd_count(), 2);
+    p_sent = fake_hogpd_get(0);
+    CHECK_EQ(p_sent->idx, APP_HID_KEYBOARD_REPORT_IDX);
+    CHECK_EQ(p_sent->length, APP_HID_KEYBOARD_REPORT_LEN);
+    CHECK_EQ(p_sent->value[0], HID_MOD_LSHIFT);
+    CHECK_EQ(p_sent->value[1], 0);
+    // Six keys at most
+    CHECK(memcmp(&p_sent->value[2], keys, 6) == 0);
+
+    p_sent = fake_hogpd_get(1);
+    for (uint8_t i = 0; i < APP_HID_KEYBOARD_REPORT_LEN; i++)
+    {
+        CHECK_EQ(p_sent->value[i], 0);
+    }
+}
+
+/// Enhanced multi-touch report: tip switch and contact ID, X, Y per contact, the count last
+static void test_enhanced_multitouch_report(void)
+{
+    hid_touch_point_t touches[2] = {0};
+    const struct fake_hogpd_report *p_sent;
+
+    setup();
+    touches[0].tip_switch = 1;
+    touches[0].contact_id = 0;
+    touches[0].x = 1000;
+    touches[0].y = 2000;
+    touches[1].tip_switch = 1;
+    touches[1].contact_id = 1;
+    touches[1].x = 0x1234;
+    touches[1].y = 0x0567;
+    app_hid_send_enhanced_multitouch(touches, 2);
+    // Both contacts lifted where they were
+    app_hid_send_enhanced_multitouch(NULL, 0);
+    host_ke_run();
+    fake_hogpd_complete_all();
+
+    CHECK_EQ(fake_hogpd_count(), 2);
+    p_sent = fake_hogpd_get(0);
+    CHECK_EQ(p_sent->idx, APP_HID_TOUCH_REPORT_IDX);
+    CHECK_EQ(p_sent->length, 16);
+    CHECK_EQ(p_sent->value[0], 0x01);
+    CHECK_EQ(co_read16p(&p_sent->value[1]), 1000);
+    CHECK_EQ(co_read16p(&p_sent->value[3]), 2000);
+    CHECK_EQ(p_sent->value[5], 0x03);
+    CHECK_EQ(co_read16p(&p_sent->value[6]), 0x1234);
+    CHECK_EQ(co_read16p(&p_sent->value[8]), 0x0567);
+    // Third contact unused, its ID only
+    CHECK_EQ(p_sent->value[10], 2 << 1);
+    CHECK_EQ(p_sent->value[15], 2);
+
+    p_sent = fake_hogpd_get(1);
+    CHECK_EQ(p_sent->value[0], 0x00);
+    CHECK_EQ(co_read16p(&p_sent->value[1]), 1000);
+    CHECK_EQ(p_sent->value[5], 0x02);
+    CHECK_EQ(co_read16p(&p_sent->value[6]), 0x1234);
+    CHECK_EQ(p_sent->value[15], 0);
+}
+
+int main(void)
+{
+    RUN_TEST(test_ready_after_ntf_cfg);
+    RUN_TEST(test_first_report_direct);
+    RUN_TEST(test_busy_reports_keep_order);
+    RUN_TEST(test_no_credit_queues_and_drops_oldest);
+    RUN_TEST(test_error_status_resets);
+    RUN_TEST(test_invalid_report_refused);
+    RUN_TEST(test_touch_coalesce_same_contacts);
+    RUN_TEST(test_touch_lift_not_overwritten);
+    RUN_TEST(test_touch_only_contact_changes_drop_oldest);
+    RUN_TEST(test_mouse_full_queue_keeps_release);
+    RUN_TEST(test_keyboard_report);
+    RUN_TEST(test_enhanced_multitouch_report);
+    CHECK_EQ(host_ke_assert_count(), 0);
+
+    return host_test_failures;
+}
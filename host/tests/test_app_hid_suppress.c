@@ -0,0 +1,184 @@
+/**
+ * @file test_app_hid_suppress.c
+ * @brief Delta-suppression of unchanged reports: dead band, keepalive and counters.
+ */
+#include <string.h>
+#include "host_test.h"
+#include "host_ke.h"
+#include "host_app.h"
+#include "fake_hogpd.h"
+#include "global_func.h"
+#include "app_hid.h"
+#include "app_hid_touchscreen.h"
+
+HOST_TEST_MAIN();
+
+extern struct app_hid_env_tag app_hid_env;
+
+static void setup(void)
+{
+    host_ke_reset();
+    host_app_init();
+    fake_hogpd_init();
+    app_hid_init();
+    app_hid_enable_prf(0);
+    host_ke_run();
+    fake_hogpd_connect(0);
+}
+
+/// Send one contact, completing the notification right away as a fast link would
+static void touch_send(bool tip, uint16_t x, uint16_t y)
+{
+    uint8_t report[APP_HID_MULTITOUCH_REPORT_LEN] = {0};
+
+    report[0] = (tip ? 0x01 : 0x00) | (1 << 1);
+    co_write16p(&report[1], x);
+    co_write16p(&report[3], y);
+    CHECK(app_hid_send_report(APP_HID_TOUCH_REPORT_IDX, report, sizeof(report)));
+    host_ke_run();
+    fake_hogpd_complete_all();
+}
+
+static uint32_t suppressed_get(uint8_t report_idx)
+{
+    struct app_hid_queue_stats stats;
+
+    app_hid_queue_get_stats(report_idx, &stats);
+    return stats.suppressed;
+}
+
+static void test_identical_touch_suppressed(void)
+{
+    setup();
+    for (int i = 0; i < 10; i++)
+    {
+        touch_send(true, 1000, 2000);
+        host_ke_advance(7500);
+    }
+    CHECK_EQ(fake_hogpd_count(), 1);
+    CHECK_EQ(suppressed_get(APP_HID_TOUCH_REPORT_IDX), 9);
+
+    // Any change goes out
+    touch_send(true, 1001, 2000);
+    CHECK_EQ(fake_hogpd_count(), 2);
+    touch_send(false, 1001, 2000);
+    CHECK_EQ(fake_hogpd_count(), 3);
+}
+
+static void test_keepalive_resends(void)
+{
+    setup();
+    touch_send(true, 1000, 2000);
+    host_ke_advance((APP_HID_SUPPRESS_KEEPALIVE_MS - 1) * 1000);
+    touch_send(true, 1000, 2000);
+    CHECK_EQ(fake_hogpd_count(), 1);
+
+    // Once the keepalive interval elapsed the unchanged report is sent again
+    host_ke_advance(1000);
+    touch_send(true, 1000, 2000);
+    CHECK_EQ(fake_hogpd_count(), 2);
+    touch_send(true, 1000, 2000);
+    CHECK_EQ(fake_hogpd_count(), 2);
+}
+
+static void test_dead_band(void)
+{
+    setup();
+    app_hid_suppress_config(APP_HID_TOUCH_REPORT_IDX, true, 4, APP_HID_SUPPRESS_KEEPALIVE_MS);
+
+    touch_send(true, 1000, 2000);
+    // Jitter within the dead band, on both axes and both directions
+    touch_send(true, 1004, 2000);
+    touch_send(true, 996, 1996);
+    touch_send(true, 1000, 2004);
+    CHECK_EQ(fake_hogpd_count(), 1);
+    CHECK_EQ(suppressed_get(APP_HID_TOUCH_REPORT_IDX), 3);
+
+    // Out of the dead band, compared with the last report sent
+    touch_send(true, 1005, 2000);
+    CHECK_EQ(fake_hogpd_count(), 2);
+    touch_send(true, 1008, 2000);
+    CHECK_EQ(fake_hogpd_count(), 2);
+
+    // Lifting the contact is never within the dead band
+    touch_send(false, 1008, 2000);
+    CHECK_EQ(fake_hogpd_count(), 3);
+    CHECK_EQ(fake_hogpd_get(2)->value[0] & 0x01, 0);
+}
+
+static void test_suppression_disabled(void)
+{
+    setup();
+    app_hid_suppress_config(APP_HID_TOUCH_REPORT_IDX, false, 0, 0);
+    for (int i = 0; i < 5; i++)
+    {
+        touch_send(true, 1000, 2000);
+    }
+    CHECK_EQ(fake_hogpd_count(), 5);
+    CHECK_EQ(suppressed_get(APP_HID_TOUCH_REPORT_IDX), 0);
+}
+
+static void test_no_keepalive(void)
+{
+    setup();
+    app_hid_suppress_config(APP_HID_TOUCH_REPORT_IDX, true, 0, 0);
+    touch_send(true, 1000, 2000);
+    host_ke_advance(10 * 1000 * 1000);
+    touch_send(true, 1000, 2000);
+    CHECK_EQ(fake_hogpd_count(), 1);
+}
+
+static void test_refused_report_not_suppressed(void)
+{
+    uint8_t report[APP_HID_KEYBOARD_REPORT_LEN] = {0};
+    struct app_hid_queue_stats stats;
+
+    setup();
+    app_hid_suppress_config(APP_HID_KEYBOARD_REPORT_IDX, true, 0, 0);
+    app_hid_queue_set_policy(APP_HID_KEYBOARD_REPORT_IDX, APP_HID_QUEUE_BLOCK);
+    // No credit left, every report waits in the queue until it is full
+    app_hid_env.nb_report = 0;
+    for (uint8_t i = 0; i < APP_HID_QUEUE_DEPTH; i++)
+    {
+        report[2] = i + 1;
+        CHECK(app_hid_send_report(APP_HID_KEYBOARD_REPORT_IDX, report, sizeof(report)));
+    }
+
+    // Refused twice, the second one must not count as an unchanged report
+    report[2] = 0x20;
+    CHECK(!app_hid_send_report(APP_HID_KEYBOARD_REPORT_IDX, report, sizeof(report)));
+    CHECK(!app_hid_send_report(APP_HID_KEYBOARD_REPORT_IDX, report, sizeof(report)));
+    app_hid_queue_get_stats(APP_HID_KEYBOARD_REPORT_IDX, &stats);
+    CHECK_EQ(stats.dropped, 2);
+    CHECK_EQ(stats.suppressed, 0);
+}
+
+static void test_multitouch_entry_point(void)
+{
+    hid_touch_point_t touch = {1, 0, 16000, 8000};
+
+    setup();
+    for (int i = 0; i < 4; i++)
+    {
+        app_hid_send_multitouch(&touch, 1);
+        host_ke_run();
+        fake_hogpd_complete_all();
+    }
+    CHECK_EQ(fake_hogpd_count(), 1);
+    CHECK_EQ(co_read16p(&fake_hogpd_get(0)->value[1]), 16000);
+    CHECK_EQ(suppressed_get(APP_HID_TOUCH_REPORT_IDX), 3);
+}
+
+int main(void)
+{
+    RUN_TEST(test_identical_touch_suppressed);
+    RUN_TEST(test_keepalive_resends);
+    RUN_TEST(test_dead_band);
+    RUN_TEST(test_suppression_disabled);
+    RUN_TEST(test_no_keepalive);
+    RUN_TEST(test_refused_report_not_suppressed);
+    RUN_TEST(test_multitouch_entry_point);
+    CHECK_EQ(host_ke_assert_count(), 0);
+
+    return host_test_failures;
+}
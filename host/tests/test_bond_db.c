@@ -0,0 +1,456 @@
+/**
+ * @file test_bond_db.c
+ * @brief ns_sec.c bond log over the simulated flash: bonds kept across boots, the replace
+ *        and drop rules, erase counts, the legacy import, and a failed flash operation or a
+ *        power cut at every flash operation of an add.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "host_test.h"
+#include "host_flash.h"
+#include "host_sec.h"
+#include "app_user_config.h"
+
+HOST_TEST_MAIN();
+
+#define BOND_DB_SIZE        (2 * FLASH_SECTOR_SIZE)
+/// Peers the random tests pair with, more than MAX_BOND_PEER
+#define PEER_NB             9
+
+/// Bonds the database should hold, oldest first, with the rules of ns_sec.c
+struct bond_model
+{
+    uint8_t num;
+    struct app_sec_bond_data_env_tag data[MAX_BOND_PEER];
+    /// Last bond replaced or dropped, it must not be found any more
+    bool has_dropped;
+    struct app_sec_bond_data_env_tag dropped;
+};
+
+static struct bond_model model;
+static uint8_t model_max_peer;
+static uint16_t bond_serial;
+
+static void bond_make(struct app_sec_bond_data_env_tag *p_bond, uint8_t peer)
+{
+    bond_serial++;
+    memset(p_bond, 0, sizeof(*p_bond));
+    p_bond->ltk.key[0] = (uint8_t)bond_serial;
+    p_bond->ltk.key[1] = (uint8_t)(bond_serial >> 8);
+    p_bond->ltk.key[15] = peer;
+    p_bond->rand_nb.nb[0] = (uint8_t)(bond_serial * 13);
+    p_bond->rand_nb.nb[7] = peer;
+    p_bond->ediv = bond_serial;
+    p_bond->key_size = 16;
+    p_bond->peer_addr_type = 0;
+    p_bond->peer_addr.addr[0] = peer;
+    p_bond->peer_addr.addr[5] = 0xC0;
+    p_bond->auth = GAP_AUTH_BOND;
+}
+
+static void model_reset(uint8_t max_peer)
+{
+    memset(&model, 0, sizeof(model));
+    model_max_peer = max_peer;
+}
+
+static void model_drop(uint8_t idx)
+{
+    model.dropped = model.data[idx];
+    model.has_dropped = true;
+    model.num--;
+    memmove(&model.data[idx], &model.data[idx + 1], (model.num - idx) * sizeof(model.data[0]));
+}
+
+static void model_add(struct app_sec_bond_data_env_tag const *p_bond)
+{
+    for (uint8_t i = 0; i < model.num; i++)
+    {
+        if (memcmp(model.data[i].peer_addr.addr, p_bond->peer_addr.addr, GAP_BD_ADDR_LEN) == 0)
+        {
+            model_drop(i);
+            break;
+        }
+    }
+    if (model.num >= model_max_peer)
+    {
+        model_drop(0);
+    }
+    model.data[model.num++] = *p_bond;
+}
+
+/// Every bond of the model found with its LTK, the dropped one not found
+static bool bonds_match(void)
+{
+    struct gap_sec_key ltk;
+    struct gap_bdaddr last;
+
+    for (uint8_t i = 0; i < model.num; i++)
+    {
+        if (!host_sec_ltk_find(model.data[i].ediv, model.data[i].rand_nb.nb, &ltk)
+            || (memcmp(&ltk, &model.data[i].ltk, sizeof(ltk)) != 0))
+        {
+            return false;
+        }
+    }
+    if (model.has_dropped && host_sec_ltk_find(model.dropped.ediv, model.dropped.rand_nb.nb, NULL))
+    {
+        return false;
+    }
+    if (model.num != 0)
+    {
+        ns_bond_last_bonded_addr(&last);
+        if (memcmp(last.addr.addr, model.data[model.num - 1].peer_addr.addr, GAP_BD_ADDR_LEN) != 0)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// Boot and compare with the model
+static bool boot_matches(void)
+{
+    return (host_sec_boot() == model.num) && bonds_match();
+}
+
+static void start(uint8_t max_peer)
+{
+    host_flash_init();
+    model_reset(max_peer);
+    CHECK_EQ(host_sec_init(max_peer), 0);
+}
+
+static void store(uint8_t peer)
+{
+    struct app_sec_bond_data_env_tag bond;
+
+    bond_make(&bond, peer);
+    CHECK(host_sec_bond_store(&bond));
+    model_add(&bond);
+}
+
+static uint32_t bond_db_erases(void)
+{
+    return host_flash_erase_count(BOND_DATA_BASE_ADDR) + host_flash_erase_count(BOND_DATA_BASE_ADDR + FLASH_SECTOR_SIZE);
+}
+
+static void test_bonds_kept_across_boots(void)
+{
+    start(MAX_BOND_PEER);
+    store(1);
+    store(2);
+    store(3);
+    CHECK(bonds_match());
+    CHECK(boot_matches());
+    CHECK(ns_sec_get_bond_status());
+    store(4);
+    CHECK(boot_matches());
+}
+
+/// A new pairing of a bonded peer replaces its bond, the LTK of the old one is gone
+static void test_same_peer_replaced(void)
+{
+    start(MAX_BOND_PEER);
+    store(1);
+    store(2);
+    store(1);
+    CHECK_EQ(model.num, 2);
+    CHECK(bonds_match());
+    CHECK(boot_matches());
+}
+
+/// Beyond bond_max_peer the oldest bond is dropped
+static void test_oldest_dropped(void)
+{
+    start(MAX_BOND_PEER);
+    for (uint8_t peer = 0; peer < MAX_BOND_PEER + 2; peer++)
+    {
+        store(peer);
+    }
+    CHECK_EQ(model.num, MAX_BOND_PEER);
+    CHECK(bonds_match());
+    CHECK(boot_matches());
+
+    start(2);
+    store(1);
+    store(2);
+    store(3);
+    CHECK(boot_matches());
+}
+
+/// Appending to the log erases a sector once per sector of records, not once per bond
+static void test_erase_count(void)
+{
+    uint32_t adds = 1000;
+
+    start(MAX_BOND_PEER);
+    srand(12);
+    for (uint32_t i = 0; i < adds; i++)
+    {
+        store(rand() % PEER_NB);
+        CHECK(bonds_match());
+        if ((i % 7) == 0)
+        {
+            CHECK(boot_matches());
+        }
+    }
+    CHECK(bond_db_erases() > 0);
+    CHECK(bond_db_erases() * 40 <= adds);
+    CHECK(boot_matches());
+}
+
+static void test_erase_all(void)
+{
+    start(MAX_BOND_PEER);
+    store(1);
+    store(2);
+    ns_sec_bond_db_erase_all();
+    CHECK(!ns_sec_get_bond_status());
+    CHECK_EQ(host_sec_boot(), 0);
+    model_reset(MAX_BOND_PEER);
+    store(3);
+    CHECK(boot_matches());
+}
+
+/// A sector that cannot be erased keeps its bonds, in RAM and after a boot
+static void test_erase_all_fail(void)
+{
+    start(MAX_BOND_PEER);
+    store(1);
+    store(2);
+    host_flash_fail_at(0);
+    CHECK(!ns_sec_bond_db_erase_all());
+    CHECK(ns_sec_get_bond_status());
+    CHECK(bonds_match());
+    CHECK(boot_matches());
+
+    CHECK(ns_sec_bond_db_erase_all());
+    CHECK_EQ(host_sec_boot(), 0);
+}
+
+/// A failed append does not hide the bonds added after it at the next boot
+static void test_append_fail_keeps_later_bonds(void)
+{
+    struct app_sec_bond_data_env_tag bond;
+
+    start(MAX_BOND_PEER);
+    store(1);
+    store(2);
+    bond_make(&bond, 3);
+    host_flash_fail_at(0);
+    CHECK(host_sec_bond_store(&bond));
+    model_add(&bond);
+    store(4);
+    store(5);
+    CHECK(bonds_match());
+    CHECK(boot_matches());
+}
+
+/// A database of the previous full-sector layout, in the given sector
+static void legacy_write(uint8_t idx)
+{
+    static struct local_device_bond_data_tag legacy;
+
+    memset(&legacy, 0xFF, sizeof(legacy));
+    legacy.valid_flag = 0x1234;
+    legacy.num = 3;
+    for (uint8_t i = 0; i < legacy.num; i++)
+    {
+        bond_make(&legacy.single_peer_bond_data[i], 100 + i);
+        model_add(&legacy.single_peer_bond_data[i]);
+    }
+    Qflash_Write(BOND_DATA_BASE_ADDR + idx * FLASH_SECTOR_SIZE, (uint8_t *)&legacy, sizeof(legacy));
+}
+
+static void test_legacy_import(void)
+{
+    for (uint8_t idx = 0; idx < 2; idx++)
+    {
+        host_flash_init();
+        model_reset(MAX_BOND_PEER);
+        legacy_write(idx);
+        CHECK_EQ(host_sec_init(MAX_BOND_PEER), 3);
+        CHECK(bonds_match());
+        CHECK(host_flash_erase_count(BOND_DATA_BASE_ADDR + idx * FLASH_SECTOR_SIZE) == 1);
+        CHECK(boot_matches());
+        store(1);
+        CHECK(boot_matches());
+    }
+}
+
+/// The import is done again from the start when power is lost during it
+static void test_legacy_import_power_cut(void)
+{
+    static const uint32_t torn[] = {0, 10, 40};
+
+    for (uint32_t t = 0; t < ARRAY_LEN(torn); t++)
+    {
+        for (uint32_t op = 0; ; op++)
+        {
+            bool cut;
+
+            host_flash_init();
+            model_reset(MAX_BOND_PEER);
+            legacy_write(1);
+            host_flash_cut_at(op, torn[t]);
+            host_sec_init(MAX_BOND_PEER);
+            cut = host_flash_is_cut();
+            host_flash_power_on();
+            if (!cut)
+            {
+                break;
+            }
+            CHECK(boot_matches());
+            store(1);
+            CHECK(boot_matches());
+        }
+    }
+}
+
+/**
+ * Fail every flash operation of each add in turn. The add keeps the bond or reports the
+ * failure and leaves the bonds as they were, in RAM and after a boot, and the next add
+ * works. The adds go through two compactions, where a failed erase refuses the bond.
+ */
+static void test_flash_fail_every_op(void)
+{
+    static uint8_t saved[BOND_DB_SIZE];
+    uint32_t fails = 0;
+    uint32_t refused = 0;
+
+    start(MAX_BOND_PEER);
+    srand(56);
+    for (uint32_t i = 0; i < 150; i++)
+    {
+        struct app_sec_bond_data_env_tag bond;
+        struct bond_model before = model;
+
+        bond_make(&bond, rand() % PEER_NB);
+        memcpy(saved, (const void *)(uintptr_t)BOND_DATA_BASE_ADDR, BOND_DB_SIZE);
+
+        for (uint32_t op = 0; ; op++)
+        {
+            uint32_t ops;
+            bool stored;
+
+            //back to the flash before the add
+            memcpy((void *)(uintptr_t)BOND_DATA_BASE_ADDR, saved, BOND_DB_SIZE);
+            model = before;
+            CHECK(boot_matches());
+
+            ops = host_flash_op_count();
+            host_flash_fail_at(op);
+            stored = host_sec_bond_store(&bond);
+            ops = host_flash_op_count() - ops;
+            host_flash_fail_at(HOST_FLASH_NEVER);
+            if (op >= ops)
+            {
+                CHECK(stored);
+                break;
+            }
+            fails++;
+
+            if (stored)
+            {
+                model_add(&bond);
+            }
+            else
+            {
+                refused++;
+            }
+            CHECK(bonds_match());
+            CHECK(boot_matches());
+            store(PEER_NB);
+            CHECK(boot_matches());
+        }
+
+        memcpy((void *)(uintptr_t)BOND_DATA_BASE_ADDR, saved, BOND_DB_SIZE);
+        model = before;
+        CHECK(boot_matches());
+        CHECK(host_sec_bond_store(&bond));
+        model_add(&bond);
+        CHECK(boot_matches());
+    }
+    CHECK(fails > 150);
+    CHECK(refused > 0);
+}
+
+/**
+ * Cut the power at every flash operation of each add, a write keeping none, a few or most
+ * of its bytes. The next boot must find the bonds from before the add or from after it,
+ * and the add that follows must work. The adds go through two compactions.
+ */
+static void test_power_cut_every_op(void)
+{
+    static const uint32_t torn[] = {0, 10, 40};
+    static uint8_t saved[BOND_DB_SIZE];
+    uint32_t cuts = 0;
+
+    start(MAX_BOND_PEER);
+    srand(34);
+    for (uint32_t i = 0; i < 150; i++)
+    {
+        struct app_sec_bond_data_env_tag bond;
+        struct bond_model before = model;
+
+        bond_make(&bond, rand() % PEER_NB);
+        memcpy(saved, (const void *)(uintptr_t)BOND_DATA_BASE_ADDR, BOND_DB_SIZE);
+
+        for (uint32_t t = 0; t < ARRAY_LEN(torn); t++)
+        {
+            for (uint32_t op = 0; ; op++)
+            {
+                bool cut;
+
+                //back to the flash before the add
+                memcpy((void *)(uintptr_t)BOND_DATA_BASE_ADDR, saved, BOND_DB_SIZE);
+                model = before;
+                CHECK(boot_matches());
+
+                host_flash_cut_at(op, torn[t]);
+                host_sec_bond_store(&bond);
+                cut = host_flash_is_cut();
+                host_flash_power_on();
+                if (!cut)
+                {
+                    break;
+                }
+                cuts++;
+
+                if (!boot_matches())
+                {
+                    model_add(&bond);
+                    CHECK(boot_matches());
+                }
+                store(PEER_NB);
+                CHECK(boot_matches());
+            }
+        }
+
+        memcpy((void *)(uintptr_t)BOND_DATA_BASE_ADDR, saved, BOND_DB_SIZE);
+        model = before;
+        CHECK(boot_matches());
+        host_sec_bond_store(&bond);
+        model_add(&bond);
+        CHECK(boot_matches());
+    }
+    //each add is a write, a compaction is an erase and more writes
+    CHECK(cuts > 150 * ARRAY_LEN(torn));
+}
+
+int main(void)
+{
+    RUN_TEST(test_bonds_kept_across_boots);
+    RUN_TEST(test_same_peer_replaced);
+    RUN_TEST(test_oldest_dropped);
+    RUN_TEST(test_erase_count);
+    RUN_TEST(test_erase_all);
+    RUN_TEST(test_erase_all_fail);
+    RUN_TEST(test_append_fail_keeps_later_bonds);
+    RUN_TEST(test_legacy_import);
+    RUN_TEST(test_legacy_import_power_cut);
+    RUN_TEST(test_flash_fail_every_op);
+    RUN_TEST(test_power_cut_every_op);
+    return host_test_failures;
+}
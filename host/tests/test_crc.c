@@ -0,0 +1,117 @@
+/**
+ * @file test_crc.c
+ * @brief ns_crc table CRCs against the bitwise code they replaced, over random buffers,
+ *        lengths, alignments and chunkings. The CRC32 peripheral path is not built here.
+ */
+#include <stdlib.h>
+#include "host_test.h"
+#include "crc_ref.h"
+#include "ns_crc.h"
+
+HOST_TEST_MAIN();
+
+#define BUF_MAX     1100
+
+static uint8_t buf[BUF_MAX + 8];
+
+static void fill_random(void)
+{
+    for (uint32_t i = 0; i < sizeof(buf); i++)
+    {
+        buf[i] = (uint8_t)rand();
+    }
+}
+
+static void test_check_values(void)
+{
+    static const uint8_t check[] = "123456789";
+
+    CHECK_EQ(ns_crc32(check, 9), 0xCBF43926);
+    CHECK_EQ(crc_ref_crc32(check, 9), 0xCBF43926);
+    CHECK_EQ(ns_crc16_ccitt_update(NS_CRC16_CCITT_INIT, check, 9), 0x29B1);
+    CHECK_EQ(ns_crc16_e2e(check, 9), crc_ref_e2e(check, 9));
+    CHECK_EQ(ns_crc32(check, 0), 0);
+    CHECK_EQ(ns_crc16_e2e(check, 0), crc_ref_e2e(check, 0));
+}
+
+/// Every length up to BUF_MAX at every alignment of the start
+static void test_crc32_lengths(void)
+{
+    fill_random();
+    for (uint32_t offset = 0; offset < 4; offset++)
+    {
+        for (uint32_t len = 0; len <= BUF_MAX; len++)
+        {
+            CHECK_EQ(ns_crc32(buf + offset, len), crc_ref_crc32(buf + offset, len));
+        }
+    }
+}
+
+/// Incremental update cut at random points gives the one-shot value
+static void test_crc32_chunks(void)
+{
+    for (uint32_t round = 0; round < 2000; round++)
+    {
+        uint32_t offset = rand() % 8;
+        uint32_t len = rand() % (BUF_MAX + 1);
+        uint32_t done = 0;
+        ns_crc32_t crc;
+
+        fill_random();
+        ns_crc32_init(&crc);
+        while (done < len)
+        {
+            uint32_t chunk = 1 + rand() % ((rand() & 1) ? 7 : 300);
+
+            if (chunk > len - done)
+            {
+                chunk = len - done;
+            }
+            ns_crc32_update(&crc, buf + offset + done, chunk);
+            done += chunk;
+        }
+        CHECK_EQ(ns_crc32_final(&crc), crc_ref_crc32(buf + offset, len));
+    }
+}
+
+static void test_crc16_ccitt(void)
+{
+    for (uint32_t round = 0; round < 2000; round++)
+    {
+        uint32_t offset = rand() % 8;
+        uint32_t len = rand() % (BUF_MAX + 1);
+        uint32_t cut = len ? (rand() % len) : 0;
+        uint16_t seed = (uint16_t)rand();
+        uint16_t crc;
+
+        fill_random();
+        CHECK_EQ(ns_crc16_ccitt_update(seed, buf + offset, len), crc_ref_crc16_ccitt(seed, buf + offset, len));
+        //the bond log chains header and payload through the running value
+        crc = ns_crc16_ccitt_update(NS_CRC16_CCITT_INIT, buf + offset, cut);
+        crc = ns_crc16_ccitt_update(crc, buf + offset + cut, len - cut);
+        CHECK_EQ(crc, crc_ref_crc16_ccitt(NS_CRC16_CCITT_INIT, buf + offset, len));
+    }
+}
+
+static void test_crc16_e2e(void)
+{
+    fill_random();
+    for (uint32_t offset = 0; offset < 4; offset++)
+    {
+        for (uint32_t len = 0; len <= BUF_MAX; len++)
+        {
+            CHECK_EQ(ns_crc16_e2e(buf + offset, len), crc_ref_e2e(buf + offset, (uint16_t)len));
+        }
+    }
+}
+
+int main(void)
+{
+    srand(17);
+    RUN_TEST(test_check_values);
+    RUN_TEST(test_crc32_lengths);
+    RUN_TEST(test_crc32_chunks);
+    RUN_TEST(test_crc16_ccitt);
+    RUN_TEST(test_crc16_e2e);
+    return host_test_failures;
+}
@@ -0,0 +1,313 @@
+/**
+ * @file test_dfu_ble.c
+ * @brief ns_dfu_ble.c image receive over the simulated flash: clean transfers, dropped and
+ *        reordered packets, reordered and resent blocks, flash errors and crc mismatches.
+ */
+#include <string.h>
+#include "host_test.h"
+#include "host_ke.h"
+#include "host_flash.h"
+#include "host_dfu.h"
+#include "ns_crc.h"
+#include "ns_dfu_boot.h"
+
+HOST_TEST_MAIN();
+
+#define IMAGE_CRC           ns_crc32(host_dfu_image(), HOST_DFU_IMAGE_SIZE)
+#define BLOCK_NB            ((HOST_DFU_IMAGE_SIZE + HOST_DFU_BLOCK_SIZE - 1) / HOST_DFU_BLOCK_SIZE)
+
+static uint32_t block_size(uint32_t block)
+{
+    uint32_t offset = block * HOST_DFU_BLOCK_SIZE;
+
+    return (HOST_DFU_IMAGE_SIZE - offset < HOST_DFU_BLOCK_SIZE) ? (HOST_DFU_IMAGE_SIZE - offset) : HOST_DFU_BLOCK_SIZE;
+}
+
+static uint8_t send_block(uint32_t block)
+{
+    return host_dfu_block(block * HOST_DFU_BLOCK_SIZE, block_size(block));
+}
+
+/// Fresh device with an older image in app1, a new transfer started and its setting accepted
+static void start(bool image_signature)
+{
+    uint8_t old[FLASH_PAGE_SIZE];
+
+    host_dfu_init();
+    memset(old, 0x3C, sizeof(old));
+    for (uint32_t addr = HOST_DFU_IMAGE_ADDRESS; addr < HOST_DFU_IMAGE_ADDRESS + HOST_DFU_IMAGE_SIZE + FLASH_SECTOR_SIZE; addr += FLASH_PAGE_SIZE)
+    {
+        Qflash_Write(addr, old, sizeof(old));
+    }
+
+    CHECK_EQ(host_dfu_version(), 1);
+    CHECK_EQ(host_dfu_setting(IMAGE_CRC, image_signature, false), 0);
+}
+
+static bool image_in_flash(void)
+{
+    return memcmp((const void *)(uintptr_t)HOST_DFU_IMAGE_ADDRESS, host_dfu_image(), HOST_DFU_IMAGE_SIZE) == 0;
+}
+
+/// Blocks back to back: each block waits for the write of the previous one only when it completes
+static void test_transfer(void)
+{
+    NS_Bootsetting_t const *p_boot = (const void *)(uintptr_t)NS_BOOTSETTING_START_ADDRESS;
+    uint32_t resets = host_ke_system_reset_count();
+
+    start(true);
+    for (uint32_t block = 0; block < BLOCK_NB; block++)
+    {
+        CHECK_EQ(send_block(block), 0);
+    }
+    CHECK_EQ(host_dfu_validate(), 0);
+    CHECK(image_in_flash());
+    for (uint32_t addr = HOST_DFU_IMAGE_ADDRESS; addr < HOST_DFU_IMAGE_ADDRESS + HOST_DFU_IMAGE_SIZE; addr += FLASH_SECTOR_SIZE)
+    {
+        CHECK_EQ(host_flash_erase_count(addr), 1);
+    }
+
+    CHECK_EQ(host_dfu_activate(), 0);
+    CHECK_EQ(p_boot->app1.activation, NS_BOOTSETTING_ACTIVATION_YES);
+    CHECK_EQ(p_boot->app1.size, HOST_DFU_IMAGE_SIZE);
+    CHECK_EQ(p_boot->app1.crc, IMAGE_CRC);
+    CHECK_EQ(p_boot->app1.version, HOST_DFU_IMAGE_VERSION);
+    CHECK_EQ(p_boot->crc, ns_crc32((const uint8_t *)&p_boot->crc + 4, sizeof(NS_Bootsetting_t) - 4));
+    host_ke_advance(1100 * 1000);
+    CHECK_EQ(host_ke_system_reset_count(), resets + 1);
+}
+
+/// The background writer runs between blocks, as when the link leaves it time
+static void test_transfer_background_writes(void)
+{
+    start(false);
+    for (uint32_t block = 0; block < BLOCK_NB; block++)
+    {
+        CHECK_EQ(send_block(block), 0);
+        CHECK(host_ke_run() > 0);
+    }
+    CHECK_EQ(host_ke_run(), 0);
+    CHECK_EQ(host_dfu_validate(), 0);
+    CHECK(image_in_flash());
+}
+
+/// A lost RC write leaves the block short, the client times out and sends the block again
+static void test_dropped_chunk(void)
+{
+    const uint8_t *p_image = host_dfu_image();
+
+    start(true);
+    CHECK_EQ(send_block(0), 0);
+
+    host_dfu_block_create(HOST_DFU_BLOCK_SIZE, HOST_DFU_BLOCK_SIZE);
+    for (uint32_t done = 0; done < HOST_DFU_BLOCK_SIZE; done += HOST_DFU_CHUNK_SIZE)
+    {
+        uint32_t len = (HOST_DFU_BLOCK_SIZE - done < HOST_DFU_CHUNK_SIZE) ? (HOST_DFU_BLOCK_SIZE - done) : HOST_DFU_CHUNK_SIZE;
+
+        if (done != 2 * HOST_DFU_CHUNK_SIZE)
+        {
+            CHECK_EQ(host_dfu_rc(p_image + HOST_DFU_BLOCK_SIZE + done, len), HOST_DFU_NO_RESPONSE);
+        }
+    }
+
+    for (uint32_t block = 1; block < BLOCK_NB; block++)
+    {
+        CHECK_EQ(send_block(block), 0);
+    }
+    CHECK_EQ(host_dfu_validate(), 0);
+    CHECK(image_in_flash());
+}
+
+/// A lost RC write followed by the first write of the retry completes the block with bad data
+static void test_dropped_chunk_filled(void)
+{
+    const uint8_t *p_image = host_dfu_image();
+
+    start(true);
+    host_dfu_block_create(0, HOST_DFU_BLOCK_SIZE);
+    CHECK_EQ(host_dfu_rc(p_image, 1000), HOST_DFU_NO_RESPONSE);
+    CHECK_EQ(host_dfu_rc(p_image + 1200, 848), HOST_DFU_NO_RESPONSE);
+    CHECK_EQ(host_dfu_rc(p_image, 200), 2);
+
+    for (uint32_t block = 0; block < BLOCK_NB; block++)
+    {
+        CHECK_EQ(send_block(block), 0);
+    }
+    CHECK_EQ(host_dfu_validate(), 0);
+    CHECK(image_in_flash());
+}
+
+/// Swapped RC writes give the right length and a wrong crc, the block is refused and resent
+static void test_reordered_chunks(void)
+{
+    const uint8_t *p_image = host_dfu_image();
+    uint32_t offset = 2 * HOST_DFU_BLOCK_SIZE;
+
+    start(true);
+    CHECK_EQ(send_block(0), 0);
+    CHECK_EQ(send_block(1), 0);
+
+    host_dfu_block_create(offset, HOST_DFU_BLOCK_SIZE);
+    CHECK_EQ(host_dfu_rc(p_image + offset + HOST_DFU_CHUNK_SIZE, HOST_DFU_CHUNK_SIZE), HOST_DFU_NO_RESPONSE);
+    CHECK_EQ(host_dfu_rc(p_image + offset, HOST_DFU_CHUNK_SIZE), HOST_DFU_NO_RESPONSE);
+    CHECK_EQ(host_dfu_rc(p_image + offset + 2 * HOST_DFU_CHUNK_SIZE, HOST_DFU_BLOCK_SIZE - 2 * HOST_DFU_CHUNK_SIZE), 2);
+    host_ke_run();
+    CHECK_EQ(host_flash_erase_count(HOST_DFU_IMAGE_ADDRESS + offset), 0);
+
+    for (uint32_t block = 2; block < BLOCK_NB; block++)
+    {
+        CHECK_EQ(send_block(block), 0);
+    }
+    CHECK_EQ(host_dfu_validate(), 0);
+    CHECK(image_in_flash());
+}
+
+/// Blocks out of order sector by sector: the signature is checked on a hash of the flash copy
+static void test_reordered_sectors(void)
+{
+    static const uint8_t order[BLOCK_NB] = {4, 5, 0, 1, 8, 9, 2, 3, 6, 7};
+
+    start(true);
+    for (uint32_t i = 0; i < BLOCK_NB; i++)
+    {
+        CHECK_EQ(send_block(order[i]), 0);
+    }
+    CHECK_EQ(host_dfu_validate(), 0);
+    CHECK(image_in_flash());
+}
+
+/// The second block of a sector sent before the first is erased by it, validation finds out
+static void test_reordered_in_sector(void)
+{
+    static const uint8_t order[BLOCK_NB] = {0, 1, 3, 2, 4, 5, 6, 7, 8, 9};
+
+    start(true);
+    for (uint32_t i = 0; i < BLOCK_NB; i++)
+    {
+        CHECK_EQ(send_block(order[i]), 0);
+    }
+    CHECK_EQ(host_dfu_validate(), 2);
+    CHECK(!image_in_flash());
+}
+
+/// A block sent again after its ack was lost is written again and not hashed twice
+static void test_resent_block(void)
+{
+    start(true);
+    for (uint32_t block = 0; block < BLOCK_NB; block++)
+    {
+        CHECK_EQ(send_block(block), 0);
+        if (block == 3)
+        {
+            CHECK_EQ(send_block(3), 0);
+        }
+    }
+    CHECK_EQ(host_dfu_validate(), 0);
+    CHECK(image_in_flash());
+}
+
+/// A write failing in the background shows on the next block ack and on validation
+static void test_flash_write_error(void)
+{
+    start(true);
+    CHECK_EQ(send_block(0), 0);
+    CHECK_EQ(send_block(1), 0);
+    CHECK_EQ(send_block(2), 0);
+    //block 2 starts a sector: erase, then its 3rd page fails
+    host_flash_fail_at(3);
+    CHECK_EQ(send_block(3), 3);
+    for (uint32_t block = 4; block < BLOCK_NB; block++)
+    {
+        CHECK_EQ(send_block(block), 3);
+    }
+    CHECK_EQ(host_dfu_validate(), 3);
+
+    //a new transfer starts clean
+    CHECK_EQ(host_dfu_version(), 1);
+    CHECK_EQ(host_dfu_setting(IMAGE_CRC, true, false), 0);
+    for (uint32_t block = 0; block < BLOCK_NB; block++)
+    {
+        CHECK_EQ(send_block(block), 0);
+    }
+    CHECK_EQ(host_dfu_validate(), 0);
+    CHECK(image_in_flash());
+}
+
+static void test_flash_erase_error(void)
+{
+    start(false);
+    CHECK_EQ(send_block(0), 0);
+    CHECK_EQ(send_block(1), 0);
+    //the write of block 1 is still pending, the erase for block 2 follows its 8 pages
+    host_flash_fail_at(8);
+    CHECK_EQ(send_block(2), 0);
+    CHECK_EQ(send_block(3), 3);
+    CHECK_EQ(host_dfu_validate(), 3);
+}
+
+static void test_block_crc_mismatch(void)
+{
+    start(true);
+    host_dfu_block_create_raw(0, HOST_DFU_BLOCK_SIZE, ns_crc32(host_dfu_image(), HOST_DFU_BLOCK_SIZE) ^ 1);
+    for (uint32_t done = 0; done < HOST_DFU_BLOCK_SIZE; done += 1024)
+    {
+        CHECK_EQ(host_dfu_rc(host_dfu_image() + done, 1024), (done + 1024 < HOST_DFU_BLOCK_SIZE) ? HOST_DFU_NO_RESPONSE : 2);
+    }
+    host_ke_run();
+    CHECK_EQ(host_flash_erase_count(HOST_DFU_IMAGE_ADDRESS), 0);
+}
+
+/// A bit dropped in flash after the blocks were acknowledged fails the image crc
+static void test_image_crc_mismatch(void)
+{
+    start(false);
+    for (uint32_t block = 0; block < BLOCK_NB; block++)
+    {
+        CHECK_EQ(send_block(block), 0);
+    }
+    host_ke_run();
+    *(volatile uint8_t *)(uintptr_t)(HOST_DFU_IMAGE_ADDRESS + 5000) ^= 0x10;
+    CHECK_EQ(host_dfu_validate(), 2);
+}
+
+/// With an image signature a corrupted flash copy still fails on the crc first
+static void test_signed_image_corrupted(void)
+{
+    start(true);
+    for (uint32_t block = 0; block < BLOCK_NB; block++)
+    {
+        CHECK_EQ(send_block(block), 0);
+    }
+    host_ke_run();
+    *(volatile uint8_t *)(uintptr_t)(HOST_DFU_IMAGE_ADDRESS + 12345) ^= 0x01;
+    CHECK_EQ(host_dfu_validate(), 2);
+}
+
+/// The setting signature covers the banks: a changed image crc or signature is refused
+static void test_setting_tampered(void)
+{
+    host_dfu_init();
+    CHECK_EQ(host_dfu_version(), 1);
+    CHECK_EQ(host_dfu_setting(IMAGE_CRC ^ 0x80, true, false), 3);
+    CHECK_EQ(host_dfu_setting(IMAGE_CRC, true, true), 3);
+    CHECK_EQ(host_dfu_setting(IMAGE_CRC, true, false), 0);
+}
+
+int main(void)
+{
+    RUN_TEST(test_transfer);
+    RUN_TEST(test_transfer_background_writes);
+    RUN_TEST(test_dropped_chunk);
+    RUN_TEST(test_dropped_chunk_filled);
+    RUN_TEST(test_reordered_chunks);
+    RUN_TEST(test_reordered_sectors);
+    RUN_TEST(test_reordered_in_sector);
+    RUN_TEST(test_resent_block);
+    RUN_TEST(test_flash_write_error);
+    RUN_TEST(test_flash_erase_error);
+    RUN_TEST(test_block_crc_mismatch);
+    RUN_TEST(test_image_crc_mismatch);
+    RUN_TEST(test_signed_image_corrupted);
+    RUN_TEST(test_setting_tampered);
+    return host_test_failures;
+}
@@ -0,0 +1,115 @@
+/**
+ * @file test_ecc.c
+ * @brief uECC_verify against the P-256 vectors of vectors/ecdsa_p256.txt, the RFC 6979
+ *        signature and single bit tampering of every valid vector. Built once with the
+ *        64 bit multiply and once with the Cortex-M0 16x16 one (uECC_MULT_16X16).
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "host_test.h"
+#include "uECC.h"
+
+HOST_TEST_MAIN();
+
+#define VECTOR_FILE     "vectors/ecdsa_p256.txt"
+
+static void hex_le(const char *hex, uint8_t *p_out, uint32_t len)
+{
+    for (uint32_t i = 0; i < len; i++)
+    {
+        sscanf(hex + 2 * i, "%2hhx", &p_out[i]);
+    }
+}
+
+/// Big endian hex as printed in the RFC to the little endian words uECC takes
+static void hex_be(const char *hex, uint8_t *p_out)
+{
+    for (uint32_t i = 0; i < 32; i++)
+    {
+        sscanf(hex + 2 * i, "%2hhx", &p_out[31 - i]);
+    }
+}
+
+static int verify(const uint8_t *p_pub, const uint8_t *p_hash, const uint8_t *p_sig)
+{
+    return uECC_verify(p_pub, p_hash, 32, p_sig, &curve_secp256r1);
+}
+
+/// RFC 6979 A.2.5, P-256 with SHA-256, message "sample"
+static void test_rfc6979(void)
+{
+    uint8_t pub[64], hash[32], sig[64];
+
+    hex_be("60FED4BA255A9D31C961EB74C6356D68C049B8923B61FA6CE669622E60F29FB6", pub);
+    hex_be("7903FE1008B8BC99A41AE9E95628BC64F2F1B20C2D7E9F5177A3C294D4462299", pub + 32);
+    hex_be("AF2BDBE1AA9B6EC1E2ADE1D694F41FC71A831D0268E9891562113D8A62ADD1BF", hash);
+    hex_be("EFD48B2AACB6A8FD1140DD9CD45E81D69D2C877B56AAF991C34D0EA84EAF3716", sig);
+    hex_be("F7CB1C942D657C41D436C7A1B6E29F65F3E900DBB9AFF4064DC4AB2F843ACDA8", sig + 32);
+
+    CHECK_EQ(verify(pub, hash, sig), 1);
+    hash[0] ^= 1;
+    CHECK_EQ(verify(pub, hash, sig), 0);
+}
+
+/// Every vector gives its expected result, every valid one fails after any single bit flip tried
+static void test_vectors(void)
+{
+    char pub_hex[129], hash_hex[65], sig_hex[129], name[32];
+    uint8_t pub[64], hash[32], sig[64];
+    int expected;
+    uint32_t count = 0;
+    FILE *f = fopen(VECTOR_FILE, "r");
+
+    CHECK(f != NULL);
+    if (f == NULL)
+    {
+        return;
+    }
+    while (fscanf(f, "%128s %64s %128s %d %31s", pub_hex, hash_hex, sig_hex, &expected, name) == 5)
+    {
+        int result;
+
+        hex_le(pub_hex, pub, 64);
+        hex_le(hash_hex, hash, 32);
+        hex_le(sig_hex, sig, 64);
+        count++;
+
+        result = verify(pub, hash, sig);
+        if (result != expected)
+        {
+            printf("vector %u (%s): %d, expected %d\n", count, name, result, expected);
+            host_test_failures++;
+            continue;
+        }
+        if (expected)
+        {
+            uint32_t bit = rand() % 256;
+
+            hash[bit / 8] ^= 1 << (bit % 8);
+            CHECK_EQ(verify(pub, hash, sig), 0);
+            hash[bit / 8] ^= 1 << (bit % 8);
+
+            bit = rand() % 512;
+            sig[bit / 8] ^= 1 << (bit % 8);
+            CHECK_EQ(verify(pub, hash, sig), 0);
+            sig[bit / 8] ^= 1 << (bit % 8);
+
+            bit = rand() % 512;
+            pub[bit / 8] ^= 1 << (bit % 8);
+            CHECK_EQ(verify(pub, hash, sig), 0);
+            pub[bit / 8] ^= 1 << (bit % 8);
+
+            CHECK_EQ(verify(pub, hash, sig), 1);
+        }
+    }
+    fclose(f);
+    CHECK_EQ(count, 463);
+}
+
+int main(void)
+{
+    srand(19);
+    RUN_TEST(test_rfc6979);
+    RUN_TEST(test_vectors);
+    return host_test_failures;
+}
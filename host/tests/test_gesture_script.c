@@ -0,0 +1,343 @@
+/**
+ * @file test_gesture_script.c
+ * @brief Gesture script validator and golden HID report streams of the gesture player.
+ *
+ * Each golden case plays a gesture on a 7.5ms connection interval and compares every
+ * touch report handed to HOGPD, with its time, to tests/golden/<case>.txt.
+ * Run with --update to write the golden files again after an intended change.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "host_test.h"
+#include "host_ke.h"
+#include "host_app.h"
+#include "fake_hogpd.h"
+#include "global_func.h"
+#include "app_hid.h"
+#include "app_gesture.h"
+#include "app_gesture_script.h"
+#include "app_hid_touchscreen.h"
+
+HOST_TEST_MAIN();
+
+/// Longest gesture played by a golden case (ms)
+#define GOLDEN_GESTURE_MAX_MS       20000
+/// Size of a report stream in text
+#define GOLDEN_TEXT_MAX             (FAKE_HOGPD_RECORD_MAX * 64)
+
+static bool golden_update;
+
+static void setup(void)
+{
+    host_ke_reset();
+    host_app_init();
+    fake_hogpd_init();
+    app_hid_init();
+    app_hid_enable_prf(0);
+    host_ke_run();
+    fake_hogpd_connect(0);
+    // 7.5ms, frames alternate 7 and 8ms
+    app_hid_set_conn_interval(6);
+}
+
+/* Validator -----------------------------------------------------------------*/
+#define CHECK_SCRIPT(expected, ...)                                             \
+    do {                                                                        \
+        static const uint8_t _code[] = { __VA_ARGS__ };                         \
+        CHECK(app_gesture_script_check(_code, sizeof(_code)) == (expected));    \
+    } while(0)
+
+static void test_check_accepts_valid(void)
+{
+    CHECK_SCRIPT(true, APP_GS_END());
+    CHECK_SCRIPT(true, APP_GS_DOWN(0, 100, 200), APP_GS_SYNC(), APP_GS_MOVE(0, 300, 400),
+                 APP_GS_PLAY(APP_TRAJ_EASE_IN_OUT, 100), APP_GS_UP(0), APP_GS_SYNC(), APP_GS_END());
+    CHECK_SCRIPT(true, APP_GS_SET(APP_GS_REG_NB - 1, 5), APP_GS_DOWN(MAX_TOUCH_POINTS - 1, 0, 0), APP_GS_END());
+    // Nesting up to APP_GS_LOOP_NB, bytes after END are not run
+    CHECK_SCRIPT(true, APP_GS_LOOP(2), APP_GS_LOOP(3), APP_GS_WAIT(1), APP_GS_NEXT(), APP_GS_NEXT(),
+                 APP_GS_END(), 0xFF, 0xFF);
+}
+
+static void test_check_rejects_bad_opcode(void)
+{
+    CHECK_SCRIPT(false, APP_GS_OP_MAX, APP_GS_END());
+    CHECK_SCRIPT(false, APP_GS_SYNC(), 0xFF, APP_GS_END());
+}
+
+static void test_check_rejects_out_of_range(void)
+{
+    // Instruction running past the end of the script
+    CHECK_SCRIPT(false, APP_GS_OP_DOWN, 0, 0x10);
+    CHECK_SCRIPT(false, APP_GS_SYNC(), APP_GS_OP_WAIT, 0x10);
+    // No END, the program counter would leave the script
+    CHECK_SCRIPT(false, APP_GS_DOWN(0, 1, 1), APP_GS_SYNC());
+    // Operand bytes out of their range
+    CHECK_SCRIPT(false, APP_GS_DOWN(MAX_TOUCH_POINTS, 0, 0), APP_GS_END());
+    CHECK_SCRIPT(false, APP_GS_SET(APP_GS_REG_NB, 0), APP_GS_END());
+    CHECK_SCRIPT(false, APP_GS_RAND(APP_GS_REG_NB, 10), APP_GS_END());
+    CHECK_SCRIPT(false, APP_GS_PLAY(APP_TRAJ_EASE_IN_OUT + 1, 10), APP_GS_END());
+
+    CHECK(!app_gesture_script_check(NULL, 4));
+    CHECK(!app_gesture_script_check((const uint8_t *)"", 0));
+}
+
+static void test_check_rejects_loop_stack(void)
+{
+    // Overflow: one LOOP more than the interpreter keeps
+    CHECK_SCRIPT(false, APP_GS_LOOP(2), APP_GS_LOOP(2), APP_GS_LOOP(2), APP_GS_WAIT(1),
+                 APP_GS_NEXT(), APP_GS_NEXT(), APP_GS_NEXT(), APP_GS_END());
+    // Underflow: NEXT without LOOP
+    CHECK_SCRIPT(false, APP_GS_NEXT(), APP_GS_END());
+    CHECK_SCRIPT(false, APP_GS_LOOP(2), APP_GS_NEXT(), APP_GS_NEXT(), APP_GS_END());
+    // END inside a loop body
+    CHECK_SCRIPT(false, APP_GS_LOOP(2), APP_GS_WAIT(1), APP_GS_END());
+}
+
+static void test_rejected_script_not_played(void)
+{
+    static const uint8_t code[] = { APP_GS_DOWN(0, 1, 1), APP_GS_NEXT(), APP_GS_END() };
+    int16_t arg[APP_GESTURE_SCRIPT_ARG_NB + 1] = {0};
+
+    setup();
+    CHECK(!app_gesture_script_play(code, sizeof(code), NULL, 0));
+    CHECK(!app_gesture_script_play(code, sizeof(code) - 1, arg, APP_GESTURE_SCRIPT_ARG_NB + 1));
+    CHECK(!app_gesture_is_busy());
+    host_ke_advance(100 * 1000);
+    CHECK_EQ(fake_hogpd_count(), 0);
+}
+
+/* Golden streams ------------------------------------------------------------*/
+static void gesture_run(void)
+{
+    for (uint32_t ms = 0; (ms < GOLDEN_GESTURE_MAX_MS) && app_gesture_is_busy(); ms++)
+    {
+        host_ke_advance(1000);
+        fake_hogpd_complete_all();
+    }
+    CHECK(!app_gesture_is_busy());
+}
+
+/// Touch reports as text: time in us since the gesture started, then the report bytes
+static void stream_format(char *text, size_t size, uint64_t start)
+{
+    size_t pos = 0;
+
+    text[0] = '\0';
+    for (uint32_t i = 0; i < fake_hogpd_count(); i++)
+    {
+        const struct fake_hogpd_report *p_report = fake_hogpd_get(i);
+
+        if (p_report->idx != APP_HID_TOUCH_REPORT_IDX)
+        {
+            continue;
+        }
+        pos += snprintf(&text[pos], size - pos, "%8llu", (unsigned long long)(p_report->time_us - start));
+        for (uint16_t j = 0; j < p_report->length; j++)
+        {
+            pos += snprintf(&text[pos], size - pos, " %02x", p_report->value[j]);
+        }
+        pos += snprintf(&text[pos], size - pos, "\n");
+    }
+}
+
+static void golden_compare(const char *name, const char *text)
+{
+    static char expected[GOLDEN_TEXT_MAX];
+    char path[96];
+    FILE *file;
+    size_t length;
+
+    snprintf(path, sizeof(path), "golden/%s.txt", name);
+    if (golden_update)
+    {
+        file = fopen(path, "w");
+        CHECK(file != NULL);
+        if (file != NULL)
+        {
+            fputs(text, file);
+            fclose(file);
+        }
+        return;
+    }
+
+    file = fopen(path, "r");
+    if (file == NULL)
+    {
+        printf("%s: missing, run with --update\n", path);
+        host_test_failures++;
+        return;
+    }
+    length = fread(expected, 1, sizeof(expected) - 1, file);
+    expected[length] = '\0';
+    fclose(file);
+
+    if (strcmp(expected, text) != 0)
+    {
+        uint32_t line = 1;
+
+        for (size_t i = 0; (expected[i] != '\0') && (expected[i] == text[i]); i++)
+        {
+            line += (expected[i] == '\n');
+        }
+        printf("%s: report stream differs from line %u\n", path, line);
+        host_test_failures++;
+    }
+}
+
+static void golden_case(const char *name, void (*start)(void))
+{
+    static char text[GOLDEN_TEXT_MAX];
+    uint64_t t0;
+
+    setup();
+    t0 = host_ke_now_us();
+    start();
+    CHECK(app_gesture_is_busy());
+    gesture_run();
+    CHECK(fake_hogpd_count() > 0);
+    stream_format(text, sizeof(text), t0);
+    golden_compare(name, text);
+    printf("  %-44s %u reports\n", name, fake_hogpd_count());
+}
+
+static void start_zoom_in(void)            { app_gesture_zoom(5, 1); }
+static void start_zoom_out(void)           { app_gesture_zoom(2, 0); }
+static void start_rotate_cw(void)          { app_gesture_rotate(90); }
+static void start_rotate_ccw(void)         { app_gesture_rotate(-30); }
+static void start_screenshot(void)         { app_gesture_screenshot(20); }
+static void start_swipe_h(void)            { app_gesture_swipe(2000, 0); }
+static void start_swipe_v(void)            { app_gesture_swipe(-3000, 1); }
+static void start_swipe_up(void)           { app_gesture_swipe_up_from_bottom(); }
+static void start_swipe_down(void)         { app_gesture_swipe_down_from_top(); }
+static void start_swipe_right(void)        { app_gesture_swipe_right_from_left(); }
+static void start_swipe_left(void)         { app_gesture_swipe_left_from_right(); }
+
+/// Registers and nested loops: three taps in a row, each one further right
+static void start_loop_registers(void)
+{
+    static const uint8_t code[] = {
+        APP_GS_SET(5, APP_GS_R(0)),
+        APP_GS_LOOP(APP_GS_R(1)),
+            APP_GS_DOWN(0, APP_GS_R(5), 16000),
+            APP_GS_SYNC(),
+            APP_GS_LOOP(2),
+                APP_GS_WAIT(20),
+                APP_GS_SYNC(),
+            APP_GS_NEXT(),
+            APP_GS_UP(0),
+            APP_GS_SYNC(),
+            APP_GS_ADD(5, 2500),
+            APP_GS_WAIT(30),
+        APP_GS_NEXT(),
+        APP_GS_END(),
+    };
+    int16_t arg[] = {4000, 3};
+
+    CHECK(app_gesture_script_play(code, sizeof(code), arg, 2));
+}
+
+/// Two contacts, one on a Bezier curve and one on a straight line, eased
+static void start_curve_ease(void)
+{
+    static const uint8_t code[] = {
+        APP_GS_DOWN(0, 4000, 28000),
+        APP_GS_DOWN(1, 28000, 28000),
+        APP_GS_SYNC(),
+        APP_GS_CURVE(0, 4000, 4000, 28000, 4000, 16000, 16000),
+        APP_GS_MOVE(1, 16000, 20000),
+        APP_GS_PLAY(APP_TRAJ_EASE_IN_OUT, 150),
+        APP_GS_UP(1),
+        APP_GS_SYNC(),
+        APP_GS_ARC(0, 16000, 12000, 4000, 90, -270),
+        APP_GS_PLAY(APP_TRAJ_EASE_OUT, 200),
+        APP_GS_END(),
+    };
+
+    CHECK(app_gesture_script_play(code, sizeof(code), NULL, 0));
+}
+
+/// Script written by the peer in the vendor Output Report, then run with arguments
+static void start_upload(void)
+{
+    static const uint8_t code[] = {
+        APP_GS_DOWN(0, APP_GS_R(0), APP_GS_R(1)),
+        APP_GS_SYNC(),
+        APP_GS_RAND(0, 300),
+        APP_GS_MOVE(0, APP_GS_R(0), 2000),
+        APP_GS_PLAY(APP_TRAJ_EASE_IN, 120),
+        APP_GS_WAIT(15),
+        APP_GS_END(),
+    };
+    uint8_t report[APP_HID_SCRIPT_REPORT_LEN];
+    uint16_t pos = 0;
+
+    report[0] = APP_GS_UPLOAD_BEGIN;
+    report[1] = sizeof(code) & 0xFF;
+    report[2] = sizeof(code) >> 8;
+    CHECK_EQ(fake_hogpd_report_write(0, APP_HID_SCRIPT_REPORT_IDX, report, 3), GAP_ERR_NO_ERROR);
+
+    while (pos < sizeof(code))
+    {
+        uint8_t n = ((sizeof(code) - pos) > (sizeof(report) - 2)) ? (sizeof(report) - 2) : (sizeof(code) - pos);
+
+        report[0] = APP_GS_UPLOAD_DATA;
+        report[1] = n;
+        memcpy(&report[2], &code[pos], n);
+        fake_hogpd_report_write(0, APP_HID_SCRIPT_REPORT_IDX, report, 2 + n);
+        pos += n;
+    }
+
+    report[0] = APP_GS_UPLOAD_RUN;
+    report[1] = 2;
+    co_write16p(&report[2], 12000);
+    co_write16p(&report[4], 30000);
+    fake_hogpd_report_write(0, APP_HID_SCRIPT_REPORT_IDX, report, 6);
+}
+
+static void test_golden_streams(void)
+{
+    golden_case("zoom_in", start_zoom_in);
+    golden_case("zoom_out", start_zoom_out);
+    golden_case("rotate_cw", start_rotate_cw);
+    golden_case("rotate_ccw", start_rotate_ccw);
+    golden_case("screenshot", start_screenshot);
+    golden_case("swipe_horizontal", start_swipe_h);
+    golden_case("swipe_vertical", start_swipe_v);
+    golden_case("swipe_up_from_bottom", start_swipe_up);
+    golden_case("swipe_down_from_top", start_swipe_down);
+    golden_case("swipe_right_from_left", start_swipe_right);
+    golden_case("swipe_left_from_right", start_swipe_left);
+    golden_case("script_loop_registers", start_loop_registers);
+    golden_case("script_curve_ease", start_curve_ease);
+    golden_case("script_upload", start_upload);
+}
+
+static void test_upload_rejected_script(void)
+{
+    static const uint8_t begin[] = { APP_GS_UPLOAD_BEGIN, 3, 0 };
+    static const uint8_t data[] = { APP_GS_UPLOAD_DATA, 3, APP_GS_NEXT(), APP_GS_SYNC(), APP_GS_END() };
+    static const uint8_t run[] = { APP_GS_UPLOAD_RUN, 0 };
+
+    setup();
+    fake_hogpd_report_write(0, APP_HID_SCRIPT_REPORT_IDX, begin, sizeof(begin));
+    fake_hogpd_report_write(0, APP_HID_SCRIPT_REPORT_IDX, data, sizeof(data));
+    fake_hogpd_report_write(0, APP_HID_SCRIPT_REPORT_IDX, run, sizeof(run));
+    CHECK(!app_gesture_is_busy());
+    CHECK_EQ(fake_hogpd_count(), 0);
+}
+
+int main(int argc, char *argv[])
+{
+    golden_update = (argc > 1) && (strcmp(argv[1], "--update") == 0);
+
+    RUN_TEST(test_check_accepts_valid);
+    RUN_TEST(test_check_rejects_bad_opcode);
+    RUN_TEST(test_check_rejects_out_of_range);
+    RUN_TEST(test_check_rejects_loop_stack);
+    RUN_TEST(test_rejected_script_not_played);
+    RUN_TEST(test_upload_rejected_script);
+    RUN_TEST(test_golden_streams);
+    CHECK_EQ(host_ke_assert_count(), 0);
+
+    return host_test_failures;
+}
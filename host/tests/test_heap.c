@@ -0,0 +1,359 @@
+/**
+ * @file test_heap.c
+ * @brief ns_heap.c walking kernel heaps laid out as ke_mem.c lays them out: use, largest
+ *        free block, fragments, high water marks, message attribution and corrupt headers.
+ *
+ * ke_malloc() and ke_free() are in the ROM and the host ones use malloc(), so the heaps are
+ * built here with the ke_mem.c block format: a 4 byte delimiter in front of each block, free
+ * blocks chained in address order from ke_env.heap[type], allocations cut from the end of the
+ * first free block large enough, freed blocks merged with their free neighbours.
+ */
+#define _GNU_SOURCE
+#include <string.h>
+#include <sys/mman.h>
+#include "host_test.h"
+#include "ke_env.h"
+#include "ke_msg.h"
+#include "co_math.h"
+#include "ns_heap.h"
+
+HOST_TEST_MAIN();
+
+/// ke_mem.c block delimiters, the size is at the same offset in both
+struct mblock_free
+{
+    uint16_t corrupt_check;
+    uint16_t free_size;
+    struct mblock_free *next;
+    struct mblock_free *previous;
+};
+
+struct mblock_used
+{
+    uint16_t corrupt_check;
+    uint16_t size;
+};
+
+#define HEAP_SIZE                   4096
+
+/// The heap bases are 32-bit in global_var.h, the heaps are mapped below 4 GiB
+struct ke_env_tag ke_env;
+uint32_t g_rwip_heap_env;
+uint16_t g_rwip_heap_env_size;
+uint32_t g_rwip_heap_db;
+uint16_t g_rwip_heap_db_size;
+uint32_t g_rwip_heap_msg;
+uint32_t g_rwip_heap_msg_size;
+uint32_t g_rwip_heap_non_ret;
+uint32_t g_rwip_heap_non_ret_size;
+
+static uint8_t *heap_mem;
+
+/// Block size ke_malloc() takes for a request
+static uint16_t heap_blk_size(uint32_t size)
+{
+    uint32_t total = CO_ALIGN4_HI(size) + sizeof(struct mblock_used);
+
+    return (uint16_t)co_max(total, sizeof(struct mblock_free));
+}
+
+/// ke_mem_init() of every heap, ns_heap marks cleared
+static void heap_init(void)
+{
+    uint32_t *bases[KE_MEM_BLOCK_MAX];
+
+    if (heap_mem == NULL)
+    {
+        heap_mem = mmap(NULL, KE_MEM_BLOCK_MAX * HEAP_SIZE, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS | MAP_32BIT, -1, 0);
+        CHECK(heap_mem != MAP_FAILED);
+    }
+    bases[KE_MEM_ENV] = &g_rwip_heap_env;
+    #if (BLE_HOST_PRESENT)
+    bases[KE_MEM_ATT_DB] = &g_rwip_heap_db;
+    #endif
+    bases[KE_MEM_KE_MSG] = &g_rwip_heap_msg;
+    bases[KE_MEM_NON_RETENTION] = &g_rwip_heap_non_ret;
+
+    for (uint8_t type = 0; type < KE_MEM_BLOCK_MAX; type++)
+    {
+        struct mblock_free *node = (struct mblock_free *)(heap_mem + type * HEAP_SIZE);
+
+        *bases[type] = (uint32_t)(uintptr_t)node;
+        node->corrupt_check = 0xA55A;
+        node->free_size = HEAP_SIZE;
+        node->next = NULL;
+        node->previous = NULL;
+        ke_env.heap[type] = node;
+        ke_env.heap_size[type] = HEAP_SIZE;
+    }
+    ns_heap_stats_reset();
+}
+
+static void *heap_alloc(uint8_t type, uint32_t size)
+{
+    uint16_t total = heap_blk_size(size);
+    struct mblock_free *node = ke_env.heap[type];
+    struct mblock_used *blk;
+
+    while ((node != NULL) && (node->free_size < total))
+    {
+        node = node->next;
+    }
+    CHECK(node != NULL);
+
+    if (node->free_size - total < sizeof(struct mblock_free))
+    {
+        // Too little left for a free block, the whole block goes
+        total = node->free_size;
+        if (node->previous != NULL)
+        {
+            node->previous->next = node->next;
+        }
+        else
+        {
+            ke_env.heap[type] = node->next;
+        }
+        if (node->next != NULL)
+        {
+            node->next->previous = node->previous;
+        }
+        blk = (struct mblock_used *)node;
+    }
+    else
+    {
+        node->free_size -= total;
+        blk = (struct mblock_used *)((uint8_t *)node + node->free_size);
+    }
+    blk->corrupt_check = 0x8338;
+    blk->size = total;
+
+    return blk + 1;
+}
+
+static void heap_free(uint8_t type, void *mem)
+{
+    struct mblock_free *freed = (struct mblock_free *)((struct mblock_used *)mem - 1);
+    struct mblock_free *prev = NULL;
+    struct mblock_free *next = ke_env.heap[type];
+
+    freed->free_size = ((struct mblock_used *)freed)->size;
+    freed->corrupt_check = 0xA55A;
+    while ((next != NULL) && (next < freed))
+    {
+        prev = next;
+        next = next->next;
+    }
+
+    freed->previous = prev;
+    freed->next = next;
+    if (prev != NULL)
+    {
+        prev->next = freed;
+    }
+    else
+    {
+        ke_env.heap[type] = freed;
+    }
+    if (next != NULL)
+    {
+        next->previous = freed;
+    }
+
+    if ((next != NULL) && ((uint8_t *)freed + freed->free_size == (uint8_t *)next))
+    {
+        freed->free_size += next->free_size;
+        freed->next = next->next;
+        if (next->next != NULL)
+        {
+            next->next->previous = freed;
+        }
+    }
+    if ((prev != NULL) && ((uint8_t *)prev + prev->free_size == (uint8_t *)freed))
+    {
+        prev->free_size += freed->free_size;
+        prev->next = freed->next;
+        if (freed->next != NULL)
+        {
+            freed->next->previous = prev;
+        }
+    }
+}
+
+static struct ke_msg *msg_alloc(ke_msg_id_t id, uint16_t param_len)
+{
+    struct ke_msg *msg = heap_alloc(KE_MEM_KE_MSG, sizeof(struct ke_msg) + param_len);
+
+    msg->id = id;
+    msg->param_len = param_len;
+    return msg;
+}
+
+static void test_empty_heap(void)
+{
+    struct ns_heap_stats_t stats;
+
+    heap_init();
+    ns_heap_stats_get(&stats);
+    for (uint8_t type = 0; type < KE_MEM_BLOCK_MAX; type++)
+    {
+        CHECK_EQ(stats.heap[type].size, HEAP_SIZE);
+        CHECK_EQ(stats.heap[type].used, 0);
+        CHECK_EQ(stats.heap[type].free_blocks, 1);
+        CHECK_EQ(stats.heap[type].free_largest, HEAP_SIZE);
+    }
+    CHECK_EQ(stats.samples, 1);
+    CHECK_EQ(stats.corrupt, 0);
+}
+
+/// Use, fragments, largest free block and the marks kept once blocks are freed
+static void test_used_and_fragments(void)
+{
+    struct ns_heap_stats_t stats;
+    const struct ns_heap_type_stats_t *p_env = &stats.heap[KE_MEM_ENV];
+    uint16_t used = heap_blk_size(60) + heap_blk_size(200) + heap_blk_size(28) + heap_blk_size(500);
+    void *a, *b, *c, *d;
+
+    heap_init();
+    // Cut from the end: the free block, d, c, b, a
+    a = heap_alloc(KE_MEM_ENV, 60);
+    b = heap_alloc(KE_MEM_ENV, 200);
+    c = heap_alloc(KE_MEM_ENV, 28);
+    d = heap_alloc(KE_MEM_ENV, 500);
+    ns_heap_sample();
+    ns_heap_stats_get(&stats);
+    CHECK_EQ(p_env->used, used);
+    CHECK_EQ(p_env->used_max, used);
+    CHECK_EQ(p_env->free_blocks, 1);
+    CHECK_EQ(p_env->free_largest, HEAP_SIZE - used);
+    CHECK_EQ(p_env->hist[0], 0);
+    CHECK_EQ(p_env->hist[1], 1);
+    CHECK_EQ(p_env->hist[2], 1);
+    CHECK_EQ(p_env->hist[3], 0);
+    CHECK_EQ(p_env->hist[4], 1);
+    CHECK_EQ(p_env->hist[5], 1);
+
+    // b between two used blocks is a second fragment
+    heap_free(KE_MEM_ENV, b);
+    ns_heap_stats_get(&stats);
+    CHECK_EQ(p_env->used, used - heap_blk_size(200));
+    CHECK_EQ(p_env->used_max, used);
+    CHECK_EQ(p_env->free_blocks, 2);
+    CHECK_EQ(p_env->free_largest, HEAP_SIZE - used);
+    CHECK_EQ(p_env->free_largest_min, HEAP_SIZE - used);
+    CHECK_EQ(p_env->hist[4], 1);
+
+    // All merged back
+    heap_free(KE_MEM_ENV, a);
+    heap_free(KE_MEM_ENV, d);
+    heap_free(KE_MEM_ENV, c);
+    ns_heap_stats_get(&stats);
+    CHECK_EQ(p_env->used, 0);
+    CHECK_EQ(p_env->free_blocks, 1);
+    CHECK_EQ(p_env->free_largest, HEAP_SIZE);
+    CHECK_EQ(p_env->used_max, used);
+    CHECK_EQ(p_env->free_largest_min, HEAP_SIZE - used);
+    CHECK_EQ(stats.samples, 4);
+    CHECK_EQ(stats.heap[KE_MEM_KE_MSG].used_max, 0);
+
+    ns_heap_stats_reset();
+    ns_heap_stats_get(&stats);
+    CHECK_EQ(p_env->used_max, 0);
+    CHECK_EQ(p_env->free_largest_min, HEAP_SIZE);
+    CHECK_EQ(stats.samples, 1);
+}
+
+/// Every other block freed: each one is a fragment, the walk finds them all
+static void test_many_fragments(void)
+{
+    struct ns_heap_stats_t stats;
+    const struct ns_heap_type_stats_t *p_env = &stats.heap[KE_MEM_ENV];
+    uint16_t blk = heap_blk_size(28);
+    void *mem[64];
+
+    heap_init();
+    for (uint8_t i = 0; i < 64; i++)
+    {
+        mem[i] = heap_alloc(KE_MEM_ENV, 28);
+    }
+    // The last block is next to the free block and merges with it
+    for (uint8_t i = 1; i < 64; i += 2)
+    {
+        heap_free(KE_MEM_ENV, mem[i]);
+    }
+    ns_heap_stats_get(&stats);
+    CHECK_EQ(p_env->used, 32 * blk);
+    CHECK_EQ(p_env->free_blocks, 32);
+    CHECK_EQ(p_env->free_largest, HEAP_SIZE - 63 * blk);
+    CHECK_EQ(p_env->hist[1], 32);
+    CHECK_EQ(stats.corrupt, 0);
+}
+
+/// Message heap content by message id, the ids that do not fit are collected in the last entry
+static void test_msg_attribution(void)
+{
+    struct ns_heap_stats_t stats;
+    uint16_t blk = heap_blk_size(sizeof(struct ke_msg) + 12);
+    uint8_t last = NS_HEAP_MSG_ID_NB - 1;
+
+    heap_init();
+    msg_alloc(0x0100, 12);
+    msg_alloc(0x0200, 12);
+    msg_alloc(0x0100, 12);
+    msg_alloc(0x0100, 12);
+    ns_heap_stats_get(&stats);
+    CHECK_EQ(stats.heap[KE_MEM_KE_MSG].used, 4 * blk);
+    CHECK_EQ(stats.msg[0].id, 0x0100);
+    CHECK_EQ(stats.msg[0].count, 3);
+    CHECK_EQ(stats.msg[0].bytes, 3 * blk);
+    CHECK_EQ(stats.msg[1].id, 0x0200);
+    CHECK_EQ(stats.msg[1].count, 1);
+    CHECK_EQ(stats.msg[2].count, 0);
+
+    heap_init();
+    for (uint16_t id = 0; id < NS_HEAP_MSG_ID_NB + 2; id++)
+    {
+        msg_alloc(0x0300 + id, 12);
+    }
+    // Walked from the lowest address, the newest block first
+    ns_heap_stats_get(&stats);
+    CHECK_EQ(stats.msg[0].id, 0x0300 + NS_HEAP_MSG_ID_NB + 1);
+    CHECK_EQ(stats.msg[last - 1].id, 0x0303);
+    CHECK_EQ(stats.msg[last].id, NS_HEAP_MSG_ID_OTHER);
+    CHECK_EQ(stats.msg[last].count, 3);
+    CHECK_EQ(stats.msg[last].bytes, 3 * blk);
+}
+
+/// An impossible block size stops the walk and is counted
+static void test_corrupt_header(void)
+{
+    struct ns_heap_stats_t stats;
+    struct mblock_used *blk;
+
+    heap_init();
+    heap_alloc(KE_MEM_ENV, 60);
+    blk = (struct mblock_used *)heap_alloc(KE_MEM_ENV, 60) - 1;
+    ns_heap_stats_get(&stats);
+    CHECK_EQ(stats.corrupt, 0);
+
+    blk->size = 6;
+    ns_heap_stats_get(&stats);
+    CHECK_EQ(stats.corrupt, 1);
+    // Nothing counted past the bad block
+    CHECK_EQ(stats.heap[KE_MEM_ENV].used, 0);
+
+    blk->size = HEAP_SIZE;
+    ns_heap_stats_get(&stats);
+    CHECK_EQ(stats.corrupt, 2);
+}
+
+int main(void)
+{
+    RUN_TEST(test_empty_heap);
+    RUN_TEST(test_used_and_fragments);
+    RUN_TEST(test_many_fragments);
+    RUN_TEST(test_msg_attribution);
+    RUN_TEST(test_corrupt_header);
+
+    return host_test_failures;
+}
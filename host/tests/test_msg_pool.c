@@ -0,0 +1,223 @@
+/**
+ * @file test_msg_pool.c
+ * @brief ns_msg_pool.c: pool hits, fallback to ke_msg_alloc(), release of pool and heap
+ *        messages, counters, and the KE_MSG_NO_FREE handoff of the HOGPD report requests.
+ *
+ * The handoff goes through the fake HOGPD, its report request handler ends the way the one
+ * of hogpd_task.c does. On the host ke_msg_free() counts the kernel messages, so a pool
+ * message the kernel freed would show in host_ke_msg_live().
+ */
+#include <string.h>
+#include "host_test.h"
+#include "host_ke.h"
+#include "host_app.h"
+#include "fake_hogpd.h"
+#include "global_func.h"
+#include "app_hid.h"
+#include "hogp/hogpd/api/hogpd_task.h"
+#include "ns_msg_pool.h"
+
+HOST_TEST_MAIN();
+
+#define TEST_MSG_ID                 0x4321
+#define TEST_MSG_OTHER_ID           0x4322
+#define TEST_PARAM_MAX              20
+
+static void setup(void)
+{
+    host_ke_reset();
+    ns_msg_pool_delete(HOGPD_REPORT_UPD_REQ);
+    ns_msg_pool_delete(TEST_MSG_ID);
+    ns_msg_pool_delete(TEST_MSG_OTHER_ID);
+}
+
+static void test_create(void)
+{
+    struct ns_msg_pool_stats_t stats;
+
+    setup();
+    CHECK(!ns_msg_pool_create(TEST_MSG_ID, TEST_PARAM_MAX, 0));
+    CHECK(!ns_msg_pool_create(TEST_MSG_ID, TEST_PARAM_MAX, NS_MSG_POOL_SLOT_MAX + 1));
+    CHECK(ns_msg_pool_create(TEST_MSG_ID, TEST_PARAM_MAX, 3));
+    // One pool per id
+    CHECK(!ns_msg_pool_create(TEST_MSG_ID, TEST_PARAM_MAX, 3));
+    CHECK(ns_msg_pool_create(TEST_MSG_OTHER_ID, TEST_PARAM_MAX, 1));
+    // All NS_MSG_POOL_NB entries taken
+    CHECK(!ns_msg_pool_create(HOGPD_REPORT_UPD_REQ, TEST_PARAM_MAX, 1));
+
+    ns_msg_pool_stats_get(TEST_MSG_ID, &stats);
+    CHECK_EQ(stats.slot_nb, 3);
+    CHECK_EQ(stats.in_use, 0);
+
+    ns_msg_pool_delete(TEST_MSG_OTHER_ID);
+    ns_msg_pool_stats_get(TEST_MSG_OTHER_ID, &stats);
+    CHECK_EQ(stats.slot_nb, 0);
+    CHECK(ns_msg_pool_create(HOGPD_REPORT_UPD_REQ, TEST_PARAM_MAX, 1));
+}
+
+/// Idle pool messages are served with the header filled and the parameters cleared
+static void test_pool_hit(void)
+{
+    struct ns_msg_pool_stats_t stats;
+    uint32_t live;
+    uint8_t *param;
+    struct ke_msg *msg;
+
+    setup();
+    CHECK(ns_msg_pool_create(TEST_MSG_ID, TEST_PARAM_MAX, 2));
+    live = host_ke_msg_live();
+
+    param = ns_msg_pool_alloc(TEST_MSG_ID, TASK_APP, HOST_TASK_HOGPD, TEST_PARAM_MAX);
+    memset(param, 0xA5, TEST_PARAM_MAX);
+    CHECK(ns_msg_pool_release(param));
+
+    param = ns_msg_pool_alloc(TEST_MSG_ID, TASK_APP, HOST_TASK_HOGPD, 8);
+    msg = ke_param2msg(param);
+    CHECK_EQ(msg->id, TEST_MSG_ID);
+    CHECK_EQ(msg->dest_id, TASK_APP);
+    CHECK_EQ(msg->src_id, HOST_TASK_HOGPD);
+    CHECK_EQ(msg->param_len, 8);
+    CHECK(msg->hdr.next == KE_MSG_NOT_IN_QUEUE);
+    for (uint8_t i = 0; i < 8; i++)
+    {
+        CHECK_EQ(param[i], 0);
+    }
+    // Not a kernel allocation
+    CHECK_EQ(host_ke_msg_live(), live);
+
+    ns_msg_pool_stats_get(TEST_MSG_ID, &stats);
+    CHECK_EQ(stats.pool_cnt, 2);
+    CHECK_EQ(stats.fallback_cnt, 0);
+    CHECK_EQ(stats.in_use, 1);
+    CHECK_EQ(stats.in_use_max, 1);
+    CHECK(ns_msg_pool_release(param));
+}
+
+/// Pool empty or message too long: ke_msg_alloc(), and the release leaves it to the kernel
+static void test_fallback(void)
+{
+    struct ns_msg_pool_stats_t stats;
+    uint32_t live;
+    void *param[3];
+    void *param_long;
+
+    setup();
+    CHECK(ns_msg_pool_create(TEST_MSG_ID, TEST_PARAM_MAX, 2));
+    live = host_ke_msg_live();
+
+    for (uint8_t i = 0; i < 3; i++)
+    {
+        param[i] = ns_msg_pool_alloc(TEST_MSG_ID, TASK_APP, HOST_TASK_HOGPD, TEST_PARAM_MAX);
+    }
+    param_long = ns_msg_pool_alloc(TEST_MSG_ID, TASK_APP, HOST_TASK_HOGPD, TEST_PARAM_MAX + 1);
+    CHECK_EQ(host_ke_msg_live(), live + 2);
+    CHECK_EQ(ke_param2msg(param_long)->param_len, TEST_PARAM_MAX + 1);
+
+    ns_msg_pool_stats_get(TEST_MSG_ID, &stats);
+    CHECK_EQ(stats.pool_cnt, 2);
+    CHECK_EQ(stats.fallback_cnt, 2);
+    CHECK_EQ(stats.in_use, 2);
+    CHECK_EQ(stats.in_use_max, 2);
+
+    // Heap messages of a pooled id are not taken by the pool
+    CHECK(!ns_msg_pool_release(param[2]));
+    CHECK(!ns_msg_pool_release(param_long));
+    ke_msg_free(ke_param2msg(param[2]));
+    ke_msg_free(ke_param2msg(param_long));
+    CHECK_EQ(host_ke_msg_live(), live);
+
+    CHECK(ns_msg_pool_release(param[0]));
+    // A second release of the same message is refused
+    CHECK(!ns_msg_pool_release(param[0]));
+    CHECK(ns_msg_pool_release(param[1]));
+    ns_msg_pool_stats_get(TEST_MSG_ID, &stats);
+    CHECK_EQ(stats.in_use, 0);
+    CHECK_EQ(stats.in_use_max, 2);
+
+    // Served by the pool again
+    param[0] = ns_msg_pool_alloc(TEST_MSG_ID, TASK_APP, HOST_TASK_HOGPD, TEST_PARAM_MAX);
+    ns_msg_pool_stats_get(TEST_MSG_ID, &stats);
+    CHECK_EQ(stats.pool_cnt, 3);
+    CHECK_EQ(stats.fallback_cnt, 2);
+    CHECK(ns_msg_pool_release(param[0]));
+}
+
+/// A message of an id without pool is always a kernel one
+static void test_foreign_message(void)
+{
+    struct ns_msg_pool_stats_t stats;
+    uint32_t live;
+    void *param;
+
+    setup();
+    CHECK(ns_msg_pool_create(TEST_MSG_ID, TEST_PARAM_MAX, 2));
+    live = host_ke_msg_live();
+
+    param = ns_msg_pool_alloc(TEST_MSG_OTHER_ID, TASK_APP, HOST_TASK_HOGPD, 4);
+    CHECK_EQ(host_ke_msg_live(), live + 1);
+    CHECK(!ns_msg_pool_release(param));
+    ke_msg_free(ke_param2msg(param));
+
+    param = KE_MSG_ALLOC_DYN(TEST_MSG_ID, TASK_APP, HOST_TASK_HOGPD, ke_msg, 4);
+    CHECK(!ns_msg_pool_release(param));
+    ke_msg_free(ke_param2msg(param));
+
+    ns_msg_pool_stats_get(TEST_MSG_ID, &stats);
+    CHECK_EQ(stats.pool_cnt, 0);
+    CHECK_EQ(stats.fallback_cnt, 0);
+    ns_msg_pool_stats_get(TEST_MSG_OTHER_ID, &stats);
+    CHECK_EQ(stats.slot_nb, 0);
+    CHECK_EQ(host_ke_msg_live(), live);
+}
+
+/// Report requests of app_hid come from the pool, the HOGPD handler keeps them from the kernel
+static void test_hogpd_report_no_free(void)
+{
+    uint8_t report[APP_HID_KEYBOARD_REPORT_LEN] = {0};
+    struct ns_msg_pool_stats_t stats;
+    uint32_t live;
+
+    host_ke_reset();
+    host_app_init();
+    fake_hogpd_init();
+    fake_hogpd_direct_enable(false);
+    app_hid_init();
+    app_hid_enable_prf(0);
+    host_ke_run();
+    fake_hogpd_connect(0);
+    live = host_ke_msg_live();
+
+    for (uint8_t i = 0; i < 3; i++)
+    {
+        report[2] = 4 + i;
+        CHECK(app_hid_send_report(APP_HID_KEYBOARD_REPORT_IDX, report, sizeof(report)));
+    }
+    host_ke_run();
+
+    // One notified, HOGPD busy: the others wait in the kernel, still out of the pool
+    CHECK_EQ(fake_hogpd_count(), 1);
+    ns_msg_pool_stats_get(HOGPD_REPORT_UPD_REQ, &stats);
+    CHECK_EQ(stats.pool_cnt, 3);
+    CHECK_EQ(stats.fallback_cnt, 0);
+    CHECK_EQ(stats.in_use, 2);
+
+    fake_hogpd_complete_all();
+    CHECK_EQ(fake_hogpd_count(), 3);
+    ns_msg_pool_stats_get(HOGPD_REPORT_UPD_REQ, &stats);
+    CHECK_EQ(stats.in_use, 0);
+    CHECK_EQ(stats.in_use_max, 3);
+    // Pool messages neither allocated nor freed by the kernel
+    CHECK_EQ(host_ke_msg_live(), live);
+    CHECK_EQ(host_ke_assert_count(), 0);
+}
+
+int main(void)
+{
+    RUN_TEST(test_create);
+    RUN_TEST(test_pool_hit);
+    RUN_TEST(test_fallback);
+    RUN_TEST(test_foreign_message);
+    RUN_TEST(test_hogpd_report_no_free);
+
+    return host_test_failures;
+}
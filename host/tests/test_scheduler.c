@@ -0,0 +1,457 @@
+/**
+ * @file test_scheduler.c
+ * @brief ns_scheduler.c byte ring: FIFO order, reserve/commit/abort, wrap-around with the
+ *        padding slot, and a full ring. Priority levels: order, overtaking, execute budget,
+ *        and the lower levels still served under a sustained load at the higher ones.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "host_test.h"
+#include "ns_scheduler.h"
+
+HOST_TEST_MAIN();
+
+#define TEST_EVENT_SIZE             8
+#define TEST_QUEUE_SIZE             4
+
+/// Bytes one event of TEST_EVENT_SIZE takes in the ring
+#define TEST_STRIDE                 (APP_SCHED_EVENT_HEADER_SIZE + TEST_EVENT_SIZE)
+
+/// Events large enough to leave room for a header at the end of the ring
+#define TEST_PAD_EVENT_SIZE         32
+
+static uint32_t test_buf[CEIL_DIV(APP_SCHED_BUF_SIZE(TEST_PAD_EVENT_SIZE, TEST_QUEUE_SIZE), sizeof(uint32_t))];
+
+/// Events seen by the handler: first payload byte and size
+static uint8_t  test_seen[64];
+static uint16_t test_seen_size[64];
+static uint32_t test_seen_nb;
+
+static void test_handler(void *p_event_data, uint16_t event_size)
+{
+    if (test_seen_nb < sizeof(test_seen))
+    {
+        test_seen[test_seen_nb] = (event_size > 0) ? *(uint8_t *)p_event_data : 0xFF;
+        test_seen_size[test_seen_nb] = event_size;
+    }
+    test_seen_nb++;
+}
+
+static void setup(void)
+{
+    CHECK_EQ(app_sched_init(TEST_EVENT_SIZE, TEST_QUEUE_SIZE, test_buf), 0);
+    test_seen_nb = 0;
+}
+
+static uint32_t put(uint8_t value, uint16_t size)
+{
+    uint8_t data[TEST_PAD_EVENT_SIZE + 1];
+
+    memset(data, value, sizeof(data));
+    return app_sched_event_put(data, size, test_handler);
+}
+
+static void test_init_checks(void)
+{
+    CHECK_EQ(app_sched_init(TEST_EVENT_SIZE, 0, test_buf), 1);
+    CHECK_EQ(app_sched_init(TEST_EVENT_SIZE, TEST_QUEUE_SIZE, (uint8_t *)test_buf + 1), 1);
+    CHECK_EQ(app_sched_queue_init(APP_SCHED_PRIO_NB, TEST_EVENT_SIZE, TEST_QUEUE_SIZE, test_buf), 1);
+    setup();
+    CHECK(!app_sched_pending());
+    CHECK_EQ(app_sched_queue_space_get(), TEST_QUEUE_SIZE);
+}
+
+static void test_fifo(void)
+{
+    app_sched_stats_t stats;
+
+    setup();
+    CHECK_EQ(put(1, 4), 0);
+    CHECK_EQ(put(2, 0), 0);
+    CHECK_EQ(put(3, TEST_EVENT_SIZE), 0);
+    CHECK(app_sched_pending());
+    CHECK_EQ(app_sched_execute_budget(2), 2);
+    CHECK_EQ(app_sched_execute_budget(10), 1);
+    CHECK(!app_sched_pending());
+
+    CHECK_EQ(test_seen_nb, 3);
+    CHECK_EQ(test_seen[0], 1);
+    CHECK_EQ(test_seen_size[0], 4);
+    CHECK_EQ(test_seen[1], 0xFF);
+    CHECK_EQ(test_seen_size[1], 0);
+    CHECK_EQ(test_seen[2], 3);
+    CHECK_EQ(test_seen_size[2], TEST_EVENT_SIZE);
+
+    app_sched_stats_get(APP_SCHED_PRIO_NORMAL, &stats);
+    CHECK_EQ(stats.executed, 3);
+    CHECK_EQ(stats.dropped, 0);
+    CHECK_EQ(stats.high_water, 3 * APP_SCHED_EVENT_HEADER_SIZE + 4 + TEST_EVENT_SIZE);
+}
+
+/// Reserved slots keep their place: later events wait for the commit, an abort is skipped
+static void test_reserve_commit(void)
+{
+    app_sched_stats_t stats;
+    uint8_t *a;
+    uint8_t *b;
+    uint8_t *c;
+
+    setup();
+    CHECK(app_sched_event_reserve(APP_SCHED_PRIO_NORMAL, TEST_EVENT_SIZE + 1) == NULL);
+    // No queue at this level
+    CHECK(app_sched_event_reserve(APP_SCHED_PRIO_NB, 1) == NULL);
+
+    a = app_sched_event_reserve(APP_SCHED_PRIO_NORMAL, TEST_EVENT_SIZE);
+    b = app_sched_event_reserve(APP_SCHED_PRIO_NORMAL, 2);
+    CHECK(a != NULL);
+    CHECK(b != NULL);
+    CHECK_EQ((uintptr_t)a & 3, 0);
+    CHECK_EQ((uintptr_t)b & 3, 0);
+
+    b[0] = 20;
+    // Slots are rounded to 4 bytes, the commit may grow the event up to that
+    CHECK_EQ(app_sched_event_commit(b, 5, test_handler), 1);
+    CHECK_EQ(app_sched_event_commit(b, 2, NULL), 1);
+    CHECK_EQ(app_sched_event_commit(b, 1, test_handler), 0);
+    // a is still being written
+    CHECK(app_sched_pending());
+    CHECK_EQ(app_sched_execute_budget(10), 0);
+    CHECK_EQ(test_seen_nb, 0);
+
+    a[0] = 10;
+    CHECK_EQ(app_sched_event_commit(a, TEST_EVENT_SIZE, test_handler), 0);
+    CHECK_EQ(app_sched_execute_budget(10), 2);
+    CHECK_EQ(test_seen_nb, 2);
+    CHECK_EQ(test_seen[0], 10);
+    CHECK_EQ(test_seen[1], 20);
+    CHECK_EQ(test_seen_size[1], 1);
+
+    c = app_sched_event_reserve(APP_SCHED_PRIO_NORMAL, 4);
+    CHECK_EQ(put(30, 1), 0);
+    app_sched_event_abort(c);
+    CHECK_EQ(app_sched_execute_budget(10), 1);
+    CHECK_EQ(test_seen_nb, 3);
+    CHECK_EQ(test_seen[2], 30);
+    CHECK(!app_sched_pending());
+
+    app_sched_stats_get(APP_SCHED_PRIO_NORMAL, &stats);
+    CHECK_EQ(stats.executed, 3);
+    CHECK_EQ(stats.dropped, 1);
+}
+
+/// QUEUE_SIZE events of the largest size fit, one more is dropped until one is executed
+static void test_full_ring(void)
+{
+    app_sched_stats_t stats;
+    uint8_t i;
+
+    setup();
+    for (i = 0; i < TEST_QUEUE_SIZE; i++)
+    {
+        CHECK_EQ(app_sched_queue_space_get(), TEST_QUEUE_SIZE - i);
+        CHECK_EQ(put(i, TEST_EVENT_SIZE), 0);
+    }
+    CHECK_EQ(app_sched_queue_space_get(), 0);
+    CHECK_EQ(put(0xAA, TEST_EVENT_SIZE), 1);
+
+    app_sched_stats_get(APP_SCHED_PRIO_NORMAL, &stats);
+    CHECK_EQ(stats.dropped, 1);
+    CHECK_EQ(stats.high_water, TEST_QUEUE_SIZE * TEST_STRIDE);
+
+    CHECK_EQ(app_sched_execute_budget(1), 1);
+    CHECK_EQ(app_sched_queue_space_get(), 1);
+    CHECK_EQ(put(TEST_QUEUE_SIZE, TEST_EVENT_SIZE), 0);
+    CHECK_EQ(put(0xAA, TEST_EVENT_SIZE), 1);
+
+    CHECK_EQ(app_sched_execute_budget(10), TEST_QUEUE_SIZE);
+    CHECK_EQ(test_seen_nb, TEST_QUEUE_SIZE + 1);
+    for (i = 0; i <= TEST_QUEUE_SIZE; i++)
+    {
+        CHECK_EQ(test_seen[i], i);
+    }
+
+    // Events only take their own size, more small ones fit
+    setup();
+    for (i = 0; put(i, 0) == 0; i++)
+    {
+    }
+    CHECK(i > TEST_QUEUE_SIZE);
+    CHECK_EQ(app_sched_execute_budget(0xFFFF), i);
+}
+
+/**
+ * Fill 4 of the TEST_QUEUE_SIZE + 1 strides of the ring, run 2, put a 4 byte event: the tail
+ * has one stride left minus that event. The next large event goes to the start of the ring.
+ */
+static void wrap_check(uint16_t event_size)
+{
+    app_sched_stats_t stats;
+
+    // Nothing left of an earlier test that would read as a header past the ring
+    memset(test_buf, 0, sizeof(test_buf));
+    CHECK_EQ(app_sched_init(event_size, TEST_QUEUE_SIZE, test_buf), 0);
+    test_seen_nb = 0;
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        CHECK_EQ(put(i, event_size), 0);
+    }
+    CHECK_EQ(app_sched_execute_budget(2), 2);
+    CHECK_EQ(put(4, 4), 0);
+    CHECK_EQ(put(5, event_size), 0);
+    // One stride between the write and the read offsets is full
+    CHECK_EQ(put(6, event_size), 1);
+    CHECK_EQ(app_sched_execute_budget(10), 4);
+
+    CHECK_EQ(test_seen_nb, 6);
+    for (uint8_t i = 0; i < 6; i++)
+    {
+        CHECK_EQ(test_seen[i], i);
+    }
+    CHECK_EQ(test_seen_size[4], 4);
+    CHECK_EQ(test_seen_size[5], event_size);
+    CHECK(!app_sched_pending());
+
+    // The skipped end of the ring is not an event
+    app_sched_stats_get(APP_SCHED_PRIO_NORMAL, &stats);
+    CHECK_EQ(stats.executed, 6);
+    CHECK_EQ(stats.dropped, 1);
+}
+
+/// The end of the ring is shorter than a header, the consumer wraps on its own
+static void test_wrap_short_tail(void)
+{
+    CHECK(TEST_EVENT_SIZE - 4 < APP_SCHED_EVENT_HEADER_SIZE);
+    wrap_check(TEST_EVENT_SIZE);
+}
+
+/// The end of the ring holds a header, it becomes a skipped slot
+static void test_wrap_padding(void)
+{
+    CHECK(TEST_PAD_EVENT_SIZE - 4 >= APP_SCHED_EVENT_HEADER_SIZE);
+    wrap_check(TEST_PAD_EVENT_SIZE);
+}
+
+/// Random sizes and batches: every accepted event comes out once, in order, with its data
+static void test_wrap_random(void)
+{
+    uint32_t put_nb = 0;
+    uint32_t dropped = 0;
+    uint32_t next = 0;
+    uint8_t *slot;
+    uint16_t size;
+    app_sched_stats_t stats;
+
+    setup();
+    srand(9);
+    for (uint32_t round = 0; round < 2000; round++)
+    {
+        uint32_t n = rand() % 4;
+
+        for (uint32_t k = 0; k < n; k++)
+        {
+            size = 1 + rand() % TEST_EVENT_SIZE;
+            if (rand() & 1)
+            {
+                if (put((uint8_t)put_nb, size) != 0)
+                {
+                    dropped++;
+                    continue;
+                }
+            }
+            else
+            {
+                slot = app_sched_event_reserve(APP_SCHED_PRIO_NORMAL, TEST_EVENT_SIZE);
+                if (slot == NULL)
+                {
+                    dropped++;
+                    continue;
+                }
+                memset(slot, (uint8_t)put_nb, size);
+                CHECK_EQ(app_sched_event_commit(slot, size, test_handler), 0);
+            }
+            put_nb++;
+        }
+
+        n = rand() % 4;
+        for (uint32_t k = 0; k < n; k++)
+        {
+            test_seen_nb = 0;
+            if (app_sched_execute_budget(1) == 0)
+            {
+                break;
+            }
+            CHECK_EQ(test_seen[0], (uint8_t)next);
+            next++;
+        }
+    }
+    while (app_sched_pending())
+    {
+        test_seen_nb = 0;
+        CHECK_EQ(app_sched_execute_budget(1), 1);
+        CHECK_EQ(test_seen[0], (uint8_t)next);
+        next++;
+    }
+
+    CHECK_EQ(next, put_nb);
+    // The ring went round many times
+    CHECK(put_nb > 50 * TEST_QUEUE_SIZE);
+    CHECK(dropped > 0);
+    app_sched_stats_get(APP_SCHED_PRIO_NORMAL, &stats);
+    CHECK_EQ(stats.executed, put_nb);
+    CHECK_EQ(stats.dropped, dropped);
+    CHECK(stats.high_water < sizeof(test_buf));
+}
+
+static uint32_t prio_buf[APP_SCHED_PRIO_NB][CEIL_DIV(APP_SCHED_BUF_SIZE(4, 8), sizeof(uint32_t))];
+
+/// Events run per level, and whether each level posts a new event from its handler
+static uint32_t prio_run[APP_SCHED_PRIO_NB];
+static bool     prio_repost[APP_SCHED_PRIO_NB];
+
+static void prio_handler(void *p_event_data, uint16_t event_size)
+{
+    uint8_t prio = *(uint8_t *)p_event_data;
+
+    test_handler(p_event_data, event_size);
+    prio_run[prio]++;
+    if (prio_repost[prio])
+    {
+        CHECK_EQ(app_sched_event_put_prio(prio, &prio, 1, prio_handler), 0);
+    }
+}
+
+static void prio_setup(void)
+{
+    for (uint8_t prio = 0; prio < APP_SCHED_PRIO_NB; prio++)
+    {
+        CHECK_EQ(app_sched_queue_init(prio, 4, 8, prio_buf[prio]), 0);
+        prio_run[prio] = 0;
+        prio_repost[prio] = false;
+    }
+    test_seen_nb = 0;
+}
+
+static void prio_put(uint8_t prio)
+{
+    CHECK_EQ(app_sched_event_put_prio(prio, &prio, 1, prio_handler), 0);
+}
+
+static void test_priority_order(void)
+{
+    prio_setup();
+    prio_put(APP_SCHED_PRIO_LOW);
+    prio_put(APP_SCHED_PRIO_NORMAL);
+    prio_put(APP_SCHED_PRIO_HIGH);
+    prio_put(APP_SCHED_PRIO_LOW);
+    prio_put(APP_SCHED_PRIO_HIGH);
+    prio_put(APP_SCHED_PRIO_NORMAL);
+    CHECK_EQ(app_sched_execute_budget(10), 6);
+
+    CHECK_EQ(test_seen[0], APP_SCHED_PRIO_HIGH);
+    CHECK_EQ(test_seen[1], APP_SCHED_PRIO_HIGH);
+    CHECK_EQ(test_seen[2], APP_SCHED_PRIO_NORMAL);
+    CHECK_EQ(test_seen[3], APP_SCHED_PRIO_NORMAL);
+    CHECK_EQ(test_seen[4], APP_SCHED_PRIO_LOW);
+    CHECK_EQ(test_seen[5], APP_SCHED_PRIO_LOW);
+}
+
+static void overtake_handler(void *p_event_data, uint16_t event_size)
+{
+    prio_handler(p_event_data, event_size);
+    // As an interrupt would while the main loop runs the backlog
+    prio_put(APP_SCHED_PRIO_HIGH);
+}
+
+/// A high event posted while a lower backlog is run goes next
+static void test_priority_overtake(void)
+{
+    uint8_t prio = APP_SCHED_PRIO_LOW;
+
+    prio_setup();
+    CHECK_EQ(app_sched_event_put_prio(APP_SCHED_PRIO_LOW, &prio, 1, overtake_handler), 0);
+    prio_put(APP_SCHED_PRIO_LOW);
+    CHECK_EQ(app_sched_execute_budget(10), 3);
+    CHECK_EQ(test_seen[0], APP_SCHED_PRIO_LOW);
+    CHECK_EQ(test_seen[1], APP_SCHED_PRIO_HIGH);
+    CHECK_EQ(test_seen[2], APP_SCHED_PRIO_LOW);
+}
+
+/// app_sched_execute() returns to the main loop after APP_SCHED_EXECUTE_BUDGET events
+static void test_execute_budget(void)
+{
+    prio_setup();
+    for (uint8_t i = 0; i < 8; i++)
+    {
+        prio_put(APP_SCHED_PRIO_HIGH);
+        prio_put(APP_SCHED_PRIO_NORMAL);
+    }
+    app_sched_execute();
+    CHECK_EQ(test_seen_nb, APP_SCHED_EXECUTE_BUDGET);
+    CHECK(app_sched_pending());
+    CHECK_EQ(app_sched_execute_budget(0xFFFF), 16 - APP_SCHED_EXECUTE_BUDGET);
+    CHECK(!app_sched_pending());
+}
+
+/// A high level that always has an event waiting lets the lower ones run every STARVE_LIMIT events
+static void test_starvation_high_load(void)
+{
+    prio_setup();
+    prio_repost[APP_SCHED_PRIO_HIGH] = true;
+    prio_put(APP_SCHED_PRIO_HIGH);
+    prio_put(APP_SCHED_PRIO_NORMAL);
+    prio_put(APP_SCHED_PRIO_LOW);
+
+    CHECK_EQ(app_sched_execute_budget(APP_SCHED_STARVE_LIMIT + 2), APP_SCHED_STARVE_LIMIT + 2);
+    for (uint8_t i = 0; i < APP_SCHED_STARVE_LIMIT; i++)
+    {
+        CHECK_EQ(test_seen[i], APP_SCHED_PRIO_HIGH);
+    }
+    CHECK_EQ(test_seen[APP_SCHED_STARVE_LIMIT], APP_SCHED_PRIO_NORMAL);
+    CHECK_EQ(test_seen[APP_SCHED_STARVE_LIMIT + 1], APP_SCHED_PRIO_LOW);
+    CHECK_EQ(prio_run[APP_SCHED_PRIO_NORMAL], 1);
+    CHECK_EQ(prio_run[APP_SCHED_PRIO_LOW], 1);
+
+    // Only the high level is left, it keeps running
+    CHECK_EQ(app_sched_execute_budget(100), 100);
+    CHECK_EQ(prio_run[APP_SCHED_PRIO_HIGH], APP_SCHED_STARVE_LIMIT + 100);
+}
+
+/// Every level always loaded: each lower level gets one event per STARVE_LIMIT higher ones
+static void test_starvation_all_loaded(void)
+{
+    const uint32_t n = 100 * (APP_SCHED_STARVE_LIMIT + 2);
+
+    prio_setup();
+    for (uint8_t prio = 0; prio < APP_SCHED_PRIO_NB; prio++)
+    {
+        prio_repost[prio] = true;
+        prio_put(prio);
+    }
+    for (uint32_t i = 0; i < n; i += APP_SCHED_EXECUTE_BUDGET)
+    {
+        app_sched_execute();
+    }
+
+    CHECK_EQ(prio_run[APP_SCHED_PRIO_HIGH] + prio_run[APP_SCHED_PRIO_NORMAL] + prio_run[APP_SCHED_PRIO_LOW], n);
+    CHECK(prio_run[APP_SCHED_PRIO_NORMAL] >= 99);
+    CHECK(prio_run[APP_SCHED_PRIO_LOW] >= 99);
+    CHECK(prio_run[APP_SCHED_PRIO_HIGH] >= 99 * APP_SCHED_STARVE_LIMIT);
+}
+
+int main(void)
+{
+    RUN_TEST(test_init_checks);
+    RUN_TEST(test_fifo);
+    RUN_TEST(test_reserve_commit);
+    RUN_TEST(test_full_ring);
+    RUN_TEST(test_wrap_short_tail);
+    RUN_TEST(test_wrap_padding);
+    RUN_TEST(test_wrap_random);
+    RUN_TEST(test_priority_order);
+    RUN_TEST(test_priority_overtake);
+    RUN_TEST(test_execute_budget);
+    RUN_TEST(test_starvation_high_load);
+    RUN_TEST(test_starvation_all_loaded);
+
+    return host_test_failures;
+}
@@ -0,0 +1,353 @@
+/**
+ * @file test_timer.c
+ * @brief ns_timer wheel: expiry times across the levels and their cascades, timers past the
+ *        wheel range, periodic re-arm, cancel and create from a callback, and the wrap of
+ *        the millisecond and BLE half-slot clocks.
+ *
+ * The wheel counts milliseconds from the BLE half-slot clock, its ticks are not aligned with
+ * the start of a test: an expiry is checked to +/-1 ms, the periodic timers over many periods
+ * so that a drift shows.
+ */
+#include <string.h>
+#include "host_test.h"
+#include "host_ke.h"
+#include "host_app.h"
+#include "ns_timer.h"
+
+HOST_TEST_MAIN();
+
+/// Wheel range and the slot size of its levels (ns_timer.c)
+#define WHEEL_RANGE_MS              (1UL << 20)
+
+#define FIRE_MAX                    256
+
+struct fire
+{
+    timer_hnd_t id;
+    uintptr_t context;
+    uint64_t us;
+};
+
+static struct fire fired[FIRE_MAX];
+static uint32_t fired_nb;
+
+/// Time of the first ns_timer call, the wheel clock counts from there
+static bool wheel_started;
+static uint64_t wheel_start_us;
+
+/// What the callback does besides recording
+static timer_hnd_t cb_cancel = NS_TIMER_INVALID_HANDLER;
+static uint32_t cb_create_delay;
+static timer_hnd_t cb_created = NS_TIMER_INVALID_HANDLER;
+
+static void fire_record(timer_hnd_t timer_id, void *p_context)
+{
+    if (fired_nb < FIRE_MAX)
+    {
+        fired[fired_nb].id = timer_id;
+        fired[fired_nb].context = (uintptr_t)p_context;
+        fired[fired_nb].us = host_ke_now_us();
+    }
+    fired_nb++;
+}
+
+static void ctx_callback(timer_hnd_t timer_id, void *p_context)
+{
+    fire_record(timer_id, p_context);
+}
+
+static void legacy_callback(void)
+{
+    fire_record(NS_TIMER_INVALID_HANDLER, NULL);
+}
+
+/// Two timers due at the same tick, each cancels the other
+static timer_hnd_t pair[2];
+
+static void pair_callback(timer_hnd_t timer_id, void *p_context)
+{
+    fire_record(timer_id, p_context);
+    ns_timer_cancel(pair[(timer_id == pair[0]) ? 1 : 0]);
+}
+
+/// Cancels cb_cancel, or itself if NS_TIMER_INVALID_HANDLER, and starts a one-shot timer if asked
+static void cancel_callback(timer_hnd_t timer_id, void *p_context)
+{
+    fire_record(timer_id, p_context);
+    ns_timer_cancel((cb_cancel != NS_TIMER_INVALID_HANDLER) ? cb_cancel : timer_id);
+    cb_cancel = NS_TIMER_INVALID_HANDLER;
+    if (cb_create_delay != 0)
+    {
+        cb_created = ns_timer_start(cb_create_delay, 0, ctx_callback, (void *)0xC0);
+        cb_create_delay = 0;
+    }
+}
+
+static void setup(void)
+{
+    ns_timer_cancel_all();
+    host_ke_reset();
+    host_app_init();
+    fired_nb = 0;
+    cb_cancel = NS_TIMER_INVALID_HANDLER;
+    cb_create_delay = 0;
+    if (!wheel_started)
+    {
+        wheel_started = true;
+        wheel_start_us = host_ke_now_us();
+    }
+}
+
+static timer_hnd_t start(uint32_t delay, uint32_t period, uintptr_t context)
+{
+    timer_hnd_t timer_id = ns_timer_start(delay, period, ctx_callback, (void *)context);
+
+    CHECK(timer_id != NS_TIMER_INVALID_HANDLER);
+    return timer_id;
+}
+
+/// Milliseconds from t0 to an expiry
+static uint32_t fired_ms(uint32_t idx, uint64_t t0)
+{
+    return (uint32_t)((fired[idx].us - t0 + 500) / 1000);
+}
+
+/// Expiry idx came delay ms after t0, to the tick of the wheel
+#define CHECK_FIRED(idx, t0, delay)                                                     \
+    CHECK((fired_ms((idx), (t0)) + 1 >= (delay)) && (fired_ms((idx), (t0)) <= (delay) + 1))
+
+/// One-shot timers on every level and on the slot boundaries of each, fired in order at their time
+static void test_one_shot_levels(void)
+{
+    static const uint32_t delay[] =
+    {
+        1, 2, 31, 32, 33, 1023, 1024, 1025, 1056, 32767, 32768, 32769, 33792, 70000, WHEEL_RANGE_MS - 1,
+    };
+    const uint8_t nb = sizeof(delay) / sizeof(delay[0]);
+    uint64_t t0;
+
+    setup();
+    host_ke_advance(123456);
+    t0 = host_ke_now_us();
+    // Started from the longest, linked in the reverse order of expiry
+    for (int8_t i = nb - 1; i >= 0; i--)
+    {
+        start(delay[i], 0, i);
+    }
+    host_ke_advance(WHEEL_RANGE_MS * 1000ULL - 2000);
+    CHECK_EQ(fired_nb, nb - 1);
+    host_ke_advance(2000);
+    CHECK_EQ(fired_nb, nb);
+
+    for (uint8_t i = 0; i < nb; i++)
+    {
+        CHECK_EQ(fired[i].context, i);
+        CHECK_FIRED(i, t0, delay[i]);
+        CHECK(!ns_timer_is_active(fired[i].id));
+    }
+    CHECK_EQ(host_ke_assert_count(), 0);
+}
+
+/// Beyond the range of the wheel the timer is parked at the top and linked again
+static void test_past_wheel_range(void)
+{
+    const uint32_t delay = 3 * WHEEL_RANGE_MS + 777;
+    uint64_t t0;
+
+    setup();
+    t0 = host_ke_now_us();
+    start(delay, 0, 1);
+    // Kernel timers are cut at one hour, the wheel waits in several rounds
+    start(5000000, 0, 2);
+    for (uint32_t s = 0; s < 5001; s++)
+    {
+        host_ke_advance(1000000);
+    }
+    CHECK_EQ(fired_nb, 2);
+    CHECK_EQ(fired[0].context, 1);
+    CHECK_FIRED(0, t0, delay);
+    CHECK_EQ(fired[1].context, 2);
+    CHECK_FIRED(1, t0, 5000000);
+}
+
+/// Periodic timers are linked again at expiry + period, also when the period crosses levels
+static void test_periodic(void)
+{
+    uint64_t t0;
+    timer_hnd_t fast;
+    timer_hnd_t slow;
+
+    setup();
+    t0 = host_ke_now_us();
+    fast = start(10, 25, 1);
+    slow = start(1500, 1500, 2);
+    CHECK(ns_timer_create(40, legacy_callback) != NS_TIMER_INVALID_HANDLER);
+    host_ke_advance(4600 * 1000);
+
+    // fast at 10, 35, ... 4585, slow at 1500, 3000, 4500, the legacy one at 40
+    CHECK_EQ(fired_nb, 184 + 3 + 1);
+    for (uint32_t i = 0, n_fast = 0, n_slow = 0; i < fired_nb; i++)
+    {
+        if (fired[i].context == 1)
+        {
+            CHECK_EQ(fired[i].id, fast);
+            CHECK_FIRED(i, t0, 10 + 25 * n_fast);
+            n_fast++;
+        }
+        else if (fired[i].context == 2)
+        {
+            CHECK_EQ(fired[i].id, slow);
+            n_slow++;
+            CHECK_FIRED(i, t0, 1500 * n_slow);
+        }
+        else if (i < FIRE_MAX)
+        {
+            CHECK_EQ(fired[i].id, NS_TIMER_INVALID_HANDLER);
+            CHECK_FIRED(i, t0, 40);
+        }
+    }
+    CHECK(ns_timer_is_active(fast));
+    CHECK(ns_timer_is_active(slow));
+
+    // A late wheel runs a periodic timer once and drops the periods it missed
+    fired_nb = 0;
+    ns_timer_cancel(fast);
+    host_ke_stall(5000 * 1000);
+    host_ke_advance(1000);
+    CHECK_EQ(fired_nb, 1);
+    t0 = fired[0].us;
+    host_ke_advance(1500 * 1000);
+    CHECK_EQ(fired_nb, 2);
+    CHECK_FIRED(1, t0, 1500);
+}
+
+/// A callback cancelling itself, a timer due at the same tick, a later one, and starting a new one
+static void test_cancel_in_callback(void)
+{
+    uint64_t t0;
+    timer_hnd_t self;
+    timer_hnd_t later;
+
+    setup();
+    t0 = host_ke_now_us();
+    self = ns_timer_start(20, 20, cancel_callback, (void *)1);
+    host_ke_advance(100 * 1000);
+    CHECK_EQ(fired_nb, 1);
+    CHECK(!ns_timer_is_active(self));
+
+    // Both due at 50 and at 5, the one run first cancels the other, in a cascaded slot and not
+    for (uint8_t i = 0; i < 2; i++)
+    {
+        fired_nb = 0;
+        pair[0] = ns_timer_start((i == 0) ? 50 : 5, 0, pair_callback, (void *)2);
+        pair[1] = ns_timer_start((i == 0) ? 50 : 5, 0, pair_callback, (void *)2);
+        host_ke_advance(200 * 1000);
+        CHECK_EQ(fired_nb, 1);
+        CHECK(!ns_timer_is_active(pair[0]));
+        CHECK(!ns_timer_is_active(pair[1]));
+        CHECK_EQ(host_ke_assert_count(), 0);
+    }
+
+    // Cancel a timer on an upper level, start a new one in its place
+    fired_nb = 0;
+    t0 = host_ke_now_us();
+    later = start(5000, 0, 3);
+    self = ns_timer_start(30, 30, cancel_callback, (void *)1);
+    cb_cancel = later;
+    cb_create_delay = 70;
+    host_ke_advance(10000 * 1000);
+    CHECK_EQ(fired_nb, 3);
+    CHECK_EQ(fired[0].context, 1);
+    CHECK_FIRED(0, t0, 30);
+    // Still periodic after its first call, it cancels itself on the second
+    CHECK_EQ(fired[1].context, 1);
+    CHECK_FIRED(1, t0, 60);
+    CHECK_EQ(fired[2].context, 0xC0);
+    CHECK_EQ(fired[2].id, cb_created);
+    CHECK_FIRED(2, t0, 100);
+    CHECK(!ns_timer_is_active(self));
+    CHECK(!ns_timer_is_active(cb_created));
+    CHECK_EQ(host_ke_assert_count(), 0);
+}
+
+/// Timers across the wrap of the 32 bit millisecond clock, and of the BLE half-slot clock on the way
+static void test_clock_wrap(void)
+{
+    const uint64_t wrap_us = wheel_start_us + (1ULL << 32) * 1000;
+    static const uint32_t delay[] = {30, 60, 90, 1500, 40000};
+    const uint8_t nb = sizeof(delay) / sizeof(delay[0]);
+    uint64_t t0;
+    timer_hnd_t periodic;
+
+    setup();
+    // The wheel reads the half-slot clock more often than it wraps, about every 23 hours
+    while (host_ke_now_us() + 3600000000ULL < wrap_us - 45000)
+    {
+        host_ke_advance(3600000000UL);
+        ns_timer_cancel(start(1, 0, 0));
+    }
+    host_ke_advance((uint32_t)(wrap_us - 45000 - host_ke_now_us()));
+    CHECK_EQ(fired_nb, 0);
+
+    t0 = host_ke_now_us();
+    for (uint8_t i = 0; i < nb; i++)
+    {
+        start(delay[i], 0, i + 1);
+    }
+    periodic = start(7, 7, 0x70);
+    host_ke_advance(100 * 1000);
+    ns_timer_cancel(periodic);
+    host_ke_advance(50000 * 1000);
+
+    for (uint32_t i = 0, n = 0, k = 0; i < fired_nb; i++)
+    {
+        if (fired[i].context == 0x70)
+        {
+            n++;
+            CHECK_FIRED(i, t0, 7 * n);
+        }
+        else
+        {
+            CHECK_EQ(fired[i].context, k + 1);
+            CHECK_FIRED(i, t0, delay[k]);
+            k++;
+        }
+    }
+    CHECK_EQ(fired_nb, nb + 100 / 7);
+    CHECK_EQ(host_ke_assert_count(), 0);
+}
+
+/// Every handler can run at the same time, and is given back
+static void test_pool(void)
+{
+    timer_hnd_t ids[NS_TIMER_MAX_NUM];
+
+    setup();
+    for (uint8_t i = 0; i < NS_TIMER_MAX_NUM; i++)
+    {
+        ids[i] = start(100 + i, 0, i);
+    }
+    CHECK(ns_timer_start(1, 0, ctx_callback, NULL) == NS_TIMER_INVALID_HANDLER);
+    host_ke_advance(200 * 1000);
+    CHECK_EQ(fired_nb, NS_TIMER_MAX_NUM);
+    for (uint8_t i = 0; i < NS_TIMER_MAX_NUM; i++)
+    {
+        CHECK(!ns_timer_is_active(ids[i]));
+    }
+    for (uint8_t i = 0; i < NS_TIMER_MAX_NUM; i++)
+    {
+        CHECK(start(1, 0, i) != NS_TIMER_INVALID_HANDLER);
+    }
+}
+
+int main(void)
+{
+    RUN_TEST(test_one_shot_levels);
+    RUN_TEST(test_past_wheel_range);
+    RUN_TEST(test_periodic);
+    RUN_TEST(test_cancel_in_callback);
+    RUN_TEST(test_clock_wrap);
+    RUN_TEST(test_pool);
+
+    return host_test_failures;
+}
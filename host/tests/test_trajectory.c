@@ -0,0 +1,251 @@
+/**
+ * @file test_trajectory.c
+ * @brief Q15 trajectory primitives against 64-bit and double references, over their full range.
+ */
+#include <math.h>
+#include <stdlib.h>
+#include "host_test.h"
+#include "app_trajectory.h"
+
+HOST_TEST_MAIN();
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/// Floor division, what an arithmetic right shift does on negative values
+static int64_t floor_div(int64_t num, int64_t den)
+{
+    int64_t q = num / den;
+
+    return ((num % den != 0) && ((num < 0) != (den < 0))) ? (q - 1) : q;
+}
+
+static void test_progress(void)
+{
+    for (uint16_t steps = 1; steps <= 255; steps++)
+    {
+        uint16_t last = 0;
+
+        CHECK_EQ(app_traj_progress(0, steps), 0);
+        CHECK_EQ(app_traj_progress(steps, steps), APP_TRAJ_ONE);
+        for (uint16_t step = 1; step <= steps; step++)
+        {
+            uint16_t t = app_traj_progress(step, steps);
+
+            CHECK(t > last);
+            CHECK_EQ(t, (step == steps) ? APP_TRAJ_ONE : ((uint32_t)step << 15) / steps);
+            last = t;
+        }
+    }
+    CHECK_EQ(app_traj_progress(3, 0), APP_TRAJ_ONE);
+}
+
+static void test_ease_endpoints_and_range(void)
+{
+    for (uint8_t ease = APP_TRAJ_EASE_LINEAR; ease <= APP_TRAJ_EASE_IN_OUT; ease++)
+    {
+        uint16_t last = 0;
+        int fails = 0;
+
+        CHECK_EQ(app_traj_ease(ease, 0), 0);
+        CHECK_EQ(app_traj_ease(ease, APP_TRAJ_ONE), APP_TRAJ_ONE);
+        // Progress past the end is clamped
+        CHECK_EQ(app_traj_ease(ease, APP_TRAJ_ONE + 1), APP_TRAJ_ONE);
+        CHECK_EQ(app_traj_ease(ease, 0xFFFF), APP_TRAJ_ONE);
+
+        for (uint32_t t = 0; t <= APP_TRAJ_ONE; t++)
+        {
+            uint16_t e = app_traj_ease(ease, (uint16_t)t);
+
+            // Never goes back, never past the end
+            if ((e < last) || (e > APP_TRAJ_ONE))
+            {
+                fails++;
+            }
+            last = e;
+        }
+        CHECK_EQ(fails, 0);
+    }
+}
+
+static void test_ease_exact(void)
+{
+    int fails = 0;
+
+    // Exact floors computed in 64 bits: any wrap of the 32-bit intermediates would show
+    for (int64_t t = 0; t <= APP_TRAJ_ONE; t++)
+    {
+        int64_t in     = (t * t) >> 15;
+        int64_t out    = APP_TRAJ_ONE - (((APP_TRAJ_ONE - t) * (APP_TRAJ_ONE - t)) >> 15);
+        int64_t in_out = (t * t * (3 * APP_TRAJ_ONE - 2 * t)) >> 30;
+
+        fails += (app_traj_ease(APP_TRAJ_EASE_LINEAR, (uint16_t)t) != t);
+        fails += (app_traj_ease(APP_TRAJ_EASE_IN, (uint16_t)t) != in);
+        fails += (app_traj_ease(APP_TRAJ_EASE_OUT, (uint16_t)t) != out);
+        fails += (app_traj_ease(APP_TRAJ_EASE_IN_OUT, (uint16_t)t) != in_out);
+        // Within 1 LSB of the real curve
+        fails += (fabs(app_traj_ease(APP_TRAJ_EASE_IN_OUT, (uint16_t)t)
+                       - APP_TRAJ_ONE * (3.0 * pow(t / 32768.0, 2) - 2.0 * pow(t / 32768.0, 3))) >= 1.0);
+    }
+    CHECK_EQ(fails, 0);
+
+    // Smoothstep is symmetric around the middle
+    CHECK_EQ(app_traj_ease(APP_TRAJ_EASE_IN_OUT, APP_TRAJ_ONE / 2), APP_TRAJ_ONE / 2);
+}
+
+static void test_sin_cos(void)
+{
+    int fails = 0;
+    int max_err = 0;
+
+    CHECK_EQ(app_traj_sin(0), 0);
+    CHECK_EQ(app_traj_sin(0x4000), 32767);
+    CHECK_EQ(app_traj_sin(0x8000), 0);
+    CHECK_EQ(app_traj_sin(0xC000), -32767);
+    CHECK_EQ(app_traj_cos(0), 32767);
+    CHECK_EQ(app_traj_cos(0x8000), -32767);
+
+    for (uint32_t a = 0; a <= 0xFFFF; a++)
+    {
+        int err = abs(app_traj_sin((uint16_t)a) - (int)lround(32767.0 * sin(a * M_PI / 32768.0)));
+
+        if (err > max_err)
+        {
+            max_err = err;
+        }
+        // Odd and shifted by a quarter turn
+        fails += (app_traj_sin((uint16_t)(0x10000 - a)) != -app_traj_sin((uint16_t)a));
+        fails += (app_traj_cos((uint16_t)a) != app_traj_sin((uint16_t)(a + 0x4000)));
+    }
+    CHECK_EQ(fails, 0);
+    CHECK(max_err <= 3);
+}
+
+static void test_turn(void)
+{
+    static const int16_t degrees[] = {0, 1, -1, 45, 90, -90, 179, 180, 359, 360, -360, 720, -1080,
+                                      32767, -32768};
+    int fails = 0;
+
+    // Whole turns land exactly on the binary angle
+    CHECK_EQ(app_traj_turn(90, APP_TRAJ_ONE), APP_TRAJ_DEG(90));
+    CHECK_EQ(app_traj_turn(-90, APP_TRAJ_ONE), APP_TRAJ_DEG(-90));
+    CHECK_EQ(app_traj_turn(180, APP_TRAJ_ONE), 0x8000);
+    CHECK_EQ(app_traj_turn(360, APP_TRAJ_ONE), 0);
+    CHECK_EQ(app_traj_turn(-360, APP_TRAJ_ONE), 0);
+    CHECK_EQ(app_traj_turn(1, APP_TRAJ_ONE), 182);
+
+    for (size_t i = 0; i < sizeof(degrees) / sizeof(degrees[0]); i++)
+    {
+        for (uint32_t t = 0; t <= APP_TRAJ_ONE; t++)
+        {
+            int64_t exact = ((int64_t)degrees[i] * t) / 180;
+
+            // deg * t / 180 rounds toward zero, as the 64-bit product would
+            fails += (app_traj_turn(degrees[i], (uint16_t)t) != (uint16_t)exact);
+            // so a turn and its opposite are mirrored
+            fails += ((uint16_t)(app_traj_turn(degrees[i], (uint16_t)t)
+                                 + app_traj_turn((int16_t)-degrees[i], (uint16_t)t)) != 0)
+                     && (degrees[i] != -32768);
+        }
+    }
+    CHECK_EQ(fails, 0);
+}
+
+static void test_lerp_overflow_boundary(void)
+{
+    // |b - a| up to 65535: (b - a) * t peaks at 65535 * 32768 = 2^31 - 32768
+    static const int32_t ends[][2] = {
+        {0, 65535}, {65535, 0}, {-32768, 32767}, {32767, -32768}, {0, 0}, {100, 101},
+        {-65535, 0}, {1000000, 1000000 + 65535}, {1000000 + 65535, 1000000},
+    };
+    int fails = 0;
+
+    for (size_t i = 0; i < sizeof(ends) / sizeof(ends[0]); i++)
+    {
+        int32_t a = ends[i][0];
+        int32_t b = ends[i][1];
+
+        CHECK_EQ(app_traj_lerp(a, b, 0), a);
+        CHECK_EQ(app_traj_lerp(a, b, APP_TRAJ_ONE), b);
+        for (int64_t t = 0; t <= APP_TRAJ_ONE; t++)
+        {
+            fails += (app_traj_lerp(a, b, (uint16_t)t) != a + floor_div((int64_t)(b - a) * t, APP_TRAJ_ONE));
+        }
+    }
+    CHECK_EQ(fails, 0);
+}
+
+static void test_arc(void)
+{
+    app_traj_point_t p;
+    int fails = 0;
+
+    app_traj_arc(16000, 16000, 10000, APP_TRAJ_DEG(0), &p);
+    CHECK(abs(p.x - 26000) <= 1);
+    CHECK_EQ(p.y, 16000);
+    app_traj_arc(16000, 16000, 10000, APP_TRAJ_DEG(90), &p);
+    CHECK_EQ(p.x, 16000);
+    CHECK(abs(p.y - 26000) <= 1);
+    app_traj_arc(16000, 16000, 10000, APP_TRAJ_DEG(180), &p);
+    CHECK(abs(p.x - 6000) <= 1);
+    app_traj_arc(16000, 16000, 10000, APP_TRAJ_DEG(270), &p);
+    CHECK(abs(p.y - 6000) <= 1);
+
+    // Largest radius: radius * sin stays within 32 bits, points stay on the circle
+    for (uint32_t a = 0; a <= 0xFFFF; a += 7)
+    {
+        double r;
+
+        app_traj_arc(32767, 32767, 65535, (uint16_t)a, &p);
+        r = hypot(p.x - 32767.0, p.y - 32767.0);
+        fails += (fabs(r - 65535.0) > 12.0);
+    }
+    CHECK_EQ(fails, 0);
+}
+
+static void test_bezier(void)
+{
+    const app_traj_point_t ctrl[4] = {{1000, 30000}, {1000, 1000}, {31000, 1000}, {31000, 30000}};
+    const app_traj_point_t line[4] = {{0, 0}, {10000, 10000}, {20000, 20000}, {30000, 30000}};
+    app_traj_point_t p;
+    int fails = 0;
+
+    app_traj_bezier(ctrl, 0, &p);
+    CHECK_EQ(p.x, 1000);
+    CHECK_EQ(p.y, 30000);
+    app_traj_bezier(ctrl, APP_TRAJ_ONE, &p);
+    CHECK_EQ(p.x, 31000);
+    CHECK_EQ(p.y, 30000);
+
+    for (uint32_t t = 0; t <= APP_TRAJ_ONE; t += 3)
+    {
+        double u = t / 32768.0;
+        double x = pow(1 - u, 3) * 1000 + 3 * pow(1 - u, 2) * u * 1000 + 3 * (1 - u) * u * u * 31000 + u * u * u * 31000;
+        double y = pow(1 - u, 3) * 30000 + 3 * pow(1 - u, 2) * u * 1000 + 3 * (1 - u) * u * u * 1000 + u * u * u * 30000;
+
+        app_traj_bezier(ctrl, (uint16_t)t, &p);
+        // Three truncations in a row
+        fails += (fabs(p.x - x) > 3.0) || (fabs(p.y - y) > 3.0);
+
+        // Evenly spaced control points on a line give the straight interpolation
+        app_traj_bezier(line, (uint16_t)t, &p);
+        fails += (p.x != p.y) || (fabs(p.x - 30000.0 * u) > 3.0);
+    }
+    CHECK_EQ(fails, 0);
+}
+
+int main(void)
+{
+    RUN_TEST(test_progress);
+    RUN_TEST(test_ease_endpoints_and_range);
+    RUN_TEST(test_ease_exact);
+    RUN_TEST(test_sin_cos);
+    RUN_TEST(test_turn);
+    RUN_TEST(test_lerp_overflow_boundary);
+    RUN_TEST(test_arc);
+    RUN_TEST(test_bezier);
+
+    return host_test_failures;
+}
@@ -0,0 +1,250 @@
+/**
+ * @file timer_ref.h
+ * @brief ns_timer as it was before the timer wheel, over a model of the kernel timer list,
+ *        kept as the reference of the host benchmark.
+ *
+ * Each ns_timer was one kernel timer. The RW kernel is in ROM, the model does what its
+ * ke_timer_set() does: take out the timer of the same id, allocate a new one and insert
+ * it in the list ordered by expiry. An expiry becomes a kernel message. Cancel and modify
+ * went through APP_CANCEL_TIMER and APP_MODIFY_TIMER messages to the application task.
+ */
+#ifndef __TIMER_REF_H__
+#define __TIMER_REF_H__
+
+#include <stdint.h>
+#include <stdlib.h>
+#include "ns_timer.h"
+
+enum timer_ref_msg_id
+{
+    TIMER_REF_CANCEL_TIMER,
+    TIMER_REF_MODIFY_TIMER,
+    /// One message id per timer, as NS_TIMER_API_MES0 to NS_TIMER_API_LAST_MES were
+    TIMER_REF_TIMER0,
+};
+
+/// Kernel timer, in the list ordered by expiry
+struct timer_ref_ke_timer
+{
+    struct timer_ref_ke_timer *next;
+    uint16_t id;
+    uint32_t time;
+};
+
+/// Kernel message, in the queue of the application task
+struct timer_ref_msg
+{
+    struct timer_ref_msg *next;
+    uint16_t id;
+    timer_hnd_t timer_id;
+    uint32_t delay;
+};
+
+static struct
+{
+    uint32_t now;
+    struct timer_ref_ke_timer *timers;
+    struct timer_ref_msg *msg_first;
+    struct timer_ref_msg *msg_last;
+    timer_callback_t callback[NS_TIMER_MAX_NUM];
+    timer_callback_t modified_callback[NS_TIMER_MAX_NUM];
+    /// Kernel work: messages sent, ke_timer_set() and ke_timer_clear() calls
+    uint32_t msg_nb;
+    uint32_t ke_timer_nb;
+} timer_ref;
+
+/* Kernel model ---------------------------------------------------------------*/
+static inline void timer_ref_msg_send(uint16_t id, timer_hnd_t timer_id, uint32_t delay)
+{
+    struct timer_ref_msg *p_msg = malloc(sizeof(*p_msg));
+
+    timer_ref.msg_nb++;
+    p_msg->next = NULL;
+    p_msg->id = id;
+    p_msg->timer_id = timer_id;
+    p_msg->delay = delay;
+    if (timer_ref.msg_last == NULL)
+    {
+        timer_ref.msg_first = p_msg;
+    }
+    else
+    {
+        timer_ref.msg_last->next = p_msg;
+    }
+    timer_ref.msg_last = p_msg;
+}
+
+static inline void timer_ref_ke_timer_extract(uint16_t id)
+{
+    for (struct timer_ref_ke_timer **pp = &timer_ref.timers; *pp != NULL; pp = &(*pp)->next)
+    {
+        if ((*pp)->id == id)
+        {
+            struct timer_ref_ke_timer *p_timer = *pp;
+
+            *pp = p_timer->next;
+            free(p_timer);
+            return;
+        }
+    }
+}
+
+static inline void timer_ref_ke_timer_clear(uint16_t id)
+{
+    timer_ref.ke_timer_nb++;
+    timer_ref_ke_timer_extract(id);
+}
+
+static inline void timer_ref_ke_timer_set(uint16_t id, uint32_t delay)
+{
+    struct timer_ref_ke_timer *p_timer;
+    struct timer_ref_ke_timer **pp = &timer_ref.timers;
+
+    timer_ref.ke_timer_nb++;
+    timer_ref_ke_timer_extract(id);
+    p_timer = malloc(sizeof(*p_timer));
+    p_timer->id = id;
+    p_timer->time = timer_ref.now + delay;
+    while ((*pp != NULL) && ((int32_t)((*pp)->time - p_timer->time) <= 0))
+    {
+        pp = &(*pp)->next;
+    }
+    p_timer->next = *pp;
+    *pp = p_timer;
+}
+
+/* ns_timer before the wheel --------------------------------------------------*/
+static void timer_ref_canceled_handler(void)
+{
+}
+
+static void timer_ref_modified_handler(void)
+{
+}
+
+static inline void timer_ref_msg_handle(struct timer_ref_msg const *p_msg)
+{
+    timer_hnd_t i = p_msg->timer_id;
+
+    switch (p_msg->id)
+    {
+        case TIMER_REF_CANCEL_TIMER:
+            if (timer_ref.callback[i] == timer_ref_canceled_handler)
+            {
+                timer_ref.callback[i] = NULL;
+                timer_ref.modified_callback[i] = NULL;
+            }
+            else if (timer_ref.callback[i] == timer_ref_modified_handler)
+            {
+                timer_ref_msg_send(TIMER_REF_MODIFY_TIMER, i, p_msg->delay);
+            }
+            break;
+
+        case TIMER_REF_MODIFY_TIMER:
+            if (timer_ref.callback[i] == timer_ref_modified_handler)
+            {
+                timer_ref.callback[i] = timer_ref.modified_callback[i];
+                timer_ref_ke_timer_set(TIMER_REF_TIMER0 + i, p_msg->delay);
+            }
+            break;
+
+        default:
+            i = p_msg->id - TIMER_REF_TIMER0;
+            if ((timer_ref.callback[i] != NULL) && (timer_ref.callback[i] != timer_ref_modified_handler)
+                && (timer_ref.callback[i] != timer_ref_canceled_handler))
+            {
+                timer_callback_t fn = timer_ref.callback[i];
+
+                timer_ref.callback[i] = NULL;
+                timer_ref.modified_callback[i] = NULL;
+                fn();
+            }
+            break;
+    }
+}
+
+/// Deliver the queued messages, as the kernel scheduler does
+static inline void timer_ref_run(void)
+{
+    while (timer_ref.msg_first != NULL)
+    {
+        struct timer_ref_msg *p_msg = timer_ref.msg_first;
+
+        timer_ref.msg_first = p_msg->next;
+        if (timer_ref.msg_first == NULL)
+        {
+            timer_ref.msg_last = NULL;
+        }
+        timer_ref_msg_handle(p_msg);
+        free(p_msg);
+    }
+}
+
+/// Move the time forward by ms, expire the kernel timers and deliver their messages
+static inline void timer_ref_advance(uint32_t ms)
+{
+    timer_ref.now += ms;
+    while ((timer_ref.timers != NULL) && ((int32_t)(timer_ref.timers->time - timer_ref.now) <= 0))
+    {
+        struct timer_ref_ke_timer *p_timer = timer_ref.timers;
+
+        timer_ref.timers = p_timer->next;
+        timer_ref_msg_send(p_timer->id, 0, 0);
+        free(p_timer);
+    }
+    timer_ref_run();
+}
+
+static inline void timer_ref_init(void)
+{
+    while (timer_ref.timers != NULL)
+    {
+        struct timer_ref_ke_timer *p_timer = timer_ref.timers;
+
+        timer_ref.timers = p_timer->next;
+        free(p_timer);
+    }
+    for (timer_hnd_t i = 0; i < NS_TIMER_MAX_NUM; i++)
+    {
+        timer_ref.callback[i] = NULL;
+        timer_ref.modified_callback[i] = NULL;
+    }
+    timer_ref_run();
+}
+
+static inline timer_hnd_t timer_ref_create(uint32_t delay, timer_callback_t fn)
+{
+    for (timer_hnd_t i = 0; i < NS_TIMER_MAX_NUM; i++)
+    {
+        if (timer_ref.callback[i] == NULL)
+        {
+            timer_ref.callback[i] = fn;
+            timer_ref_ke_timer_set(TIMER_REF_TIMER0 + i, delay);
+            return i;
+        }
+    }
+    return NS_TIMER_INVALID_HANDLER;
+}
+
+static inline void timer_ref_cancel(timer_hnd_t timer_id)
+{
+    if ((timer_ref.callback[timer_id] != NULL) && (timer_ref.callback[timer_id] != timer_ref_canceled_handler))
+    {
+        timer_ref_ke_timer_clear(TIMER_REF_TIMER0 + timer_id);
+        timer_ref.callback[timer_id] = timer_ref_canceled_handler;
+        timer_ref_msg_send(TIMER_REF_CANCEL_TIMER, timer_id, 0);
+    }
+}
+
+static inline void timer_ref_modify(timer_hnd_t timer_id, uint32_t delay)
+{
+    if ((timer_ref.callback[timer_id] != NULL) && (timer_ref.callback[timer_id] != timer_ref_modified_handler))
+    {
+        timer_ref_ke_timer_clear(TIMER_REF_TIMER0 + timer_id);
+        timer_ref.modified_callback[timer_id] = timer_ref.callback[timer_id];
+        timer_ref.callback[timer_id] = timer_ref_modified_handler;
+        timer_ref_msg_send(TIMER_REF_CANCEL_TIMER, timer_id, delay);
+    }
+}
+
+#endif //__TIMER_REF_H__
@@ -0,0 +1,42 @@
+#!/usr/bin/env python3
+"""Signing key and signatures of the DFU image of test_dfu_ble.c, written to dfu_ble.txt.
+
+The image is DFU_IMAGE_SIZE bytes of dfu_image_byte(), the same as test_dfu_ble.c builds.
+Its setting puts it in app1 at 0x01004000, version 2. Values are big endian hex as
+ns_lib_ecc_ecdsa_verify() takes them. The seed is fixed, running the script again gives
+the same file.
+"""
+import hashlib
+import random
+import struct
+import zlib
+
+from p256 import G, mul, n, sign
+
+DFU_IMAGE_SIZE = 20000
+APP1_START_ADDRESS = 0x01004000
+APP1_VERSION = 2
+
+
+def dfu_image_byte(i):
+    return ((i * 7) ^ (i >> 7) ^ 0x5A) & 0xFF
+
+
+def be(v):
+    return v.to_bytes(32, 'big').hex()
+
+
+rng = random.Random(16)
+d = rng.randrange(1, n)
+Q = mul(d, G)
+image = bytes(dfu_image_byte(i) for i in range(DFU_IMAGE_SIZE))
+
+# app1, app2, image_update banks of Dfu_setting_t: start_address, size, crc, version
+banks = struct.pack('<4I', APP1_START_ADDRESS, DFU_IMAGE_SIZE, zlib.crc32(image), APP1_VERSION) + bytes(32)
+setting_r, setting_s = sign(d, int.from_bytes(hashlib.sha256(banks).digest(), 'big'), rng)
+image_r, image_s = sign(d, int.from_bytes(hashlib.sha256(image).digest(), 'big'), rng)
+
+with open('dfu_ble.txt', 'w') as f:
+    f.write('public_key %s%s\n' % (be(Q[0]), be(Q[1])))
+    f.write('setting_signature %s%s\n' % (be(setting_r), be(setting_s)))
+    f.write('image_signature %s%s\n' % (be(image_r), be(image_s)))
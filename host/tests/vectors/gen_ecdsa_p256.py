@@ -0,0 +1,70 @@
+#!/usr/bin/env python3
+"""ECDSA P-256 verify vectors of test_ecc.c, written to ecdsa_p256.txt.
+
+One vector per line: public key x|y, hash, signature r|s, all little endian hex as
+uECC_verify takes them, then the expected result and the case name. The seed is fixed,
+running the script again gives the same file.
+"""
+import hashlib
+import random
+
+from p256 import G, inv, mul, n, p, sign
+
+
+def le(v):
+    return (v % (1 << 256)).to_bytes(32, 'little').hex()
+
+
+out = []
+
+
+def vec(Q, e, r, s, expected, case):
+    out.append('%s %s %s %d %s' % (le(Q[0]) + le(Q[1]), le(e), le(r) + le(s), expected, case))
+
+
+random.seed(7)
+for t in range(40):
+    d = random.randrange(1, n)
+    Q = mul(d, G)
+    e = int.from_bytes(hashlib.sha256(bytes([t])).digest(), 'big')
+    r, s = sign(d, e)
+    vec(Q, e, r, s, 1, 'valid')
+    vec(Q, e, r, n - s, 1, 'valid_high_s')
+    vec(Q, e ^ 1, r, s, 0, 'bad_hash')
+    vec(Q, e, (r + 1) % n, s, 0, 'bad_r')
+    vec(Q, e, r, (s + 1) % n, 0, 'bad_s')
+    vec(Q, e, 0, s, 0, 'r_zero')
+    vec(Q, e, r, 0, 0, 's_zero')
+    vec(Q, e, n, s, 0, 'r_eq_n')
+    vec(Q, e, r, n, 0, 's_eq_n')
+    vec((Q[0], (Q[1] + 1) % p), e, r, s, 0, 'pub_off_curve')
+    vec((Q[0], p - Q[1]), e, r, s, 0, 'pub_negated')
+
+# u1 = 0, from a zero hash and from a hash equal to n
+d = random.randrange(1, n)
+Q = mul(d, G)
+r, s = sign(d, 0)
+vec(Q, 0, r, s, 1, 'hash_zero')
+r, s = sign(d, 0)
+vec(Q, n, r, s, 1, 'hash_eq_n')
+
+# keys +-G, +-2G, 3G: the two halves of the sum meet in the table additions,
+# e = r gives u1 = u2 and with Q = G the addition has to double
+for d in (1, 2, 3, n - 1, n - 2):
+    Q = mul(d, G)
+    for t in range(3):
+        e = random.randrange(0, n)
+        r, s = sign(d, e)
+        vec(Q, e, r, s, 1, 'small_key')
+    k = random.randrange(1, n)
+    r = mul(k, G)[0] % n
+    s = inv(k, n) * (r + r * d) % n
+    vec(Q, r, r, s, 1 if s else 0, 'u1_eq_u2')
+
+# Q = G and u1 = -u2, the sum is the point at infinity and has to be rejected
+r = random.randrange(1, n)
+s = random.randrange(1, n)
+vec(G, (n - r) % n, r, s, 0, 'sum_infinity')
+
+with open('ecdsa_p256.txt', 'w') as f:
+    f.write('\n'.join(out) + '\n')
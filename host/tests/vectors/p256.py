@@ -0,0 +1,48 @@
+"""P-256 arithmetic of the vector generators, plain Python and slow, for test data only."""
+import random
+
+p = 0xFFFFFFFF00000001000000000000000000000000FFFFFFFFFFFFFFFFFFFFFFFF
+n = 0xFFFFFFFF00000000FFFFFFFFFFFFFFFFBCE6FAADA7179E84F3B9CAC2FC632551
+a = p - 3
+G = (0x6B17D1F2E12C4247F8BCE6E563A440F277037D812DEB33A0F4A13945D898C296,
+     0x4FE342E2FE1A7F9B8EE7EB4A7C0F9E162BCE33576B315ECECBB6406837BF51F5)
+
+
+def inv(x, m):
+    return pow(x, m - 2, m)
+
+
+def add(P, Q):
+    if P is None:
+        return Q
+    if Q is None:
+        return P
+    if P[0] == Q[0]:
+        if (P[1] + Q[1]) % p == 0:
+            return None
+        l = (3 * P[0] * P[0] + a) * inv(2 * P[1], p) % p
+    else:
+        l = (Q[1] - P[1]) * inv(Q[0] - P[0], p) % p
+    x = (l * l - P[0] - Q[0]) % p
+    return (x, (l * (P[0] - x) - P[1]) % p)
+
+
+def mul(k, P):
+    R = None
+    while k:
+        if k & 1:
+            R = add(R, P)
+        P = add(P, P)
+        k >>= 1
+    return R
+
+
+def sign(d, e, rng=random):
+    while True:
+        k = rng.randrange(1, n)
+        r = mul(k, G)[0] % n
+        if r == 0:
+            continue
+        s = inv(k, n) * (e + r * d) % n
+        if s:
+            return r, s
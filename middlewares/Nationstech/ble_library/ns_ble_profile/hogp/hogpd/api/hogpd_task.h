@@ -36,7 +36,7 @@
 
 #include <stdint.h>
 #include "rwip_task.h" // Task definitions
-#include "hogp\hogp_common.h"
+#include "hogp/hogp_common.h"
 /*
  * DEFINES
  ****************************************************************************************
@@ -45,7 +45,7 @@
 /// Maximal number of HIDS that can be added in the DB
 #define HOGPD_NB_HIDS_INST_MAX              (2)
 /// Maximal number of Report Char. that can be added in the DB for one HIDS - Up to 11
-#define HOGPD_NB_REPORT_INST_MAX            (5)
+#define HOGPD_NB_REPORT_INST_MAX            (6)
 
 /*
  * TYPE DEFINITIONS
@@ -313,6 +313,36 @@ struct hogpd_ctnl_pt_ind
 };
 
 
+/*
+ * FUNCTION DECLARATIONS
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * @brief Notify a report value without the @ref HOGPD_REPORT_UPD_REQ message hop.
+ *
+ * The report is checked as for a request and the GATT notification is built straight
+ * from the application buffer. Completion is still reported to the application with
+ * @ref HOGPD_REPORT_UPD_RSP. Shall be called from the application task context.
+ *
+ * A request already sent and not yet executed would be overtaken, so the application
+ * shall only use this function when none of its @ref HOGPD_REPORT_UPD_REQ is pending.
+ *
+ * @param[in] conidx  Connection Index
+ * @param[in] hid_idx HIDS Instance
+ * @param[in] type    Type of report (@see enum hogpd_report_type)
+ * @param[in] idx     Report Instance
+ * @param[in] value   Report value
+ * @param[in] length  Length of the report value
+ *
+ * @return GAP_ERR_NO_ERROR if the notification is sent, GAP_ERR_COMMAND_DISALLOWED if a
+ *         notification is in progress (use @ref HOGPD_REPORT_UPD_REQ instead), or the
+ *         status @ref HOGPD_REPORT_UPD_REQ would have returned.
+ ****************************************************************************************
+ */
+uint8_t hogpd_report_send_direct(uint8_t conidx, uint8_t hid_idx, uint8_t type, uint8_t idx,
+                                 const uint8_t* value, uint16_t length);
 
 /// @} HOGPDTASK
 
@@ -34,6 +34,8 @@
 #include "prf_utils.h"
 
 #include "ke_mem.h"
+#include "ns_msg_pool.h"
+#include "n32wb03x.h"
 
 /*
  * DEFINES
@@ -387,6 +389,12 @@ static uint8_t hogpd_init (struct prf_task_env* env, uint16_t* start_hdl, uint16
 //        env->desc.default_handler   = &hogpd_default_handler;
 
         hogpd_task_init(&(env->desc));
+
+        // reports keep the heap for themselves if the pool can not be allocated
+        #if (HOGPD_REPORT_POOL_NB)
+        ns_msg_pool_create(HOGPD_REPORT_UPD_REQ, sizeof(struct hogpd_report_upd_req) + HOGPD_REPORT_MAX_LEN,
+                           HOGPD_REPORT_POOL_NB);
+        #endif
         
         // service is ready, go into an Idle state
         ke_state_set(env->task, HOGPD_IDLE);
@@ -421,6 +429,9 @@ static void hogpd_destroy(struct prf_task_env* env)
 {
     struct hogpd_env_tag* hogpd_env = (struct hogpd_env_tag*) env->env;
 
+    // reports still queued are freed by the kernel
+    ns_msg_pool_delete(HOGPD_REPORT_UPD_REQ);
+
     // free profile environment variables
     env->env = NULL;
     ke_free(hogpd_env);
@@ -742,9 +753,24 @@ uint8_t hogpd_get_att_idx(struct hogpd_env_tag* hogpd_env, uint16_t handle, uint
 }
 
 
-uint8_t hogpd_ntf_send(uint8_t conidx, const struct hogpd_report_info* report)
+/**
+ ****************************************************************************************
+ * @brief Check that a report can be notified and retrieve the handle of its value.
+ *
+ * @param[in]  hogpd_env Profile environment
+ * @param[in]  conidx    Connection Index
+ * @param[in]  hid_idx   HIDS Instance
+ * @param[in]  type      Type of report (@see enum hogpd_report_type)
+ * @param[in]  idx       Report Instance
+ * @param[in]  length    Length of the report value
+ * @param[out] p_handle  Handle of the report value attribute
+ *
+ * @return Status Code to know if the report can be notified or not.
+ ****************************************************************************************
+ */
+static uint8_t hogpd_ntf_check(struct hogpd_env_tag* hogpd_env, uint8_t conidx, uint8_t hid_idx,
+                               uint8_t type, uint8_t idx, uint16_t length, uint16_t* p_handle)
 {
-    struct hogpd_env_tag* hogpd_env = PRF_ENV_GET(HOGPD, hogpd);
     uint8_t  status = GAP_ERR_NO_ERROR;
     uint16_t handle = ATT_INVALID_HANDLE;
     uint8_t  att_idx = HOGPD_IDX_NB;
@@ -757,14 +783,14 @@ uint8_t hogpd_ntf_send(uint8_t conidx, const struct hogpd_report_info* report)
     // - Attribute max length
     // - Feature to use
     // - Expected protocol mode
-    switch(report->type)
+    switch(type)
     {
         // An Input Report
         case HOGPD_REPORT:
         {
             att_idx = HOGPD_IDX_REPORT_VAL;
             max_report_len = HOGPD_REPORT_MAX_LEN;
-            feature_mask = HOGPD_CFG_REPORT_NTF_EN << report->idx;
+            feature_mask = HOGPD_CFG_REPORT_NTF_EN << idx;
             exp_prot_mode = HOGP_REPORT_PROTOCOL_MODE;
         }break;
         // Boot Keyboard input report
@@ -787,15 +813,15 @@ uint8_t hogpd_ntf_send(uint8_t conidx, const struct hogpd_report_info* report)
         default: /* Nothing to do */ break;
     }
 
-    handle = hogpd_get_att_handle(hogpd_env, report->hid_idx, att_idx, report->idx);
+    handle = hogpd_get_att_handle(hogpd_env, hid_idx, att_idx, idx);
 
     // check if attribute is found
     if(handle == ATT_INVALID_HANDLE)
     {
         // check if it's an unsupported feature
-        if((feature_mask != 0) && (report->hid_idx < hogpd_env->hids_nb)
-                && (report->idx < hogpd_env->svcs[report->hid_idx].nb_report)
-                && ((hogpd_env->svcs[report->hid_idx].features & feature_mask) == 0))
+        if((feature_mask != 0) && (hid_idx < hogpd_env->hids_nb)
+                && (idx < hogpd_env->svcs[hid_idx].nb_report)
+                && ((hogpd_env->svcs[hid_idx].features & feature_mask) == 0))
         {
             status = PRF_ERR_FEATURE_NOT_SUPPORTED;
         }
@@ -806,42 +832,170 @@ uint8_t hogpd_ntf_send(uint8_t conidx, const struct hogpd_report_info* report)
         }
     }
     // check if length is valid
-    else if(report->length > max_report_len)
+    else if(length > max_report_len)
     {
         status = PRF_ERR_UNEXPECTED_LEN;
     }
     // check if notification is enabled
-    else if ((hogpd_env->svcs[report->hid_idx].ntf_cfg[conidx] & feature_mask) == 0)
+    else if ((hogpd_env->svcs[hid_idx].ntf_cfg[conidx] & feature_mask) == 0)
     {
         status = PRF_ERR_NTF_DISABLED;
     }
     // check if protocol mode is valid
-    else if((hogpd_env->svcs[report->hid_idx].proto_mode != exp_prot_mode)
-            && ((hogpd_env->svcs[report->hid_idx].features & HOGPD_CFG_PROTO_MODE) != 0))
+    else if((hogpd_env->svcs[hid_idx].proto_mode != exp_prot_mode)
+            && ((hogpd_env->svcs[hid_idx].features & HOGPD_CFG_PROTO_MODE) != 0))
     {
         status = PRF_ERR_REQ_DISALLOWED;
     }
 
+    *p_handle = handle;
+
+    return (status);
+}
+
+/**
+ ****************************************************************************************
+ * @brief Allocate the GATT notification of a report value and send it.
+ *
+ * @param[in] hogpd_env Profile environment
+ * @param[in] conidx    Connection Index
+ * @param[in] handle    Handle of the report value attribute
+ * @param[in] value     Report value
+ * @param[in] length    Length of the report value
+ ****************************************************************************************
+ */
+static void hogpd_ntf_build(struct hogpd_env_tag* hogpd_env, uint8_t conidx, uint16_t handle,
+                            const uint8_t* value, uint16_t length)
+{
+    // Allocate the GATT notification message
+    struct gattc_send_evt_cmd *report_ntf = KE_MSG_ALLOC_DYN(GATTC_SEND_EVT_CMD,
+            KE_BUILD_ID(TASK_GATTC, conidx), prf_src_task_get(&(hogpd_env->prf_env), conidx),
+            gattc_send_evt_cmd, length);
+
+    // Fill in the parameter structure
+    report_ntf->operation = GATTC_NOTIFY;
+    report_ntf->handle    = handle;
+    // pack measured value in database
+    report_ntf->length    = length;
+    memcpy(report_ntf->value, value, length);
+    // send notification to peer device
+    ke_msg_send(report_ntf);
+}
+
+uint8_t hogpd_ntf_send(uint8_t conidx, const struct hogpd_report_info* report)
+{
+    struct hogpd_env_tag* hogpd_env = PRF_ENV_GET(HOGPD, hogpd);
+    uint16_t handle = ATT_INVALID_HANDLE;
+    uint8_t  status = hogpd_ntf_check(hogpd_env, conidx, report->hid_idx, report->type, report->idx,
+                                      report->length, &handle);
+
     if(status == GAP_ERR_NO_ERROR)
     {
-        // Allocate the GATT notification message
-        struct gattc_send_evt_cmd *report_ntf = KE_MSG_ALLOC_DYN(GATTC_SEND_EVT_CMD,
-                KE_BUILD_ID(TASK_GATTC, conidx), prf_src_task_get(&(hogpd_env->prf_env), conidx),
-                gattc_send_evt_cmd, report->length);
+        hogpd_ntf_build(hogpd_env, conidx, handle, report->value, report->length);
+    }
 
-        // Fill in the parameter structure
-        report_ntf->operation = GATTC_NOTIFY;
-        report_ntf->handle    = handle;
-        // pack measured value in database
-        report_ntf->length    = report->length;
-        memcpy(report_ntf->value, report->value, report->length);
-        // send notification to peer device
-        ke_msg_send(report_ntf);
+    return (status);
+}
+
+uint8_t hogpd_report_send_direct(uint8_t conidx, uint8_t hid_idx, uint8_t type, uint8_t idx,
+                                 const uint8_t* value, uint16_t length)
+{
+    struct hogpd_env_tag* hogpd_env = PRF_ENV_GET(HOGPD, hogpd);
+    uint16_t handle = ATT_INVALID_HANDLE;
+    uint8_t  status;
+    ke_task_id_t task;
+    uint8_t state;
+
+    // profile not added or connection does not exist
+    if((hogpd_env == NULL) || (conidx >= BLE_CONNECTION_MAX)
+            || (gapc_get_conhdl(conidx) == GAP_INVALID_CONHDL))
+    {
+        return (PRF_ERR_REQ_DISALLOWED);
+    }
+
+    task  = prf_src_task_get(&(hogpd_env->prf_env), conidx);
+    state = ke_state_get(task);
+
+    // one notification at a time, the caller falls back on HOGPD_REPORT_UPD_REQ
+    if((state & HOGPD_REQ_BUSY) != HOGPD_IDLE)
+    {
+        return (GAP_ERR_COMMAND_DISALLOWED);
+    }
+
+    status = hogpd_ntf_check(hogpd_env, conidx, hid_idx, type, idx, length, &handle);
+
+    if(status == GAP_ERR_NO_ERROR)
+    {
+        hogpd_ntf_build(hogpd_env, conidx, handle, value, length);
+        // completion is reported with HOGPD_REPORT_UPD_RSP as for a request
+        ke_state_set(task, state | HOGPD_REQ_BUSY);
     }
 
+    #if (HOGPD_REPORT_CYCLES)
+    hogpd_report_cycles_stop(true, (status == GAP_ERR_NO_ERROR));
+    #endif
+
     return (status);
 }
 
+#if (HOGPD_REPORT_CYCLES)
+/// Report being counted and the counts so far
+static struct hogpd_report_cycles hogpd_cycles;
+static uint32_t hogpd_cycles_start;
+static bool hogpd_cycles_running;
+
+void hogpd_report_cycles_start(void)
+{
+    if((SysTick->CTRL & SysTick_CTRL_ENABLE) == 0)
+    {
+        SysTick->LOAD = SysTick_LOAD_RELOAD;
+        SysTick->VAL  = 0;
+        SysTick->CTRL = SysTick_CTRL_CLKSOURCE | SysTick_CTRL_ENABLE;
+    }
+
+    // the report before is still on its way, it keeps the count
+    if(!hogpd_cycles_running)
+    {
+        hogpd_cycles_start   = SysTick->VAL;
+        hogpd_cycles_running = true;
+    }
+}
+
+void hogpd_report_cycles_stop(bool direct, bool sent)
+{
+    uint32_t now = SysTick->VAL;
+    uint32_t cycles;
+
+    if(!hogpd_cycles_running)
+    {
+        return;
+    }
+    hogpd_cycles_running = false;
+
+    if(sent)
+    {
+        // SysTick counts down from LOAD
+        cycles = (hogpd_cycles_start >= now) ? (hogpd_cycles_start - now)
+                                             : (hogpd_cycles_start + SysTick->LOAD + 1 - now);
+        if(direct)
+        {
+            hogpd_cycles.direct_nb++;
+            hogpd_cycles.direct_cycles += cycles;
+        }
+        else
+        {
+            hogpd_cycles.req_nb++;
+            hogpd_cycles.req_cycles += cycles;
+        }
+    }
+}
+
+const struct hogpd_report_cycles* hogpd_report_cycles_get(void)
+{
+    return (&hogpd_cycles);
+}
+#endif
+
 uint8_t hogpd_ntf_cfg_ind_send(uint8_t conidx, uint8_t svc_idx, uint8_t att_idx, uint8_t report_idx, uint16_t ntf_cfg)
 {
     // Status
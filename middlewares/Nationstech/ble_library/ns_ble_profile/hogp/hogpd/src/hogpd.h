@@ -30,8 +30,8 @@
 #include "rwip_config.h"
 
 #if (BLE_HID_DEVICE)
-#include "hogp\hogp_common.h"
-#include "hogp\hogpd\api\hogpd_task.h"
+#include "hogp/hogp_common.h"
+#include "hogp/hogpd/api/hogpd_task.h"
 
 #include "prf.h"
 #include "prf_types.h"
@@ -48,6 +48,14 @@
 
 /// Maximal length of Report Char. Value
 #define HOGPD_REPORT_MAX_LEN                (45)
+/// HOGPD_REPORT_UPD_REQ messages preallocated for full length reports, 0 to use the heap only
+#ifndef HOGPD_REPORT_POOL_NB
+#define HOGPD_REPORT_POOL_NB                (4)
+#endif
+/// Count the cycles of each report up to its GATT notification, see hogpd_report_cycles_start()
+#ifndef HOGPD_REPORT_CYCLES
+#define HOGPD_REPORT_CYCLES                 (0)
+#endif
 /// Maximal length of Report Map Char. Value
 #define HOGPD_REPORT_MAP_MAX_LEN            (512)
 
@@ -185,6 +193,19 @@ struct hogpd_env_tag
     uint8_t hids_nb;
 };
 
+#if (HOGPD_REPORT_CYCLES)
+/// Cycles from hogpd_report_cycles_start() to the GATT notification, per report path
+struct hogpd_report_cycles
+{
+    /// Reports notified with hogpd_report_send_direct() and their cycles
+    uint32_t direct_nb;
+    uint32_t direct_cycles;
+    /// Reports notified from a HOGPD_REPORT_UPD_REQ and their cycles
+    uint32_t req_nb;
+    uint32_t req_cycles;
+};
+#endif
+
 /*
  * GLOBAL VARIABLE DECLARATIONS
  ****************************************************************************************
@@ -262,6 +283,37 @@ uint8_t hogpd_ntf_send(uint8_t conidx, const struct hogpd_report_info* report);
  */
 uint8_t hogpd_ntf_cfg_ind_send(uint8_t conidx, uint8_t svc_idx, uint8_t att_idx, uint8_t report_idx, uint16_t ntf_cfg);
 
+#if (HOGPD_REPORT_CYCLES)
+/**
+ ****************************************************************************************
+ * @brief Start counting the cycles of a report, where the application starts sending it.
+ *
+ * The Cortex-M0 has no DWT cycle counter: SysTick counts the core clock instead. It is
+ * started free running without its interrupt if the application does not run it. The
+ * count stops when the GATT notification is sent. A report that has to wait for the one
+ * in progress is not counted, its count would hold the connection events in between.
+ ****************************************************************************************
+ */
+void hogpd_report_cycles_start(void);
+
+/**
+ ****************************************************************************************
+ * @brief Stop counting the cycles of the report being sent.
+ *
+ * @param[in] direct Notified with hogpd_report_send_direct()
+ * @param[in] sent   Notification sent, false drops the count
+ ****************************************************************************************
+ */
+void hogpd_report_cycles_stop(bool direct, bool sent);
+
+/**
+ ****************************************************************************************
+ * @brief Cycles counted so far.
+ ****************************************************************************************
+ */
+const struct hogpd_report_cycles* hogpd_report_cycles_get(void);
+#endif
+
 /*
  * TASK DESCRIPTOR DECLARATIONS
  ****************************************************************************************
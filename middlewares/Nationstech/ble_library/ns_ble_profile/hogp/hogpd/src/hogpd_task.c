@@ -36,6 +36,7 @@
 #include "prf_utils.h"
 
 #include "co_utils.h"
+#include "ns_msg_pool.h"
 
 /*
  * DEFINES
@@ -133,6 +134,10 @@ static int hogpd_report_upd_req_handler(ke_msg_id_t const msgid,
             status = hogpd_ntf_send(param->conidx, &(param->report));
         }
 
+        #if (HOGPD_REPORT_CYCLES)
+        hogpd_report_cycles_stop(false, (status == GAP_ERR_NO_ERROR));
+        #endif
+
         // an error occurs inform application
         if (status != GAP_ERR_NO_ERROR)
         {
@@ -153,6 +158,15 @@ static int hogpd_report_upd_req_handler(ke_msg_id_t const msgid,
     else
     {
         msg_status = KE_MSG_SAVED;
+        #if (HOGPD_REPORT_CYCLES)
+        hogpd_report_cycles_stop(false, false);
+        #endif
+    }
+
+    // a preallocated request goes back to its pool instead of the heap
+    if((msg_status == KE_MSG_CONSUMED) && ns_msg_pool_release(param))
+    {
+        msg_status = KE_MSG_NO_FREE;
     }
 
     return (msg_status);
@@ -28,14 +28,8 @@
 /* Public define ------------------------------------------------------------*/  
 /* Public constants ---------------------------------------------------------*/
 
-/// Value element
-struct ns_ius_val_elmt
-{
-    struct co_list_hdr hdr;
-    uint8_t att_idx;
-    uint8_t length;
-    uint8_t data[__ARRAY_EMPTY];
-};
+/// Attribute without value in ns_ius_env_tag.val_slot
+#define NS_IUS_VAL_NO_SLOT    (0xFF)
 
 struct ns_ius_env_tag
 {
@@ -45,7 +39,10 @@ struct ns_ius_env_tag
     struct ke_msg *operation;
     uint8_t cursor;
     uint8_t ccc_idx;
-    struct co_list values;
+    /// Value slot of each attribute, NS_IUS_VAL_NO_SLOT if none
+    uint8_t *val_slot;
+    /// CCC values, BLE_CONNECTION_MAX bytes per slot
+    uint8_t *ccc_val;
     ke_state_t state[NS_IUS_IDX_MAX];
 };
 
@@ -100,6 +100,15 @@ extern ke_task_id_t  ns_ble_ius_task;
  * @param[in] cc       Value to store. 
  */
 void ns_ius_set_ccc_value(uint8_t conidx, uint8_t att_idx, uint16_t ccc);
+/** 
+ * @brief Size of the Client Characteristic Configuration table of a service.
+ * @details ns_ius_init_ccc_values lays the table out after struct ns_ius_env_tag,
+ *          the environment must be allocated with this many extra bytes.
+ * @param[in] att_db         Custom service attribute definition table.
+ * @param[in] max_nb_att     Number of elements in att_db.
+ * @return Size of the table in bytes.
+ */
+uint16_t ns_ius_ccc_table_size(const struct attm_desc_128 *att_db, int max_nb_att);
 /** 
  * @brief Initialize Client Characteristic Configuration fields.
  * @details Function initializes all CCC fields to default value.
@@ -70,7 +70,8 @@ static uint8_t ns_ius_init(struct prf_task_env *env, uint16_t *start_hdl, uint16
 	
 	if (status == ATT_ERR_NO_ERROR)
 	{
-		struct ns_ius_env_tag *ns_ius_env = (struct ns_ius_env_tag *) ke_malloc(sizeof(struct ns_ius_env_tag), KE_MEM_ATT_DB);
+		struct ns_ius_env_tag *ns_ius_env = (struct ns_ius_env_tag *) ke_malloc(sizeof(struct ns_ius_env_tag)
+				+ ns_ius_ccc_table_size(ns_ius_att_db, NS_IUS_IDX_NB), KE_MEM_ATT_DB);
 		env->env = (prf_env_t *)ns_ius_env;
 		ns_ius_env->shdl = *start_hdl;
 		ns_ius_env->max_nb_att = NS_IUS_IDX_NB;
@@ -78,7 +79,6 @@ static uint8_t ns_ius_init(struct prf_task_env *env, uint16_t *start_hdl, uint16
 		ns_ius_env->prf_env.prf_task = env->task | PERM(PRF_MI, DISABLE);	
 		env->id = TASK_ID_NS_IUS;	
 		ns_ius_task_init(&(env->desc));
-		co_list_init(&(ns_ius_env->values));
 		ns_ius_init_ccc_values(ns_ius_att_db, NS_IUS_IDX_NB);
 		ns_ble_ius_task = env->task;
 		ke_state_set(ns_ble_ius_task, NS_IUS_IDLE);
@@ -96,11 +96,6 @@ static uint8_t ns_ius_init(struct prf_task_env *env, uint16_t *start_hdl, uint16
 static void ns_ius_destroy(struct prf_task_env *env)
 {
     struct ns_ius_env_tag *ns_ius_env = (struct ns_ius_env_tag *)env->env;
-    while (!co_list_is_empty(&(ns_ius_env->values)))
-    {
-        struct co_list_hdr *hdr = co_list_pop_front(&(ns_ius_env->values));
-        ke_free(hdr);
-    }
     env->env = NULL;
     ke_free(ns_ius_env);
 }
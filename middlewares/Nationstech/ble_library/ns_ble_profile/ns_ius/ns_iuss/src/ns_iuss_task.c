@@ -47,89 +47,67 @@ ke_task_id_t  ns_ble_ius_task;
 
 
 /** 
- * @brief Stores characteristic value.
- * @param[in] att_idx  Custom attribut index.
- * @param[in] length   Value length.
- * @param[in] data     Pointer to value data.
- * @return 0 on success. 
+ * @brief Tell whether an attribute is a Client Characteristic Configuration descriptor.
+ * @param[in] att  Attribute description.
+ * @return true for a CCC descriptor. 
  */
-static int ns_ius_att_set_value(uint8_t att_idx, uint16_t length, const uint8_t *data)
+static bool ns_ius_is_ccc(const struct attm_desc_128 *att)
 {
-    struct ns_ius_env_tag *ns_ius_env = PRF_ENV_GET(NS_IUS, ns_ius);
-    struct ns_ius_val_elmt *val = (struct ns_ius_val_elmt *) co_list_pick(&(ns_ius_env->values));
-    while (val != NULL)
-    {
-        if (val->att_idx == att_idx)
-        {
-            if (length != val->length)
-            {
-								co_list_extract(&ns_ius_env->values, &val->hdr);
-                ke_free(val);
-                val = NULL;
-            }
-            break;
-        }
-        val = (struct ns_ius_val_elmt *)val->hdr.next;
-    }
-
-    if (val == NULL)
+    return (PERM_GET(att->perm, UUID_LEN) == PERM_UUID_16)
+        && ((att->uuid[0] + (att->uuid[1] << 8)) == ATT_DESC_CLIENT_CHAR_CFG);
+}
+/** 
+ * @brief Find the CCC values of an attribute, one byte per connection.
+ * @param[in] ns_ius_env  Profile environment.
+ * @param[in] att_idx     Custom attribute index.
+ * @return Slot of BLE_CONNECTION_MAX bytes, NULL if the attribute is not a CCC. 
+ */
+static uint8_t *ns_ius_ccc_slot(struct ns_ius_env_tag *ns_ius_env, uint8_t att_idx)
+{
+    if ((att_idx >= ns_ius_env->max_nb_att) || (ns_ius_env->val_slot[att_idx] == NS_IUS_VAL_NO_SLOT))
     {
-        val = (struct ns_ius_val_elmt *) ke_malloc(sizeof(struct ns_ius_val_elmt) + length, KE_MEM_ATT_DB);
-        co_list_push_back(&ns_ius_env->values, &val->hdr);
+        return NULL;
     }
-    val->att_idx = att_idx;
-    val->length = length;
-    memcpy(val->data, data, length);
-
-    return 0;
+    return &ns_ius_env->ccc_val[ns_ius_env->val_slot[att_idx] * BLE_CONNECTION_MAX];
 }
 /** 
- * @brief Read characteristic value from.
- * Function checks if attribute exists, and if so return its length and pointer to data.
- * @param[in]  att_idx  Custom attribute index.
- * @param[out] length   Pointer to variable that receive length of the attribute.
- * @param[out] data     Pointer to variable that receive pointer characteristic value.
- * @return 0 on success, ATT_ERR_ATTRIBUTE_NOT_FOUND if there is no value for such attribyte. 
+ * @brief Size of the CCC value table of a service.
+ * @param[in]  att_db     Custom service attribute definition table.
+ * @param[in]  max_nb_att Number of elements in att_db. 
+ * @return Bytes to allocate after the profile environment. 
  */
-static int ns_ius_att_get_value(uint8_t att_idx, uint16_t *length, const uint8_t **data)
+uint16_t ns_ius_ccc_table_size(const struct attm_desc_128 *att_db, int max_nb_att)
 {
-    struct ns_ius_env_tag *ns_ius_env = PRF_ENV_GET(NS_IUS, ns_ius);
-    struct ns_ius_val_elmt *val = (struct ns_ius_val_elmt *) co_list_pick(&ns_ius_env->values);
-	
-    while (val != NULL)
+    uint16_t size = max_nb_att;
+    for (int i = 1; i < max_nb_att; i++)
     {
-        if (val->att_idx == att_idx)
+        if (ns_ius_is_ccc(&att_db[i]))
         {
-            *length = val->length;
-            *data = val->data;
-            break;
+            size += BLE_CONNECTION_MAX;
         }
-
-        val = (struct ns_ius_val_elmt *)val->hdr.next;
-    }
-
-    if (val == NULL)
-    {
-        *length = 0;
-        *data = NULL;
     }
-    return val ? 0 : ATT_ERR_ATTRIBUTE_NOT_FOUND;
+    return size;
 }
 /** 
  * @brief Sets initial values for all Clinet Characteristic Configurations.
+ * @details The table sized by ns_ius_ccc_table_size follows the environment:
+ *          one slot index per attribute, then BLE_CONNECTION_MAX bytes per CCC.
  * @param[in]  att_db     Custom service attribute definition table.
  * @param[in]  max_nb_att Number of elements in att_db. 
  */
 void ns_ius_init_ccc_values(const struct attm_desc_128 *att_db, int max_nb_att)
 {
-    uint8_t ccc_values[BLE_CONNECTION_MAX] = {0};
+    struct ns_ius_env_tag *ns_ius_env = PRF_ENV_GET(NS_IUS, ns_ius);
+    uint8_t nb_ccc = 0;
+
+    ns_ius_env->val_slot = (uint8_t *)(ns_ius_env + 1);
+    ns_ius_env->ccc_val = ns_ius_env->val_slot + max_nb_att;
+    ns_ius_env->val_slot[0] = NS_IUS_VAL_NO_SLOT;
     for (int i = 1; i < max_nb_att; i++)
     {
-			if( PERM_GET(att_db[i].perm, UUID_LEN) == PERM_UUID_16 && (att_db[i].uuid[0] + (att_db[i].uuid[1]<<8) ) == ATT_DESC_CLIENT_CHAR_CFG)
-			{
-				ns_ius_att_set_value(i, sizeof(ccc_values), ccc_values);
-			}
-	}
+        ns_ius_env->val_slot[i] = ns_ius_is_ccc(&att_db[i]) ? nb_ccc++ : NS_IUS_VAL_NO_SLOT;
+    }
+    memset(ns_ius_env->ccc_val, 0, nb_ccc * BLE_CONNECTION_MAX);
 }
 /** 
  * @brief Set value of CCC for given attribute and connection index.
@@ -139,17 +117,14 @@ void ns_ius_init_ccc_values(const struct attm_desc_128 *att_db, int max_nb_att)
  */
 void ns_ius_set_ccc_value(uint8_t conidx, uint8_t att_idx, uint16_t ccc)
 {
-    uint16_t length;
-    const uint8_t *value;
-    uint8_t new_value[BLE_CONNECTION_MAX];
+    uint8_t *value = ns_ius_ccc_slot(PRF_ENV_GET(NS_IUS, ns_ius), att_idx);
     ASSERT_ERR(conidx < BLE_CONNECTION_MAX);
-
-    ns_ius_att_get_value(att_idx, &length, &value);
-    ASSERT_ERR(length);
     ASSERT_ERR(value);
-    memcpy(new_value, value, length);
-    new_value[conidx] = (uint8_t)ccc;
-    ns_ius_att_set_value(att_idx, length, new_value);
+
+    if (value != NULL)
+    {
+        value[conidx] = (uint8_t)ccc;
+    }
 }
 /** 
  * @brief Read value of CCC for given attribute and connection index.
@@ -159,12 +134,8 @@ void ns_ius_set_ccc_value(uint8_t conidx, uint8_t att_idx, uint16_t ccc)
  */
 static uint16_t ns_ius_get_ccc_value(uint8_t conidx, uint8_t att_idx)
 {
-    uint16_t length;
-    const uint8_t *value;
-    uint16_t ccc_value;
-    ns_ius_att_get_value(att_idx, &length, &value);
-    ccc_value = value[conidx];
-    return ccc_value;
+    const uint8_t *value = ns_ius_ccc_slot(PRF_ENV_GET(NS_IUS, ns_ius), att_idx);
+    return (value != NULL) ? value[conidx] : 0;
 }
 
 static uint8_t ns_ius_get_att_idx(uint16_t handle, uint8_t *att_idx)
@@ -62,6 +62,7 @@
 #include "ke_mem.h"
 #include "co_utils.h"
 #include "co_error.h"
+#include "ns_crc.h"
 
 #endif /* (BLE_SERVER_PRF || BLE_CLIENT_PRF) */
 
@@ -494,38 +495,7 @@ uint8_t prf_unpack_date_time(uint8_t *packed_date, struct prf_date_time* date_ti
 #if ((BLE_CGM_SERVER || BLE_CGM_CLIENT))
 uint16_t prf_e2e_crc(const uint8_t * buf, uint16_t length)
 {
-    uint16_t crc_reg = 0xffff; // initial seed
-    uint8_t reg;
-    uint16_t crc;
-    int i, j;
-    
-    for(i=0; i < length; i++)
-    {
-      reg = *buf++;
-      for(j=0; j<8; j++)
-      {
-        if ((reg & 1) != ((crc_reg>>15)& 1))
-        {
-          crc_reg <<= 1;
-          crc_reg ^= (uint16_t)(1<<12) | (1<<5) | (1<<0);
-        }
-        else
-        {
-          crc_reg <<= 1;
-        }
-        reg >>= 1;
-      }
-    }
-    
-    crc = 0;
-    // result is in the order bits:->8 9 10 11 12 13 14 15 0 1 2 3 4 5 6 7
-    for(j=0; j<8; j++)
-    {
-      crc >>= 1;
-      crc |= crc_reg & ((1<<15) | (1<<7));
-      crc_reg <<= 1;
-    }
-    return crc;
+    return ns_crc16_e2e(buf, length);
 }
 #endif /* ((BLE_CGM_SERVER || BLE_CGM_CLIENT)) */
 
@@ -50,6 +50,17 @@
 
 #define RDTSS_IDX_MAX        (1)
 
+/// Notifications in flight per connection (1 to 16), more keeps every connection event filled
+#ifndef RDTSS_NTF_WINDOW
+#define RDTSS_NTF_WINDOW     (4)
+#endif
+
+/// Flag of the last fragment of a request in rdtss_ntf_conn.frag
+#define RDTSS_NTF_LAST       (0x8000)
+
+/// Attribute without value in rdtss_env_tag.val_slot
+#define RDTSS_VAL_NO_SLOT    (0xFF)
+
 /* Public typedef -----------------------------------------------------------*/
 /// Parameters for the database creation
 struct rdtss_db_cfg
@@ -61,17 +72,32 @@ struct rdtss_db_cfg
 
 };
 
-/// Value element
-struct rdtss_val_elmt
+/// Notification pipeline of one connection
+struct rdtss_ntf_conn
 {
-    /// list element header
-    struct co_list_hdr hdr;
-    /// value identifier
-    uint8_t att_idx;
-    /// value length
-    uint8_t length;
-    /// value data
-    uint8_t data[__ARRAY_EMPTY];
+    /// RDTSS_VAL_NTF_REQ messages not fully sent, the first one is being fragmented
+    struct co_list wait;
+    /// RDTSS_VAL_NTF_REQ messages fully sent, waiting for the completion of their last fragment
+    struct co_list sent;
+    /// Offset of the next fragment in the first waiting request
+    uint16_t offset;
+    /// Sequence number of the next GATTC_SEND_EVT_CMD
+    uint16_t seq_num;
+    /// Fragments in flight, oldest first: length, RDTSS_NTF_LAST marks the end of a request
+    uint16_t frag[RDTSS_NTF_WINDOW];
+    /// Index of the oldest fragment in flight
+    uint8_t head;
+    /// Number of fragments in flight
+    uint8_t in_flight;
+    /// First error reported for the request being completed
+    uint8_t status;
+    /// Highest number of fragments in flight since the last statistics reset
+    uint8_t in_flight_max;
+    /// Statistics: notified bytes, notifications and time window (half slots)
+    uint32_t bytes;
+    uint32_t ntf_cnt;
+    uint32_t first_hs;
+    uint32_t last_hs;
 };
 
 /// rdtss environment variable
@@ -91,8 +117,12 @@ struct rdtss_env_tag
     /// CCC handle index, used during notification/indication busy state
     uint8_t ccc_idx;
 
-    /// List of values set by application
-    struct co_list values;
+    /// Value slot of each attribute, RDTSS_VAL_NO_SLOT if none
+    uint8_t *val_slot;
+    /// CCC values, BLE_CONNECTION_MAX bytes per slot
+    uint8_t *ccc_val;
+    /// Notification pipelines
+    struct rdtss_ntf_conn ntf[BLE_CONNECTION_MAX];
     /// RDTSS task state
     ke_state_t state[RDTSS_IDX_MAX];
     /// RDTSS data base configer
@@ -109,6 +139,13 @@ struct rdtss_env_tag
 void rdtss_disable(uint16_t conhdl);
 
 const struct prf_task_cbs *rdtss_prf_itf_get(void);
+
+/** 
+ * @brief Drop the notifications queued for a connection, without confirmation
+ * @param[in] rdtss_env  Profile environment
+ * @param[in] conidx     Connection index
+ */
+void rdtss_ntf_flush(struct rdtss_env_tag *rdtss_env, uint8_t conidx);
     
 /** 
  * Initialize task handler
@@ -248,6 +248,33 @@ struct rdtss_att_info_rsp
     uint8_t  status;
 };
 
+/// Notification throughput of a connection, see rdtss_ntf_stats_get
+struct rdtss_ntf_stats
+{
+    /// Payload bytes notified
+    uint32_t bytes;
+    /// Notifications (fragments) sent over the air
+    uint32_t ntf_cnt;
+    /// Time from the first fragment to the last completion
+    uint32_t elapsed_ms;
+    /// Average payload throughput
+    uint32_t bytes_per_s;
+    /// Average notifications per connection event, times 100
+    uint16_t ntf_per_event_x100;
+    /// Highest number of notifications in flight
+    uint8_t  in_flight_max;
+};
+
+/** 
+ * @brief Size of the Client Characteristic Configuration table of a service.
+ * @details rdtss_init_ccc_values lays the table out after struct rdtss_env_tag,
+ *          the environment must be allocated with this many extra bytes.
+ * @param[in] att_db         Custom service attribute definition table.
+ * @param[in] max_nb_att     Number of elements in att_db.
+ * @return Size of the table in bytes.
+ */
+uint16_t rdtss_ccc_table_size(const struct attm_desc_128 *att_db, int max_nb_att);
+
 /** 
  * @brief Initialize Client Characteristic Configuration fields.
  * @details Function initializes all CCC fields to default value.
@@ -265,6 +292,22 @@ void rdtss_init_ccc_values(const struct attm_desc_128 *att_db, int max_nb_att);
  */
 void rdtss_set_ccc_value(uint8_t conidx, uint8_t att_idx, uint16_t ccc);
 
+/** 
+ * @brief Read the notification throughput of a connection since the last reset.
+ * @details RDTSS_VAL_NTF_REQ values longer than the ATT MTU are sent as several
+ *          notifications, up to RDTSS_NTF_WINDOW of them in flight.
+ * @param[in]  conidx        Connection index.
+ * @param[in]  con_interval  Current connection interval (1.25 ms unit), 0 if unknown.
+ * @param[out] p_stats       Statistics.
+ */
+void rdtss_ntf_stats_get(uint8_t conidx, uint16_t con_interval, struct rdtss_ntf_stats *p_stats);
+
+/** 
+ * @brief Restart the notification throughput measurement of a connection.
+ * @param[in] conidx         Connection index.
+ */
+void rdtss_ntf_stats_reset(uint8_t conidx);
+
 
 #endif // BLE_RDTSS_SERVER
 #endif // __RDTSS_TASK_PRF_H
@@ -85,7 +85,8 @@ static uint8_t rdtss_init(struct prf_task_env *env, uint16_t *start_hdl, uint16_
     if (status == ATT_ERR_NO_ERROR)
     {
         struct rdtss_env_tag *rdtss_env =
-                (struct rdtss_env_tag *) ke_malloc(sizeof(struct rdtss_env_tag), KE_MEM_ATT_DB);
+                (struct rdtss_env_tag *) ke_malloc(sizeof(struct rdtss_env_tag)
+                        + rdtss_ccc_table_size(params->att_tbl, params->max_nb_att), KE_MEM_ATT_DB);
         
         //load config from init 
         memcpy(&rdtss_env->db_cfg,params,sizeof(struct rdtss_db_cfg));
@@ -103,7 +104,7 @@ static uint8_t rdtss_init(struct prf_task_env *env, uint16_t *start_hdl, uint16_
 
         rdtss_task_init(&(env->desc));
         
-        co_list_init(&(rdtss_env->values));
+        memset(rdtss_env->ntf, 0, sizeof(rdtss_env->ntf));
         rdtss_init_ccc_values(rdtss_env->db_cfg.att_tbl, rdtss_env->db_cfg.max_nb_att);
 
         // service is ready, go into an Idle state
@@ -122,12 +123,12 @@ static uint8_t rdtss_init(struct prf_task_env *env, uint16_t *start_hdl, uint16_
 static void rdtss_destroy(struct prf_task_env *env)
 {
     struct rdtss_env_tag *rdtss_env = (struct rdtss_env_tag *)env->env;
+    uint8_t conidx;
 
-    // remove all values present in list
-    while (!co_list_is_empty(&(rdtss_env->values)))
+    // drop the queued notifications
+    for (conidx = 0; conidx < BLE_CONNECTION_MAX; conidx++)
     {
-        struct co_list_hdr *hdr = co_list_pop_front(&(rdtss_env->values));
-        ke_free(hdr);
+        rdtss_ntf_flush(rdtss_env, conidx);
     }
 
     // free profile environment variables
@@ -159,6 +160,10 @@ static void rdtss_create(struct prf_task_env *env, uint8_t conidx)
             rdtss_set_ccc_value(conidx, att_idx, 0);
         }
     }
+
+    // Start the throughput statistics with the connection
+    rdtss_ntf_flush(rdtss_env, conidx);
+    rdtss_ntf_stats_reset(conidx);
 }
 
 /** 
@@ -188,6 +193,9 @@ static void rdtss_cleanup(struct prf_task_env *env, uint8_t conidx, uint8_t reas
             rdtss_set_ccc_value(conidx, att_idx, 0);
         }
     }
+
+    // Link is gone, queued notifications will never be sent
+    rdtss_ntf_flush(rdtss_env, conidx);
 }
 
 /* Public variables ---------------------------------------------------------*/
@@ -50,53 +50,35 @@
 #include "prf_utils.h"
 #include "ke_mem.h"
 #include "co_utils.h"
+#include "co_math.h"
+#include "gattc.h"
+#include "rwip.h"
 /* Private functions ---------------------------------------------------------*/
 
 /** 
- * @brief Stores characteristic value.
- * @param[in] att_idx  Custom attribut index.
- * @param[in] length   Value length.
- * @param[in] data     Pointer to value data.
- * @return 0 on success. 
+ * @brief Tell whether an attribute is a Client Characteristic Configuration descriptor.
+ * @param[in] att  Attribute description.
+ * @return true for a CCC descriptor. 
  */
-static int rdtss_att_set_value(uint8_t att_idx, uint16_t length, const uint8_t *data)
+static bool rdtss_is_ccc(const struct attm_desc_128 *att)
 {
-    struct rdtss_env_tag *rdtss_env = PRF_ENV_GET(RDTSS, rdtss);
-    // Check value in already present in service
-    struct rdtss_val_elmt *val = (struct rdtss_val_elmt *) co_list_pick(&(rdtss_env->values));
-    // loop until value found
-    while (val != NULL)
-    {
-        // value is present in service
-        if (val->att_idx == att_idx)
-        {
-            // Value present but size changed, free old value
-            if (length != val->length)
-            {
-                //co_list_extract(&rdtss_env->values, &val->hdr, 0);
-                co_list_extract(&rdtss_env->values, &val->hdr);        //lxm
-
-                ke_free(val);
-                val = NULL;
-            }
-            break;
-        }
-
-        val = (struct rdtss_val_elmt *)val->hdr.next;
-    }
+    return (PERM_GET(att->perm, UUID_LEN) == PERM_UUID_16)
+        && ((att->uuid[0] + (att->uuid[1] << 8)) == ATT_DESC_CLIENT_CHAR_CFG);
+}
 
-    if (val == NULL)
+/** 
+ * @brief Find the CCC values of an attribute, one byte per connection.
+ * @param[in] rdtss_env  Profile environment.
+ * @param[in] att_idx    Custom attribute index.
+ * @return Slot of BLE_CONNECTION_MAX bytes, NULL if the attribute is not a CCC. 
+ */
+static uint8_t *rdtss_ccc_slot(struct rdtss_env_tag *rdtss_env, uint8_t att_idx)
+{
+    if ((att_idx >= rdtss_env->max_nb_att) || (rdtss_env->val_slot[att_idx] == RDTSS_VAL_NO_SLOT))
     {
-        // allocate value data
-        val = (struct rdtss_val_elmt *) ke_malloc(sizeof(struct rdtss_val_elmt) + length, KE_MEM_ATT_DB);
-        // insert value into the list
-        co_list_push_back(&rdtss_env->values, &val->hdr);
+        return NULL;
     }
-    val->att_idx = att_idx;
-    val->length = length;
-    memcpy(val->data, data, length);
-
-    return 0;
+    return &rdtss_env->ccc_val[rdtss_env->val_slot[att_idx] * BLE_CONNECTION_MAX];
 }
 
 /** 
@@ -110,54 +92,59 @@ static int rdtss_att_set_value(uint8_t att_idx, uint16_t length, const uint8_t *
 static int rdtss_att_get_value(uint8_t att_idx, uint16_t *length, const uint8_t **data)
 {
     struct rdtss_env_tag *rdtss_env = PRF_ENV_GET(RDTSS, rdtss);
-    // Check value in already present in service
-    struct rdtss_val_elmt *val = (struct rdtss_val_elmt *) co_list_pick(&rdtss_env->values);
     ASSERT_ERR(data);
     ASSERT_ERR(length);
 
-    // loop until value found
-    while (val != NULL)
-    {
-        // value is present in service
-        if (val->att_idx == att_idx)
-        {
-            *length = val->length;
-            *data = val->data;
-            break;
-        }
+    *data = rdtss_ccc_slot(rdtss_env, att_idx);
+    *length = (*data != NULL) ? BLE_CONNECTION_MAX : 0;
 
-        val = (struct rdtss_val_elmt *)val->hdr.next;
-    }
+    return (*data != NULL) ? 0 : ATT_ERR_ATTRIBUTE_NOT_FOUND;
+}
 
-    if (val == NULL)
+/** 
+ * @brief Size of the CCC value table of a service.
+ * @param[in]  att_db     Custom service attribute definition table.
+ * @param[in]  max_nb_att Number of elements in att_db. 
+ * @return Bytes to allocate after the profile environment. 
+ */
+uint16_t rdtss_ccc_table_size(const struct attm_desc_128 *att_db, int max_nb_att)
+{
+    uint16_t size = max_nb_att;
+    int i;
+    // Start form 1, skip service description
+    for (i = 1; i < max_nb_att; i++)
     {
-        *length = 0;
-        *data = NULL;
+        if (rdtss_is_ccc(&att_db[i]))
+        {
+            size += BLE_CONNECTION_MAX;
+        }
     }
-    return val ? 0 : ATT_ERR_ATTRIBUTE_NOT_FOUND;
+    return size;
 }
 
 /** 
  * @brief Sets initial values for all Clinet Characteristic Configurations.
+ * @details The table sized by rdtss_ccc_table_size follows the environment:
+ *          one slot index per attribute, then BLE_CONNECTION_MAX bytes per CCC.
  * @param[in]  att_db     Custom service attribute definition table.
  * @param[in]  max_nb_att Number of elements in att_db. 
  */
 void rdtss_init_ccc_values(const struct attm_desc_128 *att_db, int max_nb_att)
 {
-    // Default values 0 means no notification
-    uint8_t ccc_values[BLE_CONNECTION_MAX] = {0};
+    struct rdtss_env_tag *rdtss_env = PRF_ENV_GET(RDTSS, rdtss);
+    uint8_t nb_ccc = 0;
     int i;
+
+    rdtss_env->val_slot = (uint8_t *)(rdtss_env + 1);
+    rdtss_env->ccc_val = rdtss_env->val_slot + max_nb_att;
+    rdtss_env->val_slot[0] = RDTSS_VAL_NO_SLOT;
     // Start form 1, skip service description
     for (i = 1; i < max_nb_att; i++)
     {
-        if( PERM_GET(att_db[i].perm, UUID_LEN) == PERM_UUID_16 &&
-            (att_db[i].uuid[0] + (att_db[i].uuid[1]<<8) ) == ATT_DESC_CLIENT_CHAR_CFG
-        )
-        {
-            // Set default values for all possible connections
-            rdtss_att_set_value(i, sizeof(ccc_values), ccc_values);
-        }
+        rdtss_env->val_slot[i] = rdtss_is_ccc(&att_db[i]) ? nb_ccc++ : RDTSS_VAL_NO_SLOT;
     }
+    // Default values 0 means no notification
+    memset(rdtss_env->ccc_val, 0, nb_ccc * BLE_CONNECTION_MAX);
 }
 
 /** 
@@ -168,18 +155,15 @@ void rdtss_init_ccc_values(const struct attm_desc_128 *att_db, int max_nb_att)
  */
 void rdtss_set_ccc_value(uint8_t conidx, uint8_t att_idx, uint16_t ccc)
 {
-    uint16_t length;
-    const uint8_t *value;
-    uint8_t new_value[BLE_CONNECTION_MAX];
+    uint8_t *value = rdtss_ccc_slot(PRF_ENV_GET(RDTSS, rdtss), att_idx);
     ASSERT_ERR(conidx < BLE_CONNECTION_MAX);
-
-    rdtss_att_get_value(att_idx, &length, &value);
-    ASSERT_ERR(length);
     ASSERT_ERR(value);
-    memcpy(new_value, value, length);
+
     // For now there are only two valid values for ccc, store just one byte other is 0 anyway
-    new_value[conidx] = (uint8_t)ccc;
-    rdtss_att_set_value(att_idx, length, new_value);
+    if (value != NULL)
+    {
+        value[conidx] = (uint8_t)ccc;
+    }
 }
 
 /** 
@@ -192,7 +176,6 @@ static uint16_t rdtss_get_ccc_value(uint8_t conidx, uint8_t att_idx)
 {
     uint16_t length;
     const uint8_t *value;
-    uint16_t ccc_value;
 
     ASSERT_ERR(conidx < BLE_CONNECTION_MAX);
 
@@ -200,9 +183,200 @@ static uint16_t rdtss_get_ccc_value(uint8_t conidx, uint8_t att_idx)
     ASSERT_ERR(length);
     ASSERT_ERR(value);
 
-    ccc_value = value[conidx];
+    return (value != NULL) ? value[conidx] : 0;
+}
+
+/** 
+ * @brief Send notifications while the window of the connection has room.
+ * @details Values longer than the ATT MTU are cut in MTU sized fragments, the
+ *          request is held until the completion of its last fragment.
+ * @param[in] rdtss_env  Profile environment.
+ * @param[in] conidx     Connection index.
+ */
+static void rdtss_ntf_send(struct rdtss_env_tag *rdtss_env, uint8_t conidx)
+{
+    struct rdtss_ntf_conn *ntf = &rdtss_env->ntf[conidx];
+    uint16_t frag_max;
+
+    ASSERT_ERR(conidx < BLE_CONNECTION_MAX);
+
+    frag_max = gattc_get_mtu(conidx) - 3;
+
+    while (ntf->in_flight < RDTSS_NTF_WINDOW)
+    {
+        struct ke_msg *msg = (struct ke_msg *) co_list_pick(&ntf->wait);
+        struct rdtss_val_ntf_ind_req *app_req;
+        struct gattc_send_evt_cmd *req;
+        uint16_t length;
+
+        if (msg == NULL)
+        {
+            break;
+        }
+
+        app_req = (struct rdtss_val_ntf_ind_req *)ke_msg2param(msg);
+        length = co_min(app_req->length - ntf->offset, frag_max);
+
+        // Allocate the GATT notification message
+        req = KE_MSG_ALLOC_DYN(GATTC_SEND_EVT_CMD,
+            KE_BUILD_ID(TASK_GATTC, conidx), msg->dest_id, gattc_send_evt_cmd, length);
+
+        // Fill in the parameter structure
+        req->operation = GATTC_NOTIFY;
+        req->seq_num = ntf->seq_num++;
+        req->handle = rdtss_env->shdl + app_req->handle;
+        req->length = length;
+        memcpy(req->value, &app_req->value[ntf->offset], length);
+
+        // Send the event
+        ke_msg_send(req);
+
+        ntf->offset += length;
+        if (ntf->offset >= app_req->length)
+        {
+            // whole value sent, wait for the completion of this fragment
+            co_list_pop_front(&ntf->wait);
+            co_list_push_back(&ntf->sent, &msg->hdr);
+            ntf->offset = 0;
+            length |= RDTSS_NTF_LAST;
+        }
+
+        if (ntf->ntf_cnt == 0 && ntf->in_flight == 0)
+        {
+            ntf->first_hs = rwip_time_get().hs;
+        }
+        ntf->frag[(ntf->head + ntf->in_flight) % RDTSS_NTF_WINDOW] = length;
+        ntf->in_flight++;
+        if (ntf->in_flight > ntf->in_flight_max)
+        {
+            ntf->in_flight_max = ntf->in_flight;
+        }
+    }
+}
+
+/** 
+ * @brief Completion of the oldest notification fragment of a connection.
+ * @param[in] rdtss_env  Profile environment.
+ * @param[in] conidx     Connection index.
+ * @param[in] param      GATTC completion.
+ */
+static void rdtss_ntf_complete(struct rdtss_env_tag *rdtss_env, uint8_t conidx, struct gattc_cmp_evt const *param)
+{
+    struct rdtss_ntf_conn *ntf = &rdtss_env->ntf[conidx];
+    uint16_t frag;
+
+    ASSERT_ERR(conidx < BLE_CONNECTION_MAX);
+
+    // Ignore the completions of fragments dropped by rdtss_ntf_flush
+    if (conidx >= BLE_CONNECTION_MAX || ntf->in_flight == 0 || param->seq_num != (uint16_t)(ntf->seq_num - ntf->in_flight))
+    {
+        return;
+    }
+
+    frag = ntf->frag[ntf->head];
+    ntf->head = (ntf->head + 1) % RDTSS_NTF_WINDOW;
+    ntf->in_flight--;
+
+    if (param->status == GAP_ERR_NO_ERROR)
+    {
+        ntf->bytes += frag & ~RDTSS_NTF_LAST;
+        ntf->ntf_cnt++;
+        ntf->last_hs = rwip_time_get().hs;
+    }
+    else if (ntf->status == GAP_ERR_NO_ERROR)
+    {
+        ntf->status = param->status;
+    }
+
+    if (frag & RDTSS_NTF_LAST)
+    {
+        struct ke_msg *msg = (struct ke_msg *) co_list_pop_front(&ntf->sent);
+        struct rdtss_val_ntf_ind_req *app_req = (struct rdtss_val_ntf_ind_req *)ke_msg2param(msg);
+
+        // Inform the application that the notification PDU has been sent over the air.
+        struct rdtss_val_ntf_cfm *cfm = KE_MSG_ALLOC(RDTSS_VAL_NTF_CFM,
+                                                      msg->src_id, msg->dest_id,
+                                                      rdtss_val_ntf_cfm);
+        cfm->handle = app_req->handle;
+        cfm->status = ntf->status;
+        ke_msg_send(cfm);
+
+        ntf->status = GAP_ERR_NO_ERROR;
+        ke_free(msg);
+    }
+
+    rdtss_ntf_send(rdtss_env, conidx);
+}
+
+void rdtss_ntf_flush(struct rdtss_env_tag *rdtss_env, uint8_t conidx)
+{
+    struct rdtss_ntf_conn *ntf = &rdtss_env->ntf[conidx];
+
+    ASSERT_ERR(conidx < BLE_CONNECTION_MAX);
+    if (conidx >= BLE_CONNECTION_MAX)
+    {
+        return;
+    }
+
+    while (!co_list_is_empty(&ntf->wait))
+    {
+        ke_free(co_list_pop_front(&ntf->wait));
+    }
+    while (!co_list_is_empty(&ntf->sent))
+    {
+        ke_free(co_list_pop_front(&ntf->sent));
+    }
+    // keep seq_num running so that late completions do not match
+    ntf->offset = 0;
+    ntf->head = 0;
+    ntf->in_flight = 0;
+    ntf->status = GAP_ERR_NO_ERROR;
+}
+
+void rdtss_ntf_stats_get(uint8_t conidx, uint16_t con_interval, struct rdtss_ntf_stats *p_stats)
+{
+    struct rdtss_env_tag *rdtss_env = PRF_ENV_GET(RDTSS, rdtss);
+    struct rdtss_ntf_conn *ntf = &rdtss_env->ntf[conidx];
+    uint32_t elapsed_hs;
+    uint32_t events;
+
+    ASSERT_ERR(conidx < BLE_CONNECTION_MAX);
+    if (conidx >= BLE_CONNECTION_MAX)
+    {
+        memset(p_stats, 0, sizeof(*p_stats));
+        return;
+    }
+
+    // half slot is 312.5 us
+    elapsed_hs = ntf->ntf_cnt ? CLK_SUB(ntf->last_hs, ntf->first_hs) : 0;
+
+    p_stats->bytes = ntf->bytes;
+    p_stats->ntf_cnt = ntf->ntf_cnt;
+    p_stats->elapsed_ms = (elapsed_hs * 5) / 16;
+    p_stats->bytes_per_s = elapsed_hs ? (uint32_t)(((uint64_t)ntf->bytes * 3200) / elapsed_hs) : 0;
+    p_stats->in_flight_max = ntf->in_flight_max;
+
+    // a connection interval is 4 half slots per 1.25 ms unit, count the first event too
+    events = con_interval ? (elapsed_hs / (4 * (uint32_t)con_interval) + 1) : 0;
+    p_stats->ntf_per_event_x100 = events ? (uint16_t)co_min((ntf->ntf_cnt * 100) / events, 0xFFFF) : 0;
+}
+
+void rdtss_ntf_stats_reset(uint8_t conidx)
+{
+    struct rdtss_env_tag *rdtss_env = PRF_ENV_GET(RDTSS, rdtss);
+    struct rdtss_ntf_conn *ntf = &rdtss_env->ntf[conidx];
+
+    ASSERT_ERR(conidx < BLE_CONNECTION_MAX);
+    if (conidx >= BLE_CONNECTION_MAX)
+    {
+        return;
+    }
 
-    return ccc_value;
+    ntf->bytes = 0;
+    ntf->ntf_cnt = 0;
+    ntf->in_flight_max = ntf->in_flight;
+    ntf->first_hs = rwip_time_get().hs;
+    ntf->last_hs = ntf->first_hs;
 }
 
 /** 
@@ -227,31 +401,22 @@ static int gattc_cmp_evt_handler(ke_msg_id_t const msgid,
 {
     struct rdtss_env_tag *rdtss_env = PRF_ENV_GET(RDTSS, rdtss);
   
-    if (param->operation == GATTC_NOTIFY || param->operation == GATTC_INDICATE)
+    if (param->operation == GATTC_NOTIFY)
+    {
+        rdtss_ntf_complete(rdtss_env, KE_IDX_GET(src_id), param);
+    }
+    else if (param->operation == GATTC_INDICATE)
     {
         //TODO
         struct rdtss_val_ntf_ind_req *app_req = (struct rdtss_val_ntf_ind_req *)ke_msg2param(rdtss_env->operation);
 
-        if (param->operation  == GATTC_NOTIFY)
-        {
-            // Inform the application that the notification PDU has been sent over the air.
-            struct rdtss_val_ntf_cfm *cfm = KE_MSG_ALLOC(RDTSS_VAL_NTF_CFM,
-                                                          rdtss_env->operation->src_id, rdtss_env->operation->dest_id,
-                                                          rdtss_val_ntf_cfm);
-            cfm->handle = app_req->handle;
-            cfm->status = GAP_ERR_NO_ERROR;
-            ke_msg_send(cfm);
-        }
-        else
-        {
-            // Inform the application that the indication has been confirmed by the peer device.
-            struct rdtss_val_ind_cfm *cfm = KE_MSG_ALLOC(RDTSS_VAL_IND_CFM,
-                                                          rdtss_env->operation->src_id, rdtss_env->operation->dest_id,
-                                                          rdtss_val_ind_cfm);
-            cfm->handle = app_req->handle;
-            cfm->status = GAP_ERR_NO_ERROR;
-            ke_msg_send(cfm);
-        }     
+        // Inform the application that the indication has been confirmed by the peer device.
+        struct rdtss_val_ind_cfm *cfm = KE_MSG_ALLOC(RDTSS_VAL_IND_CFM,
+                                                      rdtss_env->operation->src_id, rdtss_env->operation->dest_id,
+                                                      rdtss_val_ind_cfm);
+        cfm->handle = app_req->handle;
+        cfm->status = GAP_ERR_NO_ERROR;
+        ke_msg_send(cfm);
         
         if(rdtss_env->operation)
         {    
@@ -304,12 +469,8 @@ static int rdtss_val_ntf_req_handler(ke_msg_id_t const msgid,
     uint8_t conidx = param->conidx;
     uint8_t ccc_idx;
     uint8_t status;
-    uint8_t state = ke_state_get(dest_id);
-
-    if (state ==  RDTSS_BUSY)
-    {
-        return KE_MSG_SAVED;
-    }
+    uint16_t length;
+    const uint8_t *ccc_values;
 
     // Find the handle of the Characteristic Client Configuration
     ccc_hdl = get_cfg_handle(handle);
@@ -321,42 +482,31 @@ static int rdtss_val_ntf_req_handler(ke_msg_id_t const msgid,
     if (status != ATT_ERR_NO_ERROR)
     {
         NS_LOG_ERROR("status err:%d\r\n", status);
-        return KE_MSG_SAVED;
+        return KE_MSG_CONSUMED;
     }             
-    rdtss_env->operation = ke_param2msg(param);
-    rdtss_env->cursor = conidx;
-    rdtss_env->ccc_idx = ccc_idx;
 
-    //TODO
-    uint16_t length;
-    const uint8_t *ccc_values;
-    rdtss_att_get_value(rdtss_env->ccc_idx, &length, &ccc_values);
-    struct rdtss_val_ntf_ind_req *app_req = (struct rdtss_val_ntf_ind_req *)ke_msg2param(rdtss_env->operation);
+    rdtss_att_get_value(ccc_idx, &length, &ccc_values);
+
+    ASSERT_ERR(conidx < BLE_CONNECTION_MAX);
 
-    if ( (ccc_values[conidx] & PRF_CLI_START_NTF)  || (ccc_values[conidx] & PRF_CLI_START_IND) )
+    if ((conidx < BLE_CONNECTION_MAX)
+        && ((ccc_values[conidx] & PRF_CLI_START_NTF) || (ccc_values[conidx] & PRF_CLI_START_IND)))
     {
-        struct gattc_send_evt_cmd *req;
-        // Allocate the GATT notification message
-        req = KE_MSG_ALLOC_DYN(GATTC_SEND_EVT_CMD,
-            KE_BUILD_ID(TASK_GATTC, conidx), rdtss_env->operation->dest_id, gattc_send_evt_cmd, app_req->length);
+        // Queue the request, it is confirmed once all its fragments are sent
+        co_list_push_back(&rdtss_env->ntf[conidx].wait, &ke_param2msg(param)->hdr);
+        rdtss_ntf_send(rdtss_env, conidx);
 
-        // Fill in the parameter structure
-        req->operation =  GATTC_NOTIFY;
-        req->handle = rdtss_env->shdl + app_req->handle;
-        req->length = app_req->length;
-        memcpy(req->value, app_req->value, app_req->length);
-        
-        // Send the event
-        ke_msg_send(req);
-        
-        ke_state_set(dest_id, RDTSS_BUSY);
+        return KE_MSG_NO_FREE;
     }
     else
     {
-        //TODO FREE
-        ke_free(rdtss_env->operation);
+        struct rdtss_val_ntf_cfm *cfm = KE_MSG_ALLOC(RDTSS_VAL_NTF_CFM, src_id, dest_id, rdtss_val_ntf_cfm);
+
+        cfm->handle = param->handle;
+        cfm->status = PRF_ERR_NTF_DISABLED;
+        ke_msg_send(cfm);
     }
-    return KE_MSG_NO_FREE;
+    return KE_MSG_CONSUMED;
 }
 
 /** 
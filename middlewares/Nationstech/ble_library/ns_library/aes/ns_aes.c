@@ -144,6 +144,15 @@ void ns_aes_xor_128_msb(uint8_t* result, const uint8_t* a, const uint8_t* b, uin
     }
 }
 
+bool ns_aes_continue_cb(struct aes_cache_env* aes_env, uint8_t* aes_res)
+{
+    uint8_t res_cache[KEY_LEN];
+    ns_ase_swap_array(res_cache, aes_res, KEY_LEN);
+    aes_env->aes_env.aes_res_cb(true,res_cache,aes_env->aes_env.src_info);
+    aes_env->aes_env.aes_res_cb = NULL; //result has been return, cancel res_cb
+    return true;
+}
+
 #if AES_DECRYPT_ENABLE
 /**
  * @brief  AES result handler
@@ -220,16 +229,6 @@ __STATIC void ns_rwip_crypt_evt_handler(void)
 }
 
 
-bool ns_aes_continue_cb(struct aes_cache_env* aes_env, uint8_t* aes_res)
-{
-    uint8_t res_cache[KEY_LEN];
-    ns_ase_swap_array(res_cache, aes_res, KEY_LEN);
-    aes_env->aes_env.aes_res_cb(true,res_cache,aes_env->aes_env.src_info);
-    aes_env->aes_env.aes_res_cb = NULL; //result has been return, cancel res_cb
-    return true;
-}
-
-
 /**
  * @brief  aes deciphering
  * @param    
@@ -297,6 +296,7 @@ void ns_aes_start(struct aes_func_env* env, const uint8_t* key, const uint8_t *v
     // AES encryption can be immediately performed
     if(!aes_env.aes_ongoing)
     {
+#if AES_DECRYPT_ENABLE
         if(env->src_info == DECRYPT_SRC_MARK)
         {
             // decrypt mode
@@ -304,6 +304,7 @@ void ns_aes_start(struct aes_func_env* env, const uint8_t* key, const uint8_t *v
             //config AES event callback
             ke_event_callback_set(KE_EVENT_AES_END, &ns_rwip_crypt_evt_handler);
         }
+#endif
         aes_env.aes_ongoing = true;
         rwip_aes_encrypt(env->key, env->val);
     }
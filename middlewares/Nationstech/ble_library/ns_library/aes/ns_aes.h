@@ -70,16 +70,24 @@ void ns_aes_ciphering(uint8_t *key, uint8_t *val, aes_func_result_cb res_cb);
 
 
 /**
- * @brief Start the AES CBC crypto function. Allocate memory for the CBC and start processing it
+ * @brief Start the AES CBC crypto function. Queue the whole message as one AES job (ns_aes_job.h)
  *        Execute result callback at end of function execution
  *
- * @param[in]  key               Pointer to the Key to be used
- * @param[in]  iv                16 Bytes iv to use for cipher/decipher
+ * @param[in]  key               Pointer to the Key to be used (MSB first)
+ * @param[in]  iv                16 Bytes iv to use for cipher/decipher (MSB first)
  * @param[in]  in_message        Input message for AES-CBC exectuion
- * @param[out] out_message       Output message that will contain cipher or decipher data
- * @param[in]  message_len       Length of Input/Output message without mic
+ * @param[out] out_message       Output message that will contain cipher or decipher data, may be in_message
+ * @param[in]  message_len       Length of Input/Output message, a non zero multiple of 16 bytes
  * @param[in]  cipher            True to encrypt message, False to decrypt it.
- * @param[in]  res_cb            Function that will handle the AES CCM result
+ * @param[in]  res_cb            Function that will handle the AES CBC result
+ *
+ * @note The message is no longer padded to a whole block: any other length is refused and
+ *       res_cb is called before returning with CO_ERROR_INVALID_HCI_PARAM and a NULL result.
+ *       On success res_cb gets CO_ERROR_NO_ERROR and a pointer to the last output block
+ *       inside out_message (the CBC-MAC when encrypting), not a copy of the engine result.
+ *       src_info is DECRYPT_SRC_MARK when deciphering, 0 otherwise. Deciphering on the
+ *       BLE core needs AES_DECRYPT_ENABLE, it is refused the same way without it.
+ *       key, iv, in_message and out_message are used in place until res_cb is called.
  */
 void ns_aes_cbc(const uint8_t* key, const uint8_t* iv, const uint8_t* in_message, uint8_t* out_message,
                 bool cipher, uint16_t message_len, aes_func_result_cb res_cb);
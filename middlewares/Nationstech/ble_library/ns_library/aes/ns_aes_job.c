@@ -0,0 +1,702 @@
+/*****************************************************************************
+ * Copyright (c) 2019, Nations Technologies Inc.
+ *
+ * All rights reserved.
+ * ****************************************************************************
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Nations' name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY NATIONS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL NATIONS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ****************************************************************************/
+
+
+/**
+ * @file ns_aes_job.c
+ * @author Nations Firmware Team
+ * @version v1.0.0
+ *
+ * @copyright Copyright (c) 2019, Nations Technologies Inc. All rights reserved.
+ */
+
+/** @addtogroup 
+ * @{
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+#include "ns_aes_job.h"
+#if !NS_AES_JOB_SW_BACKEND
+#include "ns_aes.h"
+#include "reg_access.h"
+#include "reg_ipcore.h"
+#include "em_map.h"
+#endif
+
+/* Private typedef -----------------------------------------------------------*/
+/// Job execution steps
+enum ns_aes_job_state
+{
+    /// CBC block
+    AES_JOB_CBC,
+    /// CCM CBC-MAC of B_0
+    AES_JOB_CCM_B0,
+    /// CCM CBC-MAC of the additional authenticated data
+    AES_JOB_CCM_AAD,
+    /// CCM counter block A_i of the payload
+    AES_JOB_CCM_CTR,
+    /// CCM CBC-MAC of the payload block
+    AES_JOB_CCM_MAC,
+    /// CCM counter block A_0 that masks the MIC
+    AES_JOB_CCM_TAG,
+};
+
+#if !NS_AES_JOB_SW_BACKEND
+/// Same layout as the AES environment of the stack (see ns_aes.c)
+struct aes_env_tag
+{
+    struct co_list  queue;
+    bool aes_ongoing;
+};
+extern struct aes_env_tag aes_env;
+#endif
+
+/// Job queue environment
+struct ns_aes_job_env_tag
+{
+    /// Submitted jobs, the first one owns the engine
+    struct co_list  queue;
+    /// First job started on the engine
+    bool            running;
+#if !NS_AES_JOB_SW_BACKEND
+    /// Key of the running job (LSB first, as loaded by the stack)
+    uint8_t         key[AES_BLOCK_SIZE];
+    /// Value handed to the stack AES queue (LSB first)
+    uint8_t         val[AES_BLOCK_SIZE];
+#else
+    /// Expanded key of the running job
+    uint8_t         round_key[11 * AES_BLOCK_SIZE];
+#endif
+};
+
+/* Private define ------------------------------------------------------------*/
+/// CCM length field size (L)
+#define AES_JOB_CCM_L           2
+/// CCM B_0 flags: Adata bit
+#define AES_JOB_CCM_ADATA_BIT   0x40
+
+/* Private variables ---------------------------------------------------------*/
+static struct ns_aes_job_env_tag ns_aes_job_env;
+
+#if NS_AES_JOB_SW_BACKEND
+static uint8_t aes_sbox[256];
+static uint8_t aes_inv_sbox[256];
+#endif
+
+/* Private functions ---------------------------------------------------------*/
+/**
+ * @brief  Write a CCM block made of flags, nonce and 16-bit big endian field (B_0 or A_i)
+ */
+__STATIC void ns_aes_job_ccm_block(const struct ns_aes_job* job, uint8_t* blk, uint8_t flags, uint16_t field)
+{
+    blk[0] = flags;
+    memcpy(&blk[1], job->iv, NS_AES_JOB_CCM_NONCE_SIZE);
+    blk[AES_BLOCK_SIZE - 2] = (uint8_t)(field >> 8);
+    blk[AES_BLOCK_SIZE - 1] = (uint8_t)field;
+}
+
+/**
+ * @brief  Build in job->blk the next block to give to the engine (MSB first)
+ */
+__STATIC void ns_aes_job_prepare(struct ns_aes_job* job)
+{
+    uint8_t i;
+
+    switch(job->state)
+    {
+        case AES_JOB_CBC:
+        {
+            const uint8_t* m_i = &job->in[job->cursor];
+
+            if(job->mode == NS_AES_JOB_CBC_ENCRYPT)
+            {
+                // Y := X XOR M_i
+                for(i = 0; i < AES_BLOCK_SIZE; i++)
+                {
+                    job->blk[i] = job->chain[i] ^ m_i[i];
+                }
+            }
+            else
+            {
+                memcpy(job->blk, m_i, AES_BLOCK_SIZE);
+            }
+        } break;
+
+        case AES_JOB_CCM_B0:
+        {
+            uint8_t flags = (((job->mic_len - 2) / 2) << 3) | (AES_JOB_CCM_L - 1);
+
+            if(job->aad_len)
+            {
+                flags |= AES_JOB_CCM_ADATA_BIT;
+            }
+            ns_aes_job_ccm_block(job, job->blk, flags, job->len);
+        } break;
+
+        case AES_JOB_CCM_AAD:
+        {
+            // authenticated stream is the 2 bytes length, the data and zero padding
+            for(i = 0; i < AES_BLOCK_SIZE; i++)
+            {
+                uint32_t pos = job->cursor + i;
+                uint8_t  a;
+
+                if(pos < 2)
+                {
+                    a = (uint8_t)(job->aad_len >> (pos ? 0 : 8));
+                }
+                else if(pos - 2 < job->aad_len)
+                {
+                    a = job->aad[pos - 2];
+                }
+                else
+                {
+                    a = 0;
+                }
+                job->blk[i] = job->chain[i] ^ a;
+            }
+        } break;
+
+        case AES_JOB_CCM_CTR:
+        {
+            ns_aes_job_ccm_block(job, job->blk, AES_JOB_CCM_L - 1, (uint16_t)(job->cursor / AES_BLOCK_SIZE + 1));
+        } break;
+
+        case AES_JOB_CCM_MAC:
+        {
+            // payload already XORed in the MAC when its key stream came back
+            memcpy(job->blk, job->chain, AES_BLOCK_SIZE);
+        } break;
+
+        default: // AES_JOB_CCM_TAG
+        {
+            ns_aes_job_ccm_block(job, job->blk, AES_JOB_CCM_L - 1, 0);
+        } break;
+    }
+}
+
+/**
+ * @brief  Consume the engine output of job->blk (MSB first)
+ * @return true when the job is complete, job->status holds the result
+ */
+__STATIC bool ns_aes_job_absorb(struct ns_aes_job* job, const uint8_t* res)
+{
+    uint8_t i;
+
+    switch(job->state)
+    {
+        case AES_JOB_CBC:
+        {
+            uint8_t* o_i = &job->out[job->cursor];
+
+            if(job->mode == NS_AES_JOB_CBC_ENCRYPT)
+            {
+                memcpy(o_i, res, AES_BLOCK_SIZE);
+                memcpy(job->chain, res, AES_BLOCK_SIZE);
+            }
+            else
+            {
+                // job->blk keeps C_i, the output may overwrite the input
+                for(i = 0; i < AES_BLOCK_SIZE; i++)
+                {
+                    o_i[i] = res[i] ^ job->chain[i];
+                }
+                memcpy(job->chain, job->blk, AES_BLOCK_SIZE);
+            }
+            job->cursor += AES_BLOCK_SIZE;
+            return (job->cursor >= job->len);
+        }
+
+        case AES_JOB_CCM_B0:
+        case AES_JOB_CCM_AAD:
+        {
+            memcpy(job->chain, res, AES_BLOCK_SIZE);
+            if(job->state == AES_JOB_CCM_B0)
+            {
+                job->state = AES_JOB_CCM_AAD;
+                job->cursor = 0;
+                if(job->aad_len)
+                {
+                    break;
+                }
+            }
+            else
+            {
+                job->cursor += AES_BLOCK_SIZE;
+                if(job->cursor < (uint32_t)job->aad_len + 2)
+                {
+                    break;
+                }
+            }
+            job->cursor = 0;
+            job->state = job->len ? AES_JOB_CCM_CTR : AES_JOB_CCM_TAG;
+        } break;
+
+        case AES_JOB_CCM_CTR:
+        {
+            const uint8_t* in  = &job->in[job->cursor];
+            uint8_t*       out = &job->out[job->cursor];
+            uint8_t        len = AES_BLOCK_SIZE;
+            bool           cipher = (job->mode == NS_AES_JOB_CCM_ENCRYPT);
+
+            if(job->len - job->cursor < AES_BLOCK_SIZE)
+            {
+                len = job->len - job->cursor;
+            }
+            // MAC covers the plain data: read it before the output may overwrite it
+            for(i = 0; i < len; i++)
+            {
+                uint8_t p = cipher ? in[i] : (in[i] ^ res[i]);
+
+                out[i] = in[i] ^ res[i];
+                job->chain[i] ^= p;
+            }
+            job->state = AES_JOB_CCM_MAC;
+        } break;
+
+        case AES_JOB_CCM_MAC:
+        {
+            memcpy(job->chain, res, AES_BLOCK_SIZE);
+            job->cursor += AES_BLOCK_SIZE;
+            job->state = (job->cursor < job->len) ? AES_JOB_CCM_CTR : AES_JOB_CCM_TAG;
+        } break;
+
+        default: // AES_JOB_CCM_TAG
+        {
+            if(job->mode == NS_AES_JOB_CCM_ENCRYPT)
+            {
+                for(i = 0; i < job->mic_len; i++)
+                {
+                    job->out[job->len + i] = job->chain[i] ^ res[i];
+                }
+            }
+            else
+            {
+                uint8_t diff = 0;
+
+                for(i = 0; i < job->mic_len; i++)
+                {
+                    diff |= job->in[job->len + i] ^ job->chain[i] ^ res[i];
+                }
+                if(diff)
+                {
+                    job->status = NS_AES_JOB_ERR_MIC;
+                }
+            }
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * @brief  Check the job parameters and reset its execution state
+ * @return false if the job can not run
+ */
+__STATIC bool ns_aes_job_init(struct ns_aes_job* job)
+{
+    if((job->key == NULL) || (job->iv == NULL) || (job->cb == NULL))
+    {
+        return false;
+    }
+
+    switch(job->mode)
+    {
+        case NS_AES_JOB_CBC_DECRYPT:
+        {
+            #if !NS_AES_JOB_SW_BACKEND && !AES_DECRYPT_ENABLE
+            return false;
+            #endif
+        } // no break
+        case NS_AES_JOB_CBC_ENCRYPT:
+        {
+            if((job->len == 0) || (job->len % AES_BLOCK_SIZE))
+            {
+                return false;
+            }
+            job->state = AES_JOB_CBC;
+            memcpy(job->chain, job->iv, AES_BLOCK_SIZE);
+        } break;
+
+        case NS_AES_JOB_CCM_ENCRYPT:
+        case NS_AES_JOB_CCM_DECRYPT:
+        {
+            if((job->mic_len < 4) || (job->mic_len > AES_BLOCK_SIZE) || (job->mic_len & 1)
+                || (job->aad_len > 0xFEFF) || (job->aad_len && (job->aad == NULL)))
+            {
+                return false;
+            }
+            job->state = AES_JOB_CCM_B0;
+            memset(job->chain, 0, AES_BLOCK_SIZE);
+        } break;
+
+        default:
+        {
+            return false;
+        }
+    }
+
+    job->cursor = 0;
+    job->status = NS_AES_JOB_OK;
+    return true;
+}
+
+#if NS_AES_JOB_SW_BACKEND
+/**
+ * @brief  Multiply by x in GF(2^8)
+ */
+__STATIC uint8_t aes_xtime(uint8_t a)
+{
+    return (uint8_t)((a << 1) ^ ((a & 0x80) ? 0x1B : 0x00));
+}
+
+/**
+ * @brief  Multiply two elements of GF(2^8)
+ */
+__STATIC uint8_t aes_gmul(uint8_t a, uint8_t b)
+{
+    uint8_t r = 0;
+
+    while(b)
+    {
+        if(b & 1)
+        {
+            r ^= a;
+        }
+        a = aes_xtime(a);
+        b >>= 1;
+    }
+    return r;
+}
+
+/**
+ * @brief  Build the S-boxes (walks the field with generator 3 and its inverse)
+ */
+__STATIC void aes_sbox_init(void)
+{
+    uint8_t p = 1, q = 1;
+
+    do
+    {
+        uint8_t s;
+
+        // p *= 3, q /= 3
+        p = p ^ aes_xtime(p);
+        q ^= q << 1;
+        q ^= q << 2;
+        q ^= q << 4;
+        if(q & 0x80)
+        {
+            q ^= 0x09;
+        }
+        s = q ^ (uint8_t)((q << 1) | (q >> 7)) ^ (uint8_t)((q << 2) | (q >> 6))
+              ^ (uint8_t)((q << 3) | (q >> 5)) ^ (uint8_t)((q << 4) | (q >> 4)) ^ 0x63;
+        aes_sbox[p] = s;
+        aes_inv_sbox[s] = p;
+    } while(p != 1);
+
+    aes_sbox[0] = 0x63;
+    aes_inv_sbox[0x63] = 0;
+}
+
+/**
+ * @brief  AES-128 key expansion of the running job
+ */
+__STATIC void aes_key_expand(const uint8_t* key)
+{
+    uint8_t* w = ns_aes_job_env.round_key;
+    uint8_t  rcon = 1;
+    uint8_t  i;
+
+    if(aes_sbox[0] == 0)
+    {
+        aes_sbox_init();
+    }
+
+    memcpy(w, key, AES_BLOCK_SIZE);
+    for(i = 4; i < 44; i++)
+    {
+        uint8_t t[4];
+
+        memcpy(t, &w[(i - 1) * 4], 4);
+        if((i & 3) == 0)
+        {
+            uint8_t t0 = t[0];
+
+            t[0] = aes_sbox[t[1]] ^ rcon;
+            t[1] = aes_sbox[t[2]];
+            t[2] = aes_sbox[t[3]];
+            t[3] = aes_sbox[t0];
+            rcon = aes_xtime(rcon);
+        }
+        w[i * 4 + 0] = w[(i - 4) * 4 + 0] ^ t[0];
+        w[i * 4 + 1] = w[(i - 4) * 4 + 1] ^ t[1];
+        w[i * 4 + 2] = w[(i - 4) * 4 + 2] ^ t[2];
+        w[i * 4 + 3] = w[(i - 4) * 4 + 3] ^ t[3];
+    }
+}
+
+/**
+ * @brief  Software AES-128 block with the running job key
+ */
+__STATIC void ns_aes_job_block(const uint8_t* blk, uint8_t* res, bool decrypt)
+{
+    const uint8_t* rk = ns_aes_job_env.round_key;
+    uint8_t s[AES_BLOCK_SIZE];
+    uint8_t t[AES_BLOCK_SIZE];
+    uint8_t round, i, c;
+
+    for(i = 0; i < AES_BLOCK_SIZE; i++)
+    {
+        s[i] = blk[i] ^ rk[(decrypt ? 10 : 0) * AES_BLOCK_SIZE + i];
+    }
+
+    for(round = 1; round <= 10; round++)
+    {
+        const uint8_t* k = &rk[(decrypt ? 10 - round : round) * AES_BLOCK_SIZE];
+
+        // (Inv)SubBytes and (Inv)ShiftRows, state is column major
+        for(i = 0; i < AES_BLOCK_SIZE; i++)
+        {
+            uint8_t row = i & 3;
+            uint8_t src = (i + (decrypt ? (AES_BLOCK_SIZE - 4 * row) : 4 * row)) & 0x0F;
+
+            t[i] = decrypt ? aes_inv_sbox[s[src]] : aes_sbox[s[src]];
+        }
+
+        if(decrypt)
+        {
+            for(i = 0; i < AES_BLOCK_SIZE; i++)
+            {
+                t[i] ^= k[i];
+            }
+        }
+
+        if(round != 10)
+        {
+            for(c = 0; c < AES_BLOCK_SIZE; c += 4)
+            {
+                uint8_t a0 = t[c], a1 = t[c + 1], a2 = t[c + 2], a3 = t[c + 3];
+
+                if(decrypt)
+                {
+                    t[c + 0] = aes_gmul(a0, 14) ^ aes_gmul(a1, 11) ^ aes_gmul(a2, 13) ^ aes_gmul(a3, 9);
+                    t[c + 1] = aes_gmul(a0, 9)  ^ aes_gmul(a1, 14) ^ aes_gmul(a2, 11) ^ aes_gmul(a3, 13);
+                    t[c + 2] = aes_gmul(a0, 13) ^ aes_gmul(a1, 9)  ^ aes_gmul(a2, 14) ^ aes_gmul(a3, 11);
+                    t[c + 3] = aes_gmul(a0, 11) ^ aes_gmul(a1, 13) ^ aes_gmul(a2, 9)  ^ aes_gmul(a3, 14);
+                }
+                else
+                {
+                    uint8_t x = a0 ^ a1 ^ a2 ^ a3;
+
+                    t[c + 0] = a0 ^ x ^ aes_xtime(a0 ^ a1);
+                    t[c + 1] = a1 ^ x ^ aes_xtime(a1 ^ a2);
+                    t[c + 2] = a2 ^ x ^ aes_xtime(a2 ^ a3);
+                    t[c + 3] = a3 ^ x ^ aes_xtime(a3 ^ a0);
+                }
+            }
+        }
+
+        for(i = 0; i < AES_BLOCK_SIZE; i++)
+        {
+            s[i] = decrypt ? t[i] : (t[i] ^ k[i]);
+        }
+    }
+
+    memcpy(res, s, AES_BLOCK_SIZE);
+}
+
+/* Public functions ----------------------------------------------------------*/
+/**
+ * @brief  Run a job on the software AES, the callback is called before returning
+ */
+uint8_t ns_aes_job_submit(struct ns_aes_job* job)
+{
+    uint8_t res[AES_BLOCK_SIZE];
+    bool decrypt = (job->mode == NS_AES_JOB_CBC_DECRYPT);
+    bool done;
+
+    if(!ns_aes_job_init(job))
+    {
+        return NS_AES_JOB_ERR_PARAM;
+    }
+
+    aes_key_expand(job->key);
+    do
+    {
+        ns_aes_job_prepare(job);
+        ns_aes_job_block(job->blk, res, decrypt);
+        done = ns_aes_job_absorb(job, res);
+    } while(!done);
+
+    job->cb(job, job->status);
+    return NS_AES_JOB_OK;
+}
+
+#else /* NS_AES_JOB_SW_BACKEND */
+
+/**
+ * @brief  Run one block on the BLE core AES, the key of the running job is already loaded
+ *         and the crypt interrupt is masked by the stack since the previous result.
+ */
+__STATIC void ns_aes_job_block(const uint8_t* blk, uint8_t* res, bool decrypt)
+{
+    uint8_t val[AES_BLOCK_SIZE];
+
+    ns_ase_swap_array(val, blk, AES_BLOCK_SIZE);
+    em_wr(val, EM_ENC_IN_OFFSET, AES_BLOCK_SIZE);
+    ip_aescntl_aes_mode_setf(decrypt);
+    ip_aescntl_aes_start_setf(1);
+    // start bit is released by the core at the end of the computation
+    while(ip_aescntl_aes_start_getf())
+    {
+    }
+    em_rd(val, EM_ENC_OUT_OFFSET, AES_BLOCK_SIZE);
+    ns_ase_swap_array(res, val, AES_BLOCK_SIZE);
+}
+
+/**
+ * @brief  Queue the block of job->blk on the stack AES queue, shared with the other users
+ */
+__STATIC void ns_aes_job_queue_block(struct aes_func_env* env, struct ns_aes_job* job)
+{
+    ns_ase_swap_array(ns_aes_job_env.val, job->blk, AES_BLOCK_SIZE);
+    ns_aes_start(env, ns_aes_job_env.key, ns_aes_job_env.val);
+}
+
+__STATIC bool ns_aes_job_continue(struct aes_func_env* env, uint8_t* aes_res);
+
+/**
+ * @brief  Start the first queued job, its first block goes through the stack AES queue
+ *         which loads the key and gives the engine to the job when it is free
+ */
+__STATIC void ns_aes_job_run(void)
+{
+    struct ns_aes_job* job = (struct ns_aes_job*) co_list_pick(&ns_aes_job_env.queue);
+    struct aes_func_env* env;
+
+    if(job == NULL)
+    {
+        return;
+    }
+
+    ns_aes_job_env.running = true;
+    env = aes_alloc(sizeof(struct aes_func_env), ns_aes_job_continue, NULL,
+                    (job->mode == NS_AES_JOB_CBC_DECRYPT) ? DECRYPT_SRC_MARK : 0);
+    ns_ase_swap_array(ns_aes_job_env.key, job->key, AES_BLOCK_SIZE);
+    ns_aes_job_prepare(job);
+    ns_aes_job_queue_block(env, job);
+}
+
+/**
+ * @brief  AES result of the running job. While nobody else waits for the engine the job
+ *         keeps it and chains its next blocks here, else it queues one block and yields.
+ * @return true when the job is over (the stack then frees env)
+ */
+__STATIC bool ns_aes_job_continue(struct aes_func_env* env, uint8_t* aes_res)
+{
+    struct ns_aes_job* job = (struct ns_aes_job*) co_list_pick(&ns_aes_job_env.queue);
+    bool decrypt = (job->mode == NS_AES_JOB_CBC_DECRYPT);
+    uint8_t res[AES_BLOCK_SIZE];
+    uint16_t burst = 0;
+    bool done;
+
+    ns_ase_swap_array(res, aes_res, AES_BLOCK_SIZE);
+    done = ns_aes_job_absorb(job, res);
+
+    if(!done && !aes_env.aes_ongoing)
+    {
+        struct aes_func_env* next;
+
+        // engine idle: hold it so that a request made meanwhile only queues
+        aes_env.aes_ongoing = true;
+        do
+        {
+            ns_aes_job_prepare(job);
+            ns_aes_job_block(job->blk, res, decrypt);
+            done = ns_aes_job_absorb(job, res);
+        } while(!done && (++burst < NS_AES_JOB_BURST_MAX));
+
+        // the polled blocks raised the crypt status, never report it to the stack
+        ip_intack1_cryptintack_clearf(1);
+        ip_aescntl_aes_mode_setf(0);
+        aes_env.aes_ongoing = false;
+
+        next = (struct aes_func_env*) co_list_pick(&aes_env.queue);
+        if(next != NULL)
+        {
+            aes_env.aes_ongoing = true;
+            ip_aescntl_aes_mode_setf(next->src_info == DECRYPT_SRC_MARK);
+            rwip_aes_encrypt(next->key, next->val);
+        }
+    }
+
+    if(!done)
+    {
+        ns_aes_job_prepare(job);
+        ns_aes_job_queue_block(env, job);
+        return false;
+    }
+
+    co_list_pop_front(&ns_aes_job_env.queue);
+    ns_aes_job_env.running = false;
+    job->cb(job, job->status);
+
+    // the callback may already have started the next job
+    if(!ns_aes_job_env.running)
+    {
+        ns_aes_job_run();
+    }
+    return true;
+}
+
+/* Public functions ----------------------------------------------------------*/
+/**
+ * @brief  Queue a job on the AES engine
+ */
+uint8_t ns_aes_job_submit(struct ns_aes_job* job)
+{
+    if(!ns_aes_job_init(job))
+    {
+        return NS_AES_JOB_ERR_PARAM;
+    }
+
+    co_list_push_back(&ns_aes_job_env.queue, &job->hdr);
+    if(!ns_aes_job_env.running)
+    {
+        ns_aes_job_run();
+    }
+    return NS_AES_JOB_OK;
+}
+
+#endif /* NS_AES_JOB_SW_BACKEND */
+
+/**
+ * @}
+ */
@@ -0,0 +1,150 @@
+/*****************************************************************************
+ * Copyright (c) 2019, Nations Technologies Inc.
+ *
+ * All rights reserved.
+ * ****************************************************************************
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Nations' name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY NATIONS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL NATIONS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ****************************************************************************/
+
+
+/**
+ * @file ns_aes_job.h
+ * @author Nations Firmware Team
+ * @version v1.0.0
+ *
+ * @copyright Copyright (c) 2019, Nations Technologies Inc. All rights reserved.
+ */
+
+/** @addtogroup 
+ * @{
+ */
+#ifndef __NS_AES_JOB_H__
+#define __NS_AES_JOB_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes -----------------------------------------------------------------*/
+#include "co_list.h"
+#include "aes_int.h"
+
+/* Public define ------------------------------------------------------------*/
+/// Build the job queue over a software AES instead of the BLE core (host tests and benchmarks)
+#ifndef NS_AES_JOB_SW_BACKEND
+#define NS_AES_JOB_SW_BACKEND 0
+#endif
+
+/// Blocks chained on an idle engine before the job gives the kernel a turn
+#ifndef NS_AES_JOB_BURST_MAX
+#define NS_AES_JOB_BURST_MAX 64
+#endif
+
+/// Nonce size of the CCM jobs (length field L = 2, payload up to 65535 bytes)
+#define NS_AES_JOB_CCM_NONCE_SIZE 13
+
+/* Public typedef -----------------------------------------------------------*/
+/// AES job operation
+enum ns_aes_job_mode
+{
+    NS_AES_JOB_CBC_ENCRYPT,
+    /// Needs AES_DECRYPT_ENABLE on the BLE core backend
+    NS_AES_JOB_CBC_DECRYPT,
+    NS_AES_JOB_CCM_ENCRYPT,
+    NS_AES_JOB_CCM_DECRYPT,
+};
+
+/// AES job status, given to ns_aes_job_submit caller or to the job callback
+enum ns_aes_job_status
+{
+    NS_AES_JOB_OK = 0,
+    /// Job rejected by ns_aes_job_submit, the callback is not called
+    NS_AES_JOB_ERR_PARAM,
+    /// CCM decryption done but the MIC does not match, output must be discarded
+    NS_AES_JOB_ERR_MIC,
+};
+
+struct ns_aes_job;
+
+/// Job completion callback, called from the kernel context once per job
+typedef void (*ns_aes_job_cb)(struct ns_aes_job* job, uint8_t status);
+
+/// AES job, owned by the caller and left untouched until its callback
+struct ns_aes_job
+{
+    /// Job queue link (private)
+    struct co_list_hdr hdr;
+
+    /// Operation (@see enum ns_aes_job_mode)
+    uint8_t         mode;
+    /// CCM MIC length (4, 6, ... 16), MIC appended to out (encrypt) or read after in (decrypt)
+    uint8_t         mic_len;
+    /// CCM additional authenticated data length (up to 0xFEFF)
+    uint16_t        aad_len;
+    /// Message length without MIC, a multiple of 16 bytes for CBC
+    uint16_t        len;
+    /// 16 bytes key, MSB first
+    const uint8_t*  key;
+    /// CBC: 16 bytes IV, CCM: 13 bytes nonce, MSB first
+    const uint8_t*  iv;
+    /// CCM additional authenticated data
+    const uint8_t*  aad;
+    /// Input message
+    const uint8_t*  in;
+    /// Output message, may be the input buffer
+    uint8_t*        out;
+    /// Completion callback
+    ns_aes_job_cb   cb;
+    /// Free for the requester
+    uint32_t        src_info;
+
+    /// Execution state (private)
+    uint8_t         state;
+    uint8_t         status;
+    uint32_t        cursor;
+    /// CBC chaining value or CCM CBC-MAC (private)
+    uint8_t         chain[AES_BLOCK_SIZE];
+    /// Block given to the engine (private)
+    uint8_t         blk[AES_BLOCK_SIZE];
+};
+
+/* Public function prototypes -----------------------------------------------*/
+/**
+ * @brief  Queue a multi-block CBC or CCM job on the AES engine.
+ *         Jobs run in submission order. Once a job owns an idle engine its blocks
+ *         are chained back to back (up to NS_AES_JOB_BURST_MAX per kernel event)
+ *         instead of one kernel event per block. The engine stays shared with the
+ *         stack: a job yields after each block while other AES requests wait.
+ * @param  job  job to run, its callback reports the completion
+ * @return NS_AES_JOB_OK when queued, NS_AES_JOB_ERR_PARAM if the job is malformed
+ * @note   The software backend runs the job to completion before returning.
+ */
+uint8_t ns_aes_job_submit(struct ns_aes_job* job);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __NS_AES_JOB_H__ */
+/**
+ * @}
+ */
@@ -1638,7 +1638,7 @@ void ns_peripheral_config(void)
     //enalbe lsi measurement
     if(app_env.lsc_cfg != BLE_LSC_LSE_32768HZ)   
     {
-        ns_sleep_lock_acquire();//pending sleep for calib
+        ns_sleep_lock_acquire_by(NS_SLEEP_HOLDER_LSI_CALIB);//pending sleep for calib
         RCC->OSCFCCR &= ~(0xFF<< 8);
         RCC->OSCFCCR |= (LSI_CLOCK_CNT_CYCLES <<8);
         RCC->OSCFCCR |= 1;
@@ -639,13 +639,8 @@ static int gapm_cmp_evt_handler(ke_msg_id_t const msgid,
         break;                
         case (GAPM_RESOLV_ADDR):
         {
-            #if (BLE_APP_SEC)
-            if(p_param->status != CO_ERROR_NO_ERROR)
-            {
-                //not match yet, resolv next addr
-                ns_bond_resolv_addr_start(&app_env.peer_addr,app_env.next_svc--);
-            }
-            #endif
+            // all the bonded IRKs are tried in one command, an error means none of them
+            // resolves the address: there is nothing left to try
         } break;
 
         #if (BLE_APP_PRF)
@@ -1388,7 +1383,7 @@ static int app_lsi_calib_evt_handler(ke_msg_id_t const msgid, void *p_param,
         RCC->OSCFCCR &= ~(0xFF<< 8);
         RCC->OSCFCCR |= (20 <<8);  //write count n syscle  
         RCC->OSCFCCR |= 1;
-        ns_sleep_lock_release(); //release when lsi calib finsh
+        ns_sleep_lock_release_by(NS_SLEEP_HOLDER_LSI_CALIB); //release when lsi calib finsh
     }   
 
     return (KE_MSG_CONSUMED);
@@ -1584,6 +1579,7 @@ static int app_init_timeout_evt_handler(ke_msg_id_t const msgid, void *p_param,
  */
 #if (BLE_APP_NS_IUS)
 extern int app_dfu_ble_reset_handler(ke_msg_id_t const msgid, void const *p_param, ke_task_id_t const dest_id, ke_task_id_t const src_id);
+extern int app_dfu_ble_flash_handler(ke_msg_id_t const msgid, void const *p_param, ke_task_id_t const dest_id, ke_task_id_t const src_id);
 #endif
 /* Default State handlers definition. */
 KE_MSG_HANDLER_TAB(app)
@@ -1628,6 +1624,7 @@ KE_MSG_HANDLER_TAB(app)
     #endif //(BLE_APP_SEC)
     #if (BLE_APP_NS_IUS)
     {APP_DFU_BLE_RESET_TIMER,   (ke_msg_func_t)app_dfu_ble_reset_handler},        
+    {APP_DFU_BLE_FLASH_EVT,     (ke_msg_func_t)app_dfu_ble_flash_handler},
     #endif
     
 };
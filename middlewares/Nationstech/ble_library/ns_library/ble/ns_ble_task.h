@@ -109,24 +109,13 @@ enum app_msg_id
     APP_BOND_STORE_EVT,
     #if (BLE_APP_NS_IUS)    
     APP_DFU_BLE_RESET_TIMER,
+    APP_DFU_BLE_FLASH_EVT,
     #endif
     #if (NS_TIMER_ENABLE)
     /*ns timer*/
-    APP_CANCEL_TIMER,
-    APP_MODIFY_TIMER,
-    //Do not alter the order of the next messages
-    //they are considered a range
+    //Single kernel timer driving the ns_timer wheel
     NS_TIMER_API_MES0,
-    NS_TIMER_API_MES1=NS_TIMER_API_MES0+1,
-    NS_TIMER_API_MES2=NS_TIMER_API_MES0+2,
-    NS_TIMER_API_MES3=NS_TIMER_API_MES0+3,
-    NS_TIMER_API_MES4=NS_TIMER_API_MES0+4,
-    NS_TIMER_API_MES5=NS_TIMER_API_MES0+5,
-    NS_TIMER_API_MES6=NS_TIMER_API_MES0+6,
-    NS_TIMER_API_MES7=NS_TIMER_API_MES0+7,
-    NS_TIMER_API_MES8=NS_TIMER_API_MES0+8,
-    NS_TIMER_API_MES9=NS_TIMER_API_MES0+9,
-    NS_TIMER_API_LAST_MES=NS_TIMER_API_MES9,
+    NS_TIMER_API_LAST_MES=NS_TIMER_API_MES0,
     #endif //NS_TIMER_ENABLE
     
     //keep APP_FREE_EVE_FOR_USER as last event
@@ -0,0 +1,119 @@
+/*****************************************************************************
+ * Copyright (c) 2019, Nations Technologies Inc.
+ *
+ * All rights reserved.
+ * ****************************************************************************
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Nations' name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY NATIONS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL NATIONS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ****************************************************************************/
+
+/**
+ * @file ns_crc.h
+ * @author Nations Firmware Team
+ * @version v1.0.0
+ *
+ * @copyright Copyright (c) 2019, Nations Technologies Inc. All rights reserved.
+ */
+
+/** @addtogroup 
+ * @{
+ */
+#ifndef __NS_CRC_H__
+#define __NS_CRC_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Public define ------------------------------------------------------------*/
+/// Use the CRC32 peripheral when its self check passes, 0 to always use the software tables
+#ifndef NS_CRC32_HW_ENABLE
+#define NS_CRC32_HW_ENABLE          1
+#endif
+
+/// Seed of CRC-16/CCITT-FALSE (polynomial 0x1021, msb first) for ns_crc16_ccitt_update()
+#define NS_CRC16_CCITT_INIT         0xFFFF
+
+/* Public typedef -----------------------------------------------------------*/
+/// Running CRC-32 (IEEE 802.3, the dfu_crc32 checksum), see ns_crc32_init()
+typedef struct{
+    uint32_t value;
+}ns_crc32_t;
+
+/* Public constants ---------------------------------------------------------*/
+/* Public function prototypes -----------------------------------------------*/
+/**
+ * @brief Start a CRC-32 that can be fed in any number of pieces.
+ * @param[out] p_crc running value.
+ * @return none
+ */
+void ns_crc32_init(ns_crc32_t *p_crc);
+
+/**
+ * @brief Add data to a running CRC-32. Not to be called from interrupt handlers,
+ *        the peripheral holds the state while a piece is processed.
+ * @param[in,out] p_crc running value.
+ * @param[in] p_data data, no alignment needed.
+ * @param[in] len data length.
+ * @return none
+ */
+void ns_crc32_update(ns_crc32_t *p_crc, uint8_t const *p_data, uint32_t len);
+
+/**
+ * @brief Get the CRC-32 of everything added so far, the running value stays usable.
+ * @param[in] p_crc running value.
+ * @return CRC-32.
+ */
+uint32_t ns_crc32_final(ns_crc32_t const *p_crc);
+
+/**
+ * @brief CRC-32 of one buffer, same result as dfu_crc32().
+ * @param[in] p_data data.
+ * @param[in] len data length.
+ * @return CRC-32.
+ */
+uint32_t ns_crc32(uint8_t const *p_data, uint32_t len);
+
+/**
+ * @brief Continue a CRC-16/CCITT-FALSE, start from NS_CRC16_CCITT_INIT.
+ * @param[in] crc running value.
+ * @param[in] p_data data.
+ * @param[in] len data length.
+ * @return updated value, also the final CRC.
+ */
+uint16_t ns_crc16_ccitt_update(uint16_t crc, uint8_t const *p_data, uint32_t len);
+
+/**
+ * @brief E2E-CRC of the CGM profile (polynomial 0x1021 over lsb first data, seed 0xFFFF).
+ * @param[in] p_data data.
+ * @param[in] len data length.
+ * @return CRC in the byte order of prf_e2e_crc().
+ */
+uint16_t ns_crc16_e2e(uint8_t const *p_data, uint32_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //__NS_CRC_H__
@@ -39,16 +39,19 @@
 
  /* Includes ------------------------------------------------------------------*/
 #include "ns_dfu_ble.h"
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include "ke_timer.h"
+#include "ke_msg.h"
+#include "co_math.h"
 #include "ns_ble.h"
 #include "ns_ble_task.h"
 #include "ns_dfu_boot.h"
 #include "ns_error.h"
 #include "ns_log.h"
-#include "dfu_crc.h"
+#include "ns_crc.h"
 #include "dfu_delay.h"
 /* Private typedef -----------------------------------------------------------*/
 static struct{
@@ -63,6 +66,7 @@ static struct{
 
 #if OTA_ECC_ECDSA_SHA256_ENABLE
 #include "ns_ecc.h"
+#include "sha256.h"
 #endif
 
 #define OTA_CMD_CONN_PARAM_UPDATE                     1
@@ -77,11 +81,41 @@ static struct{
 #define OTA_RC_STATE_NONE                             0
 #define OTA_RC_STATE_DFU_SETTING                      1
 #define OTA_RC_STATE_DFU_IMAGE                        2
+
+#define OTA_RC_BUFFER_SIZE                            2048
+#define OTA_RC_BUFFER_NUM                             2   //ping-pong, one receiving while the other is written
+
+//a setting packet may carry a signature of the image's SHA-256 after Dfu_setting_t
+#define OTA_IMAGE_SIGNATURE_SIZE                      64
+
+#define OTA_IMAGE_HASH_NONE                           0   //no image signature, validate by crc
+#define OTA_IMAGE_HASH_RUNNING                        1
+#define OTA_IMAGE_HASH_DONE                           2   //digest of the whole image is ready
+#define OTA_IMAGE_HASH_BROKEN                         3   //blocks came out of order, hash the flash copy
 /* Private constants ---------------------------------------------------------*/
 /* Private variables ---------------------------------------------------------*/
 static uint8_t m_rc_state = OTA_RC_STATE_NONE;
 static Dfu_setting_t m_dfu_setting;
-static uint8_t m_buffer[2048];
+static uint8_t m_buffer[OTA_RC_BUFFER_NUM][OTA_RC_BUFFER_SIZE];
+static uint8_t m_rx_buffer = 0;
+static ns_crc32_t m_rx_crc;
+static uint8_t m_flash_error = 0;
+static struct{
+    uint8_t *data;
+    uint32_t address;
+    uint32_t size;
+    uint32_t done;
+    bool erase;
+}m_flash_job;
+#if OTA_ECC_ECDSA_SHA256_ENABLE
+static struct{
+    uint8_t state;
+    uint32_t offset;
+    sha256_context_t ctx;
+    uint8_t digest[32];
+    uint8_t signature[OTA_IMAGE_SIGNATURE_SIZE];
+}m_image_hash;
+#endif
 static uint32_t rc_mtu_offset = 0;
 static uint8_t ota_selection = 0;
 static uint32_t m_ota_setting_size = 0;
@@ -89,6 +123,137 @@ static uint32_t m_ota_setting_size = 0;
 extern void ns_ble_ius_app_cc_send(uint8_t *p_data, uint16_t length);
 /* Private functions ---------------------------------------------------------*/
 
+/**
+ * @brief Do one step of the pending image write, a sector erase or one flash page.
+ *        Qflash runs with interrupts off, so steps are kept short and the BLE stack
+ *        gets the CPU back between them.
+ * @return true if there is more to write.
+ */
+static bool dfu_ble_flash_step(void)
+{
+    if(m_flash_job.size == 0){
+        return false;
+    }
+    
+    uint32_t address = m_flash_job.address + m_flash_job.done;
+    if(m_flash_job.erase){
+        m_flash_job.erase = false;
+        #ifdef APPLICATION
+        NS_LOG_INFO("bsp_flash_erase_sector --> 0x%08X\r\n",address);
+        #endif
+        if(Qflash_Erase_Sector(address) != FlashOperationSuccess){
+            m_flash_error = 3;
+        }
+        return true;
+    }
+    
+    uint32_t len = co_min(FLASH_PAGE_SIZE - (address % FLASH_PAGE_SIZE), m_flash_job.size - m_flash_job.done);
+    if(Qflash_Write(address, m_flash_job.data + m_flash_job.done, len) != FlashOperationSuccess){
+        m_flash_error = 3;
+    }
+    m_flash_job.done += len;
+    if(m_flash_job.done >= m_flash_job.size){
+        m_flash_job.size = 0;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Finish the pending image write before its buffer or the flash content is needed.
+ * @return none
+ */
+static void dfu_ble_flash_flush(void)
+{
+    while(dfu_ble_flash_step());
+}
+
+/**
+ * @brief Hand a received block to the background writer, the caller swaps buffers.
+ * @param[in] data block in one of the ping-pong buffers.
+ * @param[in] address flash address of the block.
+ * @param[in] size block length.
+ * @return none
+ */
+static void dfu_ble_flash_start(uint8_t *data, uint32_t address, uint32_t size)
+{
+    #ifdef APPLICATION
+    NS_LOG_INFO("bsp_flash_write --> 0x%08X\r\n",address);
+    #endif
+    m_flash_job.data = data;
+    m_flash_job.address = address;
+    m_flash_job.size = size;
+    m_flash_job.done = 0;
+    m_flash_job.erase = (address % FLASH_SECTOR_SIZE == 0);
+    ke_msg_send_basic(APP_DFU_BLE_FLASH_EVT, TASK_APP, TASK_APP);
+}
+
+
+/**
+ * @brief Bank of the received setting that the image being sent goes to.
+ * @return bank, NULL if no image is selected.
+ */
+static Dfu_setting_bank_t const *dfu_ble_setting_bank(void)
+{
+    switch(ota_selection){
+        case 1: return &m_dfu_setting.app1;
+        case 2: return &m_dfu_setting.app2;
+        case 3: return &m_dfu_setting.image_update;
+        default: return NULL;
+    }
+}
+
+#if OTA_ECC_ECDSA_SHA256_ENABLE
+/**
+ * @brief Add an accepted image block to the running SHA-256, in image order only.
+ *        The digest is finished with the last block so validation needs no flash pass.
+ * @param[in] data block.
+ * @param[in] offset block offset in the image.
+ * @param[in] size block length.
+ * @return none
+ */
+static void dfu_ble_image_hash_block(uint8_t const *data, uint32_t offset, uint32_t size)
+{
+    if(m_image_hash.state != OTA_IMAGE_HASH_RUNNING){
+        return;
+    }
+    if(offset + size <= m_image_hash.offset){
+        return; //resent block, already hashed
+    }
+    if(offset != m_image_hash.offset){
+        m_image_hash.state = OTA_IMAGE_HASH_BROKEN;
+        return;
+    }
+    
+    sha256_update(&m_image_hash.ctx, data, size);
+    m_image_hash.offset += size;
+    
+    Dfu_setting_bank_t const *p_bank = dfu_ble_setting_bank();
+    if(p_bank != NULL && m_image_hash.offset >= p_bank->size){
+        sha256_final(&m_image_hash.ctx, m_image_hash.digest, 0);
+        m_image_hash.state = (m_image_hash.offset == p_bank->size) ? OTA_IMAGE_HASH_DONE : OTA_IMAGE_HASH_BROKEN;
+    }
+}
+
+/**
+ * @brief Check the image signature against the streamed digest, or against a hash of
+ *        the flash copy if the stream could not be followed.
+ * @param[in] p_bank bank the image was written to.
+ * @return 0 if the signature matches, 3 otherwise.
+ */
+static uint8_t dfu_ble_image_verify(Dfu_setting_bank_t const *p_bank)
+{
+    if(m_image_hash.state == OTA_IMAGE_HASH_BROKEN){
+        if(ERROR_SUCCESS != ns_lib_ecc_hash_sha256((uint8_t *)p_bank->start_address, p_bank->size, m_image_hash.digest)){
+            return 3;
+        }
+    }
+    if(ERROR_SUCCESS != ns_lib_ecc_ecdsa_verify(ns_bootsetting.public_key, m_image_hash.digest, 32, m_image_hash.signature)){
+        return 3;
+    }
+    return 0;
+}
+#endif
 
 /**
  * @brief Processing and handling ius service cc characteristic data.
@@ -120,6 +285,12 @@ void ns_dfu_ble_handler_cc(uint8_t const *input, uint8_t input_len, uint8_t *out
         }break;
     
         case OTA_CMD_VERSION:{
+            dfu_ble_flash_flush();
+            m_flash_error = 0;
+            m_rx_buffer = 0;
+            #if OTA_ECC_ECDSA_SHA256_ENABLE
+            m_image_hash.state = OTA_IMAGE_HASH_NONE;
+            #endif
             rc_mtu_offset = 0;
             memset(&m_ota_image,0,sizeof(m_ota_image));
             uint32_t new_app1_size = input[1]<<24 | input[2]<<16 | input[3]<<8 | input[4];
@@ -133,8 +304,9 @@ void ns_dfu_ble_handler_cc(uint8_t const *input, uint8_t input_len, uint8_t *out
                 ota_selection = 0;
             
                 if(CURRENT_APP_START_ADDRESS == NS_APP1_START_ADDRESS){
-                    if(ns_bootsetting.app1.size > NS_APP1_DEFAULT_SIZE || new_app1_size > NS_APP1_DEFAULT_SIZE || new_app2_size == 0){
-                        if(ns_bootsetting.ImageUpdate.crc == dfu_crc32((uint8_t *)((uint32_t *)ns_bootsetting.ImageUpdate.start_address), ns_bootsetting.ImageUpdate.size)){
+                    if(ns_bootsetting.app1.size > NS_APP1_DEFAULT_SIZE || new_app1_size > NS_APP1_DEFAULT_SIZE || new_app2_size == 0
+                       || new_app2_size > NS_APP2_DEFAULT_SIZE){
+                        if(ns_bootsetting.ImageUpdate.crc == ns_crc32((uint8_t *)((uint32_t *)ns_bootsetting.ImageUpdate.start_address), ns_bootsetting.ImageUpdate.size)){
                             if(new_image_update_version > ns_bootsetting.ImageUpdate.version){
                                 ota_selection = 3;
                                 m_ota_image.total_size = new_image_update_size;
@@ -155,7 +327,7 @@ void ns_dfu_ble_handler_cc(uint8_t const *input, uint8_t input_len, uint8_t *out
                     }
                 }else if(CURRENT_APP_START_ADDRESS == NS_APP2_START_ADDRESS){
                     if(new_app1_size > NS_APP1_DEFAULT_SIZE){
-                        if(ns_bootsetting.ImageUpdate.crc == dfu_crc32((uint8_t *)((uint32_t *)ns_bootsetting.ImageUpdate.start_address), ns_bootsetting.ImageUpdate.size)){
+                        if(ns_bootsetting.ImageUpdate.crc == ns_crc32((uint8_t *)((uint32_t *)ns_bootsetting.ImageUpdate.start_address), ns_bootsetting.ImageUpdate.size)){
                             if(new_image_update_version > ns_bootsetting.ImageUpdate.version){
                                 ota_selection = 3;
                                 m_ota_image.total_size = new_image_update_size;
@@ -207,15 +379,16 @@ void ns_dfu_ble_handler_cc(uint8_t const *input, uint8_t input_len, uint8_t *out
         
         case OTA_CMD_JUMP_IMAGE_UPDATE:{
             uint8_t error = 0;
+            dfu_ble_flash_flush();
             NS_Bootsetting_t m_ns_bootsetting;
             memcpy(&m_ns_bootsetting,&ns_bootsetting,sizeof(NS_Bootsetting_t));
             m_ns_bootsetting.app1.activation = NS_BOOTSETTING_ACTIVATION_NO;
             m_ns_bootsetting.app2.activation = NS_BOOTSETTING_ACTIVATION_NO;
             m_ns_bootsetting.ImageUpdate.activation = NS_BOOTSETTING_ACTIVATION_YES;            
-            m_ns_bootsetting.crc = dfu_crc32((uint8_t *)&m_ns_bootsetting.crc + 4, sizeof(NS_Bootsetting_t) - 4);
+            m_ns_bootsetting.crc = ns_crc32((uint8_t *)&m_ns_bootsetting.crc + 4, sizeof(NS_Bootsetting_t) - 4);
             Qflash_Erase_Sector(NS_BOOTSETTING_START_ADDRESS);
             Qflash_Write(NS_BOOTSETTING_START_ADDRESS, (uint8_t *)&m_ns_bootsetting, sizeof(NS_Bootsetting_t));
-            if(m_ns_bootsetting.crc != dfu_crc32((uint8_t *)((uint32_t *)(NS_BOOTSETTING_START_ADDRESS + 4)), sizeof(NS_Bootsetting_t) - 4))
+            if(m_ns_bootsetting.crc != ns_crc32((uint8_t *)((uint32_t *)(NS_BOOTSETTING_START_ADDRESS + 4)), sizeof(NS_Bootsetting_t) - 4))
             {
                 error = 2;
             }            
@@ -241,29 +414,30 @@ void ns_dfu_ble_handler_cc(uint8_t const *input, uint8_t input_len, uint8_t *out
             m_ota_image.size = input[5]<<24 | input[6]<<16 | input[7]<<8 | input[8];
             m_ota_image.crc = input[9]<<24 | input[10]<<16 | input[11]<<8 | input[12];
             m_rc_state = OTA_RC_STATE_DFU_IMAGE;
+            ns_crc32_init(&m_rx_crc);
             rc_mtu_offset = 0;
             *output_len = 0;
         }break;                
         
         
         case OTA_CMD_VALIDATE_OTA_IMAGE:{
+            //blocks are not read back when written, a crc pass verifies the flash copy so
+            //that a bad write is reported as such, then a signed image is checked against
+            //the digest streamed while it was received
+            dfu_ble_flash_flush();
             output[0] = OTA_CMD_VALIDATE_OTA_IMAGE;
-            output[1] = 0;
-            if(ota_selection == 1){
-                if(m_dfu_setting.app1.crc != dfu_crc32((uint8_t *)((uint32_t *)m_dfu_setting.app1.start_address), m_dfu_setting.app1.size))
-                {
-                    output[1] = 2;
-                }            
-            }else if(ota_selection == 2){
-                if(m_dfu_setting.app2.crc != dfu_crc32((uint8_t *)((uint32_t *)m_dfu_setting.app2.start_address), m_dfu_setting.app2.size))
-                {
-                    output[1] = 2;
-                }                        
-            }else if(ota_selection == 3){
-                if(m_dfu_setting.image_update.crc != dfu_crc32((uint8_t *)((uint32_t *)m_dfu_setting.image_update.start_address), m_dfu_setting.image_update.size))
+            output[1] = m_flash_error;
+            Dfu_setting_bank_t const *p_bank = dfu_ble_setting_bank();
+            if(p_bank != NULL && output[1] == 0){
+                if(p_bank->crc != ns_crc32((uint8_t *)((uint32_t *)p_bank->start_address), p_bank->size))
                 {
                     output[1] = 2;
-                }                        
+                }
+                #if OTA_ECC_ECDSA_SHA256_ENABLE
+                else if(m_image_hash.state != OTA_IMAGE_HASH_NONE){
+                    output[1] = dfu_ble_image_verify(p_bank);
+                }
+                #endif
             }
             *output_len = 2;
         }break;            
@@ -271,6 +445,7 @@ void ns_dfu_ble_handler_cc(uint8_t const *input, uint8_t input_len, uint8_t *out
         case OTA_CMD_ACTIVATE_OTA_IMAGE:{
             
             uint8_t error = 0;
+            dfu_ble_flash_flush();
             NS_Bootsetting_t m_ns_bootsetting;
             memcpy(&m_ns_bootsetting,&ns_bootsetting,sizeof(NS_Bootsetting_t));
             m_ns_bootsetting.app1.activation = NS_BOOTSETTING_ACTIVATION_NO;
@@ -297,10 +472,10 @@ void ns_dfu_ble_handler_cc(uint8_t const *input, uint8_t input_len, uint8_t *out
                 m_ns_bootsetting.ImageUpdate.crc = m_dfu_setting.image_update.crc;
                 m_ns_bootsetting.ImageUpdate.activation = NS_BOOTSETTING_ACTIVATION_YES;                                            
             }            
-            m_ns_bootsetting.crc = dfu_crc32((uint8_t *)&m_ns_bootsetting.crc + 4, sizeof(NS_Bootsetting_t) - 4);
+            m_ns_bootsetting.crc = ns_crc32((uint8_t *)&m_ns_bootsetting.crc + 4, sizeof(NS_Bootsetting_t) - 4);
             Qflash_Erase_Sector(NS_BOOTSETTING_START_ADDRESS);
             Qflash_Write(NS_BOOTSETTING_START_ADDRESS, (uint8_t *)&m_ns_bootsetting, sizeof(NS_Bootsetting_t));
-            if(m_ns_bootsetting.crc != dfu_crc32((uint8_t *)((uint32_t *)(NS_BOOTSETTING_START_ADDRESS + 4)), sizeof(NS_Bootsetting_t) - 4))
+            if(m_ns_bootsetting.crc != ns_crc32((uint8_t *)((uint32_t *)(NS_BOOTSETTING_START_ADDRESS + 4)), sizeof(NS_Bootsetting_t) - 4))
             {
                 error = 2;
             }            
@@ -334,6 +509,21 @@ int app_dfu_ble_reset_handler(ke_msg_id_t const msgid, void const *p_param, ke_t
     NVIC_SystemReset();
     return KE_MSG_CONSUMED;
 }
+/**
+ * @brief Write the next piece of the pending image block, repost until it is done.
+ * @param[in] msgid.
+ * @param[in] p_param.
+ * @param[in] dest_id.
+ * @param[in] src_id.
+ * @return msg
+ */
+int app_dfu_ble_flash_handler(ke_msg_id_t const msgid, void const *p_param, ke_task_id_t const dest_id, ke_task_id_t const src_id)
+{
+    if(dfu_ble_flash_step()){
+        ke_msg_send_basic(APP_DFU_BLE_FLASH_EVT, TASK_APP, TASK_APP);
+    }
+    return KE_MSG_CONSUMED;
+}
 /**
  * @brief Connection update result response.
  * @param[in] status connection update succeed or fail.
@@ -372,13 +562,14 @@ void ns_dfu_ble_handler_rc(uint8_t const *input, uint32_t input_len)
     switch(m_rc_state){
     
         case OTA_RC_STATE_DFU_SETTING:{
-            memcpy(m_buffer + rc_mtu_offset, input , input_len);
+            input_len = co_min(input_len, OTA_RC_BUFFER_SIZE - rc_mtu_offset);
+            memcpy(m_buffer[m_rx_buffer] + rc_mtu_offset, input , input_len);
             rc_mtu_offset += input_len;            
             if(rc_mtu_offset >= m_ota_setting_size){
                 rc_mtu_offset = 0;
                 m_rc_state = OTA_RC_STATE_NONE;
-                memcpy(&m_dfu_setting, m_buffer, sizeof(Dfu_setting_t));
-                uint32_t crc = dfu_crc32((uint8_t *)&m_dfu_setting.crc + 4, sizeof(Dfu_setting_t) - 4);
+                memcpy(&m_dfu_setting, m_buffer[m_rx_buffer], sizeof(Dfu_setting_t));
+                uint32_t crc = ns_crc32((uint8_t *)&m_dfu_setting.crc + 4, sizeof(Dfu_setting_t) - 4);
                 if(crc == m_dfu_setting.crc){
                     uint8_t error = 0;
                     
@@ -395,6 +586,14 @@ void ns_dfu_ble_handler_rc(uint8_t const *input, uint32_t input_len)
                         }else{
                             error = 3;
                         }
+                        
+                        m_image_hash.state = OTA_IMAGE_HASH_NONE;
+                        if(error == 0 && m_ota_setting_size >= sizeof(Dfu_setting_t) + OTA_IMAGE_SIGNATURE_SIZE){
+                            memcpy(m_image_hash.signature, m_buffer[m_rx_buffer] + sizeof(Dfu_setting_t), OTA_IMAGE_SIGNATURE_SIZE);
+                            sha256_init(&m_image_hash.ctx);
+                            m_image_hash.offset = 0;
+                            m_image_hash.state = OTA_IMAGE_HASH_RUNNING;
+                        }
                     #endif
                     
                     
@@ -414,41 +613,33 @@ void ns_dfu_ble_handler_rc(uint8_t const *input, uint32_t input_len)
         
         
         case OTA_RC_STATE_DFU_IMAGE:{
-            memcpy(m_buffer + rc_mtu_offset, input , input_len);
+            //crc each chunk as it arrives, the previous block is written to flash meanwhile
+            input_len = co_min(input_len, co_min(m_ota_image.size, OTA_RC_BUFFER_SIZE) - rc_mtu_offset);
+            memcpy(m_buffer[m_rx_buffer] + rc_mtu_offset, input , input_len);
+            ns_crc32_update(&m_rx_crc, input, input_len);
             rc_mtu_offset += input_len;
-            if(rc_mtu_offset >= m_ota_image.size){
+            if(rc_mtu_offset >= m_ota_image.size || rc_mtu_offset >= OTA_RC_BUFFER_SIZE){
                 m_rc_state = OTA_RC_STATE_NONE;
-                rc_mtu_offset = 0;
-                uint32_t crc = dfu_crc32(m_buffer, m_ota_image.size);
                 uint8_t error = 0;
-                if(crc == m_ota_image.crc)
+                if(rc_mtu_offset == m_ota_image.size && ns_crc32_final(&m_rx_crc) == m_ota_image.crc)
                 {
-                    if((m_ota_image.address + m_ota_image.offset) % FLASH_SECTOR_SIZE == 0){
-                        #ifdef APPLICATION
-                        NS_LOG_INFO("bsp_flash_erase_sector --> 0x%08X\r\n",m_ota_image.address + m_ota_image.offset);
-                        #endif                            
-                        Qflash_Erase_Sector(m_ota_image.address + m_ota_image.offset);
-                    }
-                    #ifdef APPLICATION
-                    NS_LOG_INFO("bsp_flash_write --> 0x%08X\r\n",m_ota_image.address + m_ota_image.offset);
-                    #endif                        
-                    Qflash_Write(m_ota_image.address + m_ota_image.offset, m_buffer, m_ota_image.size);
-                    if(m_ota_image.crc != dfu_crc32((uint8_t *)((uint32_t *)(m_ota_image.address + m_ota_image.offset)), m_ota_image.size))
-                    {
-                        error = 3;
-                    }
-                    uint8_t response[2] = {OTA_CMD_CREATE_OTA_IMAGE};
-                    response[1] = error;
-                    ns_ble_ius_app_cc_send(response,sizeof(response));                        
-                
+                    //one block in flight: the other buffer must be written before it is reused
+                    dfu_ble_flash_flush();
+                    error = m_flash_error;
+                    #if OTA_ECC_ECDSA_SHA256_ENABLE
+                    dfu_ble_image_hash_block(m_buffer[m_rx_buffer], m_ota_image.offset, m_ota_image.size);
+                    #endif
+                    dfu_ble_flash_start(m_buffer[m_rx_buffer], m_ota_image.address + m_ota_image.offset, m_ota_image.size);
+                    m_rx_buffer ^= 1;
                 }
                 else
                 {
-                
-                    uint8_t response[2] = {OTA_CMD_CREATE_OTA_IMAGE};
-                    response[1] = 2;
-                    ns_ble_ius_app_cc_send(response,sizeof(response));                
+                    error = 2;
                 }
+                rc_mtu_offset = 0;
+                uint8_t response[2] = {OTA_CMD_CREATE_OTA_IMAGE};
+                response[1] = error;
+                ns_ble_ius_app_cc_send(response,sizeof(response));
             }
             
         }break;
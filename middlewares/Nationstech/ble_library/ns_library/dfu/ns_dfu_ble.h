@@ -56,6 +56,8 @@ typedef struct{
     uint32_t version;
 }Dfu_setting_bank_t;
 
+/* Sent as the OTA setting packet, optionally followed by a 64 byte signature of the
+ * image SHA-256 which validation then checks after the image crc. */
 typedef struct{
 
     uint32_t crc;
@@ -40,7 +40,7 @@
  /* Includes ------------------------------------------------------------------*/
 #include "ns_dfu_boot.h"
 #include "n32wb03x.h"
-#include "dfu_crc.h"
+#include "ns_crc.h"
 #include "ns_error.h"
 /* Private typedef -----------------------------------------------------------*/
 typedef void (*func_ptr_t)(void);
@@ -80,11 +80,11 @@ bool ns_dfu_boot_force_usart_dfu(void)
     NS_Bootsetting_t ns_bootsetting_tmp;
     memcpy(&ns_bootsetting_tmp,&ns_bootsetting,sizeof(NS_Bootsetting_t));
     ns_bootsetting_tmp.master_boot_force_update = NS_BOOTSETTING_MASTER_BOOT_FORCE_UPDATE_YES;
-    ns_bootsetting_tmp.crc = dfu_crc32((uint8_t *)&ns_bootsetting_tmp.crc + 4, sizeof(NS_Bootsetting_t) - 4);
+    ns_bootsetting_tmp.crc = ns_crc32((uint8_t *)&ns_bootsetting_tmp.crc + 4, sizeof(NS_Bootsetting_t) - 4);
     Qflash_Erase_Sector(NS_BOOTSETTING_START_ADDRESS);
     Qflash_Write(NS_BOOTSETTING_START_ADDRESS, (uint8_t *)&ns_bootsetting_tmp, sizeof(NS_Bootsetting_t));            
     
-    if(ns_bootsetting_tmp.crc == dfu_crc32((uint8_t *)((uint32_t *)(NS_BOOTSETTING_START_ADDRESS + 4)), sizeof(NS_Bootsetting_t) - 4))
+    if(ns_bootsetting_tmp.crc == ns_crc32((uint8_t *)((uint32_t *)(NS_BOOTSETTING_START_ADDRESS + 4)), sizeof(NS_Bootsetting_t) - 4))
     {
         NVIC_SystemReset();
         return ERROR_SUCCESS;
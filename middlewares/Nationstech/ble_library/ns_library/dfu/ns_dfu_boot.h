@@ -83,7 +83,8 @@ extern int Image$$ER_IROM1$$Base;
 #define NS_APP1_START_ADDRESS                          (0x01004000)
 #define NS_APP1_DEFAULT_SIZE                           (0x1C000)
 #define NS_APP2_START_ADDRESS                          (0x01020000)
-#define NS_APP2_DEFAULT_SIZE                           (0x1C000)
+// app2 stops at the two sectors of the bond database (BOND_DATA_BASE_ADDR), 0x01020000-0x0103A000
+#define NS_APP2_DEFAULT_SIZE                           (0x1A000)
 #define NS_IMAGE_UPDATE_START_ADDRESS                  (0x0103C000)
 #define NS_IMAGE_UPDATE_SIZE                           (0x4000)
 
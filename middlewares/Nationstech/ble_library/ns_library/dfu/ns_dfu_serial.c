@@ -45,7 +45,7 @@
 #include "n32wb03x.h"
 #include "ns_error.h"
 #include "dfu_delay.h"
-#include "dfu_crc.h"
+#include "ns_crc.h"
 /* Private typedef -----------------------------------------------------------*/
 static struct
 {
@@ -87,7 +87,7 @@ typedef struct
 #define  DFU_SERIAL_CMD_OtpErase                0x0A
 #define  DFU_SERIAL_CMD_OtpLock                 0x0B
 
-#define SCHED_EVT_RX_DATA            1
+#define DFU_SERIAL_FRAME_LEN         256
 /* Private constants ---------------------------------------------------------*/
 /* Private variables ---------------------------------------------------------*/
 static _pkt_header m_pkt_header;
@@ -95,7 +95,7 @@ static NS_Bootsetting_t m_ns_bootsetting;
 /* Private function prototypes -----------------------------------------------*/
 static void sched_evt(void * p_event_data, uint16_t event_size);
 static uint32_t serial_send_data(uint8_t *p_data, uint32_t length);
-static uint8_t m_buffer[256];
+static uint8_t *m_buffer;
 static void dfu_serial_cmd_ping(void);
 static void dfu_serial_cmd_init_pkt(void);
 static void dfu_serial_cmd_pkt_header(void);
@@ -117,7 +117,7 @@ static void dfu_serial_cmd_otp_lock(void);
 void ns_dfu_serial_init(void)
 {
     Qflash_Init();
-    if(ns_bootsetting.crc == dfu_crc32((uint8_t *)&ns_bootsetting.crc + 4, sizeof(NS_Bootsetting_t) - 4))
+    if(ns_bootsetting.crc == ns_crc32((uint8_t *)&ns_bootsetting.crc + 4, sizeof(NS_Bootsetting_t) - 4))
     {
         if(ns_bootsetting.master_boot_force_update == NS_BOOTSETTING_MASTER_BOOT_FORCE_UPDATE_YES)
         {
@@ -125,10 +125,10 @@ void ns_dfu_serial_init(void)
             do{
                 memcpy(&ns_bootsetting_tmp,&ns_bootsetting,sizeof(NS_Bootsetting_t));
                 ns_bootsetting_tmp.master_boot_force_update = NS_BOOTSETTING_MASTER_BOOT_FORCE_UPDATE_NO;
-                ns_bootsetting_tmp.crc = dfu_crc32((uint8_t *)&ns_bootsetting_tmp.crc + 4, sizeof(NS_Bootsetting_t) - 4);
+                ns_bootsetting_tmp.crc = ns_crc32((uint8_t *)&ns_bootsetting_tmp.crc + 4, sizeof(NS_Bootsetting_t) - 4);
                 Qflash_Erase_Sector(NS_BOOTSETTING_START_ADDRESS);
                 Qflash_Write(NS_BOOTSETTING_START_ADDRESS, (uint8_t *)&ns_bootsetting_tmp, sizeof(NS_Bootsetting_t));            
-            }while(ns_bootsetting_tmp.crc != dfu_crc32((uint8_t *)((uint32_t *)(NS_BOOTSETTING_START_ADDRESS + 4)), sizeof(NS_Bootsetting_t) - 4));
+            }while(ns_bootsetting_tmp.crc != ns_crc32((uint8_t *)((uint32_t *)(NS_BOOTSETTING_START_ADDRESS + 4)), sizeof(NS_Bootsetting_t) - 4));
         }    
     }
     
@@ -141,15 +141,16 @@ void ns_dfu_serial_init(void)
 
 /**
  * @brief Process data received from serial port.
- * @param[in] p_event_data event type.
- * @param[in] event_size event size.
+ * @param[in] p_event_data received frame, filled in place by the serial interrupt.
+ * @param[in] event_size frame size.
  * @return none
  */
 static void sched_evt(void * p_event_data, uint16_t event_size)
 {
-    switch(*(uint8_t *)p_event_data)
+    m_buffer = p_event_data;
+    switch(event_size)
     {
-        case SCHED_EVT_RX_DATA:{
+        case DFU_SERIAL_FRAME_LEN:{
             if(m_buffer[0] == DFU_SERIAL_HEADER)
             {
                 switch(m_buffer[1]){
@@ -212,7 +213,7 @@ static void dfu_serial_cmd_init_pkt(void)
 {
     uint8_t error = 0;
     memcpy(&m_init_pkt,m_buffer+2,sizeof(_init_pkt));
-    if(m_init_pkt.crc != dfu_crc32((uint8_t *)&m_init_pkt.crc + 4, sizeof(_init_pkt) - 4))
+    if(m_init_pkt.crc != ns_crc32((uint8_t *)&m_init_pkt.crc + 4, sizeof(_init_pkt) - 4))
     {
         error = 1;
     }
@@ -220,6 +221,11 @@ static void dfu_serial_cmd_init_pkt(void)
     {
         error = 1;
     }
+    // the bond database follows app2, a larger image would erase it
+    if((m_init_pkt.app_start_address == NS_APP2_START_ADDRESS) && (m_init_pkt.app_size > NS_APP2_DEFAULT_SIZE))
+    {
+        error = 1;
+    }
     uint8_t cmd[] = {DFU_SERIAL_HEADER,DFU_SERIAL_CMD_InitPkt,error};
     serial_send_data(cmd, sizeof(cmd));
 }
@@ -249,11 +255,11 @@ static void dfu_serial_cmd_pkt(void)
     
     if(m_pkt.offset >= m_pkt_header.size)
     {
-        if(m_pkt_header.crc == dfu_crc32(m_pkt.buffer, m_pkt_header.size))
+        if(m_pkt_header.crc == ns_crc32(m_pkt.buffer, m_pkt_header.size))
         {
             Qflash_Erase_Sector(m_init_pkt.app_start_address + m_pkt_header.offset);
             Qflash_Write(m_init_pkt.app_start_address + m_pkt_header.offset, m_pkt.buffer, m_pkt_header.size);
-            if(m_pkt_header.crc != dfu_crc32((uint8_t *)((uint32_t *)(m_init_pkt.app_start_address + m_pkt_header.offset)), m_pkt_header.size))
+            if(m_pkt_header.crc != ns_crc32((uint8_t *)((uint32_t *)(m_init_pkt.app_start_address + m_pkt_header.offset)), m_pkt_header.size))
             {
                 error = 1;
             }
@@ -275,7 +281,7 @@ static void dfu_serial_cmd_postvalidate(void)
 {
     uint8_t error = 0;
     
-    if(m_init_pkt.app_crc != dfu_crc32((uint8_t *)((uint32_t *)m_init_pkt.app_start_address), m_init_pkt.app_size))
+    if(m_init_pkt.app_crc != ns_crc32((uint8_t *)((uint32_t *)m_init_pkt.app_start_address), m_init_pkt.app_size))
     {
         error = 1;
     }
@@ -316,10 +322,10 @@ static void dfu_serial_cmd_postvalidate(void)
         }
         
         if(error == 0){
-            m_ns_bootsetting.crc = dfu_crc32((uint8_t *)&m_ns_bootsetting.crc + 4, sizeof(NS_Bootsetting_t) - 4);
+            m_ns_bootsetting.crc = ns_crc32((uint8_t *)&m_ns_bootsetting.crc + 4, sizeof(NS_Bootsetting_t) - 4);
             Qflash_Erase_Sector(NS_BOOTSETTING_START_ADDRESS);
             Qflash_Write(NS_BOOTSETTING_START_ADDRESS, (uint8_t *)&m_ns_bootsetting, sizeof(NS_Bootsetting_t));
-            if(m_ns_bootsetting.crc != dfu_crc32((uint8_t *)((uint32_t *)(NS_BOOTSETTING_START_ADDRESS + 4)), sizeof(NS_Bootsetting_t) - 4))
+            if(m_ns_bootsetting.crc != ns_crc32((uint8_t *)((uint32_t *)(NS_BOOTSETTING_START_ADDRESS + 4)), sizeof(NS_Bootsetting_t) - 4))
             {
                 error = 2;
             }        
@@ -385,7 +391,7 @@ static void dfu_serial_cmd_otp_read(void)
     
     if(error == 0)
     {
-        rec_pkt.crc = dfu_crc32(&otp_rsp[3+sizeof(_pkt_header)],rec_pkt.size);
+        rec_pkt.crc = ns_crc32(&otp_rsp[3+sizeof(_pkt_header)],rec_pkt.size);
         memcpy(&otp_rsp[3],&rec_pkt,sizeof(_pkt_header));// copy  address+size+crc
     }
     otp_rsp[2] = error;
@@ -415,7 +421,7 @@ static void dfu_serial_cmd_otp_write(void)
     uint8_t error = 0;
     _pkt_header rec_pkt = {0};  
     memcpy(&rec_pkt,m_buffer+2,sizeof(_pkt_header)); // copy  address+size+crc    
-    uint32_t check_crc = dfu_crc32(m_buffer+2+sizeof(_pkt_header), rec_pkt.size);    
+    uint32_t check_crc = ns_crc32(m_buffer+2+sizeof(_pkt_header), rec_pkt.size);    
 
     if(check_crc == rec_pkt.crc)
     {
@@ -470,25 +476,33 @@ static void dfu_serial_cmd_otp_lock(void)
 void USART1_IRQHandler(void)
 {
     static uint32_t index = 0;
-    static uint8_t buffer[256];
+    static uint8_t *buffer = NULL;
     
     if(USART_GetFlagStatus(USART1, USART_FLAG_RXDNE) != RESET)
     {
-        buffer[index] = USART_ReceiveData(USART1);
+        uint8_t data = USART_ReceiveData(USART1);
         
-        if(buffer[0] == DFU_SERIAL_HEADER)
+        if(index == 0)
         {
-            index++;
-            if(index >= 256)
+            if(data != DFU_SERIAL_HEADER)
             {
-                index = 0;    
-                memset(m_buffer,0,sizeof(m_buffer));
-                memcpy(m_buffer,buffer, 256);
-                
-                uint8_t event = SCHED_EVT_RX_DATA;
-                uint32_t    err_code = app_sched_event_put(&event ,sizeof(uint8_t),sched_evt);
-                ERROR_CHECK(err_code);
-            }                            
+                return;
+            }
+            // The frame is received straight into a scheduler slot
+            buffer = app_sched_event_reserve(APP_SCHED_PRIO_NORMAL, DFU_SERIAL_FRAME_LEN);
+            if(buffer == NULL)
+            {
+                ERROR_CHECK(1);
+                return;
+            }
+        }
+        buffer[index] = data;
+        index++;
+        if(index >= DFU_SERIAL_FRAME_LEN)
+        {
+            index = 0;    
+            uint32_t    err_code = app_sched_event_commit(buffer, DFU_SERIAL_FRAME_LEN, sched_evt);
+            ERROR_CHECK(err_code);
         }
     }    
 }
@@ -51,6 +51,10 @@ extern "C" {
 
 /* Public constants ---------------------------------------------------------*/
 /* Public function prototypes -----------------------------------------------*/
+/**
+ * @brief Initialize serial dfu. Frames are received into the APP_SCHED_PRIO_NORMAL scheduler
+ *        queue, which must be initialized with an event size of at least 256 bytes.
+ */
 void ns_dfu_serial_init(void);
 
 
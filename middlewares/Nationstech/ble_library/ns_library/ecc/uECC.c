@@ -44,7 +44,106 @@
 /* Private define ------------------------------------------------------------*/
 #define uECC_VLI_API static
 
+/* Cortex-M0 has no 32x32->64 multiply, products are built from 16 bit halves there */
+#ifndef uECC_MULT_16X16
+#if defined(__TARGET_ARCH_6S_M) || defined(__ARM_ARCH_6M__)
+#define uECC_MULT_16X16 1
+#else
+#define uECC_MULT_16X16 0
+#endif
+#endif
+
+/* wNAF widths of the verify scalars: u1 against the flash table of G, u2 against Q */
+#define uECC_G_WINDOW 6
+#define uECC_Q_WINDOW 4
+#define uECC_Q_TABLE_SIZE (1 << (uECC_Q_WINDOW - 2))
+#define uECC_NAF_DIGITS (uECC_MAX_WORDS * uECC_WORD_BITS + 1)
+
 /* Private constants ---------------------------------------------------------*/
+/* Odd multiples 1G, 3G, ... 31G of the secp256r1 generator, affine x then y */
+static const uECC_word_t secp256r1_G_odd[1 << (uECC_G_WINDOW - 2)][uECC_MAX_WORDS * 2] = {
+    { /* 1G */
+        0xD898C296, 0xF4A13945, 0x2DEB33A0, 0x77037D81,
+        0x63A440F2, 0xF8BCE6E5, 0xE12C4247, 0x6B17D1F2,
+        0x37BF51F5, 0xCBB64068, 0x6B315ECE, 0x2BCE3357,
+        0x7C0F9E16, 0x8EE7EB4A, 0xFE1A7F9B, 0x4FE342E2 },
+    { /* 3G */
+        0xC6E7FD6C, 0xFB41661B, 0xEFADA985, 0xE6C6B721,
+        0x1D4BF165, 0xC8F7EF95, 0xA6330A44, 0x5ECBE4D1,
+        0xA27D5032, 0x9A79B127, 0x384FB83D, 0xD82AB036,
+        0x1A64A2EC, 0x374B06CE, 0x4998FF7E, 0x8734640C },
+    { /* 5G */
+        0xC3D033ED, 0x21554A0D, 0x1F5BE524, 0xEF8C82FD,
+        0x08668FDF, 0xD784C856, 0x515140D2, 0x51590B7A,
+        0xFDA16DA4, 0xD1D0BB44, 0xD4D80888, 0x0D012F00,
+        0xBF8A7926, 0x8AE1BF36, 0x904A727D, 0xE0C17DA8 },
+    { /* 7G */
+        0x3187B2A3, 0x30062870, 0xA80FEF5B, 0x7EF9F8B8,
+        0x7C01FB60, 0x25BB3066, 0xA0BF7B46, 0x8E533B6F,
+        0xC1F400B4, 0xC55E1A86, 0xCB041B21, 0x53C73633,
+        0xA6F59000, 0x6D069F83, 0xE0331836, 0x73EB1DBD },
+    { /* 9G */
+        0x90949EE0, 0xD79E8A4B, 0x2C6DF8B3, 0x9E0ACB8C,
+        0x1D71F872, 0x878938D5, 0xFEDF0B71, 0xEA68D7B6,
+        0x4DD048FA, 0xE85A224A, 0xA4DE823F, 0x4D714FEA,
+        0x4A8EA0C8, 0x87014A96, 0x72C9FCE7, 0x2A2744C9 },
+    { /* 11G */
+        0x74BC21D1, 0x433391D3, 0x255048BF, 0x16742ED0,
+        0xB0C21CDA, 0x0638379D, 0x883B4C59, 0x3ED113B7,
+        0xE82A3740, 0xE2F8EEFC, 0x5E9889DA, 0x090D04DA,
+        0xA4F4C68A, 0x24C843AF, 0xCCC4C8A2, 0x9099209A },
+    { /* 13G */
+        0x46072C01, 0x98E15D9D, 0x65EAD58A, 0x792E284B,
+        0xD85EE2FC, 0x61805DF2, 0xE0AC495A, 0x177C837A,
+        0xEFC7BFD8, 0x9C43BBE2, 0xA1FB4DF3, 0x26EE14C3,
+        0xB40F4E72, 0xA24091AD, 0x4EBEA558, 0x63BB58CD },
+    { /* 15G */
+        0xE59B9D5F, 0x63668C63, 0xDE3A0EF1, 0xAE03AF92,
+        0x99888265, 0xADFB3789, 0x971ABAE7, 0xF0454DC6,
+        0x0D034F36, 0x47E59CDE, 0x75B5FA3F, 0x2A3B21CE,
+        0x1F9643E6, 0x4E6594E5, 0x592E2D1F, 0xB5B93EE3 },
+    { /* 17G */
+        0x4738A73E, 0xBA1ABCE3, 0xF0D64AF8, 0x5FA68678,
+        0x6F75301A, 0x9C0984B6, 0xC0F1CC3A, 0x47776904,
+        0x71F1FCDC, 0x32F787FF, 0x28D5733F, 0x81B28044,
+        0x77648E83, 0x62318565, 0xB5B95728, 0xAA005EE6 },
+    { /* 19G */
+        0xAB03ED83, 0xC1FC7B74, 0x57884895, 0x782C4522,
+        0x7108C507, 0xCE39B7C1, 0x102C0C25, 0xCB6D2861,
+        0x2BCECDAA, 0xE3915075, 0x30FA3E03, 0xA496716E,
+        0x0D6D6CE4, 0x5C35E710, 0x24D9EF51, 0x58D7614B },
+    { /* 21G */
+        0x67399E83, 0xFD76364E, 0xF42B1523, 0x3A582139,
+        0xB473BCA5, 0x2E4AC86E, 0x86637C7B, 0x3250FCF6,
+        0x71D48C09, 0x15DE24A0, 0x3B566A82, 0x897CD3C3,
+        0x1D7EB88C, 0x97B3090D, 0x667D3593, 0x42E7C342 },
+    { /* 23G */
+        0x45CA7896, 0x672E5730, 0xDF64A4FE, 0x3C0BC0A5,
+        0xD4583FA6, 0xD28A3E39, 0x9C2640D7, 0x0E91C723,
+        0x3140AD55, 0x13804654, 0x75E7A5AE, 0x7E688335,
+        0xB8E0BD6D, 0x1A22733B, 0x550DBA22, 0x5DF65C3B },
+    { /* 25G */
+        0xF200D687, 0x84A4DC45, 0xB76F1B24, 0x41652FC5,
+        0x8C07FA84, 0x85F4F52D, 0x4B0C0BB6, 0x3A67E255,
+        0x02F79324, 0xA9ED16B3, 0x35A7618A, 0x8C188AF7,
+        0x163AFB0D, 0x26DAF267, 0x2F1FCF43, 0x27D0F187 },
+    { /* 27G */
+        0x3B0883D1, 0xF2E20117, 0x683E54AB, 0x576355BD,
+        0x4611F378, 0xDEBA2FAC, 0x19D80D51, 0x184FFA58,
+        0x60906E6F, 0x20D242C2, 0x63F04916, 0x45BDECCC,
+        0x26CB9995, 0xA4C6D908, 0x6688F359, 0xC0A66E27 },
+    { /* 29G */
+        0x1C784DEF, 0xDEDD693D, 0x88B58A41, 0xFD8CD1C6,
+        0x90853B8C, 0xA7C36DA0, 0xFA195B07, 0xD6D33ADE,
+        0x93D1BCA6, 0x550C1245, 0x4B95EDED, 0x09A166AB,
+        0x558A5DCB, 0x3F78245F, 0xEE195D7E, 0x84AABA16 },
+    { /* 31G */
+        0xA1B45B8B, 0x3E3F9AA0, 0x52A95B3E, 0xFAC9DB7D,
+        0xA7AE9AA0, 0xA85DA026, 0x2DC7E05D, 0x301D9E50,
+        0xA17EE267, 0xD58DB6AE, 0x6887CA61, 0x298D9AE4,
+        0x6B017D72, 0xE0D23C02, 0xB3061223, 0x6551B6F6 },
+};
+
 /* Private variables ---------------------------------------------------------*/
 /* Private function prototypes -----------------------------------------------*/
 /* Private functions ---------------------------------------------------------*/
@@ -99,17 +198,81 @@ uECC_VLI_API uECC_word_t uECC_vli_sub(uECC_word_t *result,
 }
 
 
+#if uECC_MULT_16X16
+/* 64 bit product of a and b from four 16x16 multiplies, high word in *hi. */
+static uECC_word_t mul_32x32(uECC_word_t a, uECC_word_t b, uECC_word_t *hi) {
+    uECC_word_t a0 = a & 0xFFFF, a1 = a >> 16;
+    uECC_word_t b0 = b & 0xFFFF, b1 = b >> 16;
+    uECC_word_t lo = a0 * b0;
+    uECC_word_t mid = a0 * b1;
+    uECC_word_t mid2 = a1 * b0;
+    uECC_word_t h = a1 * b1;
+
+    mid += mid2;
+    h += (mid < mid2) ? 0x10000 : 0;
+    h += mid >> 16;
+    mid <<= 16;
+    lo += mid;
+    h += (lo < mid);
+    *hi = h;
+    return lo;
+}
+#endif
+
 static void muladd(uECC_word_t a,
                    uECC_word_t b,
                    uECC_word_t *r0,
                    uECC_word_t *r1,
                    uECC_word_t *r2) {
+#if uECC_MULT_16X16
+    uECC_word_t hi;
+    uECC_word_t lo = mul_32x32(a, b, &hi);
+
+    *r0 += lo;
+    hi += (*r0 < lo); /* cannot wrap, the high word of a product is at most 0xFFFFFFFE */
+    *r1 += hi;
+    *r2 += (*r1 < hi);
+#else
+    uECC_dword_t p = (uECC_dword_t)a * b;
+    uECC_dword_t r01 = ((uECC_dword_t)(*r1) << uECC_WORD_BITS) | *r0;
+    r01 += p;
+    *r2 += (r01 < p);
+    *r1 = r01 >> uECC_WORD_BITS;
+    *r0 = (uECC_word_t)r01;
+#endif
+}
+
+/* Like muladd, but adds the product twice, for the cross terms of a square. */
+static void mul2add(uECC_word_t a,
+                    uECC_word_t b,
+                    uECC_word_t *r0,
+                    uECC_word_t *r1,
+                    uECC_word_t *r2) {
+#if uECC_MULT_16X16
+    uECC_word_t hi;
+    uECC_word_t lo = mul_32x32(a, b, &hi);
+
+    uECC_word_t carry;
+
+    *r2 += (hi >> (uECC_WORD_BITS - 1));
+    hi = (hi << 1) | (lo >> (uECC_WORD_BITS - 1));
+    lo <<= 1;
+    *r0 += lo;
+    carry = (*r0 < lo);
+    *r1 += carry;
+    *r2 += (*r1 < carry);
+    *r1 += hi;
+    *r2 += (*r1 < hi);
+#else
     uECC_dword_t p = (uECC_dword_t)a * b;
     uECC_dword_t r01 = ((uECC_dword_t)(*r1) << uECC_WORD_BITS) | *r0;
+    *r2 += (p >> (uECC_WORD_BITS * 2 - 1));
+    p *= 2;
     r01 += p;
     *r2 += (r01 < p);
     *r1 = r01 >> uECC_WORD_BITS;
     *r0 = (uECC_word_t)r01;
+#endif
 }
 
 uECC_VLI_API void uECC_vli_mult(uECC_word_t *result,
@@ -143,6 +306,32 @@ uECC_VLI_API void uECC_vli_mult(uECC_word_t *result,
     result[num_words * 2 - 1] = r0;
 }
 
+/* Like uECC_vli_mult(result, left, left), each cross product is computed once. */
+uECC_VLI_API void uECC_vli_square(uECC_word_t *result,
+                                  const uECC_word_t *left,
+                                  wordcount_t num_words) {
+    uECC_word_t r0 = 0;
+    uECC_word_t r1 = 0;
+    uECC_word_t r2 = 0;
+    wordcount_t i, k;
+
+    for (k = 0; k < num_words * 2 - 1; ++k) {
+        wordcount_t min = (k < num_words ? 0 : (k + 1) - num_words);
+        for (i = min; i <= k && i <= k - i; ++i) {
+            if (i < k - i) {
+                mul2add(left[i], left[k - i], &r0, &r1, &r2);
+            } else {
+                muladd(left[i], left[k - i], &r0, &r1, &r2);
+            }
+        }
+        result[k] = r0;
+        r0 = r1;
+        r1 = r2;
+        r2 = 0;
+    }
+    result[num_words * 2 - 1] = r0;
+}
+
 uECC_VLI_API void uECC_vli_set(uECC_word_t *dest, const uECC_word_t *src, wordcount_t num_words) {
     wordcount_t i;
     for (i = 0; i < num_words; ++i) {
@@ -204,7 +393,9 @@ uECC_VLI_API void uECC_vli_modAdd(uECC_word_t *result,
 uECC_VLI_API void uECC_vli_modSquare_fast(uECC_word_t *result,
                                           const uECC_word_t *left,
                                           uECC_Curve curve) {
-    uECC_vli_modMult_fast(result, left, left, curve);
+    uECC_word_t product[2 * uECC_MAX_WORDS];
+    uECC_vli_square(product, left, curve->num_words);
+    curve->mmod_fast(result, product);
 }
 
 
@@ -615,53 +806,157 @@ uECC_VLI_API void uECC_vli_modMult(uECC_word_t *result,
                                 
 
 
-/* Input P = (x1, y1, Z), Q = (x2, y2, Z)
-   Output P' = (x1', y1', Z3), P + Q = (x3, y3, Z3)
-   or P => P', Q => P + Q
-*/
-static void XYcZ_add(uECC_word_t * X1,
-                     uECC_word_t * Y1,
-                     uECC_word_t * X2,
-                     uECC_word_t * Y2,
-                     uECC_Curve curve) {
-    /* t1 = X1, t2 = Y1, t3 = X2, t4 = Y2 */
-    uECC_word_t t5[uECC_MAX_WORDS];
+/* (X1, Y1, Z1) += (x2, y2) or -(x2, y2) if negate is set. Jacobian plus affine,
+   Z1 = 0 is the point at infinity. */
+static void add_mixed(uECC_word_t * X1,
+                      uECC_word_t * Y1,
+                      uECC_word_t * Z1,
+                      const uECC_word_t * x2,
+                      const uECC_word_t * y2,
+                      uECC_word_t negate,
+                      uECC_Curve curve) {
+    uECC_word_t t1[uECC_MAX_WORDS];
+    uECC_word_t t2[uECC_MAX_WORDS];
+    uECC_word_t t3[uECC_MAX_WORDS];
+    uECC_word_t y[uECC_MAX_WORDS];
     wordcount_t num_words = curve->num_words;
 
-    uECC_vli_modSub(t5, X2, X1, curve->p, num_words); /* t5 = x2 - x1 */
-    uECC_vli_modSquare_fast(t5, t5, curve);                  /* t5 = (x2 - x1)^2 = A */
-    uECC_vli_modMult_fast(X1, X1, t5, curve);                /* t1 = x1*A = B */
-    uECC_vli_modMult_fast(X2, X2, t5, curve);                /* t3 = x2*A = C */
-    uECC_vli_modSub(Y2, Y2, Y1, curve->p, num_words); /* t4 = y2 - y1 */
-    uECC_vli_modSquare_fast(t5, Y2, curve);                  /* t5 = (y2 - y1)^2 = D */
-
-    uECC_vli_modSub(t5, t5, X1, curve->p, num_words); /* t5 = D - B */
-    uECC_vli_modSub(t5, t5, X2, curve->p, num_words); /* t5 = D - B - C = x3 */
-    uECC_vli_modSub(X2, X2, X1, curve->p, num_words); /* t3 = C - B */
-    uECC_vli_modMult_fast(Y1, Y1, X2, curve);                /* t2 = y1*(C - B) */
-    uECC_vli_modSub(X2, X1, t5, curve->p, num_words); /* t3 = B - x3 */
-    uECC_vli_modMult_fast(Y2, Y2, X2, curve);                /* t4 = (y2 - y1)*(B - x3) */
-    uECC_vli_modSub(Y2, Y2, Y1, curve->p, num_words); /* t4 = y3 */
-
-    uECC_vli_set(X2, t5, num_words);
-}
-/* Point multiplication algorithm using Montgomery's ladder with co-Z coordinates.
-From http://eprint.iacr.org/2011/338.pdf
-*/
-
-/* Modify (x1, y1) => (x1 * z^2, y1 * z^3) */
-static void apply_z(uECC_word_t * X1,
-                    uECC_word_t * Y1,
-                    const uECC_word_t * const Z,
-                    uECC_Curve curve) {
-    uECC_word_t t1[uECC_MAX_WORDS];
+    if (negate) {
+        uECC_vli_sub(y, curve->p, y2, num_words);
+    } else {
+        uECC_vli_set(y, y2, num_words);
+    }
+
+    if (uECC_vli_isZero(Z1, num_words)) {
+        uECC_vli_set(X1, x2, num_words);
+        uECC_vli_set(Y1, y, num_words);
+        uECC_vli_clear(Z1, num_words);
+        Z1[0] = 1;
+        return;
+    }
+
+    uECC_vli_modSquare_fast(t1, Z1, curve);                   /* t1 = z1^2 */
+    uECC_vli_modMult_fast(t2, t1, Z1, curve);                 /* t2 = z1^3 */
+    uECC_vli_modMult_fast(t1, t1, x2, curve);                 /* t1 = x2*z1^2 */
+    uECC_vli_modMult_fast(t2, t2, y, curve);                  /* t2 = y2*z1^3 */
+    uECC_vli_modSub(t1, t1, X1, curve->p, num_words);  /* t1 = x2*z1^2 - x1 = H */
+    uECC_vli_modSub(t2, t2, Y1, curve->p, num_words);  /* t2 = y2*z1^3 - y1 = R */
+    if (uECC_vli_isZero(t1, num_words)) {
+        if (uECC_vli_isZero(t2, num_words)) {
+            curve->double_jacobian(X1, Y1, Z1, curve);        /* same point */
+        } else {
+            uECC_vli_clear(Z1, num_words);                   /* opposite points */
+        }
+        return;
+    }
+
+    uECC_vli_modMult_fast(Z1, Z1, t1, curve);                 /* z3 = z1*H */
+    uECC_vli_modSquare_fast(t3, t1, curve);                   /* t3 = H^2 */
+    uECC_vli_modMult_fast(t1, t1, t3, curve);                 /* t1 = H^3 */
+    uECC_vli_modMult_fast(t3, t3, X1, curve);                 /* t3 = x1*H^2 = V */
+    uECC_vli_modSquare_fast(X1, t2, curve);                   /* x1 = R^2 */
+    uECC_vli_modSub(X1, X1, t1, curve->p, num_words);  /* x1 = R^2 - H^3 */
+    uECC_vli_modSub(X1, X1, t3, curve->p, num_words);
+    uECC_vli_modSub(X1, X1, t3, curve->p, num_words);  /* x1 = R^2 - H^3 - 2V = x3 */
+    uECC_vli_modSub(t3, t3, X1, curve->p, num_words);  /* t3 = V - x3 */
+    uECC_vli_modMult_fast(t3, t3, t2, curve);                 /* t3 = R*(V - x3) */
+    uECC_vli_modMult_fast(Y1, Y1, t1, curve);                 /* y1 = y1*H^3 */
+    uECC_vli_modSub(Y1, t3, Y1, curve->p, num_words);  /* y1 = R*(V - x3) - y1*H^3 = y3 */
+}
+
+/* Builds the affine odd multiples Q, 3Q, 5Q, ... of the public key. The Jacobian
+   sums are brought back to affine with a single inversion. */
+static void q_table_build(uECC_word_t table[][uECC_MAX_WORDS * 2],
+                          const uECC_word_t *Q,
+                          uECC_Curve curve) {
+    uECC_word_t x2[uECC_MAX_WORDS], y2[uECC_MAX_WORDS], z[uECC_MAX_WORDS];
+    uECC_word_t zs[uECC_Q_TABLE_SIZE][uECC_MAX_WORDS];
+    uECC_word_t prefix[uECC_Q_TABLE_SIZE][uECC_MAX_WORDS];
+    uECC_word_t t[uECC_MAX_WORDS];
+    wordcount_t num_words = curve->num_words;
+    uint8_t i;
+
+    /* 2Q in affine */
+    uECC_vli_set(x2, Q, num_words);
+    uECC_vli_set(y2, Q + num_words, num_words);
+    uECC_vli_clear(z, num_words);
+    z[0] = 1;
+    curve->double_jacobian(x2, y2, z, curve);
+    uECC_vli_modInv(z, z, curve->p, num_words);
+    uECC_vli_modSquare_fast(t, z, curve);
+    uECC_vli_modMult_fast(x2, x2, t, curve);
+    uECC_vli_modMult_fast(t, t, z, curve);
+    uECC_vli_modMult_fast(y2, y2, t, curve);
+
+    /* table[i] = table[i - 1] + 2Q, kept Jacobian for now */
+    uECC_vli_set(table[0], Q, num_words * 2);
+    uECC_vli_set(t, Q, num_words);
+    uECC_vli_set(z, Q + num_words, num_words);
+    uECC_vli_clear(zs[0], num_words);
+    zs[0][0] = 1;
+    for (i = 1; i < uECC_Q_TABLE_SIZE; ++i) {
+        uECC_vli_set(zs[i], zs[i - 1], num_words);
+        add_mixed(t, z, zs[i], x2, y2, 0, curve);
+        uECC_vli_set(table[i], t, num_words);
+        uECC_vli_set(table[i] + num_words, z, num_words);
+    }
 
-    uECC_vli_modSquare_fast(t1, Z, curve);    /* z^2 */
-    uECC_vli_modMult_fast(X1, X1, t1, curve); /* x1 * z^2 */
-    uECC_vli_modMult_fast(t1, t1, Z, curve);  /* z^3 */
-    uECC_vli_modMult_fast(Y1, Y1, t1, curve); /* y1 * z^3 */
+    /* invert every z at once: 1/z_i = prefix_{i-1} / prefix_i */
+    uECC_vli_set(prefix[1], zs[1], num_words);
+    for (i = 2; i < uECC_Q_TABLE_SIZE; ++i) {
+        uECC_vli_modMult_fast(prefix[i], prefix[i - 1], zs[i], curve);
+    }
+    uECC_vli_modInv(z, prefix[uECC_Q_TABLE_SIZE - 1], curve->p, num_words);
+    for (i = uECC_Q_TABLE_SIZE - 1; i >= 1; --i) {
+        if (i > 1) {
+            uECC_vli_modMult_fast(t, z, prefix[i - 1], curve);  /* t = 1/z_i */
+            uECC_vli_modMult_fast(z, z, zs[i], curve);
+        } else {
+            uECC_vli_set(t, z, num_words);
+        }
+        uECC_vli_modSquare_fast(x2, t, curve);
+        uECC_vli_modMult_fast(table[i], table[i], x2, curve);
+        uECC_vli_modMult_fast(x2, x2, t, curve);
+        uECC_vli_modMult_fast(table[i] + num_words, table[i] + num_words, x2, curve);
+    }
+}
+
+/* Width-w NAF of scalar, least significant digit first: odd digits below 2^(w-1) in
+   magnitude with at least w-1 zeros after each. Returns the number of digits. */
+static bitcount_t vli_wnaf(int8_t *naf,
+                           const uECC_word_t *scalar,
+                           uint8_t w,
+                           wordcount_t num_words) {
+    uECC_word_t k[uECC_MAX_WORDS + 1];
+    bitcount_t len = 0;
+
+    uECC_vli_set(k, scalar, num_words);
+    k[num_words] = 0;
+    while (!uECC_vli_isZero(k, num_words + 1)) {
+        int digit = 0;
+        if (k[0] & 1) {
+            digit = (int)(k[0] & ((1u << w) - 1));
+            if (digit >= (1 << (w - 1))) {
+                digit -= (1 << w);
+            }
+            if (digit > 0) {
+                k[0] -= (uECC_word_t)digit;   /* clears the low bits, no borrow */
+            } else {
+                uECC_word_t add = (uECC_word_t)(-digit);
+                wordcount_t i;
+                k[0] += add;
+                if (k[0] < add) {
+                    for (i = 1; i <= num_words && ++k[i] == 0; ++i) {
+                    }
+                }
+            }
+        }
+        naf[len++] = (int8_t)digit;
+        uECC_vli_rshift1(k, num_words + 1);
+    }
+    return len;
 }
-                                        
+
 static bitcount_t smax(bitcount_t a, bitcount_t b) {
     return (a > b ? a : b);
 }
@@ -687,22 +982,18 @@ int uECC_verify(const uint8_t *public_key,
                 uECC_Curve curve) {
     uECC_word_t u1[uECC_MAX_WORDS], u2[uECC_MAX_WORDS];
     uECC_word_t z[uECC_MAX_WORDS];
-    uECC_word_t sum[uECC_MAX_WORDS * 2];
     uECC_word_t rx[uECC_MAX_WORDS];
     uECC_word_t ry[uECC_MAX_WORDS];
     uECC_word_t tx[uECC_MAX_WORDS];
-    uECC_word_t ty[uECC_MAX_WORDS];
-    uECC_word_t tz[uECC_MAX_WORDS];
-    const uECC_word_t *points[4];
-    const uECC_word_t *point;
-    bitcount_t num_bits;
+    uECC_word_t q_table[uECC_Q_TABLE_SIZE][uECC_MAX_WORDS * 2];
+    int8_t naf1[uECC_NAF_DIGITS], naf2[uECC_NAF_DIGITS];
+    bitcount_t len1, len2;
     bitcount_t i;
     uECC_word_t *_public = (uECC_word_t *)public_key;
     uECC_word_t r[uECC_MAX_WORDS], s[uECC_MAX_WORDS];
     wordcount_t num_words = curve->num_words;
     wordcount_t num_n_words = BITS_TO_WORDS(curve->num_n_bits);
 
-    rx[num_n_words - 1] = 0;
     r[num_n_words - 1] = 0;
     s[num_n_words - 1] = 0;
 
@@ -721,6 +1012,17 @@ int uECC_verify(const uint8_t *public_key,
         return 0;
     }
 
+    /* The public key must be a point on the curve, the tables below rely on it. */
+    if (uECC_vli_cmp_unsafe(curve->p, _public, num_words) != 1 ||
+            uECC_vli_cmp_unsafe(curve->p, _public + num_words, num_words) != 1) {
+        return 0;
+    }
+    curve->x_side(tx, _public, curve);
+    uECC_vli_modSquare_fast(z, _public + num_words, curve);
+    if (!uECC_vli_equal(tx, z, num_words)) {
+        return 0;
+    }
+
     /* Calculate u1 and u2. */
     uECC_vli_modInv(z, s, curve->n, num_n_words); /* z = 1/s */
     u1[num_n_words - 1] = 0;
@@ -728,58 +1030,40 @@ int uECC_verify(const uint8_t *public_key,
     uECC_vli_modMult(u1, u1, z, curve->n, num_n_words); /* u1 = e/s */
     uECC_vli_modMult(u2, r, z, curve->n, num_n_words); /* u2 = r/s */
 
-    /* Calculate sum = G + Q. */
-    uECC_vli_set(sum, _public, num_words);
-    uECC_vli_set(sum + num_words, _public + num_words, num_words);
-    uECC_vli_set(tx, curve->G, num_words);
-    uECC_vli_set(ty, curve->G + num_words, num_words);
-    uECC_vli_modSub(z, sum, tx, curve->p, num_words); /* z = x2 - x1 */
-    XYcZ_add(tx, ty, sum, sum + num_words, curve);
-    uECC_vli_modInv(z, z, curve->p, num_words); /* z = 1/z */
-    apply_z(sum, sum + num_words, z, curve);
-
-    /* Use Shamir's trick to calculate u1*G + u2*Q */
-    points[0] = 0;
-    points[1] = curve->G;
-    points[2] = _public;
-    points[3] = sum;
-    num_bits = smax(uECC_vli_numBits(u1, num_n_words),
-                    uECC_vli_numBits(u2, num_n_words));
-
-    point = points[(!!uECC_vli_testBit(u1, num_bits - 1)) |
-                   ((!!uECC_vli_testBit(u2, num_bits - 1)) << 1)];
-    uECC_vli_set(rx, point, num_words);
-    uECC_vli_set(ry, point + num_words, num_words);
-    uECC_vli_clear(z, num_words);
-    z[0] = 1;
+    /* Shamir's trick on wNAF digits: u1*G from the flash table, u2*Q from odd multiples
+       of Q computed here, sharing one chain of doublings. */
+    q_table_build(q_table, _public, curve);
+    len1 = vli_wnaf(naf1, u1, uECC_G_WINDOW, num_n_words);
+    len2 = vli_wnaf(naf2, u2, uECC_Q_WINDOW, num_n_words);
 
-    for (i = num_bits - 2; i >= 0; --i) {
-        uECC_word_t index;
+    uECC_vli_clear(rx, num_words);
+    uECC_vli_clear(ry, num_words);
+    uECC_vli_clear(z, num_words);
+    for (i = smax(len1, len2) - 1; i >= 0; --i) {
         curve->double_jacobian(rx, ry, z, curve);
-
-        index = (!!uECC_vli_testBit(u1, i)) | ((!!uECC_vli_testBit(u2, i)) << 1);
-        point = points[index];
-        if (point) {
-            uECC_vli_set(tx, point, num_words);
-            uECC_vli_set(ty, point + num_words, num_words);
-            apply_z(tx, ty, z, curve);
-            uECC_vli_modSub(tz, rx, tx, curve->p, num_words); /* Z = x2 - x1 */
-            XYcZ_add(tx, ty, rx, ry, curve);
-            uECC_vli_modMult_fast(z, z, tz, curve);
+        if (i < len1 && naf1[i]) {
+            const uECC_word_t *point = secp256r1_G_odd[(naf1[i] < 0 ? -naf1[i] : naf1[i]) >> 1];
+            add_mixed(rx, ry, z, point, point + num_words, naf1[i] < 0, curve);
+        }
+        if (i < len2 && naf2[i]) {
+            const uECC_word_t *point = q_table[(naf2[i] < 0 ? -naf2[i] : naf2[i]) >> 1];
+            add_mixed(rx, ry, z, point, point + num_words, naf2[i] < 0, curve);
         }
     }
-
-    uECC_vli_modInv(z, z, curve->p, num_words); /* Z = 1/Z */
-    apply_z(rx, ry, z, curve);
-
-    /* v = x1 (mod n) */
-    if (uECC_vli_cmp_unsafe(curve->n, rx, num_n_words) != 1) {
-        uECC_vli_sub(rx, rx, curve->n, num_n_words);
+    if (uECC_vli_isZero(z, num_words)) {
+        return 0;
     }
 
-    /* Accept only if v == r. */
-    return (int)(uECC_vli_equal(rx, r, num_words));
+    /* Accept if x1 mod n == r, that is x1 == r or x1 == r + n, compared as
+       X == r*Z^2 so no inversion is needed. */
+    uECC_vli_modSquare_fast(z, z, curve);
+    uECC_vli_modMult_fast(tx, r, z, curve);
+    if (uECC_vli_equal(tx, rx, num_words)) {
+        return 1;
+    }
+    if (!uECC_vli_add(tx, r, curve->n, num_words) && uECC_vli_cmp_unsafe(curve->p, tx, num_words) == 1) {
+        uECC_vli_modMult_fast(tx, tx, z, curve);
+        return (int)(uECC_vli_equal(tx, rx, num_words));
+    }
+    return 0;
 }
-
-
-
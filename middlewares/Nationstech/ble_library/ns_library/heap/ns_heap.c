@@ -0,0 +1,317 @@
+/*****************************************************************************
+ * Copyright (c) 2019, Nations Technologies Inc.
+ *
+ * All rights reserved.
+ * ****************************************************************************
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Nations' name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY NATIONS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL NATIONS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ****************************************************************************/
+
+/**
+ * @file ns_heap.c
+ * @author Nations Firmware Team
+ * @version v1.0.0
+ *
+ * @copyright Copyright (c) 2019, Nations Technologies Inc. All rights reserved.
+ */
+
+/** @addtogroup 
+ * @{
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "ns_heap.h"
+#include <string.h>
+#include "ke_env.h"
+#include "ke_msg.h"
+#include "co_math.h"
+#include "global_func.h"
+#include "global_var.h"
+#include "ns_log.h"
+
+/* Private typedef -----------------------------------------------------------*/
+/// Delimiter at the start of every kernel heap block, used or free (ke_mem.c)
+struct heap_blk_t
+{
+    uint16_t corrupt_check;
+    uint16_t size;                                  /**< Block size including the delimiter */
+};
+
+/// Free block, chained from ke_env.heap[type]
+struct heap_free_blk_t
+{
+    struct heap_blk_t hdr;
+    struct heap_free_blk_t *next;
+    struct heap_free_blk_t *previous;
+};
+
+/// Result of one heap walk
+struct heap_walk_t
+{
+    uint16_t used;
+    uint16_t free_largest;
+    uint16_t free_blocks;
+    uint16_t hist[NS_HEAP_SIZE_CLASS_NB];
+    struct ns_heap_msg_stats_t msg[NS_HEAP_MSG_ID_NB];
+    bool     corrupt;
+};
+
+/* Private define ------------------------------------------------------------*/
+/// Largest block size of the first size class, each class doubles it
+#define HEAP_CLASS_MIN_SIZE         16
+
+/* Private constants ---------------------------------------------------------*/
+/* Private variables ---------------------------------------------------------*/
+static struct ns_heap_stats_t ns_heap_env;
+
+/* Private function prototypes -----------------------------------------------*/
+/* Private functions ---------------------------------------------------------*/
+
+/**
+ * @brief  Start of the memory given to ke_mem_init() for a heap.
+ * @param  type: enum KE_MEM_HEAP
+ * @return heap start, NULL if unknown
+ * @note   
+ */
+static uint8_t *heap_base(uint8_t type)
+{
+    switch(type)
+    {
+        case KE_MEM_ENV:            return (uint8_t *)(uintptr_t)g_rwip_heap_env;
+        #if (BLE_HOST_PRESENT)
+        case KE_MEM_ATT_DB:         return (uint8_t *)(uintptr_t)g_rwip_heap_db;
+        #endif
+        case KE_MEM_KE_MSG:         return (uint8_t *)(uintptr_t)g_rwip_heap_msg;
+        case KE_MEM_NON_RETENTION:  return (uint8_t *)(uintptr_t)g_rwip_heap_non_ret;
+        default:                    return NULL;
+    }
+}
+
+/**
+ * @brief  Size class of a block.
+ * @param  size: block size including the delimiter
+ * @return index in ns_heap_type_stats_t.hist
+ * @note   
+ */
+static uint8_t heap_size_class(uint16_t size)
+{
+    uint8_t cls = 0;
+    uint16_t limit = HEAP_CLASS_MIN_SIZE;
+
+    while((size > limit) && (cls < NS_HEAP_SIZE_CLASS_NB - 1))
+    {
+        limit <<= 1;
+        cls++;
+    }
+    return cls;
+}
+
+/**
+ * @brief  Account a used block of the message heap to its message id.
+ * @param  msg: table, the last entry collects the ids that do not fit
+ * @param  id: message id of the block
+ * @param  size: block size including the delimiter
+ * @return 
+ * @note   
+ */
+static void heap_msg_add(struct ns_heap_msg_stats_t *msg, uint16_t id, uint16_t size)
+{
+    uint8_t i;
+
+    for(i = 0; i < NS_HEAP_MSG_ID_NB - 1; i++)
+    {
+        if((msg[i].count == 0) || (msg[i].id == id))
+        {
+            break;
+        }
+    }
+    if(i == NS_HEAP_MSG_ID_NB - 1)
+    {
+        id = NS_HEAP_MSG_ID_OTHER;
+    }
+    msg[i].id = id;
+    msg[i].count++;
+    msg[i].bytes += size;
+}
+
+/**
+ * @brief  Walk one heap block by block, a block is free when it is in the free list.
+ * @param  type: enum KE_MEM_HEAP
+ * @param  p_walk: result
+ * @return 
+ * @note   Runs with interrupts disabled, the heaps are also used from interrupt context.
+ *         ke_free() keeps the free list in address order, so the list is followed with
+ *         the blocks and the walk is linear in the number of blocks.
+ */
+static void heap_walk(uint8_t type, struct heap_walk_t *p_walk)
+{
+    uint8_t *base = heap_base(type);
+    struct heap_free_blk_t *node;
+    uint8_t *blk;
+    uint8_t *end;
+
+    memset(p_walk, 0, sizeof(*p_walk));
+    if(base == NULL)
+    {
+        return;
+    }
+
+    GLOBAL_INT_DISABLE();
+    blk = (uint8_t *)CO_ALIGN4_HI((uintptr_t)base);
+    end = base + ke_env.heap_size[type];
+    node = (struct heap_free_blk_t *)ke_env.heap[type];
+    while(blk + sizeof(struct heap_blk_t) <= end)
+    {
+        uint16_t size = ((struct heap_blk_t *)blk)->size;
+
+        if((size < sizeof(struct heap_blk_t)) || (size & 0x3) || (size > end - blk))
+        {
+            p_walk->corrupt = true;
+            break;
+        }
+        // Free blocks behind the walk are skipped, an out of order list cannot loop
+        while((node != NULL) && ((uint8_t *)node < blk))
+        {
+            node = node->next;
+        }
+
+        if((uint8_t *)node == blk)
+        {
+            p_walk->free_blocks++;
+            p_walk->free_largest = co_max(p_walk->free_largest, size);
+        }
+        else
+        {
+            p_walk->used += size;
+            p_walk->hist[heap_size_class(size)]++;
+            if((type == KE_MEM_KE_MSG) && (size >= sizeof(struct heap_blk_t) + sizeof(struct ke_msg)))
+            {
+                // ke_msg and ke_timer both keep the message id right after the list header
+                heap_msg_add(p_walk->msg, ((struct ke_msg *)(blk + sizeof(struct heap_blk_t)))->id, size);
+            }
+        }
+        blk += size;
+    }
+    GLOBAL_INT_RESTORE();
+}
+
+/* Public functions ---------------------------------------------------------*/
+
+/**
+ * @brief  Walk the kernel heaps and keep the high water marks.
+ * @param  
+ * @return 
+ * @note   The walk follows the block delimiters of the kernel allocator and the
+ *         free list with them, interrupts stay masked for one heap at a time.
+ */
+void ns_heap_sample(void)
+{
+    struct heap_walk_t walk;
+    bool first = (ns_heap_env.samples == 0);
+    uint8_t type;
+
+    for(type = 0; type < KE_MEM_BLOCK_MAX; type++)
+    {
+        struct ns_heap_type_stats_t *p_heap = &ns_heap_env.heap[type];
+
+        heap_walk(type, &walk);
+        if(walk.corrupt && (ns_heap_env.corrupt != 0xFFFF))
+        {
+            ns_heap_env.corrupt++;
+        }
+
+        p_heap->size         = ke_env.heap_size[type];
+        p_heap->used         = walk.used;
+        p_heap->free_largest = walk.free_largest;
+        p_heap->free_blocks  = walk.free_blocks;
+        if(first || (walk.free_largest < p_heap->free_largest_min))
+        {
+            p_heap->free_largest_min = walk.free_largest;
+        }
+        if(first || (walk.used > p_heap->used_max))
+        {
+            p_heap->used_max = walk.used;
+            memcpy(p_heap->hist, walk.hist, sizeof(p_heap->hist));
+            if(type == KE_MEM_KE_MSG)
+            {
+                memcpy(ns_heap_env.msg, walk.msg, sizeof(ns_heap_env.msg));
+            }
+        }
+    }
+
+    if(ns_heap_env.samples != 0xFFFF)
+    {
+        ns_heap_env.samples++;
+    }
+}
+
+/**
+ * @brief  Get the heap statistics.
+ * @param  p_stats: output
+ * @return 
+ * @note   
+ */
+void ns_heap_stats_get(struct ns_heap_stats_t *p_stats)
+{
+    ns_heap_sample();
+    *p_stats = ns_heap_env;
+}
+
+/**
+ * @brief  Clear the high water marks, the next sample starts them again.
+ * @param  
+ * @return 
+ * @note   
+ */
+void ns_heap_stats_reset(void)
+{
+    memset(&ns_heap_env, 0, sizeof(ns_heap_env));
+}
+
+/**
+ * @brief  Print the heap statistics.
+ * @param  
+ * @return 
+ * @note   
+ */
+void ns_heap_stats_log(void)
+{
+    struct ns_heap_stats_t stats;
+    uint8_t i;
+
+    ns_heap_stats_get(&stats);
+    for(i = 0; i < KE_MEM_BLOCK_MAX; i++)
+    {
+        const struct ns_heap_type_stats_t *p_heap = &stats.heap[i];
+
+        NS_LOG_INFO("heap %d: used %d max %d of %d, largest free %d min %d, %d free blocks\r\n",
+                    i, p_heap->used, p_heap->used_max, p_heap->size,
+                    p_heap->free_largest, p_heap->free_largest_min, p_heap->free_blocks);
+        NS_LOG_INFO("heap %d at max: %d %d %d %d %d %d blocks\r\n", i,
+                    p_heap->hist[0], p_heap->hist[1], p_heap->hist[2],
+                    p_heap->hist[3], p_heap->hist[4], p_heap->hist[5]);
+    }
+    for(i = 0; (i < NS_HEAP_MSG_ID_NB) && (stats.msg[i].count != 0); i++)
+    {
+        NS_LOG_INFO("msg 0x%04x: %d blocks %d bytes\r\n", stats.msg[i].id, stats.msg[i].count, stats.msg[i].bytes);
+    }
+    NS_LOG_INFO("%d samples, %d corrupt walks\r\n", stats.samples, stats.corrupt);
+}
@@ -0,0 +1,126 @@
+/*****************************************************************************
+ * Copyright (c) 2019, Nations Technologies Inc.
+ *
+ * All rights reserved.
+ * ****************************************************************************
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Nations' name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY NATIONS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL NATIONS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ****************************************************************************/
+
+/**
+ * @file ns_heap.h
+ * @author Nations Firmware Team
+ * @version v1.0.0
+ *
+ * @copyright Copyright (c) 2019, Nations Technologies Inc. All rights reserved.
+ */
+
+/** @addtogroup 
+ * @{
+ */
+#ifndef __NS_HEAP_H__
+#define __NS_HEAP_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include "rwip_config.h"
+
+/* Public define ------------------------------------------------------------*/
+/* Block size classes of the histogram, sizes include the 4 byte block header:
+ * up to 16, 32, 64, 128, 256 bytes and larger */
+#define NS_HEAP_SIZE_CLASS_NB       6
+
+/// Message ids tracked in the KE_MEM_KE_MSG heap, the last entry collects the others
+#ifndef NS_HEAP_MSG_ID_NB
+#define NS_HEAP_MSG_ID_NB           8
+#endif
+
+/// Message id of the entry collecting the messages that did not fit in the table
+#define NS_HEAP_MSG_ID_OTHER        0xFFFF
+
+/* Public typedef -----------------------------------------------------------*/
+/// Statistics of one kernel heap (enum KE_MEM_HEAP), sizes in bytes including block headers
+struct ns_heap_type_stats_t
+{
+    uint16_t size;                              /**< Heap size */
+    uint16_t used;                              /**< Used now */
+    uint16_t used_max;                          /**< Highest use seen by ns_heap_sample() */
+    uint16_t free_largest;                      /**< Largest free block now */
+    uint16_t free_largest_min;                  /**< Lowest largest free block seen, the biggest allocation always served */
+    uint16_t free_blocks;                       /**< Free fragments now */
+    uint16_t hist[NS_HEAP_SIZE_CLASS_NB];       /**< Used blocks per size class when used_max was reached */
+};
+
+/// Kernel messages of one id in the KE_MEM_KE_MSG heap, timers are listed under their id too
+struct ns_heap_msg_stats_t
+{
+    uint16_t id;                                /**< Message id, NS_HEAP_MSG_ID_OTHER for the rest */
+    uint16_t count;                             /**< Blocks */
+    uint16_t bytes;                             /**< Bytes including block headers */
+};
+
+/// Heap statistics, all fields are 16-bit little endian so the struct is also the GATT payload
+struct ns_heap_stats_t
+{
+    struct ns_heap_type_stats_t heap[KE_MEM_BLOCK_MAX];
+    struct ns_heap_msg_stats_t msg[NS_HEAP_MSG_ID_NB];  /**< KE_MEM_KE_MSG content when its used_max was reached */
+    uint16_t samples;                           /**< ns_heap_sample() calls, saturates at 0xFFFF */
+    uint16_t corrupt;                           /**< Heap walks stopped on an inconsistent block header */
+};
+
+/* Public constants ---------------------------------------------------------*/
+/* Public function prototypes -----------------------------------------------*/
+/**
+ * @brief Walk the kernel heaps and keep the high water marks. The walk masks the
+ *        interrupts for a time that grows with the heap use, call it from a slow
+ *        timer or an idle point, never from the report path.
+ * @return none
+ */
+void ns_heap_sample(void);
+
+/**
+ * @brief Get the heap statistics, the "now" fields come from a fresh walk.
+ * @param[out] p_stats statistics.
+ * @return none
+ */
+void ns_heap_stats_get(struct ns_heap_stats_t *p_stats);
+
+/**
+ * @brief Clear the high water marks.
+ * @return none
+ */
+void ns_heap_stats_reset(void);
+
+/**
+ * @brief Print the heap statistics with NS_LOG_INFO.
+ * @return none
+ */
+void ns_heap_stats_log(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //__NS_HEAP_H__
@@ -0,0 +1,282 @@
+/*****************************************************************************
+ * Copyright (c) 2019, Nations Technologies Inc.
+ *
+ * All rights reserved.
+ * ****************************************************************************
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Nations' name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY NATIONS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL NATIONS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ****************************************************************************/
+
+/**
+ * @file ns_msg_pool.c
+ * @author Nations Firmware Team
+ * @version v1.0.0
+ *
+ * @copyright Copyright (c) 2019, Nations Technologies Inc. All rights reserved.
+ */
+
+/** @addtogroup 
+ * @{
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "ns_msg_pool.h"
+#include <string.h>
+#include "ke_mem.h"
+#include "ke_task.h"
+#include "global_func.h"
+
+/* Private typedef -----------------------------------------------------------*/
+/// Preallocated messages of one id
+struct ns_msg_pool_env_t
+{
+    struct ke_msg *slot[NS_MSG_POOL_SLOT_MAX];
+    ke_msg_id_t id;
+    uint16_t param_max;
+    uint8_t  busy;                              /**< Bit per slot, set from alloc to release */
+    struct ns_msg_pool_stats_t stats;
+};
+
+/* Private define ------------------------------------------------------------*/
+/* Private constants ---------------------------------------------------------*/
+/* Private variables ---------------------------------------------------------*/
+static struct ns_msg_pool_env_t ns_msg_pool[NS_MSG_POOL_NB];
+
+/* Private function prototypes -----------------------------------------------*/
+/* Private functions ---------------------------------------------------------*/
+
+/**
+ * @brief  Pool of a message id.
+ * @param  id: message id
+ * @return pool, NULL if the id has none
+ * @note   
+ */
+static struct ns_msg_pool_env_t *msg_pool_find(ke_msg_id_t id)
+{
+    uint8_t i;
+
+    for(i = 0; i < NS_MSG_POOL_NB; i++)
+    {
+        if((ns_msg_pool[i].stats.slot_nb != 0) && (ns_msg_pool[i].id == id))
+        {
+            return &ns_msg_pool[i];
+        }
+    }
+    return NULL;
+}
+
+/* Public functions ---------------------------------------------------------*/
+
+/**
+ * @brief  Preallocate messages of one id.
+ * @param  id: message id
+ * @param  param_max: largest parameter length served by the pool
+ * @param  nb: number of messages
+ * @return true on success
+ * @note   
+ */
+bool ns_msg_pool_create(ke_msg_id_t id, uint16_t param_max, uint8_t nb)
+{
+    struct ns_msg_pool_env_t *p_pool = NULL;
+    uint32_t size = offsetof(struct ke_msg, param) + param_max;
+    uint8_t i;
+
+    if((nb == 0) || (nb > NS_MSG_POOL_SLOT_MAX) || (msg_pool_find(id) != NULL))
+    {
+        return false;
+    }
+    for(i = 0; i < NS_MSG_POOL_NB; i++)
+    {
+        if(ns_msg_pool[i].stats.slot_nb == 0)
+        {
+            p_pool = &ns_msg_pool[i];
+            break;
+        }
+    }
+    if(p_pool == NULL)
+    {
+        return false;
+    }
+
+    memset(p_pool, 0, sizeof(*p_pool));
+    for(i = 0; i < nb; i++)
+    {
+        if(!ke_check_malloc(size, KE_MEM_KE_MSG))
+        {
+            break;
+        }
+        p_pool->slot[i] = (struct ke_msg *)ke_malloc(size, KE_MEM_KE_MSG);
+    }
+    if(i < nb)
+    {
+        while(i--)
+        {
+            ke_free(p_pool->slot[i]);
+        }
+        memset(p_pool, 0, sizeof(*p_pool));
+        return false;
+    }
+
+    p_pool->id = id;
+    p_pool->param_max = param_max;
+    p_pool->stats.slot_nb = nb;
+    return true;
+}
+
+/**
+ * @brief  Free the idle messages of a pool and forget it.
+ * @param  id: message id
+ * @return 
+ * @note   
+ */
+void ns_msg_pool_delete(ke_msg_id_t id)
+{
+    struct ns_msg_pool_env_t *p_pool = msg_pool_find(id);
+    uint8_t i;
+
+    if(p_pool == NULL)
+    {
+        return;
+    }
+    for(i = 0; i < p_pool->stats.slot_nb; i++)
+    {
+        if((p_pool->busy & (1 << i)) == 0)
+        {
+            ke_free(p_pool->slot[i]);
+        }
+    }
+    memset(p_pool, 0, sizeof(*p_pool));
+}
+
+/**
+ * @brief  Allocate a message, from its pool when possible.
+ * @param  id: message id
+ * @param  dest: destination task
+ * @param  src: source task
+ * @param  param_len: parameter length
+ * @return parameter pointer
+ * @note   Fills the message header the way ke_msg_alloc() does.
+ */
+void *ns_msg_pool_alloc(ke_msg_id_t id, ke_task_id_t dest, ke_task_id_t src, uint16_t param_len)
+{
+    struct ns_msg_pool_env_t *p_pool = msg_pool_find(id);
+    struct ke_msg *msg = NULL;
+    uint8_t i;
+
+    if(p_pool == NULL)
+    {
+        return ke_msg_alloc(id, dest, src, param_len);
+    }
+
+    GLOBAL_INT_DISABLE();
+    if(param_len <= p_pool->param_max)
+    {
+        for(i = 0; i < p_pool->stats.slot_nb; i++)
+        {
+            if((p_pool->busy & (1 << i)) == 0)
+            {
+                p_pool->busy |= (1 << i);
+                msg = p_pool->slot[i];
+                p_pool->stats.pool_cnt++;
+                p_pool->stats.in_use++;
+                if(p_pool->stats.in_use > p_pool->stats.in_use_max)
+                {
+                    p_pool->stats.in_use_max = p_pool->stats.in_use;
+                }
+                break;
+            }
+        }
+    }
+    if(msg == NULL)
+    {
+        p_pool->stats.fallback_cnt++;
+    }
+    GLOBAL_INT_RESTORE();
+
+    if(msg == NULL)
+    {
+        return ke_msg_alloc(id, dest, src, param_len);
+    }
+
+    msg->hdr.next  = KE_MSG_NOT_IN_QUEUE;
+    msg->id        = id;
+    msg->dest_id   = dest;
+    msg->src_id    = src;
+    msg->param_len = param_len;
+    memset(ke_msg2param(msg), 0, param_len);
+
+    return ke_msg2param(msg);
+}
+
+/**
+ * @brief  Give a consumed message back to its pool.
+ * @param  param: parameter pointer of the message
+ * @return true if the message belongs to a pool
+ * @note   
+ */
+bool ns_msg_pool_release(void const *param)
+{
+    struct ke_msg *msg = ke_param2msg(param);
+    struct ns_msg_pool_env_t *p_pool = msg_pool_find(msg->id);
+    bool found = false;
+    uint8_t i;
+
+    if(p_pool == NULL)
+    {
+        return false;
+    }
+
+    GLOBAL_INT_DISABLE();
+    for(i = 0; i < p_pool->stats.slot_nb; i++)
+    {
+        if((p_pool->slot[i] == msg) && (p_pool->busy & (1 << i)))
+        {
+            p_pool->busy &= ~(1 << i);
+            p_pool->stats.in_use--;
+            found = true;
+            break;
+        }
+    }
+    GLOBAL_INT_RESTORE();
+
+    return found;
+}
+
+/**
+ * @brief  Get the counters of a pool.
+ * @param  id: message id
+ * @param  p_stats: output
+ * @return 
+ * @note   
+ */
+void ns_msg_pool_stats_get(ke_msg_id_t id, struct ns_msg_pool_stats_t *p_stats)
+{
+    struct ns_msg_pool_env_t *p_pool = msg_pool_find(id);
+
+    if(p_pool == NULL)
+    {
+        memset(p_stats, 0, sizeof(*p_stats));
+        return;
+    }
+    GLOBAL_INT_DISABLE();
+    *p_stats = p_pool->stats;
+    GLOBAL_INT_RESTORE();
+}
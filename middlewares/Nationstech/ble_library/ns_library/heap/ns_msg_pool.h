@@ -0,0 +1,131 @@
+/*****************************************************************************
+ * Copyright (c) 2019, Nations Technologies Inc.
+ *
+ * All rights reserved.
+ * ****************************************************************************
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Nations' name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY NATIONS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL NATIONS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ****************************************************************************/
+
+/**
+ * @file ns_msg_pool.h
+ * @author Nations Firmware Team
+ * @version v1.0.0
+ *
+ * @copyright Copyright (c) 2019, Nations Technologies Inc. All rights reserved.
+ */
+
+/** @addtogroup 
+ * @{
+ */
+#ifndef __NS_MSG_POOL_H__
+#define __NS_MSG_POOL_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+#include "rwip_config.h"
+#include "ke_msg.h"
+
+/* Public define ------------------------------------------------------------*/
+/// Message ids that can have a pool at the same time
+#ifndef NS_MSG_POOL_NB
+#define NS_MSG_POOL_NB              2
+#endif
+
+/// Highest number of messages in one pool
+#define NS_MSG_POOL_SLOT_MAX        8
+
+/**
+ * @brief Allocate a message from the pool of its id, like KE_MSG_ALLOC_DYN().
+ *        The receiving handler gives the message back with ns_msg_pool_release().
+ */
+#define NS_MSG_POOL_ALLOC_DYN(id, dest, src, param_str, length)  (struct param_str*)ns_msg_pool_alloc(id, dest, src, \
+    (sizeof(struct param_str) + (length)))
+
+/* Public typedef -----------------------------------------------------------*/
+/// Pool counters
+struct ns_msg_pool_stats_t
+{
+    uint32_t pool_cnt;                          /**< Messages served by the pool */
+    uint32_t fallback_cnt;                      /**< Messages allocated from the kernel heap, pool empty or too short */
+    uint8_t  slot_nb;                           /**< Messages in the pool */
+    uint8_t  in_use;                            /**< Messages of the pool not released yet */
+    uint8_t  in_use_max;                        /**< Highest in_use */
+};
+
+/* Public constants ---------------------------------------------------------*/
+/* Public function prototypes -----------------------------------------------*/
+/**
+ * @brief Preallocate messages of one id. The messages are blocks of the
+ *        KE_MEM_KE_MSG heap, so a pool message the kernel frees on its own
+ *        (flush, task without handler) is simply lost to the pool.
+ * @param[in] id message id.
+ * @param[in] param_max largest parameter length served by the pool.
+ * @param[in] nb number of messages, up to NS_MSG_POOL_SLOT_MAX.
+ * @return false if no pool entry is free or the heap is short, nothing is kept then.
+ */
+bool ns_msg_pool_create(ke_msg_id_t id, uint16_t param_max, uint8_t nb);
+
+/**
+ * @brief Free the idle messages of a pool and forget it, messages still in
+ *        the kernel queues are freed by the kernel.
+ * @param[in] id message id.
+ * @return none
+ */
+void ns_msg_pool_delete(ke_msg_id_t id);
+
+/**
+ * @brief Allocate a message, from the pool of its id when one is idle and
+ *        long enough, from the kernel heap otherwise.
+ * @param[in] id message id.
+ * @param[in] dest destination task.
+ * @param[in] src source task.
+ * @param[in] param_len parameter length.
+ * @return parameter pointer, the parameters are cleared.
+ */
+void *ns_msg_pool_alloc(ke_msg_id_t id, ke_task_id_t dest, ke_task_id_t src, uint16_t param_len);
+
+/**
+ * @brief Give a consumed message back to its pool.
+ * @param[in] param parameter pointer of the message being handled.
+ * @return true if the message belongs to a pool, the handler must then return
+ *         KE_MSG_NO_FREE; false for a heap message, return KE_MSG_CONSUMED.
+ */
+bool ns_msg_pool_release(void const *param);
+
+/**
+ * @brief Get the counters of a pool.
+ * @param[in] id message id.
+ * @param[out] p_stats counters, all 0 when the id has no pool.
+ * @return none
+ */
+void ns_msg_pool_stats_get(ke_msg_id_t id, struct ns_msg_pool_stats_t *p_stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //__NS_MSG_POOL_H__
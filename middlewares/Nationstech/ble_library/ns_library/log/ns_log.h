@@ -74,6 +74,17 @@ extern "C" {
 #ifndef NS_LOG_RTT_ENABLE
 #define NS_LOG_RTT_ENABLE        0
 #endif
+/* Binary log mode (USART only): the macros store the format string address and the raw
+ * 32-bit arguments in a ring buffer, DMA drains it from the main loop and
+ * ns_log_decode.py renders the stream back to text with the firmware ELF. */
+#ifndef NS_LOG_BIN_ENABLE
+#define NS_LOG_BIN_ENABLE        0
+#endif
+
+#define NS_LOG_LEVEL_ERROR       1
+#define NS_LOG_LEVEL_WARNING     2
+#define NS_LOG_LEVEL_INFO        3
+#define NS_LOG_LEVEL_DEBUG       4
 
 #ifndef PRINTF_COLOR_ENABLE
 #define PRINTF_COLOR_ENABLE      0
@@ -85,44 +96,57 @@ extern "C" {
 
 
 #if   (NS_LOG_LPUART_ENABLE)
-#define NS_LOG_INTERNAL_OUTPUT(color, ...)  NS_LOG_LPUART_OUTPUT(color, __VA_ARGS__)
+#define NS_LOG_INTERNAL_OUTPUT(level, color, ...)  NS_LOG_LPUART_OUTPUT(color, __VA_ARGS__)
 #define NS_LOG_INTERNAL_INIT()              NS_LOG_LPUART_INIT() 
 #define NS_LOG_INTERNAL_DEINIT()           
+#elif (NS_LOG_USART_ENABLE) && (NS_LOG_BIN_ENABLE)
+#define NS_LOG_INTERNAL_OUTPUT(level, color, ...)  NS_LOG_USART_BIN_OUTPUT(level, __VA_ARGS__)
+#define NS_LOG_INTERNAL_INIT()              NS_LOG_USART_INIT()
+#define NS_LOG_INTERNAL_DEINIT()            NS_LOG_USART_DEINIT()
+#define NS_LOG_INTERNAL_FLUSH()             ns_log_usart_bin_flush()
+#define NS_LOG_INTERNAL_BUSY()              ns_log_usart_bin_busy()
 #elif (NS_LOG_USART_ENABLE)
-#define NS_LOG_INTERNAL_OUTPUT(color, ...)  NS_LOG_USART_OUTPUT(color, __VA_ARGS__)
+#define NS_LOG_INTERNAL_OUTPUT(level, color, ...)  NS_LOG_USART_OUTPUT(color, __VA_ARGS__)
 #define NS_LOG_INTERNAL_INIT()              NS_LOG_USART_INIT()
 #define NS_LOG_INTERNAL_DEINIT()            NS_LOG_USART_DEINIT()
 #elif (NS_LOG_RTT_ENABLE)
-#define NS_LOG_INTERNAL_OUTPUT(color, ...)  NS_LOG_RTT_OUTPUT(color, __VA_ARGS__)
+#define NS_LOG_INTERNAL_OUTPUT(level, color, ...)  NS_LOG_RTT_OUTPUT(color, __VA_ARGS__)
 #define NS_LOG_INTERNAL_INIT()              NS_LOG_RTT_INIT()
 #define NS_LOG_INTERNAL_DEINIT()            NS_LOG_RTT_DEINIT()
 #else
-#define NS_LOG_INTERNAL_OUTPUT(color, ...)  
+#define NS_LOG_INTERNAL_OUTPUT(level, color, ...)  
 #define NS_LOG_INTERNAL_INIT() 
 #define NS_LOG_INTERNAL_DEINIT()
 #endif
+
+#ifndef NS_LOG_INTERNAL_FLUSH
+#define NS_LOG_INTERNAL_FLUSH()
+#endif
+#ifndef NS_LOG_INTERNAL_BUSY
+#define NS_LOG_INTERNAL_BUSY()              0
+#endif
 /* Public typedef -----------------------------------------------------------*/
 /* Public define ------------------------------------------------------------*/
 #if  NS_LOG_ERROR_ENABLE
-#define NS_LOG_ERROR(...)        NS_LOG_INTERNAL_OUTPUT(LOG_COLOR_RED, __VA_ARGS__)
+#define NS_LOG_ERROR(...)        NS_LOG_INTERNAL_OUTPUT(NS_LOG_LEVEL_ERROR, LOG_COLOR_RED, __VA_ARGS__)
 #else
 #define NS_LOG_ERROR( ...) 
 #endif
 
 #if NS_LOG_WARNING_ENABLE
-#define NS_LOG_WARNING(...)      NS_LOG_INTERNAL_OUTPUT(LOG_COLOR_YELLOW, __VA_ARGS__)
+#define NS_LOG_WARNING(...)      NS_LOG_INTERNAL_OUTPUT(NS_LOG_LEVEL_WARNING, LOG_COLOR_YELLOW, __VA_ARGS__)
 #else
 #define NS_LOG_WARNING( ...) 
 #endif
 
 #if  NS_LOG_INFO_ENABLE
-#define NS_LOG_INFO(...)         NS_LOG_INTERNAL_OUTPUT(LOG_COLOR_CYAN, __VA_ARGS__)
+#define NS_LOG_INFO(...)         NS_LOG_INTERNAL_OUTPUT(NS_LOG_LEVEL_INFO, LOG_COLOR_CYAN, __VA_ARGS__)
 #else
 #define NS_LOG_INFO( ...) 
 #endif
 
 #if  NS_LOG_DEBUG_ENABLE
-#define NS_LOG_DEBUG(...)        NS_LOG_INTERNAL_OUTPUT(LOG_COLOR_GREEN, __VA_ARGS__)
+#define NS_LOG_DEBUG(...)        NS_LOG_INTERNAL_OUTPUT(NS_LOG_LEVEL_DEBUG, LOG_COLOR_GREEN, __VA_ARGS__)
 #else
 #define NS_LOG_DEBUG( ...) 
 #endif
@@ -143,6 +167,22 @@ extern "C" {
  * @note   
  */
 #define NS_LOG_DEINIT()            NS_LOG_INTERNAL_DEINIT()
+
+/**
+ * @brief   Drain pending binary log records, call it from the main loop before ns_sleep
+ * @param  
+ * @return 
+ * @note    No effect in text mode
+ */
+#define NS_LOG_FLUSH()             NS_LOG_INTERNAL_FLUSH()
+
+/**
+ * @brief   Check whether log data is still waiting for or in transmission
+ * @param  
+ * @return  non-zero while the log output must not be powered down
+ * @note    Always 0 in text mode
+ */
+#define NS_LOG_BUSY()              NS_LOG_INTERNAL_BUSY()
 /* Public constants ---------------------------------------------------------*/
 /* Public function prototypes -----------------------------------------------*/
 
@@ -0,0 +1,161 @@
+#!/usr/bin/env python3
+# Copyright (c) 2019, Nations Technologies Inc. All rights reserved.
+"""Decode the NS_LOG binary stream (NS_LOG_BIN_ENABLE) back to text.
+
+Each record is 0xA5, (level << 4 | nargs), the format string address and nargs
+32-bit arguments, little endian. Format strings and "%s" arguments that point to
+flash are read from the firmware ELF (the .axf file Keil builds).
+
+    python ns_log_decode.py Objects/touch_screen.axf COM5
+    python ns_log_decode.py Objects/touch_screen.axf capture.bin
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+SYNC = 0xA5
+COLORS = {1: "\033[0;31m", 2: "\033[0;33m", 3: "\033[0;36m", 4: "\033[0;32m"}
+
+SHT_NOBITS = 8
+SHF_ALLOC = 0x2
+
+FMT_RE = re.compile(r"%([-+ #0]*)(\d*)(?:\.(\d+))?(hh|h|ll|l|z|t|j)?([diouxXcsp%])")
+
+
+class Elf:
+    """Read-only view of the loadable sections of a 32-bit little endian ELF."""
+
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            self.data = f.read()
+        if self.data[:4] != b"\x7fELF" or self.data[4] != 1 or self.data[5] != 1:
+            raise ValueError("%s is not a 32-bit little endian ELF" % path)
+        shoff, = struct.unpack_from("<I", self.data, 0x20)
+        shentsize, shnum = struct.unpack_from("<HH", self.data, 0x2E)
+        self.sections = []
+        for i in range(shnum):
+            _, sh_type, flags, addr, offset, size = struct.unpack_from(
+                "<IIIIII", self.data, shoff + i * shentsize)
+            if (flags & SHF_ALLOC) and sh_type != SHT_NOBITS and size:
+                self.sections.append((addr, offset, size))
+
+    def cstr(self, addr):
+        for base, offset, size in self.sections:
+            if base <= addr < base + size:
+                start = offset + addr - base
+                end = self.data.find(b"\0", start, offset + size)
+                if end < 0:
+                    end = offset + size
+                return self.data[start:end].decode("latin-1")
+        return None
+
+
+def render(elf, fmt, args):
+    out = []
+    pos = 0
+    args = list(args)
+    for m in FMT_RE.finditer(fmt):
+        out.append(fmt[pos:m.start()])
+        pos = m.end()
+        flags, width, prec, _, conv = m.groups()
+        if conv == "%":
+            out.append("%")
+            continue
+        value = args.pop(0) if args else 0
+        spec = "%" + flags + width + ("." + prec if prec else "")
+        if conv in "di":
+            out.append((spec + "d") % (value - (1 << 32) if value & 0x80000000 else value))
+        elif conv == "u":
+            out.append((spec + "d") % value)
+        elif conv in "oxX":
+            out.append((spec + conv) % value)
+        elif conv == "c":
+            out.append((spec + "c") % chr(value & 0xFF))
+        elif conv == "p":
+            out.append("0x%08x" % value)
+        else:
+            text = elf.cstr(value)
+            out.append((spec + "s") % (text if text is not None else "<ram 0x%08x>" % value))
+    out.append(fmt[pos:])
+    return "".join(out)
+
+
+def records(stream):
+    """Yield (level, fmt_addr, args), resynchronising on the sync byte after line noise."""
+    buf = bytearray()
+    while True:
+        chunk = stream.read(256)
+        if not chunk:
+            return
+        buf += chunk
+        while True:
+            start = buf.find(bytes([SYNC]))
+            if start < 0:
+                del buf[:]
+                break
+            del buf[:start]
+            if len(buf) < 2:
+                break
+            level, nargs = buf[1] >> 4, buf[1] & 0x0F
+            if nargs > 8 or level > 4:
+                del buf[:1]
+                continue
+            size = 2 + 4 * (nargs + 1)
+            if len(buf) < size:
+                break
+            words = struct.unpack_from("<%dI" % (nargs + 1), buf, 2)
+            del buf[:size]
+            yield level, words[0], words[1:]
+
+
+class SerialInput:
+    """Blocking reader over a pyserial port, a read timeout is not end of stream."""
+
+    def __init__(self, name, baud):
+        import serial  # pyserial, only needed for a live port
+        self.port = serial.Serial(name, baud, timeout=0.1)
+
+    def read(self, size):
+        while True:
+            data = self.port.read(size)
+            if data:
+                return data
+
+
+def open_input(name, baud):
+    if name == "-":
+        return sys.stdin.buffer
+    try:
+        return open(name, "rb")
+    except OSError:
+        return SerialInput(name, baud)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("elf", help="firmware ELF with the format strings (.axf)")
+    parser.add_argument("input", help="capture file, serial port or - for stdin")
+    parser.add_argument("-b", "--baud", type=int, default=115200)
+    parser.add_argument("-c", "--color", action="store_true", help="color by level")
+    opts = parser.parse_args()
+
+    elf = Elf(opts.elf)
+    for level, fmt_addr, args in records(open_input(opts.input, opts.baud)):
+        if level == 0:
+            sys.stdout.write("!! %u log records dropped\n" % (args[0] if args else 0))
+            continue
+        fmt = elf.cstr(fmt_addr)
+        if fmt is None:
+            text = "<unknown format 0x%08x> %s\n" % (fmt_addr, " ".join("%08x" % a for a in args))
+        else:
+            text = render(elf, fmt, args)
+        if opts.color:
+            text = COLORS[level] + text + "\033[0m"
+        sys.stdout.write(text)
+        sys.stdout.flush()
+
+
+if __name__ == "__main__":
+    main()
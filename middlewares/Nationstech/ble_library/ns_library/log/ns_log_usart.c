@@ -39,6 +39,7 @@
 
  /* Includes ------------------------------------------------------------------*/
 #include <stdio.h>
+#include <stdarg.h>
 #include "n32wb03x.h"
 #include "ns_log.h"
 
@@ -57,6 +58,7 @@
 #define USARTx_TxPin        GPIO_PIN_6
 #define USARTx_Rx_GPIO_AF   GPIO_AF3_USART1
 #define USARTx_Tx_GPIO_AF   GPIO_AF3_USART1
+#define USARTx_DMA_REMAP    DMA_REMAP_USART1_TX
 #define GPIO_APBxClkCmd     RCC_EnableAPB2PeriphClk
 #define USART_APBxClkCmd    RCC_EnableAPB2PeriphClk
 #endif
@@ -70,14 +72,117 @@
 #define USARTx_TxPin        GPIO_PIN_4
 #define USARTx_Rx_GPIO_AF   GPIO_AF3_USART2
 #define USARTx_Tx_GPIO_AF   GPIO_AF3_USART2
+#define USARTx_DMA_REMAP    DMA_REMAP_USART2_TX
 #define GPIO_APBxClkCmd     RCC_EnableAPB2PeriphClk
 #define USART_APBxClkCmd    RCC_EnableAPB1PeriphClk
 #endif
 
+#if (NS_LOG_BIN_ENABLE)
+/* Ring size in bytes, must be a power of two. */
+#ifndef NS_LOG_BIN_BUF_SIZE
+#define NS_LOG_BIN_BUF_SIZE 1024
+#endif
+#define NS_LOG_BIN_BUF_MASK (NS_LOG_BIN_BUF_SIZE - 1)
+#if (NS_LOG_BIN_BUF_SIZE & NS_LOG_BIN_BUF_MASK) || (NS_LOG_BIN_BUF_SIZE > 0x8000)
+#error "NS_LOG_BIN_BUF_SIZE must be a power of two up to 32768"
+#endif
+
+/* DMA channels 5-8 share one interrupt vector, the handler only acknowledges the channel 5
+ * flag and must be merged with any other user of channels 6-8. */
+#define LOG_DMA_CH          DMA_CH5
+#define LOG_DMA_IRQn        DMA_Channel5_IRQn
+#define LOG_DMA_INT_TXC     DMA_INT_TXC5
+#define LOG_DMA_IRQHandler  DMA_Channel5_IRQHandler
+
+#define LOG_BIN_HEADER_LEN  2   /* sync byte and (level << 4 | nargs) */
+
+/* The ring is shared with interrupt handlers, PRIMASK keeps the update atomic on Cortex-M0. */
+#define CRITICAL_REGION_ENTER()                                                                   \
+    uint32_t log_primask = __get_PRIMASK();                                                       \
+    __disable_irq()
+#define CRITICAL_REGION_EXIT()                                                                    \
+    __set_PRIMASK(log_primask)
+#endif
+
 /* Private variables ---------------------------------------------------------*/
+#if (NS_LOG_BIN_ENABLE)
+static struct
+{
+    uint8_t             buf[NS_LOG_BIN_BUF_SIZE];
+    uint16_t            head;           /**< Next byte to write. */
+    uint16_t            tail;           /**< Next byte to send. */
+    uint16_t            dma_len;        /**< Bytes in flight, 0 when the DMA channel is idle. */
+    uint32_t            pending_drop;   /**< Records dropped since the last drop record. */
+    ns_log_bin_stats_t  stats;
+} m_log;
+#endif
 /* Private function prototypes -----------------------------------------------*/
 
 /* Private functions ---------------------------------------------------------*/
+#if (NS_LOG_BIN_ENABLE)
+/**
+ * @brief  Copy bytes into the ring, the caller has checked the free space.
+ */
+static void log_ring_put(const uint8_t *p_data, uint16_t len)
+{
+    uint16_t head = m_log.head;
+
+    while (len--)
+    {
+        m_log.buf[head] = *p_data++;
+        head = (head + 1) & NS_LOG_BIN_BUF_MASK;
+    }
+    m_log.head = head;
+}
+
+/**
+ * @brief  Append one record, words[0] is the format address followed by the arguments.
+ */
+static void log_record_put(uint8_t level, uint8_t nargs, const uint32_t *p_words)
+{
+    uint8_t header[LOG_BIN_HEADER_LEN];
+
+    header[0] = NS_LOG_BIN_SYNC;
+    header[1] = (uint8_t)((level << 4) | nargs);
+    log_ring_put(header, LOG_BIN_HEADER_LEN);
+    /* Cortex-M0 is little endian, the words go out in wire order. */
+    log_ring_put((const uint8_t *)p_words, (uint16_t)((nargs + 1) * sizeof(uint32_t)));
+}
+
+/**
+ * @brief  Start a DMA transfer of the contiguous part of the ring, interrupts disabled.
+ */
+static void log_dma_start(void)
+{
+    DMA_InitType DMA_InitStructure;
+    uint16_t     len;
+
+    if ((m_log.dma_len != 0) || (m_log.head == m_log.tail))
+    {
+        return;
+    }
+    len = (m_log.head > m_log.tail) ? (m_log.head - m_log.tail) : (NS_LOG_BIN_BUF_SIZE - m_log.tail);
+
+    DMA_EnableChannel(LOG_DMA_CH, DISABLE);
+    DMA_InitStructure.PeriphAddr     = (uint32_t)&USARTx->DAT;
+    DMA_InitStructure.MemAddr        = (uint32_t)&m_log.buf[m_log.tail];
+    DMA_InitStructure.Direction      = DMA_DIR_PERIPH_DST;
+    DMA_InitStructure.BufSize        = len;
+    DMA_InitStructure.PeriphInc      = DMA_PERIPH_INC_DISABLE;
+    DMA_InitStructure.DMA_MemoryInc  = DMA_MEM_INC_ENABLE;
+    DMA_InitStructure.PeriphDataSize = DMA_PERIPH_DATA_SIZE_BYTE;
+    DMA_InitStructure.MemDataSize    = DMA_MemoryDataSize_Byte;
+    DMA_InitStructure.CircularMode   = DMA_MODE_NORMAL;
+    DMA_InitStructure.Priority       = DMA_PRIORITY_LOW;
+    DMA_InitStructure.Mem2Mem        = DMA_M2M_DISABLE;
+    DMA_Init(LOG_DMA_CH, &DMA_InitStructure);
+    DMA_RequestRemap(USARTx_DMA_REMAP, DMA, LOG_DMA_CH, ENABLE);
+    DMA_ConfigInt(LOG_DMA_CH, DMA_INT_TXC, ENABLE);
+
+    m_log.dma_len = len;
+    DMA_EnableChannel(LOG_DMA_CH, ENABLE);
+}
+#endif
 
 
 
@@ -118,7 +223,13 @@ void ns_log_usart_init(void)
     /* Enable the USARTx */
     USART_Enable(USARTx, ENABLE);
 
-
+    #if (NS_LOG_BIN_ENABLE)
+    /* TX is fed by DMA, the channel is programmed per transfer by log_dma_start */
+    RCC_EnableAHBPeriphClk(RCC_AHB_PERIPH_DMA, ENABLE);
+    USART_EnableDMA(USARTx, USART_DMAREQ_TX, ENABLE);
+    NVIC_SetPriority(LOG_DMA_IRQn, 3);
+    NVIC_EnableIRQ(LOG_DMA_IRQn);
+    #endif
 }
 
 void ns_log_usart_deinit(void)
@@ -128,6 +239,131 @@ void ns_log_usart_deinit(void)
     GPIO_DeInitPin(USARTx_GPIO,USARTx_TxPin); 
 }
 
+#if (NS_LOG_BIN_ENABLE)
+/**
+ * @brief  Store a binary log record, called by the NS_LOG_* macros in binary mode.
+ * @param  level: NS_LOG_LEVEL_xxx
+ * @param  nargs: number of arguments after fmt, up to NS_LOG_BIN_MAX_ARGS
+ * @param  fmt: format string, must be a literal so the decoder finds it in the ELF
+ * @return 
+ * @note   Safe from interrupt context, nothing is formatted on the target. A full ring
+ *         drops the record and a drop counter record is written once space is back.
+ */
+void ns_log_usart_bin_write(uint8_t level, uint8_t nargs, const char *fmt, ...)
+{
+    uint32_t words[1 + NS_LOG_BIN_MAX_ARGS];
+    uint16_t len;
+    uint16_t used;
+    uint8_t  i;
+    va_list  ap;
+
+    if (nargs > NS_LOG_BIN_MAX_ARGS)
+    {
+        nargs = NS_LOG_BIN_MAX_ARGS;
+    }
+    words[0] = (uint32_t)fmt;
+    va_start(ap, fmt);
+    for (i = 0; i < nargs; i++)
+    {
+        words[i + 1] = va_arg(ap, uint32_t);
+    }
+    va_end(ap);
+    len = LOG_BIN_HEADER_LEN + (nargs + 1) * sizeof(uint32_t);
+
+    CRITICAL_REGION_ENTER();
+    used = (m_log.head - m_log.tail) & NS_LOG_BIN_BUF_MASK;
+    if (m_log.pending_drop != 0)
+    {
+        uint32_t drop[2];
+
+        /* report the loss ahead of the next record so the decoder shows where it happened */
+        if ((used + 2 * LOG_BIN_HEADER_LEN + sizeof(drop) + len) < NS_LOG_BIN_BUF_SIZE)
+        {
+            drop[0] = 0;
+            drop[1] = m_log.pending_drop;
+            log_record_put(0, 1, drop);
+            m_log.pending_drop = 0;
+            used += LOG_BIN_HEADER_LEN + sizeof(drop);
+        }
+    }
+    if ((m_log.pending_drop == 0) && ((used + len) < NS_LOG_BIN_BUF_SIZE))
+    {
+        log_record_put(level, nargs, words);
+        used += len;
+        m_log.stats.written++;
+        if (used > m_log.stats.high_water)
+        {
+            m_log.stats.high_water = used;
+        }
+    }
+    else
+    {
+        m_log.pending_drop++;
+        m_log.stats.dropped++;
+    }
+    CRITICAL_REGION_EXIT();
+}
+
+/**
+ * @brief  Start draining the ring, call it when the CPU is idle (main loop, before ns_sleep).
+ * @param  
+ * @return 
+ * @note   The DMA interrupt chains the following transfers until the ring is empty.
+ */
+void ns_log_usart_bin_flush(void)
+{
+    CRITICAL_REGION_ENTER();
+    log_dma_start();
+    CRITICAL_REGION_EXIT();
+}
+
+/**
+ * @brief  Check whether log bytes are still queued or on the wire.
+ * @param  
+ * @return true while the USART must stay powered
+ * @note   ns_sleep uses it to pick idle mode instead of deep sleep.
+ */
+uint8_t ns_log_usart_bin_busy(void)
+{
+    if ((m_log.head != m_log.tail) || (m_log.dma_len != 0))
+    {
+        return true;
+    }
+    return (USART_GetFlagStatus(USARTx, USART_FLAG_TXC) == RESET);
+}
+
+/**
+ * @brief  Get the binary log ring statistics.
+ * @param  p_stats: output
+ * @return 
+ * @note   
+ */
+void ns_log_usart_bin_stats_get(ns_log_bin_stats_t *p_stats)
+{
+    if (p_stats != NULL)
+    {
+        CRITICAL_REGION_ENTER();
+        *p_stats = m_log.stats;
+        CRITICAL_REGION_EXIT();
+    }
+}
+
+/**
+ * @brief  DMA transfer complete, release the sent bytes and send the next chunk.
+ */
+void LOG_DMA_IRQHandler(void)
+{
+    if (DMA_GetIntStatus(LOG_DMA_INT_TXC, DMA) != RESET)
+    {
+        DMA_ClrIntPendingBit(LOG_DMA_INT_TXC, DMA);
+        DMA_EnableChannel(LOG_DMA_CH, DISABLE);
+        m_log.tail = (m_log.tail + m_log.dma_len) & NS_LOG_BIN_BUF_MASK;
+        m_log.dma_len = 0;
+        log_dma_start();
+    }
+}
+#endif
+
 /* retarget the C library printf function to the USART */
 int fputc(int ch, FILE* f)
 {
@@ -46,8 +46,17 @@ extern "C" {
 
 /* Includes ------------------------------------------------------------------*/
 #include <stdio.h>
+#include <stdint.h>
 /* Public define ------------------------------------------------------------*/
 /* Public typedef -----------------------------------------------------------*/
+/**@brief Binary log ring statistics. */
+typedef struct
+{
+    uint32_t written;       /**< Records stored in the ring. */
+    uint32_t dropped;       /**< Records lost because the ring was full. */
+    uint16_t high_water;    /**< Largest number of bytes waiting in the ring. */
+} ns_log_bin_stats_t;
+
 /* Public define ------------------------------------------------------------*/
 #define NS_LOG_USART_OUTPUT(color, ...)  \
 do{                                      \
@@ -59,6 +68,21 @@ do{                                      \
 }while(0)                            
 
     
+/* Binary record: 0xA5, (level << 4 | nargs), format string address and nargs 32-bit
+ * arguments, all little endian. Level 0 marks a dropped record counter (format 0, one
+ * argument). Arguments are passed as 32-bit words, 64-bit and floating point arguments
+ * are not supported, "%s" only renders strings that live in flash. */
+#define NS_LOG_BIN_SYNC              0xA5
+#define NS_LOG_BIN_MAX_ARGS          8
+
+#define NS_LOG_BIN_NARG(...)         NS_LOG_BIN_NARG_(__VA_ARGS__, 8, 7, 6, 5, 4, 3, 2, 1, 0, 0)
+#define NS_LOG_BIN_NARG_(fmt, a1, a2, a3, a4, a5, a6, a7, a8, n, ...)  n
+
+#define NS_LOG_USART_BIN_OUTPUT(level, ...)  \
+do{                                          \
+    ns_log_usart_bin_write(level, NS_LOG_BIN_NARG(__VA_ARGS__), __VA_ARGS__); \
+}while(0)
+
 #define NS_LOG_USART_INIT()           \
 do{                                   \
     ns_log_usart_init();              \
@@ -72,6 +96,10 @@ do{                                   \
 /* Public function prototypes -----------------------------------------------*/
 void ns_log_usart_init(void);
 void ns_log_usart_deinit(void);
+void ns_log_usart_bin_write(uint8_t level, uint8_t nargs, const char *fmt, ...);
+void ns_log_usart_bin_flush(void);
+uint8_t ns_log_usart_bin_busy(void);
+void ns_log_usart_bin_stats_get(ns_log_bin_stats_t *p_stats);
 
 #ifdef __cplusplus
 }
@@ -39,26 +39,42 @@
 
  /* Includes ------------------------------------------------------------------*/
 #include "ns_scheduler.h"
+#include "n32wb03x.h"
 
+/* Cortex-M0 has no exclusive access instructions, the index updates are protected by masking
+ * interrupts for a few cycles. Nested use from an interrupt keeps the caller's PRIMASK. */
+#define CRITICAL_REGION_ENTER()                                                                   \
+    uint32_t sched_primask = __get_PRIMASK();                                                      \
+    __disable_irq()
+#define CRITICAL_REGION_EXIT()                                                                    \
+    __set_PRIMASK(sched_primask)
 
+/**@brief Round an event size up to the payload alignment. */
+#define APP_SCHED_ALIGN(SIZE)       (((SIZE) + 3) & ~3)
 
-#define CRITICAL_REGION_ENTER() 
-#define CRITICAL_REGION_EXIT()
-
-
+/**@brief Event header, placed in the byte ring in front of each payload. */
 typedef struct
 {
-    app_sched_event_handler_t handler;          /**< Pointer to event handler to receive the event. */
+    app_sched_event_handler_t handler;          /**< Event handler, NULL while the slot is being filled. */
+    uint16_t                  slot_size;        /**< Payload bytes reserved in the ring. */
     uint16_t                  event_data_size;  /**< Size of event data. */
 } event_header_t;
 
-static event_header_t * m_queue_event_headers;  /**< Array for holding the queue event headers. */
-static uint8_t        * m_queue_event_data;     /**< Array for holding the queue event data. */
-static volatile uint8_t m_queue_start_index;    /**< Index of queue entry at the start of the queue. */
-static volatile uint8_t m_queue_end_index;      /**< Index of queue entry at the end of the queue. */
-static uint16_t         m_queue_event_size;     /**< Maximum event size in queue. */
-static uint16_t         m_queue_size;           /**< Number of queue entries. */
+/* The ring is dimensioned with APP_SCHED_EVENT_HEADER_SIZE, it must be the size of the header. */
+typedef char event_header_size_check_t[(sizeof(event_header_t) == APP_SCHED_EVENT_HEADER_SIZE) ? 1 : -1];
+
+typedef struct
+{
+    uint8_t           * buffer;                 /**< Byte ring holding headers and payloads. */
+    uint32_t            capacity;               /**< Size of the ring, 0 if not initialized. */
+    volatile uint32_t   read_offset;            /**< Offset of the oldest event, written by the consumer. */
+    volatile uint32_t   write_offset;           /**< Offset of the next reservation, written by producers. */
+    uint16_t            event_size;             /**< Maximum event size in queue. */
+    uint16_t            passed_over;            /**< Events run at higher levels while this one was waiting. */
+    app_sched_stats_t   stats;                  /**< Queue statistics. */
+} sched_queue_t;
 
+static sched_queue_t m_queues[APP_SCHED_PRIO_NB];
 
 
 static __inline bool is_word_aligned(void const* p)
@@ -67,154 +83,375 @@ static __inline bool is_word_aligned(void const* p)
 }
 
 
-/**@brief Function for incrementing a queue index, and handle wrap-around.
- *
- * @param[in]   index   Old index.
- *
- * @return      New (incremented) index.
- */
-static __inline uint8_t next_index(uint8_t index)
+/**@brief Handler of aborted slots and of the padding left at the end of the ring. */
+static void app_sched_skip(void * p_event_data, uint16_t event_size)
 {
-    return (index < m_queue_size) ? (index + 1) : 0;
+    (void)p_event_data;
+    (void)event_size;
 }
 
 
-static __inline uint8_t app_sched_queue_full()
+/**@brief Function for getting the number of bytes in use in a queue. */
+static __inline uint32_t queue_used_get(sched_queue_t const * p_queue)
 {
-  uint8_t tmp = m_queue_start_index;
-  return next_index(m_queue_end_index) == tmp;
-}
+    uint32_t start = p_queue->read_offset;
+    uint32_t end   = p_queue->write_offset;
 
-/**@brief Macro for checking if a queue is full. */
-#define APP_SCHED_QUEUE_FULL() app_sched_queue_full()
+    return (end >= start) ? (end - start) : (p_queue->capacity - start + end);
+}
 
 
-static __inline uint8_t app_sched_queue_empty()
+static __inline bool app_sched_queue_empty(sched_queue_t const * p_queue)
 {
-  uint8_t tmp = m_queue_start_index;
-  return m_queue_end_index == tmp;
+    uint32_t tmp = p_queue->read_offset;
+    return p_queue->write_offset == tmp;
 }
 
-/**@brief Macro for checking if a queue is empty. */
-#define APP_SCHED_QUEUE_EMPTY() app_sched_queue_empty()
 
-
-uint32_t app_sched_init(uint16_t event_size, uint16_t queue_size, void * p_event_buffer)
+uint32_t app_sched_queue_init(app_sched_prio_t prio, uint16_t event_size, uint16_t queue_size,
+                              void * p_event_buffer)
 {
-    uint16_t data_start_index = (queue_size + 1) * sizeof(event_header_t);
+    sched_queue_t * p_queue;
 
-    // Check that buffer is correctly aligned
-    if (!is_word_aligned(p_event_buffer))
+    // Check the level and that buffer is correctly aligned
+    if ((prio >= APP_SCHED_PRIO_NB) || (queue_size == 0) || !is_word_aligned(p_event_buffer))
     {
         return 1;
     }
 
-    // Initialize event scheduler
-    m_queue_event_headers = p_event_buffer;
-    m_queue_event_data    = &((uint8_t *)p_event_buffer)[data_start_index];
-    m_queue_end_index     = 0;
-    m_queue_start_index   = 0;
-    m_queue_event_size    = event_size;
-    m_queue_size          = queue_size;
+    // Initialize event queue
+    p_queue = &m_queues[prio];
+    memset(p_queue, 0, sizeof(sched_queue_t));
+    p_queue->buffer     = p_event_buffer;
+    p_queue->capacity   = APP_SCHED_BUF_SIZE(event_size, queue_size);
+    p_queue->event_size = event_size;
 
     return 0;
 }
 
 
+uint32_t app_sched_init(uint16_t event_size, uint16_t queue_size, void * p_event_buffer)
+{
+    return app_sched_queue_init(APP_SCHED_PRIO_NORMAL, event_size, queue_size, p_event_buffer);
+}
+
 
 uint16_t app_sched_queue_space_get()
 {
-    uint16_t start = m_queue_start_index;
-    uint16_t end   = m_queue_end_index;
-    uint16_t free_space = m_queue_size - ((end >= start) ?
-                           (end - start) : (m_queue_size + 1 - start + end));
-    return free_space;
+    sched_queue_t const * p_queue = &m_queues[APP_SCHED_PRIO_NORMAL];
+    uint32_t stride = APP_SCHED_EVENT_HEADER_SIZE + APP_SCHED_ALIGN(p_queue->event_size);
+    uint32_t start  = p_queue->read_offset;
+    uint32_t end    = p_queue->write_offset;
+    uint32_t space;
+
+    if (p_queue->capacity == 0)
+    {
+        return 0;
+    }
+    // The write offset never catches up with the read offset, keep one byte between them.
+    if (end >= start)
+    {
+        space = (p_queue->capacity - end - ((start == 0) ? 1 : 0)) / stride;
+        if (start > 0)
+        {
+            space += (start - 1) / stride;
+        }
+    }
+    else
+    {
+        space = (start - end - 1) / stride;
+    }
+
+    return (uint16_t)space;
 }
 
 
-uint32_t app_sched_event_put(void const              * p_event_data,
-                             uint16_t                  event_data_size,
-                             app_sched_event_handler_t handler)
+void * app_sched_event_reserve(app_sched_prio_t prio, uint16_t event_size)
 {
-    uint32_t err_code;
+    sched_queue_t  * p_queue;
+    event_header_t * p_header = NULL;
+    uint32_t need = APP_SCHED_EVENT_HEADER_SIZE + APP_SCHED_ALIGN(event_size);
 
-    if (event_data_size <= m_queue_event_size)
+    if (prio >= APP_SCHED_PRIO_NB)
     {
-        uint16_t event_index = 0xFFFF;
-
-        CRITICAL_REGION_ENTER();
+        return NULL;
+    }
+    p_queue = &m_queues[prio];
 
-        if (!APP_SCHED_QUEUE_FULL())
-        {
-            event_index       = m_queue_end_index;
-            m_queue_end_index = next_index(m_queue_end_index);
-        }
+    CRITICAL_REGION_ENTER();
 
-        CRITICAL_REGION_EXIT();
+    if ((p_queue->capacity != 0) && (event_size <= p_queue->event_size))
+    {
+        uint32_t start = p_queue->read_offset;
+        uint32_t end   = p_queue->write_offset;
+        uint32_t pos   = 0xFFFFFFFF;
 
-        if (event_index != 0xFFFF)
+        if (end >= start)
         {
-            // NOTE: This can be done outside the critical region since the event consumer will
-            //       always be called from the main loop, and will thus never interrupt this code.
-            m_queue_event_headers[event_index].handler = handler;
-            if ((p_event_data != NULL) && (event_data_size > 0))
+            uint32_t tail = p_queue->capacity - end;
+
+            if ((need < tail) || ((need == tail) && (start != 0)))
             {
-                memcpy(&m_queue_event_data[event_index * m_queue_event_size],
-                       p_event_data,
-                       event_data_size);
-                m_queue_event_headers[event_index].event_data_size = event_data_size;
+                pos = end;
             }
-            else
+            else if (need < start)
             {
-                m_queue_event_headers[event_index].event_data_size = 0;
+                // Wrap around, the end of the ring is consumed by a skipped slot.
+                if (tail >= APP_SCHED_EVENT_HEADER_SIZE)
+                {
+                    event_header_t * p_pad = (event_header_t *)&p_queue->buffer[end];
+
+                    p_pad->slot_size       = tail - APP_SCHED_EVENT_HEADER_SIZE;
+                    p_pad->event_data_size = 0;
+                    p_pad->handler         = app_sched_skip;
+                }
+                pos = 0;
             }
-
-            err_code = 0;
         }
-        else
+        else if (need < start - end)
         {
-            err_code = 1;
+            pos = end;
+        }
+
+        if (pos != 0xFFFFFFFF)
+        {
+            uint32_t used;
+
+            p_header = (event_header_t *)&p_queue->buffer[pos];
+            p_header->handler         = NULL;
+            p_header->slot_size       = APP_SCHED_ALIGN(event_size);
+            p_header->event_data_size = event_size;
+            p_queue->write_offset     = pos + need;
+
+            used = queue_used_get(p_queue);
+            if (used > p_queue->stats.high_water)
+            {
+                p_queue->stats.high_water = used;
+            }
         }
     }
-    else
+    if (p_header == NULL)
     {
-        err_code = 1;
+        p_queue->stats.dropped++;
     }
 
-    return err_code;
+    CRITICAL_REGION_EXIT();
+
+    return (p_header != NULL) ? (void *)(p_header + 1) : NULL;
 }
 
 
+uint32_t app_sched_event_commit(void * p_event_data, uint16_t event_size,
+                                app_sched_event_handler_t handler)
+{
+    event_header_t * p_header = (event_header_t *)p_event_data - 1;
 
+    if ((p_event_data == NULL) || (handler == NULL) || (event_size > p_header->slot_size))
+    {
+        return 1;
+    }
 
+    p_header->event_data_size = event_size;
+    // Publish the event, the handler must be written last.
+    *(app_sched_event_handler_t volatile *)&p_header->handler = handler;
 
-void app_sched_execute(void)
+    return 0;
+}
+
+
+void app_sched_event_abort(void * p_event_data)
+{
+    if (p_event_data != NULL)
+    {
+        event_header_t * p_header = (event_header_t *)p_event_data - 1;
+
+        p_header->event_data_size = 0;
+        *(app_sched_event_handler_t volatile *)&p_header->handler = app_sched_skip;
+    }
+}
+
+
+uint32_t app_sched_event_put_prio(app_sched_prio_t          prio,
+                                  void const              * p_event_data,
+                                  uint16_t                  event_data_size,
+                                  app_sched_event_handler_t handler)
 {
-    while (!APP_SCHED_QUEUE_EMPTY())
+    void * p_slot;
+
+    if (handler == NULL)
     {
-        // Since this function is only called from the main loop, there is no
-        // need for a critical region here, however a special care must be taken
-        // regarding update of the queue start index (see the end of the loop).
-        uint16_t event_index = m_queue_start_index;
+        return 1;
+    }
+
+    p_slot = app_sched_event_reserve(prio, event_data_size);
+    if (p_slot == NULL)
+    {
+        return 1;
+    }
+
+    // NOTE: The slot is owned by this caller, it can be filled with interrupts enabled. Another
+    //       producer preempting us reserves the next slot and never touches this one.
+    if ((p_event_data != NULL) && (event_data_size > 0))
+    {
+        memcpy(p_slot, p_event_data, event_data_size);
+    }
+    else
+    {
+        event_data_size = 0;
+    }
 
-        void * p_event_data;
-        uint16_t event_data_size;
+    return app_sched_event_commit(p_slot, event_data_size, handler);
+}
+
+
+uint32_t app_sched_event_put(void const              * p_event_data,
+                             uint16_t                  event_data_size,
+                             app_sched_event_handler_t handler)
+{
+    return app_sched_event_put_prio(APP_SCHED_PRIO_NORMAL, p_event_data, event_data_size, handler);
+}
+
+
+/**@brief Function for executing the event at the start of a queue.
+ *
+ * @return      false if the queue is empty or its first event is still being written.
+ */
+static bool app_sched_queue_execute_one(sched_queue_t * p_queue)
+{
+    // Since this function is only called from the main loop, there is no need for a critical
+    // region here, the read offset is only written by the consumer.
+    while (!app_sched_queue_empty(p_queue))
+    {
+        uint32_t start = p_queue->read_offset;
+        event_header_t * p_header;
         app_sched_event_handler_t event_handler;
 
-        p_event_data = &m_queue_event_data[event_index * m_queue_event_size];
-        event_data_size = m_queue_event_headers[event_index].event_data_size;
-        event_handler   = m_queue_event_headers[event_index].handler;
+        if (p_queue->capacity - start < APP_SCHED_EVENT_HEADER_SIZE)
+        {
+            // Too short for a header, the producer has wrapped around.
+            p_queue->read_offset = 0;
+            continue;
+        }
 
-        event_handler(p_event_data, event_data_size);
+        p_header      = (event_header_t *)&p_queue->buffer[start];
+        event_handler = *(app_sched_event_handler_t volatile *)&p_header->handler;
+        if (event_handler == NULL)
+        {
+            // Reserved by a producer which has not committed yet, events behind it keep their order.
+            return false;
+        }
 
-        // Event processed, now it is safe to move the queue start index,
-        // so the queue entry occupied by this event can be used to store
+        if (event_handler != app_sched_skip)
+        {
+            event_handler(p_header + 1, p_header->event_data_size);
+            p_queue->stats.executed++;
+        }
+
+        // Event processed, now it is safe to move the read offset,
+        // so the bytes occupied by this event can be used to store
         // a next one.
-        m_queue_start_index = next_index(m_queue_start_index);
+        p_queue->read_offset = start + APP_SCHED_EVENT_HEADER_SIZE + p_header->slot_size;
+
+        if (event_handler != app_sched_skip)
+        {
+            return true;
+        }
     }
+
+    return false;
 }
 
 
+/**@brief Function for executing the next event of the highest level, or of a starved level.
+ *
+ * @return      false if no event could be executed.
+ */
+static bool app_sched_execute_next(void)
+{
+    uint8_t prio;
+    uint8_t lower;
 
+    // A level passed over APP_SCHED_STARVE_LIMIT times runs one event ahead of the higher ones.
+    for (prio = 1; prio < APP_SCHED_PRIO_NB; prio++)
+    {
+        if ((m_queues[prio].passed_over >= APP_SCHED_STARVE_LIMIT)
+            && app_sched_queue_execute_one(&m_queues[prio]))
+        {
+            break;
+        }
+    }
+    if (prio == APP_SCHED_PRIO_NB)
+    {
+        for (prio = 0; prio < APP_SCHED_PRIO_NB; prio++)
+        {
+            if (app_sched_queue_execute_one(&m_queues[prio]))
+            {
+                break;
+            }
+        }
+        if (prio == APP_SCHED_PRIO_NB)
+        {
+            return false;
+        }
+    }
+
+    m_queues[prio].passed_over = 0;
+    for (lower = prio + 1; lower < APP_SCHED_PRIO_NB; lower++)
+    {
+        if (!app_sched_queue_empty(&m_queues[lower]) && (m_queues[lower].passed_over < 0xFFFF))
+        {
+            m_queues[lower].passed_over++;
+        }
+    }
+
+    return true;
+}
+
+
+uint16_t app_sched_execute_budget(uint16_t budget)
+{
+    uint16_t executed = 0;
+
+    // Restart from the highest level after every event, so that an event posted from an
+    // interrupt at a higher level overtakes the lower level backlog.
+    while ((executed < budget) && app_sched_execute_next())
+    {
+        executed++;
+    }
+
+    return executed;
+}
+
+
+void app_sched_execute(void)
+{
+    (void)app_sched_execute_budget(APP_SCHED_EXECUTE_BUDGET);
+}
+
+
+bool app_sched_pending(void)
+{
+    uint8_t prio;
+
+    for (prio = 0; prio < APP_SCHED_PRIO_NB; prio++)
+    {
+        if (!app_sched_queue_empty(&m_queues[prio]))
+        {
+            return true;
+        }
+    }
 
+    return false;
+}
+
+
+void app_sched_stats_get(app_sched_prio_t prio, app_sched_stats_t * p_stats)
+{
+    if ((prio < APP_SCHED_PRIO_NB) && (p_stats != NULL))
+    {
+        CRITICAL_REGION_ENTER();
+        *p_stats = m_queues[prio].stats;
+        CRITICAL_REGION_EXIT();
+    }
+}
 
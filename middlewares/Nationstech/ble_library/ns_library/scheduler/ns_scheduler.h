@@ -53,7 +53,7 @@ extern "C" {
 #include <string.h>
 
 
-#define APP_SCHED_EVENT_HEADER_SIZE 8       /**< Size of app_scheduler.event_header_t (only for use inside APP_SCHED_BUF_SIZE()). */
+#define APP_SCHED_EVENT_HEADER_SIZE (2 * sizeof(void *))    /**< Size of app_scheduler.event_header_t, a handler and two 16 bit sizes: 8 bytes on the device (only for use inside APP_SCHED_BUF_SIZE()). */
 
 
 /**@brief Compute number of bytes required to hold the scheduler buffer.
@@ -62,14 +62,46 @@ extern "C" {
  * @param[in] QUEUE_SIZE   Number of entries in scheduler queue (i.e. the maximum number of events
  *                         that can be scheduled for execution).
  *
+ * @note      Events only take the space of their own size in the queue, so more than QUEUE_SIZE
+ *            events smaller than EVENT_SIZE fit in the buffer.
+ *
  * @return    Required scheduler buffer size (in bytes).
  */
 #define APP_SCHED_BUF_SIZE(EVENT_SIZE, QUEUE_SIZE)                                                 \
-            (((EVENT_SIZE) + APP_SCHED_EVENT_HEADER_SIZE) * ((QUEUE_SIZE) + 1))
+            (((((EVENT_SIZE) + 3) & ~3) + APP_SCHED_EVENT_HEADER_SIZE) * ((QUEUE_SIZE) + 1))
 
 /**@brief Scheduler event handler type. */
 typedef void (*app_sched_event_handler_t)(void * p_event_data, uint16_t event_size);
 
+/**@brief Scheduler priority levels, a level is served when the higher ones are empty, or once it
+ *        has been passed over APP_SCHED_STARVE_LIMIT times. */
+typedef enum
+{
+    APP_SCHED_PRIO_HIGH = 0,        /**< Time critical events (e.g. key or serial RX interrupts). */
+    APP_SCHED_PRIO_NORMAL,          /**< Default level, used by app_sched_event_put(). */
+    APP_SCHED_PRIO_LOW,             /**< Background work. */
+    APP_SCHED_PRIO_NB,
+} app_sched_prio_t;
+
+/**@brief Number of events app_sched_execute() runs before returning to the main loop. */
+#ifndef APP_SCHED_EXECUTE_BUDGET
+#define APP_SCHED_EXECUTE_BUDGET    8
+#endif
+
+/**@brief Number of events run at higher levels while a level waits before it runs one event
+ *        ahead of them, so that a sustained load at a high level does not stop the lower ones. */
+#ifndef APP_SCHED_STARVE_LIMIT
+#define APP_SCHED_STARVE_LIMIT      16
+#endif
+
+/**@brief Scheduler queue statistics. */
+typedef struct
+{
+    uint32_t high_water;            /**< Highest number of bytes used in the queue. */
+    uint32_t executed;              /**< Events executed. */
+    uint32_t dropped;               /**< Events refused because the queue was full or too small. */
+} app_sched_stats_t;
+
 /**@brief Macro for performing integer division, making sure the result is rounded up.
  *
  * @details One typical use for this is to compute the number of objects with size B is needed to
@@ -104,6 +136,20 @@ typedef void (*app_sched_event_handler_t)(void * p_event_data, uint16_t event_si
     } while (0)
 
 
+/**@brief Macro for initializing the queue of a priority level.
+ *
+ * @param[in] PRIO         Priority level (@ref app_sched_prio_t).
+ * @param[in] EVENT_SIZE   Maximum size of events to be passed through this queue.
+ * @param[in] QUEUE_SIZE   Number of entries in the queue.
+ */
+#define NS_SCHED_QUEUE_INIT(PRIO, EVENT_SIZE, QUEUE_SIZE)                                         \
+    do                                                                                             \
+    {                                                                                              \
+        static uint32_t APP_SCHED_BUF[CEIL_DIV(APP_SCHED_BUF_SIZE((EVENT_SIZE), (QUEUE_SIZE)),     \
+                                               sizeof(uint32_t))];                                 \
+        (void)app_sched_queue_init((PRIO), (EVENT_SIZE), (QUEUE_SIZE), APP_SCHED_BUF);            \
+    } while (0)
+
 /**@brief Function for initializing the Scheduler.
  *
  * @details It must be called before entering the main loop.
@@ -124,16 +170,48 @@ typedef void (*app_sched_event_handler_t)(void * p_event_data, uint16_t event_si
  */
 uint32_t app_sched_init(uint16_t max_event_size, uint16_t queue_size, void * p_evt_buffer);
 
-/**@brief Function for executing all scheduled events.
+/**@brief Function for initializing the queue of a priority level.
+ *
+ * @details app_sched_init() is the same as calling this function with APP_SCHED_PRIO_NORMAL.
+ *          Events can only be put to the levels that have been initialized.
+ *
+ * @param[in]   prio             Priority level.
+ * @param[in]   max_event_size   Maximum size of events to be passed through this queue.
+ * @param[in]   queue_size       Number of entries in the queue.
+ * @param[in]   p_evt_buffer     Buffer dimensioned with APP_SCHED_BUF_SIZE(), 4 byte aligned.
+ *
+ * @retval      0   Successful initialization.
+ * @retval      1   Invalid parameter.
+ */
+uint32_t app_sched_queue_init(app_sched_prio_t prio, uint16_t max_event_size, uint16_t queue_size,
+                              void * p_evt_buffer);
+
+/**@brief Function for executing scheduled events.
  *
- * @details This function must be called from within the main loop. It will execute all events
- *          scheduled since the last time it was called.
+ * @details This function must be called from within the main loop. It executes at most
+ *          APP_SCHED_EXECUTE_BUDGET events, highest priority first (see APP_SCHED_STARVE_LIMIT),
+ *          so that a burst of events does not hold back rwip_schedule(). Use app_sched_pending()
+ *          to know if events are left.
  */
 void app_sched_execute(void);
 
+/**@brief Function for executing at most a given number of scheduled events.
+ *
+ * @param[in]   budget   Maximum number of events to execute.
+ *
+ * @return      Number of events executed.
+ */
+uint16_t app_sched_execute_budget(uint16_t budget);
+
+/**@brief Function for checking if events are waiting to be executed.
+ *
+ * @return      true if at least one queue is not empty.
+ */
+bool app_sched_pending(void);
+
 /**@brief Function for scheduling an event.
  *
- * @details Puts an event into the event queue.
+ * @details Puts an event into the APP_SCHED_PRIO_NORMAL queue. Can be called from interrupt context.
  *
  * @param[in]   p_event_data   Pointer to event data to be scheduled.
  * @param[in]   event_size     Size of event data to be scheduled.
@@ -145,8 +223,55 @@ uint32_t app_sched_event_put(void const *              p_event_data,
                              uint16_t                  event_size,
                              app_sched_event_handler_t handler);
 
+/**@brief Function for reserving a slot to build an event in place.
+ *
+ * @details The returned slot is filled by the caller, then handed to the scheduler with
+ *          app_sched_event_commit() or released with app_sched_event_abort(). Events reserved
+ *          later are only executed once this one is committed or aborted. Can be called from
+ *          interrupt context.
+ *
+ * @param[in]   prio         Priority level.
+ * @param[in]   event_size   Number of bytes to reserve, at most the event size of the level.
+ *
+ * @return      Pointer to the 4 byte aligned slot, NULL if the queue is full.
+ */
+void * app_sched_event_reserve(app_sched_prio_t prio, uint16_t event_size);
+
+/**@brief Function for committing an event built with app_sched_event_reserve().
+ *
+ * @param[in]   p_event_data   Slot returned by app_sched_event_reserve().
+ * @param[in]   event_size     Size of event data, at most the reserved size.
+ * @param[in]   handler        Event handler to receive the event.
+ *
+ * @return      0 on success, otherwise an error code.
+ */
+uint32_t app_sched_event_commit(void * p_event_data, uint16_t event_size,
+                                app_sched_event_handler_t handler);
+
+/**@brief Function for releasing a slot reserved with app_sched_event_reserve().
+ *
+ * @param[in]   p_event_data   Slot returned by app_sched_event_reserve().
+ */
+void app_sched_event_abort(void * p_event_data);
 
-/**@brief Function for getting the current amount of free space in the queue.
+/**@brief Function for scheduling an event at a given priority level.
+ *
+ * @details Can be called from interrupt context.
+ *
+ * @param[in]   prio           Priority level.
+ * @param[in]   p_event_data   Pointer to event data to be scheduled.
+ * @param[in]   event_size     Size of event data to be scheduled.
+ * @param[in]   handler        Event handler to receive the event.
+ *
+ * @return      0 on success, otherwise an error code.
+ */
+uint32_t app_sched_event_put_prio(app_sched_prio_t          prio,
+                                  void const *              p_event_data,
+                                  uint16_t                  event_size,
+                                  app_sched_event_handler_t handler);
+
+
+/**@brief Function for getting the current amount of free space in the APP_SCHED_PRIO_NORMAL queue.
  *
  * @details The real amount of free space may be less if entries are being added from an interrupt.
  *          To get the sxact value, this function should be called from the critical section.
@@ -155,6 +280,13 @@ uint32_t app_sched_event_put(void const *              p_event_data,
  */
 uint16_t app_sched_queue_space_get(void);
 
+/**@brief Function for reading the statistics of a priority level.
+ *
+ * @param[in]   prio      Priority level.
+ * @param[out]  p_stats   Statistics.
+ */
+void app_sched_stats_get(app_sched_prio_t prio, app_sched_stats_t * p_stats);
+
 
 #ifdef __cplusplus
 }
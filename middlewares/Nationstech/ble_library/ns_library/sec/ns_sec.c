@@ -46,6 +46,7 @@
 #include "ns_ble.h"        // Application API Definition
 #include "ns_ble_task.h"
 #include "ns_sec.h"        // Application Security API Definition
+#include "ns_crc.h"
 
 
 #if (DISPLAY_SUPPORT)
@@ -64,21 +65,403 @@
 
 
 /* Private typedef -----------------------------------------------------------*/
+/// Bond database sector header, written last when a sector is filled by compaction
+struct bond_db_sector_hdr
+{
+    uint32_t magic;
+    // Generation, the valid sector with the highest one is the active sector
+    uint32_t gen;
+    uint16_t crc;
+    uint16_t reserved;
+};
+
+/// Bond database record header, followed by the payload padded to 4 bytes
+struct bond_db_record_hdr
+{
+    uint16_t magic;
+    uint8_t  type;
+    uint8_t  len;
+    // CRC of type, len and payload
+    uint16_t crc;
+    uint16_t reserved;
+};
+
+/// Bond record as written to flash
+struct bond_db_record
+{
+    struct bond_db_record_hdr hdr;
+    struct app_sec_bond_data_env_tag data;
+};
+
+/// Bond database environment, rebuilt from the log at init. The live bonds are kept in RAM
+/// so that the reconnection path does not read the flash.
+struct bond_db_env_tag
+{
+    // Active sector index, BOND_DB_NO_SECTOR if the log is empty
+    uint8_t  active;
+    // Number of live bonds
+    uint8_t  num;
+    // Number of bonds with an IRK
+    uint8_t  irk_num;
+    // Generation of the active sector
+    uint32_t gen;
+    // Next free address in the active sector
+    uint32_t write_addr;
+    // Lookup keys: EDIV/Rand and identity address folded to a word
+    uint32_t ltk_key[MAX_BOND_PEER];
+    uint32_t addr_key[MAX_BOND_PEER];
+    // Bonds with an IRK, newest first, to resolve a private address in one command
+    uint8_t  irk_idx[MAX_BOND_PEER];
+    // Live bonds, oldest first
+    struct app_sec_bond_data_env_tag data[MAX_BOND_PEER];
+};
 
 /* Private define ------------------------------------------------------------*/
 #define BOND_SPACE_VALID_FLAG           0x1234
 #define BOND_STORE_LATENCY              500 //  unit 20ms
+
+#define BOND_DB_SECTOR_MAGIC            0x31424442 // "BDB1"
+#define BOND_DB_RECORD_MAGIC            0xB0D5
+#define BOND_DB_RECORD_ADD              0x01
+#define BOND_DB_NO_SECTOR               0xFF
+#define BOND_DB_SECTOR_ADDR(idx)        (app_sec_env.sec_init.bond_db_addr + (idx) * FLASH_SECTOR_SIZE)
+#define BOND_DB_RECORD_SIZE             ((sizeof(struct bond_db_record) + 3) & ~3)
+#define BOND_DB_MAX_PEER                ((app_sec_env.sec_init.bond_max_peer < MAX_BOND_PEER) ? \
+                                         app_sec_env.sec_init.bond_max_peer : MAX_BOND_PEER)
 /* Private constants ---------------------------------------------------------*/
 /* Private variables ---------------------------------------------------------*/
 struct app_sec_bond_data_env_tag app_sec_bond_data;
 extern uint8_t key_enable;
 /// Application Security Environment Structure
 struct app_sec_env_tag app_sec_env;
+static struct bond_db_env_tag bond_db_env;
 /* Private function prototypes -----------------------------------------------*/
 /* Private functions ---------------------------------------------------------*/
 extern __INLINE uint32_t co_rand_word(void);
 
 
+static uint16_t ns_bond_db_record_crc(struct bond_db_record const *p_record)
+{
+    uint16_t crc = ns_crc16_ccitt_update(NS_CRC16_CCITT_INIT, &p_record->hdr.type, 2);
+    return ns_crc16_ccitt_update(crc, (uint8_t const *)&p_record->data, p_record->hdr.len);
+}
+
+static bool ns_bond_db_is_erased(uint32_t addr, uint32_t len)
+{
+    uint32_t const *p_word = (uint32_t const *)addr;
+
+    for(uint32_t i = 0; i < len / 4; i++)
+    {
+        if(p_word[i] != 0xFFFFFFFF)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief  check if two bond entries belong to the same peer, by identity address when the
+ *         peer distributed one, otherwise by connection address
+ */
+static bool ns_bond_db_has_irk(struct app_sec_bond_data_env_tag const *p_data)
+{
+    static const uint8_t no_addr[GAP_BD_ADDR_LEN] = {0};
+
+    return memcmp(p_data->irk.addr.addr.addr, no_addr, GAP_BD_ADDR_LEN) != 0;
+}
+
+static bool ns_bond_db_same_peer(struct app_sec_bond_data_env_tag const *p_a,
+                                 struct app_sec_bond_data_env_tag const *p_b)
+{
+    if(ns_bond_db_has_irk(p_a) || ns_bond_db_has_irk(p_b))
+    {
+        return !memcmp(p_a->irk.addr.addr.addr, p_b->irk.addr.addr.addr, GAP_BD_ADDR_LEN);
+    }
+    return (p_a->peer_addr_type == p_b->peer_addr_type)
+           && !memcmp(p_a->peer_addr.addr, p_b->peer_addr.addr, GAP_BD_ADDR_LEN);
+}
+
+/**
+ * @brief  fold EDIV and Rand to a lookup key
+ */
+static uint32_t ns_bond_db_ltk_key(uint16_t ediv, uint8_t const *p_rand)
+{
+    uint32_t key = ediv;
+
+    for(uint8_t i = 0; i < GAP_RAND_NB_LEN; i++)
+    {
+        key = (key << 5) + (key >> 27) + p_rand[i];
+    }
+    return key;
+}
+
+/**
+ * @brief  fold an address to a lookup key
+ */
+static uint32_t ns_bond_db_addr_key(uint8_t const *p_addr)
+{
+    return (uint32_t)p_addr[0] | ((uint32_t)p_addr[1] << 8) | ((uint32_t)p_addr[2] << 16)
+           | ((uint32_t)(p_addr[3] ^ p_addr[4] ^ p_addr[5]) << 24);
+}
+
+/**
+ * @brief  rebuild the lookup keys and the IRK list after the bond list changed
+ */
+static void ns_bond_db_index_refresh(void)
+{
+    bond_db_env.irk_num = 0;
+    for(uint8_t i = 0; i < bond_db_env.num; i++)
+    {
+        struct app_sec_bond_data_env_tag const *p_data = &bond_db_env.data[i];
+
+        bond_db_env.ltk_key[i] = ns_bond_db_ltk_key(p_data->ediv, p_data->rand_nb.nb);
+        // Identity address if the peer distributed one, otherwise connection address
+        bond_db_env.addr_key[i] = ns_bond_db_addr_key(ns_bond_db_has_irk(p_data) ?
+                                                      p_data->irk.addr.addr.addr : p_data->peer_addr.addr);
+    }
+    for(uint8_t i = bond_db_env.num; i > 0; i--)
+    {
+        if(ns_bond_db_has_irk(&bond_db_env.data[i - 1]))
+        {
+            bond_db_env.irk_idx[bond_db_env.irk_num++] = i - 1;
+        }
+    }
+}
+
+/**
+ * @brief  find the newest bond matching EDIV and Rand
+ * @return the bond data, NULL if not found
+ */
+static struct app_sec_bond_data_env_tag const *ns_bond_db_find_ltk(uint16_t ediv, uint8_t const *p_rand)
+{
+    uint32_t key = ns_bond_db_ltk_key(ediv, p_rand);
+
+    for(uint8_t i = bond_db_env.num; i > 0; i--)
+    {
+        struct app_sec_bond_data_env_tag const *p_data = &bond_db_env.data[i - 1];
+
+        if((bond_db_env.ltk_key[i - 1] == key) && (p_data->ediv == ediv)
+           && !memcmp(p_data->rand_nb.nb, p_rand, GAP_RAND_NB_LEN))
+        {
+            return p_data;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief  find the newest bond of an identity address, or of a connection address for the
+ *         peers which did not distribute one
+ * @return the bond data, NULL if not found
+ */
+static struct app_sec_bond_data_env_tag const *ns_bond_db_find_addr(uint8_t const *p_addr)
+{
+    uint32_t key = ns_bond_db_addr_key(p_addr);
+
+    for(uint8_t i = bond_db_env.num; i > 0; i--)
+    {
+        struct app_sec_bond_data_env_tag const *p_data = &bond_db_env.data[i - 1];
+        uint8_t const *p_bond_addr = ns_bond_db_has_irk(p_data) ? p_data->irk.addr.addr.addr
+                                                                : p_data->peer_addr.addr;
+
+        if((bond_db_env.addr_key[i - 1] == key) && !memcmp(p_bond_addr, p_addr, GAP_BD_ADDR_LEN))
+        {
+            return p_data;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief  drop the entry of the same peer and the oldest one if the database is full,
+ *         making room for a new entry
+ */
+static void ns_bond_db_index_prepare(struct app_sec_bond_data_env_tag const *p_data)
+{
+    for(uint8_t i = 0; i < bond_db_env.num; i++)
+    {
+        if(ns_bond_db_same_peer(&bond_db_env.data[i], p_data))
+        {
+            bond_db_env.num--;
+            memmove(&bond_db_env.data[i], &bond_db_env.data[i + 1],
+                    (bond_db_env.num - i) * sizeof(struct app_sec_bond_data_env_tag));
+            break;
+        }
+    }
+    if((bond_db_env.num != 0) && (bond_db_env.num >= BOND_DB_MAX_PEER))
+    {
+        bond_db_env.num--;
+        memmove(&bond_db_env.data[0], &bond_db_env.data[1],
+                bond_db_env.num * sizeof(struct app_sec_bond_data_env_tag));
+    }
+}
+
+/**
+ * @brief  replay an add record, the same rules as when it was written give the same database
+ */
+static void ns_bond_db_index_add(struct app_sec_bond_data_env_tag const *p_data)
+{
+    if(BOND_DB_MAX_PEER == 0)
+    {
+        return;
+    }
+    ns_bond_db_index_prepare(p_data);
+    memcpy(&bond_db_env.data[bond_db_env.num++], p_data, sizeof(struct app_sec_bond_data_env_tag));
+}
+
+/**
+ * @brief  check the header of a bond database sector
+ * @return true if the sector holds a log
+ */
+static bool ns_bond_db_sector_valid(uint8_t idx, uint32_t *p_gen)
+{
+    struct bond_db_sector_hdr const *p_hdr = (void *)BOND_DB_SECTOR_ADDR(idx);
+
+    if((p_hdr->magic != BOND_DB_SECTOR_MAGIC)
+       || (p_hdr->crc != ns_crc16_ccitt_update(NS_CRC16_CCITT_INIT, (uint8_t const *)p_hdr, 8)))
+    {
+        return false;
+    }
+    *p_gen = p_hdr->gen;
+    return true;
+}
+
+/**
+ * @brief  rebuild the bond list from the records of the active sector. The log ends at the
+ *         first erased header, a torn record ends it too and the next add compacts the log.
+ */
+static void ns_bond_db_scan(uint8_t idx, uint32_t gen)
+{
+    uint32_t addr = BOND_DB_SECTOR_ADDR(idx) + sizeof(struct bond_db_sector_hdr);
+    uint32_t end = BOND_DB_SECTOR_ADDR(idx) + FLASH_SECTOR_SIZE;
+
+    bond_db_env.active = idx;
+    bond_db_env.gen = gen;
+    bond_db_env.num = 0;
+
+    while(addr + BOND_DB_RECORD_SIZE <= end)
+    {
+        struct bond_db_record const *p_record = (void *)addr;
+
+        if(*(uint32_t const *)addr == 0xFFFFFFFF)
+        {
+            break;
+        }
+        if((p_record->hdr.magic != BOND_DB_RECORD_MAGIC)
+           || (p_record->hdr.type != BOND_DB_RECORD_ADD)
+           || (p_record->hdr.len != sizeof(struct app_sec_bond_data_env_tag))
+           || (p_record->hdr.crc != ns_bond_db_record_crc(p_record)))
+        {
+            NS_LOG_WARNING("bond db: torn record at 0x%08x\r\n", addr);
+            addr = end;
+            break;
+        }
+        ns_bond_db_index_add(&p_record->data);
+        addr += BOND_DB_RECORD_SIZE;
+    }
+    bond_db_env.write_addr = addr;
+    ns_bond_db_index_refresh();
+}
+
+/**
+ * @brief  append a bond record at a given address
+ * @return true if the record is written
+ */
+static bool ns_bond_db_write_record(uint32_t addr, struct app_sec_bond_data_env_tag const *p_data)
+{
+    uint32_t buffer[BOND_DB_RECORD_SIZE / 4];
+    struct bond_db_record *p_record = (void *)buffer;
+
+    memset(buffer, 0xFF, sizeof(buffer));
+    p_record->hdr.magic = BOND_DB_RECORD_MAGIC;
+    p_record->hdr.type = BOND_DB_RECORD_ADD;
+    p_record->hdr.len = sizeof(struct app_sec_bond_data_env_tag);
+    memcpy(&p_record->data, p_data, sizeof(struct app_sec_bond_data_env_tag));
+    p_record->hdr.crc = ns_bond_db_record_crc(p_record);
+
+    if(Qflash_Write(addr, (uint8_t *)buffer, BOND_DB_RECORD_SIZE) != FlashOperationSuccess)
+    {
+        NS_LOG_WARNING("bond db: write failed at 0x%08x\r\n", addr);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief  copy the live bonds and a new one to the other sector. The sector header is
+ *         written last, a reset or a flash error before leaves the previous sector active.
+ * @return true if the target sector is the active one
+ */
+static bool ns_bond_db_compact(uint8_t target, struct app_sec_bond_data_env_tag const *p_new)
+{
+    struct bond_db_sector_hdr hdr;
+    uint32_t addr = BOND_DB_SECTOR_ADDR(target) + sizeof(struct bond_db_sector_hdr);
+
+    if(!ns_bond_db_is_erased(BOND_DB_SECTOR_ADDR(target), FLASH_SECTOR_SIZE)
+       && (Qflash_Erase_Sector(BOND_DB_SECTOR_ADDR(target)) != FlashOperationSuccess))
+    {
+        NS_LOG_WARNING("bond db: erase failed at 0x%08x\r\n", BOND_DB_SECTOR_ADDR(target));
+        return false;
+    }
+
+    for(uint8_t i = 0; i < bond_db_env.num; i++)
+    {
+        if(!ns_bond_db_write_record(addr, &bond_db_env.data[i]))
+        {
+            return false;
+        }
+        addr += BOND_DB_RECORD_SIZE;
+    }
+    if((p_new != NULL) && !ns_bond_db_write_record(addr, p_new))
+    {
+        return false;
+    }
+
+    hdr.magic = BOND_DB_SECTOR_MAGIC;
+    hdr.gen = bond_db_env.gen + 1;
+    hdr.crc = ns_crc16_ccitt_update(NS_CRC16_CCITT_INIT, (uint8_t const *)&hdr, 8);
+    hdr.reserved = 0xFFFF;
+    if(Qflash_Write(BOND_DB_SECTOR_ADDR(target), (uint8_t *)&hdr, sizeof(hdr)) != FlashOperationSuccess)
+    {
+        NS_LOG_WARNING("bond db: write failed at 0x%08x\r\n", BOND_DB_SECTOR_ADDR(target));
+        return false;
+    }
+
+    ns_bond_db_scan(target, hdr.gen);
+    return true;
+}
+
+/**
+ * @brief  import the bonds of the previous full-sector layout into the log
+ * @return true if a legacy database was found
+ */
+static bool ns_bond_db_migrate(void)
+{
+    for(uint8_t idx = 0; idx < 2; idx++)
+    {
+        struct local_device_bond_data_tag const *p_legacy = (void *)BOND_DB_SECTOR_ADDR(idx);
+
+        if((p_legacy->valid_flag == BOND_SPACE_VALID_FLAG) && (p_legacy->num <= MAX_BOND_PEER))
+        {
+            for(uint8_t i = 0; i < p_legacy->num; i++)
+            {
+                ns_bond_db_index_add(&p_legacy->single_peer_bond_data[i]);
+            }
+            // the legacy sector is kept until the log holds its bonds, the next boot imports
+            // them again if the log could not be written
+            if(ns_bond_db_compact(idx ^ 1, NULL)
+               && (Qflash_Erase_Sector(BOND_DB_SECTOR_ADDR(idx)) != FlashOperationSuccess))
+            {
+                // the valid log is read first, the next compaction erases this sector again
+                NS_LOG_WARNING("bond db: erase failed at 0x%08x\r\n", BOND_DB_SECTOR_ADDR(idx));
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
 /**
  * @brief  ns bond database get size
  * @param  
@@ -87,42 +470,48 @@ extern __INLINE uint32_t co_rand_word(void);
  */
 static uint8_t ns_bond_db_get_size(void)
 {
-    uint8_t bond_num = 0;
-    uint16_t bond_space_valid = 0;
-    struct local_device_bond_data_tag* p_strored = (void*)app_sec_env.sec_init.bond_db_addr;
-    
-    //NS_LOG_DEBUG("%s\r\n",__func__);
-    
-    bond_space_valid = p_strored->valid_flag;
-    bond_num = p_strored->num;
-    
-    if(bond_space_valid == BOND_SPACE_VALID_FLAG)
+    return bond_db_env.num;
+}
+
+
+/**
+ * @brief  rebuild the bond list from the flash: the newest valid sector, or the legacy
+ *         database to import
+ */
+static void ns_bond_db_read(void)
+{
+    uint32_t gen[2];
+    bool valid[2];
+
+    memset(&bond_db_env, 0, sizeof(bond_db_env));
+    bond_db_env.active = BOND_DB_NO_SECTOR;
+    valid[0] = ns_bond_db_sector_valid(0, &gen[0]);
+    valid[1] = ns_bond_db_sector_valid(1, &gen[1]);
+    if(valid[0] && (!valid[1] || ((int32_t)(gen[0] - gen[1]) > 0)))
     {
-        if(bond_num > app_sec_env.sec_init.bond_max_peer)
-        {
-            bond_num = 0;
-            
-            // Erase full sector
-            Qflash_Erase_Sector(app_sec_env.sec_init.bond_db_addr);
-        }
+        ns_bond_db_scan(0, gen[0]);
+    }
+    else if(valid[1])
+    {
+        ns_bond_db_scan(1, gen[1]);
     }
     else
     {
-        bond_num = 0;
+        ns_bond_db_migrate();
     }
-    
-    return bond_num;
 }
 
-
 /**
  * @brief  bond database init
  */
 static void ns_bond_db_init(void)
 {
     uint8_t peer_num = 0;
+
     Qflash_Init();
     NS_LOG_DEBUG("%s\r\n",__func__);
+
+    ns_bond_db_read();
     peer_num = ns_bond_db_get_size();
     if(app_sec_env.sec_init.ns_sec_msg_handler)
     {
@@ -143,47 +532,52 @@ static void ns_bond_db_init(void)
 }
 
 /**
- * @brief  ns bond database add entry
+ * @brief  ns bond database add entry, appended to the log. The sector is only erased when
+ *         it is full, or a write to it failed, and the live bonds are compacted to the other one.
  * @param  
- * @return 
+ * @return false if the flash could not take the bond, the database is as before the add
  * @note   
  */
-static void ns_bond_db_add_entry(struct app_sec_bond_data_env_tag * bond_data_param)
+static bool ns_bond_db_add_entry(struct app_sec_bond_data_env_tag * bond_data_param)
 {
-    // Load bond data from flash
-    struct local_device_bond_data_tag local_device_bond_data = {0};
-    struct local_device_bond_data_tag* p_strored = (void*)app_sec_env.sec_init.bond_db_addr;
+    uint32_t addr = bond_db_env.write_addr;
+
     if(!app_sec_env.sec_init.bond_enable )
     {
-        return;
+        return true;
     }
     
-    local_device_bond_data.num = ns_bond_db_get_size();
-    
-    // Update bond data
-    if(local_device_bond_data.num < app_sec_env.sec_init.bond_max_peer)
+    if((bond_db_env.active != BOND_DB_NO_SECTOR)
+       && (addr + BOND_DB_RECORD_SIZE <= BOND_DB_SECTOR_ADDR(bond_db_env.active) + FLASH_SECTOR_SIZE)
+       && ns_bond_db_is_erased(addr, BOND_DB_RECORD_SIZE))
     {
-        uint32_t load_size = sizeof(struct app_sec_bond_data_env_tag) * local_device_bond_data.num;
-        memcpy(&local_device_bond_data.single_peer_bond_data, &(p_strored->single_peer_bond_data[0]),load_size);
-        local_device_bond_data.num ++;
+        if(ns_bond_db_write_record(addr, bond_data_param))
+        {
+            bond_db_env.write_addr = addr + BOND_DB_RECORD_SIZE;
+            ns_bond_db_index_add(bond_data_param);
+            ns_bond_db_index_refresh();
+            return true;
+        }
+        // the write offset stays on the failed record, the boot scan stops there: the
+        // live bonds and the new one go to the other sector instead
     }
-    else
+
+    ns_bond_db_index_prepare(bond_data_param);
+    if(bond_db_env.active == BOND_DB_NO_SECTOR)
     {
-        uint32_t load_size = sizeof(struct app_sec_bond_data_env_tag) * (local_device_bond_data.num-1);
-        memcpy(&local_device_bond_data.single_peer_bond_data,&(p_strored->single_peer_bond_data[1]), load_size);
+        if(ns_bond_db_compact(0, bond_data_param) || ns_bond_db_compact(1, bond_data_param))
+        {
+            return true;
+        }
+    }
+    else if(ns_bond_db_compact(bond_db_env.active ^ 1, bond_data_param))
+    {
+        return true;
     }
 
-    memcpy(&local_device_bond_data.single_peer_bond_data[local_device_bond_data.num-1], bond_data_param,
-            sizeof(struct app_sec_bond_data_env_tag) );
-    
-    local_device_bond_data.valid_flag = BOND_SPACE_VALID_FLAG;
-    
-    // Erase full sector
-    Qflash_Erase_Sector(app_sec_env.sec_init.bond_db_addr);
-    
-    // Re-write data
-    Qflash_Write(app_sec_env.sec_init.bond_db_addr, (uint8_t*)(&local_device_bond_data), sizeof(struct local_device_bond_data_tag) );
-
+    // back to the bonds the flash holds
+    ns_bond_db_read();
+    return false;
 }
 
 /**
@@ -195,10 +589,12 @@ static void ns_bond_db_add_entry(struct app_sec_bond_data_env_tag * bond_data_pa
 static void ns_bond_db_load(uint8_t index, struct app_sec_bond_data_env_tag * single_bond_data)
 {
     uint32_t length = sizeof(struct app_sec_bond_data_env_tag);
-    struct local_device_bond_data_tag* p_strored = (void*)app_sec_env.sec_init.bond_db_addr;
     //NS_LOG_DEBUG("%s\r\n",__func__);
     
-    memcpy(single_bond_data, &(p_strored->single_peer_bond_data[index]), length);
+    if(index < bond_db_env.num)
+    {
+        memcpy(single_bond_data, &bond_db_env.data[index], length);
+    }
 }
 
 
@@ -268,24 +664,25 @@ void ns_bond_last_bonded_ral_info(struct gap_ral_dev_info *ral_list)
  */
 void ns_bond_resolv_addr_start(struct bd_addr* addr, uint8_t idx)
 {
-    uint8_t peer_num = ns_bond_db_get_size(); 
-    NS_LOG_DEBUG("%s, idx:%d, num:%d\r\n", __func__, idx ,peer_num);
+    uint8_t nb_key = (idx < bond_db_env.irk_num) ? idx : bond_db_env.irk_num;
+    NS_LOG_DEBUG("%s, idx:%d, num:%d\r\n", __func__, idx ,bond_db_env.irk_num);
     
-    if((idx > 0) && (idx<= peer_num))
+    if(nb_key > 0)
     {
-        // Prepare the GAPM_RESOLV_ADDR_CMD message
+        // Prepare the GAPM_RESOLV_ADDR_CMD message, all the IRKs are tried in one command
         struct gapm_resolv_addr_cmd *p_cmd = KE_MSG_ALLOC_DYN(GAPM_RESOLV_ADDR_CMD,
                                                          TASK_GAPM, TASK_APP,
-                                                         gapm_resolv_addr_cmd,KEY_LEN);
+                                                         gapm_resolv_addr_cmd,nb_key*KEY_LEN);
         // Set operation code
         p_cmd->operation  = GAPM_RESOLV_ADDR;
-        p_cmd->nb_key  = 1;
+        p_cmd->nb_key  = nb_key;
 
         memcpy(p_cmd->addr.addr, addr, sizeof(bd_addr_t));
         
-        struct app_sec_bond_data_env_tag  bond_data = {0};
-        ns_bond_db_load( idx-1, &bond_data);
-        memcpy(&(p_cmd->irk[0]), &(bond_data.irk.irk), KEY_LEN);
+        for(uint8_t i = 0; i < nb_key; i++)
+        {
+            memcpy(&(p_cmd->irk[i]), &(bond_db_env.data[bond_db_env.irk_idx[i]].irk.irk), KEY_LEN);
+        }
         
         // Send the message
         ke_msg_send(p_cmd);
@@ -301,7 +698,6 @@ void ns_bond_resolv_addr_start(struct bd_addr* addr, uint8_t idx)
  */
 void ns_bond_search_addr_irk(struct bd_addr* addr,uint8_t addr_type)
 {
-    struct app_sec_bond_data_env_tag  bond_data = {0};
     uint8_t peer_num = ns_bond_db_get_size();  
     
     NS_LOG_DEBUG("%s,type:%d,bond num:%d\r\n", __func__,addr_type,peer_num);
@@ -310,22 +706,18 @@ void ns_bond_search_addr_irk(struct bd_addr* addr,uint8_t addr_type)
 
     if(addr_type == GAPM_GEN_RSLV_ADDR)
     {
-        //start resolv addr
-        app_env.next_svc = peer_num;
-        ns_bond_resolv_addr_start(addr,app_env.next_svc--);
+        //start resolv addr with every IRK, a failure does not retry
+        ns_bond_resolv_addr_start(addr,bond_db_env.irk_num);
     }
     else{
         // not need to resolv
-        for(uint8_t i = peer_num; i > 0; i--)
+        struct app_sec_bond_data_env_tag const *p_bond = ns_bond_db_find_addr(addr->addr);
+
+        if((p_bond != NULL) && ns_bond_db_has_irk(p_bond))
         {
-            ns_bond_db_load( i-1, &bond_data);
-            if(!memcmp(addr->addr,bond_data.irk.addr.addr.addr,BD_ADDR_LEN))
-            {
-                //found
-                memcpy(&app_env.peer_irk.key,&bond_data.irk.irk.key,GAP_KEY_LEN);
-                NS_LOG_DEBUG("IRK found, static addr\r\n");
-                break;
-            }
+            //found
+            memcpy(&app_env.peer_irk.key,&p_bond->irk.irk.key,GAP_KEY_LEN);
+            NS_LOG_DEBUG("IRK found, static addr\r\n");
         }
     }
 }
@@ -334,11 +726,24 @@ void ns_bond_search_addr_irk(struct bd_addr* addr,uint8_t addr_type)
 /**
  * @brief erase all bond database
  */
-void ns_sec_bond_db_erase_all(void)
+bool ns_sec_bond_db_erase_all(void)
 {
-    // Erase full sector
-    Qflash_Erase_Sector(app_sec_env.sec_init.bond_db_addr);
-    app_sec_env.bonded = false;
+    bool erased = true;
+
+    // Erase both log sectors
+    for(uint8_t idx = 0; idx < 2; idx++)
+    {
+        if(Qflash_Erase_Sector(BOND_DB_SECTOR_ADDR(idx)) != FlashOperationSuccess)
+        {
+            NS_LOG_WARNING("bond db: erase failed at 0x%08x\r\n", BOND_DB_SECTOR_ADDR(idx));
+            erased = false;
+        }
+    }
+
+    // the bonds of a sector left as it was are still found
+    ns_bond_db_read();
+    app_sec_env.bonded = (ns_bond_db_get_size() != 0);
+    return erased;
 }
 
 
@@ -422,20 +827,16 @@ void ns_sec_send_encrypt_req(uint8_t conidx)
     cmd->operation = GAPC_ENCRYPT;
     if(app_sec_env.sec_init.bond_enable)
     {
-        uint8_t peer_num = 0;
-        struct app_sec_bond_data_env_tag  bond_data = {0};
-        peer_num = ns_bond_db_get_size();
-
-        for(uint8_t i = peer_num; i > 0; i--)
+        for(uint8_t i = ns_bond_db_get_size(); i > 0; i--)
         {
-            ns_bond_db_load( i-1, &bond_data);
-            if( !memcmp(&bond_data.peer_addr, &app_env.peer_addr, GAP_BD_ADDR_LEN))
+            struct app_sec_bond_data_env_tag const *p_bond = &bond_db_env.data[i-1];
+            if( !memcmp(&p_bond->peer_addr, &app_env.peer_addr, GAP_BD_ADDR_LEN))
             {
                 NS_LOG_DEBUG("Found bonded device\r\n"); 
-                cmd->ltk.ediv =  bond_data.ediv;
-                cmd->ltk.key_size =  bond_data.key_size;
-                memcpy(cmd->ltk.ltk.key, bond_data.ltk.key, sizeof(struct gap_sec_key));
-                memcpy(cmd->ltk.randnb.nb, bond_data.rand_nb.nb, sizeof(struct rand_nb));
+                cmd->ltk.ediv =  p_bond->ediv;
+                cmd->ltk.key_size =  p_bond->key_size;
+                memcpy(cmd->ltk.ltk.key, p_bond->ltk.key, sizeof(struct gap_sec_key));
+                memcpy(cmd->ltk.randnb.nb, p_bond->rand_nb.nb, sizeof(struct rand_nb));
                 break;
             }
         }
@@ -754,46 +1155,49 @@ static int gapc_encrypt_req_ind_handler(ke_msg_id_t const msgid,
 //        NS_LOG_DEBUG("bonded,searching ltk\r\n");
         if(app_sec_env.sec_init.bond_enable)
         {
-            uint8_t peer_num = 0;
-            struct app_sec_bond_data_env_tag  bond_data = {0};
-            
-            peer_num = ns_bond_db_get_size();
+            struct app_sec_bond_data_env_tag const *p_bond = NULL;
 
-            for(uint8_t i = peer_num; i > 0; i--)
+            #if (BLE_APP_SEC_CON)
+            rand_nb_t lesc_rand_nb = {0};
+            if(param->ediv == 0 &&
+               !memcmp(param->rand_nb.nb, lesc_rand_nb.nb, GAP_RAND_NB_LEN))
             {
-                ns_bond_db_load( i-1, &bond_data);
-                #if (BLE_APP_SEC_CON)
-                rand_nb_t lesc_rand_nb = {0};
-                if(param->ediv == 0 &&
-                   !memcmp(bond_data.rand_nb.nb, lesc_rand_nb.nb, GAP_RAND_NB_LEN))
+                //LESC mode,  ediv and rand_nb are 0x0
+                for(uint8_t i = ns_bond_db_get_size(); (i > 0) && (p_bond == NULL); i--)
                 {
-                    //LESC mode,  ediv and rand_nb are 0x0
+                    struct app_sec_bond_data_env_tag const *p_data = &bond_db_env.data[i-1];
+                    if(memcmp(p_data->rand_nb.nb, lesc_rand_nb.nb, GAP_RAND_NB_LEN))
+                    {
+                        continue;
+                    }
                     if((app_env.peer_addr_type == GAPM_STATIC_ADDR) && 
-                       (!memcmp(app_env.peer_addr.addr, bond_data.peer_addr.addr,GAP_BD_ADDR_LEN)) )
+                       (!memcmp(app_env.peer_addr.addr, p_data->peer_addr.addr,GAP_BD_ADDR_LEN)) )
                     {
                         NS_LOG_INFO("static addr match\r\n");
-                        cfm->found    = true;
+                        p_bond = p_data;
                     }
-                    else if(!memcmp(app_env.peer_irk.key, bond_data.irk.irk.key,GAP_KEY_LEN))
+                    else if(!memcmp(app_env.peer_irk.key, p_data->irk.irk.key,GAP_KEY_LEN))
                     {
                         NS_LOG_INFO("irk match\r\n");
-                        cfm->found    = true;
+                        p_bond = p_data;
                     }
-                }else 
-                #endif
-                if( (bond_data.ediv == param->ediv) && 
-                    !memcmp(&bond_data.rand_nb, &param->rand_nb.nb, sizeof(struct rand_nb)) )
-                {										
-                    NS_LOG_INFO("ediv&rand_nb match %d\r\n",key_enable);
-                    cfm->found    = true;
                 }
-                if(cfm->found)
+            }
+            else
+            #endif
+            {
+                p_bond = ns_bond_db_find_ltk(param->ediv, param->rand_nb.nb);
+                if(p_bond != NULL)
                 {
-                    cfm->key_size = bond_data.key_size;
-                    memcpy(cfm->ltk.key, bond_data.ltk.key, sizeof(struct gap_sec_key));
-                    break;
+                    NS_LOG_INFO("ediv&rand_nb match %d\r\n",key_enable);
                 }
             }
+            if(p_bond != NULL)
+            {
+                cfm->found    = true;
+                cfm->key_size = p_bond->key_size;
+                memcpy(cfm->ltk.key, p_bond->ltk.key, sizeof(struct gap_sec_key));
+            }
         }
         else
         {
@@ -899,8 +1303,16 @@ int ns_sec_bond_store_evt_handler(ke_msg_id_t const msgid, void *p_param,
     if((duration > 64) || (app_sec_env.store_latency == 0))// 20ms, xMS / 0.3125
     {
          //erase and write flash 
-        ns_bond_db_add_entry(&app_sec_bond_data);
-        NS_LOG_INFO("Bond info stored\r\n");
+        if(ns_bond_db_add_entry(&app_sec_bond_data))
+        {
+            NS_LOG_INFO("Bond info stored\r\n");
+        }
+        else if(app_sec_env.sec_init.ns_sec_msg_handler)
+        {
+            struct sec_msg_t sec_msg = {NS_SEC_NULL_MSG,NULL};
+            sec_msg.msg_id = NS_SEC_BOND_STORE_FAILED;
+            app_sec_env.sec_init.ns_sec_msg_handler(&sec_msg);
+        }
 				key_enable = 2;
         #if 0
         NS_LOG_DEBUG("save peer, type:%d, addr:%02X %02X %02X %02X %02X %02X \r\n",
@@ -64,6 +64,8 @@ enum sec_msg_id
     NS_SEC_LTK_FOUND,
     NS_SEC_LTK_MISSING,
     NS_SEC_ENC_SUCCEED,
+    /// A bond could not be written to flash, it is not kept across a reset
+    NS_SEC_BOND_STORE_FAILED,
     
 };
 
@@ -110,20 +112,28 @@ struct app_sec_bond_data_env_tag
 };
 
 /* bonding structure
+ * The bond database is an append-only log over two flash sectors starting at bond_db_addr.
+ * Each bond is appended as a record, the sector is only erased when it is full: the live
+ * bonds are then copied to the other sector, whose header is written last.
  * --------------------------------------------------------------------------------
- * |         ADDR            |                 FIELD                   |   SIZE   |
+ * |         OFFSET          |                 FIELD                   |   SIZE   |
  * --------------------------|-----------------------------------------|----------|
- * | BOND_DATA_BASE_ADDR+0   | Bond space valid flag                   |    2     |
+ * | 0                       | Magic "BDB1"                            |    4     |
  * --------------------------|-----------------------------------------|----------|
- * | BOND_DATA_BASE_ADDR+2   | Bonded peer device numbers              |    1     |
- * --------------------------------------------------------------------------------
- * | BOND_DATA_BASE_ADDR+4   | Bond data0(@ app_sec_bond_data_env_tag) |          |
+ * | 4                       | Generation, highest valid one is active |    4     |
+ * --------------------------|-----------------------------------------|----------|
+ * | 8                       | Header CRC-16                           |    4     |
  * --------------------------------------------------------------------------------
- * |                         | Bond data1(@ app_sec_bond_data_env_tag) |          |
+ * | 12                      | Record: magic, type, length, CRC-16     |    8     |
+ * |                         | Bond data(@ app_sec_bond_data_env_tag)  |          |
  * --------------------------------------------------------------------------------
  * |                         |               ......                    |          |
  * --------------------------------------------------------------------------------
- */  
+ * A newer record of the same peer replaces the older one, the oldest bond is dropped
+ * when more than bond_max_peer are stored.
+ */
+
+/// Previous full-sector layout, imported into the log at init
 struct local_device_bond_data_tag
 {
     uint16_t valid_flag;
@@ -203,8 +213,9 @@ void ns_sec_pincode_respond(uint8_t conidx, uint32_t pincode);
 bool ns_sec_get_bond_status(void);
 /**
  * @brief  erase all bond information
+ * @return false if a flash sector could not be erased, the bonds it holds are kept
  */
-void ns_sec_bond_db_erase_all(void);
+bool ns_sec_bond_db_erase_all(void);
 
 /**
  * @brief  store bond information event hander
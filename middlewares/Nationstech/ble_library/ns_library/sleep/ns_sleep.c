@@ -51,16 +51,106 @@ enum ns_bb_status_t
     BB_WAKEUP_ERROR,   
 //    BB_WAKEUP_RTC, //keep in sleep after lpt callback
 };
+
+/// Sleep governor environment, times are in half-slots (312.5us) of the BLE clock
+struct ns_sleep_gov_env_t
+{
+    uint32_t mark_hs;                               /**< End of the last accounted period */
+    uint32_t residency_hs[NS_SLEEP_MODE_NB];
+    uint32_t wakeup_cnt[NS_SLEEP_WAKEUP_NB];
+    uint32_t holder_hs[NS_SLEEP_HOLDER_NUM];
+    uint32_t holder_since_hs[NS_SLEEP_HOLDER_NUM];
+    uint8_t  holder_cnt[NS_SLEEP_HOLDER_NUM];
+    uint32_t input_hs;
+    uint32_t wake_hs;
+    uint32_t wake_hus;
+    uint32_t latency_last_us;
+    uint32_t latency_max_us;
+    struct ns_sleep_policy_t policy;
+    bool     input_valid;
+    bool     wake_pending;                          /**< GPIO wakeup waiting for its first report */
+    bool     deep_blocked;                          /**< RW_PLF_DEEP_SLEEP_DISABLED set by the governor */
+};
 /* Private define ------------------------------------------------------------*/
 #ifndef NS_WAKEUP_CONFIG
 #define NS_WAKEUP_CONFIG()   
 #endif
+
+#define HS_TO_MS(hs)        (((hs) >> 4) * 5 + (((hs) & 0xF) * 5 >> 4))
+#define MS_TO_HS(ms)        (((uint32_t)(ms) << 4) / 5)
 /* Private constants ---------------------------------------------------------*/
 /* Private variables ---------------------------------------------------------*/
 uint32_t ns_sleep_lock = 0;
+static struct ns_sleep_gov_env_t ns_sleep_gov;
 /* Private function prototypes -----------------------------------------------*/
 /* Private functions ---------------------------------------------------------*/
 
+/**
+ * @brief  Check the policy before rwip_sleep, deep sleep is blocked through the
+ *         platform bit of rwip so the stack picks CPU sleep instead.
+ */
+static void ns_sleep_policy_apply(uint32_t now_hs)
+{
+    bool allowed = true;
+
+    /* deep sleep powers the log USART down, idle until the log is drained */
+    if(NS_LOG_BUSY())
+    {
+        allowed = false;
+    }
+    else if(ns_sleep_gov.input_valid)
+    {
+        if(CLK_SUB(now_hs, ns_sleep_gov.input_hs) < MS_TO_HS(ns_sleep_gov.policy.input_holdoff_ms))
+        {
+            allowed = false;
+        }
+        else
+        {
+            ns_sleep_gov.input_valid = false;
+        }
+    }
+    if(allowed && (ns_sleep_gov.policy.deep_allowed != NULL))
+    {
+        allowed = ns_sleep_gov.policy.deep_allowed();
+    }
+
+    if(allowed == ns_sleep_gov.deep_blocked)
+    {
+        ns_sleep_gov.deep_blocked = !allowed;
+        if(allowed)
+        {
+            rwip_prevent_sleep_clear(RW_PLF_DEEP_SLEEP_DISABLED);
+        }
+        else
+        {
+            rwip_prevent_sleep_set(RW_PLF_DEEP_SLEEP_DISABLED);
+        }
+    }
+}
+
+/**
+ * @brief  Classify the deep sleep wakeup, called with interrupts still disabled so
+ *         the pending lines have not been cleared by their handlers yet.
+ */
+static uint8_t ns_sleep_wakeup_source(void)
+{
+    uint32_t pend = EXTI->PEND & EXTI->IMASK;
+
+    if((g_sleep_status_flag == BB_WAKEUP_OSEN) || (pend & EXTI_LINE11))
+    {
+        return NS_SLEEP_WAKEUP_BLE;
+    }
+    if((g_sleep_status_flag == BB_WAKEUP_USER) || (pend & EXTI_LINE9))
+    {
+        return NS_SLEEP_WAKEUP_RTC;
+    }
+    if((g_sleep_status_flag == BB_WAKEUP_EXIT) || pend)
+    {
+        return NS_SLEEP_WAKEUP_GPIO;
+    }
+    return NS_SLEEP_WAKEUP_OTHER;
+}
+
 #ifdef SLEEP_LP_TIMER_ENABLE
 /**
  * @brief  low power timer initialization.
@@ -140,12 +230,7 @@ void ns_sleep_lp_timer_wake_ble(void)
  */
 uint8_t ns_sleep_lock_acquire(void)
 {
-    if(ns_sleep_lock++ == 0)
-    {
-        //overflow
-        return false;
-    }
-    return true;
+    return ns_sleep_lock_acquire_by(NS_SLEEP_HOLDER_ANY);
 }
 
 /**
@@ -157,12 +242,176 @@ uint8_t ns_sleep_lock_acquire(void)
  */
 uint8_t ns_sleep_lock_release(void)
 {
+    return ns_sleep_lock_release_by(NS_SLEEP_HOLDER_ANY);
+}
+
+/**
+ * @brief  Acquire a sleep lock on behalf of a holder, the held time is accounted to it.
+ * @param  holder: NS_SLEEP_HOLDER_xxx, or an application id from NS_SLEEP_HOLDER_USER
+ * @return 
+ * @note   Can be used from interrupt handlers, e.g. around a busy wait.
+ */
+uint8_t ns_sleep_lock_acquire_by(uint8_t holder)
+{
+    uint8_t ret = true;
+
+    if(holder >= NS_SLEEP_HOLDER_NUM)
+    {
+        holder = NS_SLEEP_HOLDER_ANY;
+    }
+    GLOBAL_INT_DISABLE();
+    if(ns_sleep_gov.holder_cnt[holder]++ == 0)
+    {
+        ns_sleep_gov.holder_since_hs[holder] = rwip_time_get().hs;
+    }
+    if(ns_sleep_lock++ == 0)
+    {
+        //overflow
+        ret = false;
+    }
+    GLOBAL_INT_RESTORE();
+    return ret;
+}
+
+/**
+ * @brief  Release a sleep lock taken with ns_sleep_lock_acquire_by.
+ * @param  holder: same id as the acquire
+ * @return 
+ * @note   
+ */
+uint8_t ns_sleep_lock_release_by(uint8_t holder)
+{
+    uint8_t ret = false;
+
+    if(holder >= NS_SLEEP_HOLDER_NUM)
+    {
+        holder = NS_SLEEP_HOLDER_ANY;
+    }
+    GLOBAL_INT_DISABLE();
     if(ns_sleep_lock)
     {
         ns_sleep_lock--;
-        return true;
+        ret = true;
     }
-    return false;
+    if(ns_sleep_gov.holder_cnt[holder] && (--ns_sleep_gov.holder_cnt[holder] == 0))
+    {
+        ns_sleep_gov.holder_hs[holder] += CLK_SUB(rwip_time_get().hs, ns_sleep_gov.holder_since_hs[holder]);
+    }
+    GLOBAL_INT_RESTORE();
+    return ret;
+}
+
+/**
+ * @brief  Set the sleep policy.
+ * @param  p_policy: policy, copied
+ * @return 
+ * @note   
+ */
+void ns_sleep_policy_set(const struct ns_sleep_policy_t *p_policy)
+{
+    ns_sleep_gov.policy = *p_policy;
+}
+
+/**
+ * @brief  Mark user input, restarts the deep sleep hold off of the policy.
+ * @param  
+ * @return 
+ * @note   Can be called from interrupt handlers.
+ */
+void ns_sleep_input_event(void)
+{
+    ns_sleep_gov.input_hs    = rwip_time_get().hs;
+    ns_sleep_gov.input_valid = true;
+}
+
+/**
+ * @brief  Mark a report sent to the peer, closes the wakeup-to-report latency measurement.
+ * @param  
+ * @return 
+ * @note   
+ */
+void ns_sleep_report_event(void)
+{
+    rwip_time_t now;
+    uint32_t latency_us;
+
+    if(!ns_sleep_gov.wake_pending)
+    {
+        return;
+    }
+    ns_sleep_gov.wake_pending = false;
+    now = rwip_time_get();
+    latency_us = CLK_SUB(now.hs, ns_sleep_gov.wake_hs) * HALF_SLOT_SIZE / 2;
+    latency_us = latency_us + (now.hus >> 1) - (ns_sleep_gov.wake_hus >> 1);
+    ns_sleep_gov.latency_last_us = latency_us;
+    if(latency_us > ns_sleep_gov.latency_max_us)
+    {
+        ns_sleep_gov.latency_max_us = latency_us;
+    }
+}
+
+/**
+ * @brief  Get the sleep statistics.
+ * @param  p_stats: output
+ * @return 
+ * @note   
+ */
+void ns_sleep_stats_get(struct ns_sleep_stats_t *p_stats)
+{
+    uint32_t now_hs;
+    uint8_t i;
+
+    GLOBAL_INT_DISABLE();
+    now_hs = rwip_time_get().hs;
+    for(i = 0; i < NS_SLEEP_MODE_NB; i++)
+    {
+        p_stats->residency_ms[i] = HS_TO_MS(ns_sleep_gov.residency_hs[i]);
+    }
+    /* the caller runs between two ns_sleep calls, that time is active */
+    p_stats->residency_ms[RWIP_ACTIVE] += HS_TO_MS(CLK_SUB(now_hs, ns_sleep_gov.mark_hs));
+    for(i = 0; i < NS_SLEEP_WAKEUP_NB; i++)
+    {
+        p_stats->wakeup_cnt[i] = ns_sleep_gov.wakeup_cnt[i];
+    }
+    p_stats->report_latency_last_us = ns_sleep_gov.latency_last_us;
+    p_stats->report_latency_max_us  = ns_sleep_gov.latency_max_us;
+    for(i = 0; i < NS_SLEEP_HOLDER_NUM; i++)
+    {
+        uint32_t held_hs = ns_sleep_gov.holder_hs[i];
+
+        if(ns_sleep_gov.holder_cnt[i])
+        {
+            held_hs += CLK_SUB(now_hs, ns_sleep_gov.holder_since_hs[i]);
+        }
+        p_stats->holder_ms[i] = HS_TO_MS(held_hs);
+    }
+    GLOBAL_INT_RESTORE();
+}
+
+/**
+ * @brief  Clear the sleep statistics.
+ * @param  
+ * @return 
+ * @note   
+ */
+void ns_sleep_stats_reset(void)
+{
+    uint32_t now_hs;
+    uint8_t i;
+
+    GLOBAL_INT_DISABLE();
+    now_hs = rwip_time_get().hs;
+    ns_sleep_gov.mark_hs = now_hs;
+    memset(ns_sleep_gov.residency_hs, 0, sizeof(ns_sleep_gov.residency_hs));
+    memset(ns_sleep_gov.wakeup_cnt, 0, sizeof(ns_sleep_gov.wakeup_cnt));
+    memset(ns_sleep_gov.holder_hs, 0, sizeof(ns_sleep_gov.holder_hs));
+    for(i = 0; i < NS_SLEEP_HOLDER_NUM; i++)
+    {
+        ns_sleep_gov.holder_since_hs[i] = now_hs;
+    }
+    ns_sleep_gov.latency_last_us = 0;
+    ns_sleep_gov.latency_max_us  = 0;
+    GLOBAL_INT_RESTORE();
 }
 
 
@@ -256,17 +505,27 @@ void entry_idle(void)
  */
 void ns_sleep(void)
 {
+    uint8_t sleep_mode;
+    uint8_t wakeup_src = NS_SLEEP_WAKEUP_NB;
+    uint32_t start_hs;
+    rwip_time_t end_time;
+
     if(ns_sleep_lock != 0)
     {
         return;
     }
     GLOBAL_INT_DISABLE();
+    start_hs = rwip_time_get().hs;
+    ns_sleep_gov.residency_hs[RWIP_ACTIVE] += CLK_SUB(start_hs, ns_sleep_gov.mark_hs);
+    ns_sleep_policy_apply(start_hs);
     app_sleep_prepare_proc();
-    switch(rwip_sleep())
+    sleep_mode = rwip_sleep();
+    switch(sleep_mode)
     {
         case RWIP_DEEP_SLEEP:
         {
             entry_sleep();
+            wakeup_src = ns_sleep_wakeup_source();
         }
         break;
         case RWIP_CPU_SLEEP:
@@ -308,6 +567,24 @@ void ns_sleep(void)
             }
         }
     }
+
+    /* account the sleep period, deep sleep time is valid once the BLE clock is back */
+    end_time = rwip_time_get();
+    if(sleep_mode < NS_SLEEP_MODE_NB)
+    {
+        ns_sleep_gov.residency_hs[sleep_mode] += CLK_SUB(end_time.hs, start_hs);
+    }
+    ns_sleep_gov.mark_hs = end_time.hs;
+    if(wakeup_src < NS_SLEEP_WAKEUP_NB)
+    {
+        ns_sleep_gov.wakeup_cnt[wakeup_src]++;
+        if(wakeup_src == NS_SLEEP_WAKEUP_GPIO)
+        {
+            ns_sleep_gov.wake_hs      = end_time.hs;
+            ns_sleep_gov.wake_hus     = end_time.hus;
+            ns_sleep_gov.wake_pending = true;
+        }
+    }
     
     app_sleep_resume_proc(); 
 
@@ -44,9 +44,52 @@ extern "C" {
 #endif
 
 /* Includes -----------------------------------------------------------------*/
+#include <stdbool.h>
 #include "global_func.h"
-/* Public typedef -----------------------------------------------------------*/
 /* Public define ------------------------------------------------------------*/    
+/* Sleep lock holders, time is accounted per holder while it keeps the lock.
+ * ns_sleep_lock_acquire() is NS_SLEEP_HOLDER_ANY, ids from NS_SLEEP_HOLDER_USER are free for the application. */
+#define NS_SLEEP_HOLDER_ANY          0
+#define NS_SLEEP_HOLDER_LSI_CALIB    1
+#define NS_SLEEP_HOLDER_USER         2
+#ifndef NS_SLEEP_HOLDER_NUM
+#define NS_SLEEP_HOLDER_NUM          6
+#endif
+
+/* Residency buckets, indexed by the rwip_sleep() result */
+#define NS_SLEEP_MODE_NB             3
+
+/* Public typedef -----------------------------------------------------------*/
+/// Source of a deep sleep wakeup
+enum ns_sleep_wakeup_src
+{
+    NS_SLEEP_WAKEUP_BLE = 0,    /**< BLE core timer (connection or advertising event) */
+    NS_SLEEP_WAKEUP_GPIO,       /**< External interrupt line, usually user input */
+    NS_SLEEP_WAKEUP_RTC,        /**< Low power timer */
+    NS_SLEEP_WAKEUP_OTHER,
+    NS_SLEEP_WAKEUP_NB,
+};
+
+/// Sleep statistics, all fields are 32-bit little endian so the struct is also the GATT payload
+struct ns_sleep_stats_t
+{
+    uint32_t residency_ms[NS_SLEEP_MODE_NB];    /**< Time in RWIP_ACTIVE, RWIP_CPU_SLEEP, RWIP_DEEP_SLEEP */
+    uint32_t wakeup_cnt[NS_SLEEP_WAKEUP_NB];    /**< Deep sleep wakeups per source */
+    uint32_t report_latency_last_us;            /**< GPIO wakeup to first report, last value */
+    uint32_t report_latency_max_us;             /**< GPIO wakeup to first report, worst case */
+    uint32_t holder_ms[NS_SLEEP_HOLDER_NUM];    /**< Time each holder kept the sleep lock */
+};
+
+/// Policy hook, return false to keep the system out of deep sleep this time
+typedef bool (*ns_sleep_deep_allowed_t)(void);
+
+/// Sleep policy, trades wakeup latency against current
+struct ns_sleep_policy_t
+{
+    uint16_t input_holdoff_ms;                  /**< No deep sleep for this long after ns_sleep_input_event() */
+    ns_sleep_deep_allowed_t deep_allowed;       /**< Optional application veto, NULL if unused */
+};
+
 /* Public constants ---------------------------------------------------------*/
 /* Public function prototypes -----------------------------------------------*/
 
@@ -75,6 +118,62 @@ uint8_t ns_sleep_lock_acquire(void);
  * @note   
  */
 uint8_t ns_sleep_lock_release(void);
+/**
+ * @brief  Acquire a sleep lock on behalf of a holder, the held time is accounted to it.
+ * @param  holder: NS_SLEEP_HOLDER_xxx, or an application id from NS_SLEEP_HOLDER_USER
+ * @return 
+ * @note   Can be used from interrupt handlers, e.g. around a busy wait.
+ */
+uint8_t ns_sleep_lock_acquire_by(uint8_t holder);
+
+/**
+ * @brief  Release a sleep lock taken with ns_sleep_lock_acquire_by.
+ * @param  holder: same id as the acquire
+ * @return 
+ * @note   
+ */
+uint8_t ns_sleep_lock_release_by(uint8_t holder);
+
+/**
+ * @brief  Set the sleep policy.
+ * @param  p_policy: policy, copied
+ * @return 
+ * @note   
+ */
+void ns_sleep_policy_set(const struct ns_sleep_policy_t *p_policy);
+
+/**
+ * @brief  Mark user input, restarts the deep sleep hold off of the policy.
+ * @param  
+ * @return 
+ * @note   Can be called from interrupt handlers.
+ */
+void ns_sleep_input_event(void);
+
+/**
+ * @brief  Mark a report sent to the peer, closes the wakeup-to-report latency measurement.
+ * @param  
+ * @return 
+ * @note   
+ */
+void ns_sleep_report_event(void);
+
+/**
+ * @brief  Get the sleep statistics.
+ * @param  p_stats: output
+ * @return 
+ * @note   
+ */
+void ns_sleep_stats_get(struct ns_sleep_stats_t *p_stats);
+
+/**
+ * @brief  Clear the sleep statistics.
+ * @param  
+ * @return 
+ * @note   
+ */
+void ns_sleep_stats_reset(void);
+
 /**
  * @brief  User code beofre enter sleep mode
  * @param  
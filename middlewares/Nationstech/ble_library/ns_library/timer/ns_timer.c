@@ -46,179 +46,432 @@
 #include "ns_ble.h"
 #include "ns_timer.h"
 #include "ns_ble_task.h"
+#include "rwip.h"
+#include "co_utils.h"
 #include <stdio.h>
 /* Private define ------------------------------------------------------------*/
-#define NS_TIMER_MAX_NUM                        (NS_TIMER_API_LAST_MES - NS_TIMER_API_MES0 + 1)
 //handler: Timer handler values = 0...NS_TIMER_MAX_NUM -1
-#define NS_TIMER_HANDLER_TO_MSG_ID(hnd_idx)     (hnd_idx  + NS_TIMER_API_MES0)
-#define NS_TIMER_MSG_ID_TO_HANDLER(msg_id)      (msg_id   - NS_TIMER_API_MES0)
 #define NS_TIMER_HANDLER_IS_VALID(hnd_idx)      (hnd_idx  < NS_TIMER_MAX_NUM)
+#define NS_TIMER_NONE                           (0xFF)
 
-#define CREATE_TIMER(timer_id,delay)             ke_timer_set(NS_TIMER_HANDLER_TO_MSG_ID(timer_id), TASK_APP, delay)
+/// Hierarchical wheel: 4 levels of 32 slots of 1ms, 32ms, 1s and 33s, covering 17 minutes
+#define WHEEL_LEVEL_BITS                        (5)
+#define WHEEL_SLOT_NB                           (1 << WHEEL_LEVEL_BITS)
+#define WHEEL_SLOT_MASK                         (WHEEL_SLOT_NB - 1)
+#define WHEEL_LEVEL_NB                          (4)
+#define WHEEL_RANGE                             (1UL << (WHEEL_LEVEL_BITS * WHEEL_LEVEL_NB))
+#define WHEEL_LEVEL_SHIFT(level)                ((level) * WHEEL_LEVEL_BITS)
+
+/// Longest kernel timer programmed at once, keeps the half-slot clock difference unambiguous
+#define WHEEL_KE_TIMER_MAX                      (3600000)
+
+/// Timer is linked in the wheel
+#define TIMER_FLAG_ACTIVE                       (0x01)
+/// Legacy callback without context
+#define TIMER_FLAG_LEGACY                       (0x02)
 
 /* Private typedef -----------------------------------------------------------*/
-struct cancel_timer_t
+struct ns_timer_t
 {
-    timer_hnd_t timer_id;
-    uint32_t delay;
+    /// Expiry time in ms of the wheel clock
+    uint32_t expires;
+    /// Reload value in ms, 0 for one-shot timers
+    uint32_t period;
+    /// User callback
+    void *callback;
+    /// User context
+    void *p_context;
+    /// Next and previous timers in the slot, or next free timer
+    timer_hnd_t next;
+    timer_hnd_t prev;
+    /// Slot index in the wheel (level * WHEEL_SLOT_NB + slot)
+    uint8_t slot;
+    /// TIMER_FLAG_*
+    uint8_t flags;
 };
 
-struct modify_timer_t
+struct ns_timer_wheel_t
 {
-    timer_hnd_t timer_id;
-    uint32_t delay;
+    /// Time of the next tick to process, every timer expiring before has been called
+    uint32_t clk;
+    /// Millisecond clock and half-slot remainder derived from the BLE core time
+    uint32_t now;
+    uint32_t last_hs;
+    uint8_t rem_hs;
+    /// Kernel timer programmed and its expiry
+    bool ke_armed;
+    uint32_t ke_expires;
+    /// Number of linked timers
+    uint16_t count;
+    /// First free timer
+    timer_hnd_t free;
+    /// Non-empty slots of each level
+    uint32_t occupied[WHEEL_LEVEL_NB];
+    /// Heads of the slot lists
+    timer_hnd_t head[WHEEL_LEVEL_NB * WHEEL_SLOT_NB];
 };
+
 /* Private constants ---------------------------------------------------------*/
 /* Private variables ---------------------------------------------------------*/
-// Array that holds the callback function of the active timers
-static timer_callback_t timer_callback_array[NS_TIMER_MAX_NUM];
-
-// Array that holds the callback function of the active timers, whose delay period is to be modified
-static timer_callback_t modified_timer_callback_array[NS_TIMER_MAX_NUM];
+static struct ns_timer_t timer_pool[NS_TIMER_MAX_NUM];
+static struct ns_timer_wheel_t wheel;
+static bool wheel_initialized = false;
 
 /* Private function prototypes -----------------------------------------------*/
 /* Private functions ---------------------------------------------------------*/
 
-
 /**
- * @brief Place a callback in the first available position in the timer callback array.
- * @param fn The callback to be added
- * @return The handler of the timer for future reference. NS_TIMER_INVALID_HANDLER if
- * there is no timer available
+ * @brief Initialize the timer pool and the wheel on first use.
  */
-static timer_hnd_t set_callback(timer_callback_t fn)
+static void wheel_init(void)
 {
+    memset(&wheel, 0, sizeof(wheel));
+    memset(wheel.head, NS_TIMER_NONE, sizeof(wheel.head));
     for (int i = 0; i < NS_TIMER_MAX_NUM; i++)
     {
-        if (timer_callback_array[i] == NULL)
-        {
-            timer_callback_array[i] = fn;
-            return (i);
-        }
+        timer_pool[i].flags = 0;
+        timer_pool[i].next = (i + 1 < NS_TIMER_MAX_NUM) ? (i + 1) : NS_TIMER_NONE;
     }
-    return NS_TIMER_INVALID_HANDLER;
+    wheel.last_hs = rwip_time_get().hs;
+    wheel_initialized = true;
+}
+
+/**
+ * @brief Read the millisecond clock, derived from the BLE core half-slot clock (312.5us).
+ * @return Current time in ms
+ */
+static uint32_t wheel_now(void)
+{
+    uint32_t hs;
+    uint32_t acc;
+
+    GLOBAL_INT_DISABLE();
+    hs = rwip_time_get().hs;
+    GLOBAL_INT_RESTORE();
+
+    // 16 half-slots are 5ms
+    acc = CLK_SUB(hs, wheel.last_hs) * 5 + wheel.rem_hs;
+    wheel.last_hs = hs;
+    wheel.now += acc >> 4;
+    wheel.rem_hs = acc & 0x0F;
+
+    return wheel.now;
+}
+
+/**
+ * @brief Link a timer in the slot matching its expiry. O(1)
+ * @param timer_id The timer to link
+ */
+static void wheel_link(timer_hnd_t timer_id)
+{
+    struct ns_timer_t *timer = &timer_pool[timer_id];
+    uint32_t expires = timer->expires;
+    int32_t delta = (int32_t)(expires - wheel.clk);
+    uint8_t level = 0;
+    uint8_t slot;
+
+    if (delta < 0)
+    {
+        // Already due, run on the next tick
+        expires = wheel.clk;
+        delta = 0;
+    }
+    else if ((uint32_t)delta >= WHEEL_RANGE)
+    {
+        // Out of range, parked in the last slot of the top level and linked again on cascade
+        expires = wheel.clk + WHEEL_RANGE - 1;
+        delta = WHEEL_RANGE - 1;
+    }
+
+    while ((level < WHEEL_LEVEL_NB - 1) && ((uint32_t)delta >= (1UL << WHEEL_LEVEL_SHIFT(level + 1))))
+    {
+        level++;
+    }
+
+    slot = level * WHEEL_SLOT_NB + ((expires >> WHEEL_LEVEL_SHIFT(level)) & WHEEL_SLOT_MASK);
+    timer->slot = slot;
+    timer->prev = NS_TIMER_NONE;
+    timer->next = wheel.head[slot];
+    if (timer->next != NS_TIMER_NONE)
+    {
+        timer_pool[timer->next].prev = timer_id;
+    }
+    wheel.head[slot] = timer_id;
+    wheel.occupied[level] |= (1UL << (slot & WHEEL_SLOT_MASK));
+    timer->flags |= TIMER_FLAG_ACTIVE;
+    wheel.count++;
 }
 
 /**
- * @brief Dummy callback used when canceling a timer.
+ * @brief Unlink a timer from its slot. O(1)
+ * @param timer_id The timer to unlink
  */
-static void timer_canceled_handler(void)
+static void wheel_unlink(timer_hnd_t timer_id)
 {
-    //keep empty
+    struct ns_timer_t *timer = &timer_pool[timer_id];
+    uint8_t slot = timer->slot;
+
+    if (timer->prev != NS_TIMER_NONE)
+    {
+        timer_pool[timer->prev].next = timer->next;
+    }
+    else
+    {
+        wheel.head[slot] = timer->next;
+        if (timer->next == NS_TIMER_NONE)
+        {
+            wheel.occupied[slot / WHEEL_SLOT_NB] &= ~(1UL << (slot & WHEEL_SLOT_MASK));
+        }
+    }
+    if (timer->next != NS_TIMER_NONE)
+    {
+        timer_pool[timer->next].prev = timer->prev;
+    }
+    timer->flags &= ~TIMER_FLAG_ACTIVE;
+    wheel.count--;
 }
 
 /**
- * @brief Dummy callback used when modifying a timer.
+ * @brief Offset of the first non-empty slot at or after a position, 32 if none.
  */
-static void timer_modified_handler(void)
+static uint8_t wheel_first_slot(uint32_t occupied, uint8_t from)
 {
-    //keep empty
+    uint32_t rotated;
+    uint8_t offset = 0;
+
+    if (occupied == 0)
+    {
+        return WHEEL_SLOT_NB;
+    }
+    rotated = (from == 0) ? occupied : ((occupied >> from) | (occupied << (WHEEL_SLOT_NB - from)));
+    while ((rotated & 0x01) == 0)
+    {
+        rotated >>= 1;
+        offset++;
+    }
+    return offset;
 }
 
 /**
- * @brief Call the callback of a specific timer handler if it exists.
- * @param timer_id The handler to call
+ * @brief Compute the next time the wheel has work to do: a level 0 slot to expire or
+ *        an upper level slot to cascade.
+ * @param p_next Next time in ms of the wheel clock
+ * @return false if no timer is linked
  */
-static void call_user_callback(const timer_hnd_t timer_id)
+static bool wheel_next_event(uint32_t *p_next)
 {
-    void (*return_timer_cb)(timer_hnd_t timer_id);
+    bool found = false;
 
-    if NS_TIMER_HANDLER_IS_VALID(timer_id)
+    for (uint8_t level = 0; level < WHEEL_LEVEL_NB; level++)
     {
-        if (timer_callback_array[timer_id] != NULL)
+        uint8_t shift = WHEEL_LEVEL_SHIFT(level);
+        // First slot boundary of this level at or after clk
+        uint32_t base = (wheel.clk + (1UL << shift) - 1) >> shift;
+        uint8_t offset = wheel_first_slot(wheel.occupied[level], base & WHEEL_SLOT_MASK);
+
+        if (offset < WHEEL_SLOT_NB)
         {
-            timer_callback_t fn = timer_callback_array[timer_id];
-            // Check if the a timer to be modified or canceled has expired
-            if ((fn != timer_modified_handler) && (fn != timer_canceled_handler))
+            uint32_t time = (base + offset) << shift;
+
+            if (!found || ((int32_t)(time - *p_next) < 0))
             {
-                timer_callback_array[timer_id] = NULL;
-                modified_timer_callback_array[timer_id] = NULL;
-                return_timer_cb = (void (*)(timer_hnd_t))fn;
-                return_timer_cb(timer_id);
+                *p_next = time;
+                found = true;
             }
         }
     }
-    else
+    return found;
+}
+
+/**
+ * @brief Link again the timers of an upper level slot whose time has come.
+ * @param level The level to cascade
+ */
+static void wheel_cascade(uint8_t level)
+{
+    uint8_t slot = level * WHEEL_SLOT_NB + ((wheel.clk >> WHEEL_LEVEL_SHIFT(level)) & WHEEL_SLOT_MASK);
+    timer_hnd_t timer_id = wheel.head[slot];
+
+    wheel.head[slot] = NS_TIMER_NONE;
+    wheel.occupied[level] &= ~(1UL << (slot & WHEEL_SLOT_MASK));
+    while (timer_id != NS_TIMER_NONE)
     {
-        ASSERT_WARN(0,0,0);
+        timer_hnd_t next = timer_pool[timer_id].next;
+
+        wheel.count--;
+        wheel_link(timer_id);
+        timer_id = next;
     }
 }
 
 /**
- * @brief Handler function that is called when the TASK_APP receives the APP_CANCEL_TIMER
- *        message.
- * @param msgid Id of the message received
- * @param param The timer details to be canceled
- * @param dest_id ID of the receiving task instance
- * @param src_id ID of the sending task instance
- * @return KE_MSG_CONSUMED
+ * @brief Call the callback of an expired timer, periodic timers are linked again first
+ *        so that the callback can cancel or modify them.
+ * @param timer_id The expired timer
+ * @param now Current time of the wheel clock, later than the tick processed if the wheel is late
  */
-static int cancel_timer_msg_handler(ke_msg_id_t const msgid,
-                                struct cancel_timer_t const *param,
-                                ke_task_id_t const dest_id,
-                                ke_task_id_t const src_id)
+static void wheel_expire(timer_hnd_t timer_id, uint32_t now)
 {
-    if NS_TIMER_HANDLER_IS_VALID(param->timer_id)
+    struct ns_timer_t *timer = &timer_pool[timer_id];
+    void *callback = timer->callback;
+    void *p_context = timer->p_context;
+    uint8_t flags = timer->flags;
+
+    wheel_unlink(timer_id);
+    if (timer->period != 0)
     {
-        int i = param->timer_id;
-        if (timer_callback_array[i] == timer_canceled_handler)
+        timer->expires += timer->period;
+        if ((int32_t)(timer->expires - now) <= 0)
         {
-            timer_callback_array[i] = NULL;
-            modified_timer_callback_array[i] = NULL;
+            // Periods missed while the wheel was late are dropped
+            timer->expires = now + timer->period;
         }
-        else if (timer_callback_array[i] == timer_modified_handler)
+        wheel_link(timer_id);
+    }
+    else
+    {
+        // Release the handler before the call, the callback may create a new timer
+        timer->flags = 0;
+        timer->next = wheel.free;
+        wheel.free = timer_id;
+    }
+
+    if (flags & TIMER_FLAG_LEGACY)
+    {
+        ((void (*)(timer_hnd_t))callback)(timer_id);
+    }
+    else
+    {
+        ((timer_ctx_callback_t)callback)(timer_id, p_context);
+    }
+}
+
+/**
+ * @brief Program the kernel timer for the next wheel event if it is earlier than the
+ *        one already programmed.
+ * @param force Program even if a later kernel timer is armed
+ */
+static void wheel_schedule(bool force)
+{
+    uint32_t next = 0;
+
+    if (!wheel_next_event(&next))
+    {
+        if (wheel.ke_armed)
         {
-            struct modify_timer_t *req = KE_MSG_ALLOC(APP_MODIFY_TIMER,
-                                                           TASK_APP,
-                                                           TASK_APP,
-                                                           modify_timer_t);
-
-            req->timer_id = param->timer_id;
-            req->delay = param->delay;
-            ke_msg_send(req);
+            ke_timer_clear(NS_TIMER_API_MES0, TASK_APP);
+            wheel.ke_armed = false;
         }
+        return;
     }
-    else
+
+    if (force || !wheel.ke_armed || ((int32_t)(next - wheel.ke_expires) < 0))
     {
-        ASSERT_ERR(0);
+        uint32_t now = wheel_now();
+        int32_t delay = (int32_t)(next - now);
+
+        if (delay < 1)
+        {
+            delay = 1;
+        }
+        else if (delay > WHEEL_KE_TIMER_MAX)
+        {
+            delay = WHEEL_KE_TIMER_MAX;
+        }
+        ke_timer_set(NS_TIMER_API_MES0, TASK_APP, delay);
+        wheel.ke_armed = true;
+        wheel.ke_expires = now + delay;
     }
-    return KE_MSG_CONSUMED;
 }
 
 /**
-*
- * @brief Handler function that is called when the TASK_APP receives the APP_MODIFY_TIMER
- *        message.
- * @param msgid Id of the message received
- * @param param The timer details to be modified
- * @param dest_id ID of the receiving task instance
- * @param src_id ID of the sending task instance
- * @return KE_MSG_CONSUMED
-*
+ * @brief Run every timer expired at the current time.
  */
-static int modify_timer_msg_handler(ke_msg_id_t const msgid,
-                                struct modify_timer_t const *param,
-                                ke_task_id_t const dest_id,
-                                ke_task_id_t const src_id)
+static void wheel_process(void)
 {
-    if NS_TIMER_HANDLER_IS_VALID(param->timer_id)
+    uint32_t now = wheel_now();
+    uint32_t next = 0;
+
+    while (wheel_next_event(&next) && ((int32_t)(next - now) <= 0))
     {
-        if (timer_callback_array[param->timer_id] == timer_modified_handler)
+        // Nothing is linked between clk and next, jump there
+        wheel.clk = next;
+        for (uint8_t level = WHEEL_LEVEL_NB - 1; level > 0; level--)
+        {
+            if ((wheel.clk & ((1UL << WHEEL_LEVEL_SHIFT(level)) - 1)) == 0)
+            {
+                wheel_cascade(level);
+            }
+        }
+
+        // The callbacks may link timers 32ms ahead in the slot being processed, only the
+        // ones expired at this tick are called
+        uint32_t tick = wheel.clk;
+        timer_hnd_t *p_head = &wheel.head[tick & WHEEL_SLOT_MASK];
+
+        wheel.clk++;
+        for (;;)
         {
-            // Restore timer callback function
-            timer_callback_array[param->timer_id] = modified_timer_callback_array[param->timer_id];
+            timer_hnd_t timer_id = *p_head;
 
-            // Re-create the timer with new delay
-            CREATE_TIMER(param->timer_id, param->delay);
+            while ((timer_id != NS_TIMER_NONE) && ((int32_t)(timer_pool[timer_id].expires - tick) > 0))
+            {
+                timer_id = timer_pool[timer_id].next;
+            }
+            if (timer_id == NS_TIMER_NONE)
+            {
+                break;
+            }
+            wheel_expire(timer_id, now);
         }
     }
-    else
+    if ((int32_t)(now + 1 - wheel.clk) > 0)
     {
-        ASSERT_ERR(0);
+        wheel.clk = now + 1;
     }
-    return KE_MSG_CONSUMED;
+
+    wheel.ke_armed = false;
+    wheel_schedule(true);
 }
 
+/**
+ * @brief Take a timer from the free list and arm it. O(1)
+ */
+static timer_hnd_t timer_start(uint32_t delay, uint32_t period, void *callback, void *p_context,
+                               uint8_t flags)
+{
+    timer_hnd_t timer_id;
+    uint32_t now;
+
+    if (!wheel_initialized)
+    {
+        wheel_init();
+    }
+
+    timer_id = wheel.free;
+    if (timer_id == NS_TIMER_NONE)
+    {
+        return NS_TIMER_INVALID_HANDLER; //No timers available
+    }
+    wheel.free = timer_pool[timer_id].next;
+
+    now = wheel_now();
+    if (wheel.count == 0)
+    {
+        // Idle wheel, nothing is pending before now
+        wheel.clk = now;
+    }
+
+    timer_pool[timer_id].callback = callback;
+    timer_pool[timer_id].p_context = p_context;
+    timer_pool[timer_id].period = period;
+    timer_pool[timer_id].flags = flags;
+    timer_pool[timer_id].expires = now + delay;
+    wheel_link(timer_id);
+    wheel_schedule(false);
+
+    return timer_id;
+}
 
 enum process_event_response ns_timer_api_process_handler(ke_msg_id_t const msgid,
                                                           void const *param,
@@ -230,26 +483,17 @@ enum process_event_response ns_timer_api_process_handler(ke_msg_id_t const msgid
     NS_LOG_DEBUG("app_timer_api_process_handler:msgid:%04x\r\n",msgid);
     switch (msgid)
     {
-        case APP_CANCEL_TIMER:
-            *msg_ret = (enum ke_msg_status_tag)cancel_timer_msg_handler(msgid, param, dest_id, src_id);
-            return PR_EVENT_HANDLED;
-
-        case APP_MODIFY_TIMER:
-            *msg_ret = (enum ke_msg_status_tag)modify_timer_msg_handler(msgid, param, dest_id, src_id);
-            return PR_EVENT_HANDLED;
-
-        default:
-            if ((msgid < NS_TIMER_API_MES0) || (msgid > NS_TIMER_API_LAST_MES))
-            {
-                *msg_ret = KE_MSG_NO_FREE;
-                return PR_EVENT_UNHANDLED;
-            }
-            else
+        case NS_TIMER_API_MES0:
+            if (wheel_initialized)
             {
-                call_user_callback(NS_TIMER_MSG_ID_TO_HANDLER(msgid));
-                *msg_ret = KE_MSG_CONSUMED;
+                wheel_process();
             }
+            *msg_ret = KE_MSG_CONSUMED;
             return PR_EVENT_HANDLED;
+
+        default:
+            *msg_ret = KE_MSG_NO_FREE;
+            return PR_EVENT_UNHANDLED;
     }
 }
 
@@ -259,45 +503,40 @@ timer_hnd_t ns_timer_create(const uint32_t delay, timer_callback_t fn)
     ASSERT_ERR(delay > 0);                  // Delay should not be zero
     ASSERT_ERR(delay < KE_TIMER_DELAY_MAX); // Delay should not be more than maximum allowed
 
-    timer_hnd_t timer_id = set_callback(fn);
-    if (timer_id == NS_TIMER_INVALID_HANDLER)
-    {
-        return NS_TIMER_INVALID_HANDLER; //No timers available
-    }
+    return timer_start(delay, 0, (void *)fn, NULL, TIMER_FLAG_LEGACY);
+}
+
+timer_hnd_t ns_timer_start(const uint32_t delay, const uint32_t period,
+                           timer_ctx_callback_t fn, void *p_context)
+{
+    // Sanity checks
+    ASSERT_ERR(delay > 0);                  // Delay should not be zero
+    ASSERT_ERR(delay < KE_TIMER_DELAY_MAX); // Delay should not be more than maximum allowed
+    ASSERT_ERR(period < KE_TIMER_DELAY_MAX);
 
-    // Create timer
-    CREATE_TIMER(timer_id, delay);
+    return timer_start(delay, period, (void *)fn, p_context, 0);
+}
 
-    return timer_id;
+bool ns_timer_is_active(const timer_hnd_t timer_id)
+{
+    return NS_TIMER_HANDLER_IS_VALID(timer_id) && wheel_initialized
+           && ((timer_pool[timer_id].flags & TIMER_FLAG_ACTIVE) != 0);
 }
 
 void ns_timer_cancel(const timer_hnd_t timer_id)
 {
-    if NS_TIMER_HANDLER_IS_VALID(timer_id)
+    if (ns_timer_is_active(timer_id))
     {
-        if ((timer_callback_array[timer_id] != NULL) &&
-            (timer_callback_array[timer_id] != timer_canceled_handler))
-        {
-            // Remove the timer from the timer queue
-            ke_timer_clear(NS_TIMER_HANDLER_TO_MSG_ID(timer_id), TASK_APP);
-
-            timer_callback_array[timer_id] = timer_canceled_handler;
-
-            struct cancel_timer_t *req = KE_MSG_ALLOC(APP_CANCEL_TIMER, TASK_APP, TASK_APP,
-                                                           cancel_timer_t);
-
-            req->timer_id = timer_id;
-            ke_msg_send(req);
-        }
-        else
-        {
-            ASSERT_WARN(0,0,0);
-        }
-   }
-   else
-   {
-       ASSERT_WARN(0,0,0);
-   }
+        // The kernel timer is left armed, an early wake-up finds nothing to do
+        wheel_unlink(timer_id);
+        timer_pool[timer_id].flags = 0;
+        timer_pool[timer_id].next = wheel.free;
+        wheel.free = timer_id;
+    }
+    else
+    {
+        ASSERT_WARN(0,0,0);
+    }
 }
 
 timer_hnd_t ns_timer_modify(const timer_hnd_t timer_id, uint32_t delay)
@@ -306,32 +545,20 @@ timer_hnd_t ns_timer_modify(const timer_hnd_t timer_id, uint32_t delay)
     ASSERT_ERR(delay > 0);                  // Delay should not be zero
     ASSERT_ERR(delay < KE_TIMER_DELAY_MAX); // Delay should not be more than maximum allowed
 
-    if NS_TIMER_HANDLER_IS_VALID(timer_id)
+    if (ns_timer_is_active(timer_id))
     {
-        if ((timer_callback_array[timer_id] != NULL) &&
-            (timer_callback_array[timer_id] != timer_modified_handler))
-        {
-            // Remove the timer from the timer queue
-            ke_timer_clear(NS_TIMER_HANDLER_TO_MSG_ID(timer_id), TASK_APP);
+        uint32_t now = wheel_now();
 
-            // Store the timer function callback
-            modified_timer_callback_array[timer_id] = timer_callback_array[timer_id];
-
-            timer_callback_array[timer_id] = timer_modified_handler;
-
-            struct cancel_timer_t *req = KE_MSG_ALLOC(APP_CANCEL_TIMER, TASK_APP, TASK_APP,
-                                                           cancel_timer_t);
-
-            req->timer_id = timer_id;
-            req->delay = delay;
-            ke_msg_send(req);
-
-            return timer_id;
-        }
-        else
+        wheel_unlink(timer_id);
+        if (wheel.count == 0)
         {
-            ASSERT_WARN(0,0,0);
+            wheel.clk = now;
         }
+        timer_pool[timer_id].expires = now + delay;
+        wheel_link(timer_id);
+        wheel_schedule(false);
+
+        return timer_id;
     }
     else
     {
@@ -344,11 +571,10 @@ void ns_timer_cancel_all(void)
 {
     for (int i = 0; i < NS_TIMER_MAX_NUM; i++)
     {
-        if ((timer_callback_array[i] != NULL) &&
-            (timer_callback_array[i] != timer_canceled_handler))
-            {
-                ns_timer_cancel(i);
-            }
+        if (ns_timer_is_active(i))
+        {
+            ns_timer_cancel(i);
+        }
     }
 }
 
@@ -47,11 +47,17 @@
 typedef uint8_t timer_hnd_t;
 /// Timer callback function type definition
 typedef void (* timer_callback_t)(void);
+/// Timer callback with the handler and the context given to ns_timer_start()
+typedef void (* timer_ctx_callback_t)(timer_hnd_t timer_id, void *p_context);
 /* Public define ------------------------------------------------------------*/    
 /// Max timer delay 41943sec (41943000ms)
 #define KE_TIMER_DELAY_MAX          (41943000)
 /// Value indicating an invalide timer operation
 #define NS_TIMER_INVALID_HANDLER    (0xFF)
+/// Number of timers which can run at the same time (at most 254), each one takes 20 bytes of RAM
+#ifndef NS_TIMER_MAX_NUM
+#define NS_TIMER_MAX_NUM            (16)
+#endif
 /* Public constants ---------------------------------------------------------*/
 /* Public function prototypes -----------------------------------------------*/
 
@@ -85,6 +91,27 @@ enum process_event_response ns_timer_api_process_handler(ke_msg_id_t const msgid
  */
 timer_hnd_t ns_timer_create(const uint32_t delay, timer_callback_t fn);
 
+/**
+ * @brief Create a new timer with a context, one-shot or periodic.
+ * @param delay     The amount of timer value to wait before the first call (time resolution is 1ms)
+ * @param period    The reload value after each call, 0 for a one-shot timer
+ * @param fn        The callback to be called when the timer expires
+ * @param p_context The context given to the callback
+ * @return The handler of the timer for future reference. If there are not timers available
+ *         NS_TIMER_INVALID_HANDLER will be returned
+ * @note A periodic timer keeps its handler until ns_timer_cancel() is called, the callback
+ *       may cancel or modify its own timer.
+ */
+timer_hnd_t ns_timer_start(const uint32_t delay, const uint32_t period,
+                           timer_ctx_callback_t fn, void *p_context);
+
+/**
+ * @brief Check if a timer is running.
+ * @param timer_id The timer handler
+ * @return true if the timer has not expired nor been canceled
+ */
+bool ns_timer_is_active(const timer_hnd_t timer_id);
+
 /**
  * @brief Cancel an active timer.
  * @param timer_id The timer handler to cancel
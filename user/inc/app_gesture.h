@@ -0,0 +1,141 @@
+/*****************************************************************************
+ * Copyright (c) 2019, Nations Technologies Inc.
+ *
+ * All rights reserved.
+ * ****************************************************************************
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Nations' name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY NATIONS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL NATIONS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ****************************************************************************/
+
+
+/**
+ * @file app_gesture.h
+ * @author Nations Firmware Team
+ * @version v1.0.0
+ *
+ * @copyright Copyright (c) 2019, Nations Technologies Inc. All rights reserved.
+ */
+#ifndef __APP_GESTURE_H__
+#define __APP_GESTURE_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "app_hid_touchscreen.h"
+#include "app_trajectory.h"
+
+// Number of gestures that can wait behind the one being played
+#define APP_GESTURE_QUEUE_NB     4
+
+// Delay between two fingers landing when APP_GESTURE_FLAG_STAGGER is set (ms)
+#define APP_GESTURE_STAGGER_MS   10
+
+// Gesture flags
+#define APP_GESTURE_FLAG_STAGGER 0x01   // Fingers land one after the other
+#define APP_GESTURE_FLAG_FIXED   0x02   // Keep steps/frame_ms, do not follow the connection interval
+
+// Contact trajectory type
+enum app_gesture_path {
+    APP_GESTURE_PATH_LINE,              // Each contact moves on a straight line
+    APP_GESTURE_PATH_ARC,               // Contacts turn around a common center
+    APP_GESTURE_PATH_BEZIER,            // Each contact follows a cubic Bezier curve
+    APP_GESTURE_PATH_SCRIPT,            // Contacts driven by a gesture script (app_gesture_script.h)
+};
+
+// Report sender used by the player
+typedef void (*app_gesture_send_t)(const hid_touch_point_t* touches, uint8_t count);
+
+// Straight line of one contact
+typedef struct {
+    uint16_t x_start;
+    uint16_t y_start;
+    uint16_t x_end;
+    uint16_t y_end;
+} app_gesture_line_t;
+
+// Arc shared by all contacts, evenly spread around the center
+typedef struct {
+    uint16_t center_x;
+    uint16_t center_y;
+    uint16_t radius;
+    int16_t  angle_degrees;             // Positive = clockwise
+} app_gesture_arc_t;
+
+// Cubic Bezier curve of one contact: start, two control points, end
+typedef struct {
+    uint16_t x[4];
+    uint16_t y[4];
+} app_gesture_bezier_t;
+
+// Number of arguments passed to a gesture script
+#define APP_GESTURE_SCRIPT_ARG_NB 5
+
+// Gesture script and its arguments, the code must stay valid until the gesture ends
+typedef struct {
+    const uint8_t* code;
+    uint16_t length;
+    int16_t  arg[APP_GESTURE_SCRIPT_ARG_NB];
+} app_gesture_script_t;
+
+// Gesture description
+typedef struct {
+    uint8_t  path;                      // enum app_gesture_path
+    uint8_t  contact_nb;                // Number of fingers (1-MAX_TOUCH_POINTS), unused by scripts
+    uint8_t  steps;                     // Number of move frames after touch down
+    uint8_t  flags;                     // APP_GESTURE_FLAG_xxx
+    uint8_t  ease;                      // enum app_traj_ease, speed profile of the move frames
+    uint16_t frame_ms;                  // Delay between two move frames, steps * frame_ms = move duration
+    uint16_t hold_ms;                   // Delay between the last move frame and lift-off
+    app_gesture_send_t send;            // NULL = app_hid_send_multitouch
+    union {
+        app_gesture_line_t line[MAX_TOUCH_POINTS];
+        app_gesture_arc_t  arc;
+        app_gesture_bezier_t bezier[MAX_TOUCH_POINTS];
+        app_gesture_script_t script;
+    } u;
+} app_gesture_t;
+
+/**
+ * @brief Play a gesture, or queue it behind the one being played
+ * @param gesture Gesture description, copied by the player
+ * @return false if the gesture is invalid or the queue is full
+ */
+bool app_gesture_start(const app_gesture_t* gesture);
+
+/**
+ * @brief Stop the current gesture, lift the fingers and flush the queue
+ */
+void app_gesture_cancel(void);
+
+/**
+ * @brief Check if a gesture is being played
+ * @return true until the last queued gesture has lifted its fingers
+ */
+bool app_gesture_is_busy(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __APP_GESTURE_H__ */
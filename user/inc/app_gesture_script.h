@@ -0,0 +1,161 @@
+/*****************************************************************************
+ * Copyright (c) 2019, Nations Technologies Inc.
+ *
+ * All rights reserved.
+ * ****************************************************************************
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Nations' name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY NATIONS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL NATIONS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ****************************************************************************/
+
+
+/**
+ * @file app_gesture_script.h
+ * @author Nations Firmware Team
+ * @version v1.0.0
+ *
+ * @copyright Copyright (c) 2019, Nations Technologies Inc. All rights reserved.
+ */
+#ifndef __APP_GESTURE_SCRIPT_H__
+#define __APP_GESTURE_SCRIPT_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "app_gesture.h"
+
+/*
+ * Gesture script encoding
+ *
+ * An instruction is one opcode byte, an optional byte field (contact, register or
+ * ease) and up to 6 little-endian int16 values. A value between APP_GS_R(0) and
+ * APP_GS_R(APP_GS_REG_NB - 1) reads a register instead of being an immediate.
+ * Registers R0-R4 hold the script arguments, the other ones are scratch.
+ * Contacts only change in the report on SYNC, PLAY frames and END.
+ */
+
+// Number of registers, R0 to R(APP_GESTURE_SCRIPT_ARG_NB - 1) are the arguments
+#define APP_GS_REG_NB               12
+// Nesting depth of LOOP/NEXT
+#define APP_GS_LOOP_NB              2
+// Instructions run in a row before the interpreter yields for 1ms
+#define APP_GS_STEP_BUDGET          64
+// Largest script accepted by the upload report
+#define APP_GS_UPLOAD_MAX_LEN       256
+// step() return value once the script has ended
+#define APP_GESTURE_SCRIPT_DONE     0xFFFF
+
+// Register reference
+#define APP_GS_R(n)                 (-32768 + (n))
+// int16 value
+#define APP_GS_V(v)                 (uint8_t)((uint16_t)(v) & 0xFF), (uint8_t)((uint16_t)(v) >> 8)
+
+// Opcodes
+enum app_gs_op {
+    APP_GS_OP_END,                  // Lift remaining contacts, end of script
+    APP_GS_OP_DOWN,                 // [contact] x y: land a contact
+    APP_GS_OP_UP,                   // [contact]: lift a contact
+    APP_GS_OP_MOVE,                 // [contact] x y: straight path to (x, y)
+    APP_GS_OP_ARC,                  // [contact] cx cy r start turn: arc path, angles in degrees
+    APP_GS_OP_CURVE,                // [contact] x1 y1 x2 y2 x y: cubic Bezier path
+    APP_GS_OP_PLAY,                 // [ease] ms: move the contacts along their path
+    APP_GS_OP_SYNC,                 // Send the contacts state
+    APP_GS_OP_WAIT,                 // ms: pause
+    APP_GS_OP_SET,                  // [register] v: R = v
+    APP_GS_OP_ADD,                  // [register] v: R += v
+    APP_GS_OP_SUB,                  // [register] v: R -= v
+    APP_GS_OP_RAND,                 // [register] range: R += random in [-range/2, range/2)
+    APP_GS_OP_LOOP,                 // n: run up to NEXT n times
+    APP_GS_OP_NEXT,                 // End of loop body
+
+    APP_GS_OP_MAX,
+};
+
+// Instruction builders, for const scripts
+#define APP_GS_END()                        APP_GS_OP_END
+#define APP_GS_DOWN(id, x, y)               APP_GS_OP_DOWN, (id), APP_GS_V(x), APP_GS_V(y)
+#define APP_GS_UP(id)                       APP_GS_OP_UP, (id)
+#define APP_GS_MOVE(id, x, y)               APP_GS_OP_MOVE, (id), APP_GS_V(x), APP_GS_V(y)
+#define APP_GS_ARC(id, cx, cy, r, start, turn) \
+    APP_GS_OP_ARC, (id), APP_GS_V(cx), APP_GS_V(cy), APP_GS_V(r), APP_GS_V(start), APP_GS_V(turn)
+#define APP_GS_CURVE(id, x1, y1, x2, y2, x, y) \
+    APP_GS_OP_CURVE, (id), APP_GS_V(x1), APP_GS_V(y1), APP_GS_V(x2), APP_GS_V(y2), APP_GS_V(x), APP_GS_V(y)
+#define APP_GS_PLAY(ease, ms)               APP_GS_OP_PLAY, (ease), APP_GS_V(ms)
+#define APP_GS_SYNC()                       APP_GS_OP_SYNC
+#define APP_GS_WAIT(ms)                     APP_GS_OP_WAIT, APP_GS_V(ms)
+#define APP_GS_SET(r, v)                    APP_GS_OP_SET, (r), APP_GS_V(v)
+#define APP_GS_ADD(r, v)                    APP_GS_OP_ADD, (r), APP_GS_V(v)
+#define APP_GS_SUB(r, v)                    APP_GS_OP_SUB, (r), APP_GS_V(v)
+#define APP_GS_RAND(r, range)               APP_GS_OP_RAND, (r), APP_GS_V(range)
+#define APP_GS_LOOP(n)                      APP_GS_OP_LOOP, APP_GS_V(n)
+#define APP_GS_NEXT()                       APP_GS_OP_NEXT
+
+// Upload report commands (first byte of the vendor Output Report)
+enum app_gs_upload_cmd {
+    APP_GS_UPLOAD_BEGIN = 0x01,     // length(2): start a new script
+    APP_GS_UPLOAD_DATA  = 0x02,     // n(1) bytes(n): append to the script
+    APP_GS_UPLOAD_RUN   = 0x03,     // n(1) args(2*n): check and play the script
+};
+
+/**
+ * @brief Check that a script can be run safely
+ * @param code Script
+ * @param length Script length
+ * @return true if every instruction is complete and valid, loops balanced and END present
+ */
+bool app_gesture_script_check(const uint8_t* code, uint16_t length);
+
+/**
+ * @brief Play a script, or queue it behind the gesture being played
+ * @param code Script, must stay valid until the gesture ends
+ * @param length Script length
+ * @param arg Arguments copied to R0.., may be NULL if arg_nb is 0
+ * @param arg_nb Number of arguments (0-APP_GESTURE_SCRIPT_ARG_NB)
+ * @return false if the script is invalid or the queue is full
+ */
+bool app_gesture_script_play(const uint8_t* code, uint16_t length, const int16_t* arg, uint8_t arg_nb);
+
+/**
+ * @brief Handle a write to the script upload report
+ * @param data Report value (@see enum app_gs_upload_cmd)
+ * @param length Report length
+ */
+void app_gesture_script_upload(const uint8_t* data, uint16_t length);
+
+/**
+ * @brief Prepare the interpreter for a script gesture, called by the player
+ */
+void app_gesture_script_begin(const app_gesture_script_t* script);
+
+/**
+ * @brief Run the script until it has to wait, called by the player
+ * @param send Report sender
+ * @return Delay before the next call in ms, APP_GESTURE_SCRIPT_DONE once ended
+ */
+uint16_t app_gesture_script_step(app_gesture_send_t send);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __APP_GESTURE_SCRIPT_H__ */
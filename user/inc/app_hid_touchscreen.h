@@ -72,6 +72,14 @@ typedef struct __attribute__((packed)) {
  */
 void app_hid_send_multitouch(const hid_touch_point_t* touches, uint8_t count);
 
+/**
+ * @brief Send a multi-touch report with the contact count in byte 15, lifting the contacts
+ *        of the previous report that are not in this one
+ * @param touches Array of touch points
+ * @param count Number of active touch points (0-3)
+ */
+void app_hid_send_enhanced_multitouch(const hid_touch_point_t* touches, uint8_t count);
+
 /**
  * @brief Send single touch screen event (convenience function)
  * @param contact_id Contact identifier (0-4)
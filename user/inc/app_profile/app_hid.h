@@ -77,6 +77,12 @@ struct app_hid_env_tag
     bool timer_enabled;
     /// Number of report that can be sent
     uint8_t nb_report;
+    /// Number of report sent and not completed yet
+    uint8_t nb_out;
+    /// Number of them sent with HOGPD_REPORT_UPD_REQ, always the most recent ones
+    uint8_t nb_req_out;
+    /// Current connection interval (in unit of 1.25ms)
+    uint16_t con_interval;
 };
 
 /// Mouse report (data packet)
@@ -98,6 +104,9 @@ struct ps2_mouse_msg
 #define APP_HID_CONSUMER_REPORT_LEN    (4)
 #define APP_HID_MOUSE_REPORT_LEN       (6)
 #define APP_HID_KEYBOARD_REPORT_LEN    (8)  // 1 byte modifier + 1 byte reserved + 6 bytes key codes
+/// Relative movement range of the mouse report (Logical Minimum/Maximum)
+#define APP_HID_MOUSE_XY_MAX           (255)
+#define APP_HID_MOUSE_WHEEL_MAX        (127)
 /// Length of the Report Descriptor for an HID Mouse
 #define APP_HID_MOUSE_REPORT_MAP_LEN   (sizeof(app_hid_mouse_report_map))
 
@@ -109,6 +118,73 @@ struct ps2_mouse_msg
 /// Number of reports that can be sent
 #define APP_HID_NB_SEND_REPORT         (200)
 
+/// Notify reports with hogpd_report_send_direct() when HOGPD is free, 0 to always send a
+/// HOGPD_REPORT_UPD_REQ (to compare both paths with HOGPD_REPORT_CYCLES)
+#ifndef APP_HID_DIRECT_SEND
+#define APP_HID_DIRECT_SEND            (1)
+#endif
+
+/// Number of Input Report instances (Report ID 1 to 4) served by the pending report queue
+#define APP_HID_REPORT_NB              (4)
+/// Number of pending reports kept per report instance while no credit is available
+#define APP_HID_QUEUE_DEPTH            (8)
+/// Largest report kept by the pending report queue
+#define APP_HID_QUEUE_REPORT_MAX_LEN   (16)
+
+/// Report instance of the vendor Output Report (Report ID 5) receiving gesture scripts
+#define APP_HID_SCRIPT_REPORT_IDX      (5)
+/// Length of the gesture script Output Report
+#define APP_HID_SCRIPT_REPORT_LEN      (20)
+
+/// Longest time an unchanged report is suppressed before being sent again (ms)
+#define APP_HID_SUPPRESS_KEEPALIVE_MS  (500)
+
+/// Number of touch frames generated per connection event, bounded by the controller TX buffers
+#define APP_HID_FRAMES_PER_EVENT       (1)
+
+/// Report instance index of each Input Report (Report ID - 1)
+enum app_hid_report_idx
+{
+    /// Report ID 1: Mouse
+    APP_HID_MOUSE_REPORT_IDX,
+    /// Report ID 2: Consumer control
+    APP_HID_CONSUMER_REPORT_IDX,
+    /// Report ID 3: Keyboard
+    APP_HID_KEYBOARD_REPORT_IDX,
+    /// Report ID 4: Multi-touch screen
+    APP_HID_TOUCH_REPORT_IDX,
+};
+
+/// Behaviour of a pending report queue when it is full
+enum app_hid_queue_policy
+{
+    /// Discard the oldest pending report to make room for the new one
+    APP_HID_QUEUE_DROP_OLDEST,
+    /// Overwrite the most recent pending report with the new one if they have the same
+    /// contacts, otherwise drop an older report that only moved, contact changes are kept
+    APP_HID_QUEUE_COALESCE_LATEST,
+    /// Refuse the new report, the caller has to retry later
+    APP_HID_QUEUE_BLOCK,
+    /// Add relative motion to the newest pending mouse report, button edges are kept apart,
+    /// also when the queue is full
+    APP_HID_QUEUE_ACCUMULATE,
+};
+
+/// Pending report queue counters of one report instance
+struct app_hid_queue_stats
+{
+    /// Reports that had to wait for a credit
+    uint32_t queued;
+    /// Pending reports overwritten by a newer one
+    uint32_t coalesced;
+    /// Reports lost (dropped oldest or refused)
+    uint32_t dropped;
+    /// Highest number of pending reports observed
+    uint8_t  max_depth;
+    /// Reports not sent because they did not differ from the previous one
+    uint32_t suppressed;
+};
+
 /// States of the Application HID Module
 enum app_hid_states
 {
@@ -168,6 +244,67 @@ void app_hid_send_keyboard_report(uint8_t* report);
 void app_hid_send_voice_report(uint8_t* report, uint8_t len);
 void app_hid_send_report_id(uint8_t report_id, uint8_t* data, uint16_t len);
 bool is_app_hid_ready(void);
+
+/**
+ * @brief Send an Input Report, or queue it until a credit comes back
+ *
+ * @param[in]:  report_idx - Report instance (@see enum app_hid_report_idx)
+ * @param[in]:  data       - Report value
+ * @param[in]:  len        - Report length
+ *
+ * @return false if the report has been refused (APP_HID_QUEUE_BLOCK policy)
+ **/
+bool app_hid_send_report(uint8_t report_idx, const uint8_t* data, uint16_t len);
+
+/**
+ * @brief Select the overflow policy of a report instance queue
+ **/
+void app_hid_queue_set_policy(uint8_t report_idx, enum app_hid_queue_policy policy);
+
+/**
+ * @brief Number of reports waiting for a credit, all report instances included
+ **/
+uint8_t app_hid_queue_pending(void);
+
+/**
+ * @brief Read the pending report queue counters of a report instance
+ **/
+void app_hid_queue_get_stats(uint8_t report_idx, struct app_hid_queue_stats *stats);
+
+/**
+ * @brief Skip reports that do not differ from the previous one of the same instance
+ *
+ * @param[in]:  report_idx   - Report instance (@see enum app_hid_report_idx)
+ * @param[in]:  enable       - Suppression enabled
+ * @param[in]:  dead_band    - Touch report only: coordinate moves up to this value are not a change
+ * @param[in]:  keepalive_ms - An unchanged report is still sent after this time, 0 = never
+ **/
+void app_hid_suppress_config(uint8_t report_idx, bool enable, uint16_t dead_band, uint16_t keepalive_ms);
+
+/**
+ * @brief Record the interval negotiated for the current connection
+ *
+ * @param[in]:  con_interval - Connection interval (in unit of 1.25ms)
+ **/
+void app_hid_set_conn_interval(uint16_t con_interval);
+
+/**
+ * @brief Period between two generated frames, so that each connection event
+ *        carries APP_HID_FRAMES_PER_EVENT of them
+ *
+ * @return Frame period in us
+ **/
+uint32_t app_hid_get_frame_period(void);
+
+/**
+ * @brief Delay until the next generated frame. The part of the frame period below
+ *        1ms is carried over, so that frames do not drift against connection events
+ *
+ * @param[in,out]: p_carry - Time carried over by the caller (in us), 0 for the first frame
+ *
+ * @return Delay in ms
+ **/
+uint16_t app_hid_get_frame_delay(uint32_t* p_carry);
 #endif //(BLE_APP_HID)
 
 /// @} APP
@@ -0,0 +1,94 @@
+/*****************************************************************************
+ * Copyright (c) 2019, Nations Technologies Inc.
+ *
+ * All rights reserved.
+ * ****************************************************************************
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Nations' name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY NATIONS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL NATIONS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ****************************************************************************/
+
+/**
+ * @file app_rdtss.h
+ * @author Nations Firmware Team
+ * @version v1.0.0
+ *
+ * @copyright Copyright (c) 2019, Nations Technologies Inc. All rights reserved.
+ */
+
+#ifndef APP_RDTSS_H_
+#define APP_RDTSS_H_
+
+/**
+ * @addtogroup APP
+ * @ingroup RICOW
+ *
+ * @brief Raw data transfer server application, publishes the sleep and heap statistics
+ *
+ * @{
+ **/
+
+/* Includes ------------------------------------------------------------------*/
+
+#include "rwip_config.h"     // SW configuration
+
+#if (BLE_APP_RDTSS)
+
+#include <stdint.h>          // Standard Integer Definition
+#include "ke_task.h"         // Kernel Task Definition
+
+/* Public typedef -----------------------------------------------------------*/
+
+/// Attribute indexes of the raw data transfer service
+enum app_rdtss_att_idx
+{
+    RDTSS_IDX_SVC,
+    /// Sleep statistics (struct ns_sleep_stats_t), read; write 0x00 clears them
+    RDTSS_IDX_SLEEP_STATS_CHAR,
+    RDTSS_IDX_SLEEP_STATS_VAL,
+    /// Kernel heap statistics (struct ns_heap_stats_t), read; write 0x00 clears the high water marks
+    RDTSS_IDX_HEAP_STATS_CHAR,
+    RDTSS_IDX_HEAP_STATS_VAL,
+
+    RDTSS_IDX_NB,
+};
+
+/* Public variables ---------------------------------------------------------*/
+
+/// Table of message handlers
+extern const struct app_subtask_handlers app_rdtss_handlers;
+
+/* Public function prototypes -----------------------------------------------*/
+
+/**
+ * @brief Initialize raw data transfer server Application Module
+ **/
+void app_rdtss_init(void);
+
+/**
+ * @brief Add a raw data transfer service instance in the DB
+ **/
+void app_rdtss_add_rdts(void);
+
+#endif //(BLE_APP_RDTSS)
+
+/// @} APP
+
+#endif // APP_RDTSS_H_
@@ -88,6 +88,13 @@
 #define BLE_APP_BATT         0
 #endif //(CFG_APP_BATT)
 
+/// Raw Data Transfer Server Application
+#if (CFG_APP_RDTSS)
+#define BLE_APP_RDTSS        1
+#else
+#define BLE_APP_RDTSS        0
+#endif //(CFG_APP_RDTSS)
+
 /// Security Application
 #if (defined(CFG_APP_SEC) || BLE_APP_HID)
 #define BLE_APP_SEC          1
@@ -0,0 +1,134 @@
+/*****************************************************************************
+ * Copyright (c) 2019, Nations Technologies Inc.
+ *
+ * All rights reserved.
+ * ****************************************************************************
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Nations' name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY NATIONS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL NATIONS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ****************************************************************************/
+
+
+/**
+ * @file app_trajectory.h
+ * @author Nations Firmware Team
+ * @version v1.0.0
+ *
+ * @copyright Copyright (c) 2019, Nations Technologies Inc. All rights reserved.
+ */
+#ifndef __APP_TRAJECTORY_H__
+#define __APP_TRAJECTORY_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+// Q15 progress of a trajectory: 0 = start, APP_TRAJ_ONE = end
+#define APP_TRAJ_ONE            (1 << 15)
+
+// Binary angle: 0x10000 = 360 degrees, wraps naturally on uint16_t
+#define APP_TRAJ_DEG(deg)       ((uint16_t)(((int32_t)(deg) * 65536) / 360))
+
+// Speed profile along a trajectory
+enum app_traj_ease {
+    APP_TRAJ_EASE_LINEAR,               // Constant speed
+    APP_TRAJ_EASE_IN,                   // Accelerate from rest
+    APP_TRAJ_EASE_OUT,                  // Decelerate to rest
+    APP_TRAJ_EASE_IN_OUT,               // Accelerate then decelerate (smoothstep)
+};
+
+// Point in screen coordinates
+typedef struct {
+    int32_t x;
+    int32_t y;
+} app_traj_point_t;
+
+/**
+ * @brief Progress of a frame
+ * @param step Frame index (0-steps)
+ * @param steps Number of frames
+ * @return Q15 progress (0-APP_TRAJ_ONE)
+ */
+uint16_t app_traj_progress(uint8_t step, uint8_t steps);
+
+/**
+ * @brief Apply a speed profile to a progress
+ * @param ease enum app_traj_ease
+ * @param t Q15 progress (0-APP_TRAJ_ONE)
+ * @return Q15 eased progress (0-APP_TRAJ_ONE)
+ */
+uint16_t app_traj_ease(uint8_t ease, uint16_t t);
+
+/**
+ * @brief Sine of a binary angle
+ * @param angle Binary angle (0x10000 = 360 degrees)
+ * @return Q15 sine (-32767 to 32767)
+ */
+int16_t app_traj_sin(uint16_t angle);
+
+/**
+ * @brief Cosine of a binary angle
+ * @param angle Binary angle (0x10000 = 360 degrees)
+ * @return Q15 cosine (-32767 to 32767)
+ */
+int16_t app_traj_cos(uint16_t angle);
+
+/**
+ * @brief Part of a rotation covered at a given progress
+ * @param degrees Full rotation in degrees, positive = clockwise
+ * @param t Q15 progress (0-APP_TRAJ_ONE)
+ * @return Binary angle
+ */
+uint16_t app_traj_turn(int16_t degrees, uint16_t t);
+
+/**
+ * @brief Linear interpolation
+ * @param a Start value
+ * @param b End value, |b - a| must not exceed 65535
+ * @param t Q15 progress (0-APP_TRAJ_ONE)
+ */
+int32_t app_traj_lerp(int32_t a, int32_t b, uint16_t t);
+
+/**
+ * @brief Point on a circle
+ * @param center_x Center X coordinate
+ * @param center_y Center Y coordinate
+ * @param radius Circle radius
+ * @param angle Binary angle, 0 = right side, increasing clockwise on screen
+ * @param point Output point
+ */
+void app_traj_arc(uint16_t center_x, uint16_t center_y, uint16_t radius,
+                  uint16_t angle, app_traj_point_t* point);
+
+/**
+ * @brief Point on a cubic Bezier curve
+ * @param ctrl Start point, two control points and end point, in screen coordinates
+ * @param t Q15 progress (0-APP_TRAJ_ONE)
+ * @param point Output point
+ */
+void app_traj_bezier(const app_traj_point_t ctrl[4], uint16_t t, app_traj_point_t* point);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __APP_TRAJECTORY_H__ */
@@ -91,7 +91,7 @@
 //bond conifg
 #define MAX_BOND_PEER                       5
 #define BOND_STORE_ENABLE                   1
-#define BOND_DATA_BASE_ADDR                 0x0103B000
+#define BOND_DATA_BASE_ADDR                 0x0103A000  // 2 sectors, up to 0x0103C000, after app2 (NS_APP2_DEFAULT_SIZE)
 
 /* profiles config  */
 #define CFG_APP_DIS     1
@@ -103,6 +103,9 @@
 #define CFG_PRF_HOGPD   1
 #define CFG_APP_HID     1
 
+#define CFG_APP_RDTSS   1
+#define CFG_PRF_RDTSS   1
+
 // enable this patch if your MTK phone pair fail
 #define _PATCH_ENC_RESPONDSE_ 1 
 
@@ -115,10 +118,14 @@
 #define NS_LOG_DEBUG_ENABLE      0
 
 #define NS_LOG_USART_ENABLE      1
+#define NS_LOG_BIN_ENABLE        0  /* 1: binary records, decode with ns_log_decode.py */
 
 
 #define NS_TIMER_ENABLE          1
 
+/* stay out of deep sleep this long after a key press, trades current for report latency */
+#define APP_SLEEP_INPUT_HOLDOFF_MS    200
+
 #define FIRMWARE_VERSION         "1.0.0"
 #define HARDWARE_VERSION         "1.0.0"
 
@@ -42,25 +42,42 @@
 #include "app_hid.h"
 #include "app_dis.h"
 #include "app_batt.h"
+#include "app_rdtss.h"
 #if (BLE_APP_NS_IUS)
 #include "app_ns_ius.h"
 #endif //BLE_APP_NS_IUS
 #include "app_user_config.h"
+#include "ns_heap.h"
+#include "ns_timer.h"
 /** @addtogroup 
  * @{
  */
 /* Private typedef -----------------------------------------------------------*/
 /* Private define ------------------------------------------------------------*/
+/// Heap sampling period while connected (ms), a walk is too slow for the report path
+#define APP_HEAP_SAMPLE_PERIOD      (200)
 
 /* Private macro -------------------------------------------------------------*/
 /* Private variables ---------------------------------------------------------*/
 extern uint8_t key_enable;
+static timer_hnd_t app_heap_timer = NS_TIMER_INVALID_HANDLER;
 /* Private function prototypes -----------------------------------------------*/
 
 /* Private functions ---------------------------------------------------------*/
 void app_ble_connected(void);
 void app_ble_disconnected(void);
 
+/**
+ * @brief  Keep the heap high water marks while connected
+ * @param  
+ * @return 
+ * @note   
+ */
+static void app_heap_sample_timeout(timer_hnd_t timer_id, void *p_context)
+{
+    ns_heap_sample();
+}
+
 /**
  * @brief  user message handler
  * @param  
@@ -102,6 +119,7 @@ void app_ble_msg_handler(struct ble_msg_t const *p_ble_msg)
         case APP_BLE_GAP_CONNECTED:
             app_batt_enable_prf(app_env.conidx);
             app_hid_enable_prf(app_env.conidx);
+            app_hid_set_conn_interval(p_ble_msg->msg.p_connection_ind->con_interval);
 
             app_ble_connected();
             break;
@@ -114,6 +132,9 @@ void app_ble_msg_handler(struct ble_msg_t const *p_ble_msg)
                 NS_LOG_INFO("RSSI: %d dBm\r\n", rssi_ind->rssi);
             }
             break;
+        case APP_BLE_GAP_PARAMS_IND:
+            app_hid_set_conn_interval(p_ble_msg->msg.p_param_updated->con_interval);
+            break;
 
         default:
             break;
@@ -282,8 +303,12 @@ void app_ble_prf_init(void)
     ns_ble_add_prf_func_register(app_dis_add_dis);    
     //add battery level server
     ns_ble_add_prf_func_register(app_batt_add_bas);
-    //add raw data transmit server(rdts)
+    //add hid over gatt server
     ns_ble_add_prf_func_register(app_hid_add_hids);
+    #if (BLE_APP_RDTSS)
+    //add raw data transmit server(rdts), carries the sleep statistics
+    ns_ble_add_prf_func_register(app_rdtss_add_rdts);
+    #endif
     
 
     
@@ -326,6 +351,12 @@ void app_ble_connected(void)
     // Start RSSI monitoring every 2 seconds (2000 ms)
     ns_ble_active_rssi(2000);
     NS_LOG_INFO("Started RSSI monitoring\r\n");
+
+    if(app_heap_timer == NS_TIMER_INVALID_HANDLER)
+    {
+        app_heap_timer = ns_timer_start(APP_HEAP_SAMPLE_PERIOD, APP_HEAP_SAMPLE_PERIOD,
+                                        app_heap_sample_timeout, NULL);
+    }
 }
 
 /**
@@ -338,6 +369,12 @@ void app_ble_disconnected(void)
 {
     // Restart Advertising
     ns_ble_adv_start();
+    if(app_heap_timer != NS_TIMER_INVALID_HANDLER)
+    {
+        ns_timer_cancel(app_heap_timer);
+        app_heap_timer = NS_TIMER_INVALID_HANDLER;
+    }
+    ns_heap_stats_log();
     
     LedOff(LED2_PORT,LED2_PIN);
 }
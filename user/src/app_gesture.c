@@ -0,0 +1,317 @@
+/*****************************************************************************
+ * Copyright (c) 2019, Nations Technologies Inc.
+ *
+ * All rights reserved.
+ * ****************************************************************************
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Nations' name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY NATIONS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL NATIONS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ****************************************************************************/
+
+
+/**
+ * @file app_gesture.c
+ * @author Nations Firmware Team
+ * @version v1.0.0
+ *
+ * @copyright Copyright (c) 2019, Nations Technologies Inc. All rights reserved.
+ */
+
+#include "app_gesture.h"
+#include <string.h>
+#include "rwip_config.h"
+#include "ns_timer.h"
+#include "ns_log.h"
+#include "app_hid.h"
+#include "app_gesture_script.h"
+
+// Player phases
+enum app_gesture_phase {
+    APP_GESTURE_IDLE,                   // Nothing to play
+    APP_GESTURE_DOWN,                   // Fingers landing
+    APP_GESTURE_MOVE,                   // Fingers moving along their path
+    APP_GESTURE_LIFT,                   // Waiting for lift-off
+    APP_GESTURE_SCRIPT,                 // Script interpreter running
+};
+
+// Gestures waiting to be played, the head is the one being played
+static app_gesture_t gesture_queue[APP_GESTURE_QUEUE_NB];
+static uint8_t gesture_head = 0;
+static uint8_t gesture_count = 0;
+
+static uint8_t gesture_phase = APP_GESTURE_IDLE;
+// Fingers down in APP_GESTURE_DOWN phase, move frame index in APP_GESTURE_MOVE phase
+static uint8_t gesture_step = 0;
+static timer_hnd_t gesture_timer = NS_TIMER_INVALID_HANDLER;
+// Move frames follow the connection interval, time below 1ms carried to the next frame (us)
+static bool gesture_paced = false;
+static uint32_t gesture_carry = 0;
+
+static void app_gesture_tick(void);
+
+static app_gesture_send_t app_gesture_sender(const app_gesture_t* gesture)
+{
+    return (gesture->send != NULL) ? gesture->send : app_hid_send_multitouch;
+}
+
+/**
+ * @brief Compute the position of every contact at a given move frame
+ * @param gesture Gesture being played
+ * @param step Move frame index (0 = touch down position)
+ * @param touches Output touch points, gesture->contact_nb entries
+ */
+static void app_gesture_frame(const app_gesture_t* gesture, uint8_t step, hid_touch_point_t* touches)
+{
+    // Progress is computed once per frame, contacts then only multiply and shift
+    uint16_t t = app_traj_ease(gesture->ease, app_traj_progress(step, gesture->steps));
+    uint16_t turn = 0;
+
+    if (gesture->path == APP_GESTURE_PATH_ARC) {
+        turn = app_traj_turn(gesture->u.arc.angle_degrees, t);
+    }
+
+    for (uint8_t i = 0; i < gesture->contact_nb; i++) {
+        app_traj_point_t point;
+
+        if (gesture->path == APP_GESTURE_PATH_ARC) {
+            const app_gesture_arc_t* arc = &gesture->u.arc;
+            // Contacts are evenly spread on the circle and turn by the same angle
+            uint16_t angle = turn + (uint16_t)(((uint32_t)i << 16) / gesture->contact_nb);
+
+            app_traj_arc(arc->center_x, arc->center_y, arc->radius, angle, &point);
+        } else if (gesture->path == APP_GESTURE_PATH_BEZIER) {
+            const app_gesture_bezier_t* bezier = &gesture->u.bezier[i];
+            app_traj_point_t ctrl[4];
+
+            for (uint8_t j = 0; j < 4; j++) {
+                ctrl[j].x = bezier->x[j];
+                ctrl[j].y = bezier->y[j];
+            }
+            app_traj_bezier(ctrl, t, &point);
+        } else {
+            const app_gesture_line_t* line = &gesture->u.line[i];
+
+            point.x = app_traj_lerp(line->x_start, line->x_end, t);
+            point.y = app_traj_lerp(line->y_start, line->y_end, t);
+        }
+
+        touches[i].tip_switch = 1;
+        touches[i].contact_id = i;
+        touches[i].x = (point.x < 0) ? 0 : ((point.x > SCREEN_WIDTH) ? SCREEN_WIDTH : point.x);
+        touches[i].y = (point.y < 0) ? 0 : ((point.y > SCREEN_HEIGHT) ? SCREEN_HEIGHT : point.y);
+    }
+}
+
+/**
+ * @brief Spread the move duration of a gesture over connection events
+ * @param gesture Gesture about to be played
+ */
+static void app_gesture_pace(app_gesture_t* gesture)
+{
+    uint32_t duration_us = (uint32_t)gesture->steps * gesture->frame_ms * 1000;
+    uint32_t period_us = app_hid_get_frame_period();
+    uint32_t steps;
+
+    gesture_paced = false;
+    gesture_carry = 0;
+    if ((gesture->flags & APP_GESTURE_FLAG_FIXED) || (gesture->steps == 0)) {
+        return;
+    }
+
+    steps = (duration_us + period_us / 2) / period_us;
+    if (steps == 0) {
+        steps = 1;
+    } else if (steps > UINT8_MAX) {
+        steps = UINT8_MAX;
+    }
+
+    gesture->steps = steps;
+    gesture->frame_ms = (period_us + 500) / 1000;
+    gesture_paced = true;
+}
+
+/**
+ * @brief Delay until the next move frame
+ * @param gesture Gesture being played
+ */
+static uint16_t app_gesture_frame_delay(const app_gesture_t* gesture)
+{
+    return gesture_paced ? app_hid_get_frame_delay(&gesture_carry) : gesture->frame_ms;
+}
+
+/**
+ * @brief Drop every gesture, lifting the fingers of the current one if needed
+ */
+static void app_gesture_flush(void)
+{
+    if ((gesture_phase != APP_GESTURE_IDLE) && (gesture_count != 0)) {
+        app_gesture_sender(&gesture_queue[gesture_head])(NULL, 0);
+    }
+
+    gesture_head = 0;
+    gesture_count = 0;
+    gesture_phase = APP_GESTURE_IDLE;
+    gesture_step = 0;
+}
+
+/**
+ * @brief Schedule the next frame
+ */
+static void app_gesture_arm(uint16_t delay_ms)
+{
+    gesture_timer = ns_timer_create((delay_ms != 0) ? delay_ms : 1, app_gesture_tick);
+
+    if (gesture_timer == NS_TIMER_INVALID_HANDLER) {
+        NS_LOG_ERROR("Gesture: no timer available\r\n");
+        app_gesture_flush();
+    }
+}
+
+/**
+ * @brief Start the gesture at the head of the queue, if any
+ */
+static void app_gesture_next(void)
+{
+    if (gesture_count == 0) {
+        gesture_phase = APP_GESTURE_IDLE;
+        return;
+    }
+
+    if (gesture_queue[gesture_head].path == APP_GESTURE_PATH_SCRIPT) {
+        app_gesture_script_begin(&gesture_queue[gesture_head].u.script);
+        gesture_phase = APP_GESTURE_SCRIPT;
+        app_gesture_tick();
+        return;
+    }
+
+    // The interval may have changed while the gesture was waiting in the queue
+    app_gesture_pace(&gesture_queue[gesture_head]);
+    gesture_phase = APP_GESTURE_DOWN;
+    gesture_step = 0;
+    app_gesture_tick();
+}
+
+/**
+ * @brief Emit one frame of the current gesture and schedule the next one
+ */
+static void app_gesture_tick(void)
+{
+    hid_touch_point_t touches[MAX_TOUCH_POINTS];
+    const app_gesture_t* gesture = &gesture_queue[gesture_head];
+    app_gesture_send_t send = app_gesture_sender(gesture);
+    uint16_t delay_ms;
+
+    gesture_timer = NS_TIMER_INVALID_HANDLER;
+
+    switch (gesture_phase) {
+        case APP_GESTURE_DOWN:
+            gesture_step = (gesture->flags & APP_GESTURE_FLAG_STAGGER) ? (gesture_step + 1) : gesture->contact_nb;
+            app_gesture_frame(gesture, 0, touches);
+            send(touches, gesture_step);
+
+            if (gesture_step < gesture->contact_nb) {
+                delay_ms = APP_GESTURE_STAGGER_MS;
+            } else if (gesture->steps != 0) {
+                gesture_phase = APP_GESTURE_MOVE;
+                gesture_step = 0;
+                delay_ms = app_gesture_frame_delay(gesture);
+            } else {
+                gesture_phase = APP_GESTURE_LIFT;
+                delay_ms = gesture->hold_ms;
+            }
+            break;
+
+        case APP_GESTURE_MOVE:
+            gesture_step++;
+            app_gesture_frame(gesture, gesture_step, touches);
+            send(touches, gesture->contact_nb);
+
+            if (gesture_step < gesture->steps) {
+                delay_ms = app_gesture_frame_delay(gesture);
+            } else {
+                gesture_phase = APP_GESTURE_LIFT;
+                delay_ms = gesture->hold_ms;
+            }
+            break;
+
+        case APP_GESTURE_SCRIPT:
+            delay_ms = app_gesture_script_step(send);
+            if (delay_ms != APP_GESTURE_SCRIPT_DONE) {
+                break;
+            }
+            // The script has lifted its contacts itself
+            gesture_head = (gesture_head + 1) % APP_GESTURE_QUEUE_NB;
+            gesture_count--;
+            app_gesture_next();
+            return;
+
+        case APP_GESTURE_LIFT:
+            send(NULL, 0);
+            gesture_head = (gesture_head + 1) % APP_GESTURE_QUEUE_NB;
+            gesture_count--;
+            app_gesture_next();
+            return;
+
+        default:
+            return;
+    }
+
+    app_gesture_arm(delay_ms);
+}
+
+bool app_gesture_start(const app_gesture_t* gesture)
+{
+    if ((gesture == NULL)
+        || ((gesture->path == APP_GESTURE_PATH_SCRIPT)
+            ? !app_gesture_script_check(gesture->u.script.code, gesture->u.script.length)
+            : ((gesture->contact_nb == 0) || (gesture->contact_nb > MAX_TOUCH_POINTS)))) {
+        NS_LOG_WARNING("Gesture: invalid description\r\n");
+        return false;
+    }
+
+    if (gesture_count == APP_GESTURE_QUEUE_NB) {
+        NS_LOG_WARNING("Gesture: queue full\r\n");
+        return false;
+    }
+
+    memcpy(&gesture_queue[(gesture_head + gesture_count) % APP_GESTURE_QUEUE_NB], gesture, sizeof(app_gesture_t));
+    gesture_count++;
+
+    if (gesture_phase == APP_GESTURE_IDLE) {
+        app_gesture_next();
+    }
+
+    return true;
+}
+
+void app_gesture_cancel(void)
+{
+    if (gesture_timer != NS_TIMER_INVALID_HANDLER) {
+        ns_timer_cancel(gesture_timer);
+        gesture_timer = NS_TIMER_INVALID_HANDLER;
+    }
+
+    app_gesture_flush();
+}
+
+bool app_gesture_is_busy(void)
+{
+    return (gesture_phase != APP_GESTURE_IDLE);
+}
@@ -0,0 +1,540 @@
+/*****************************************************************************
+ * Copyright (c) 2019, Nations Technologies Inc.
+ *
+ * All rights reserved.
+ * ****************************************************************************
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Nations' name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY NATIONS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL NATIONS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ****************************************************************************/
+
+
+/**
+ * @file app_gesture_script.c
+ * @author Nations Firmware Team
+ * @version v1.0.0
+ *
+ * @copyright Copyright (c) 2019, Nations Technologies Inc. All rights reserved.
+ */
+
+#include "app_gesture_script.h"
+#include <string.h>
+#include "rwip_config.h"
+#include "ns_log.h"
+#include "app_hid.h"
+
+// Largest number of int16 values of an instruction
+#define APP_GS_VAL_MAX      6
+
+// Contact states
+enum app_gs_contact_state {
+    APP_GS_CONTACT_UP,                  // Not in the report
+    APP_GS_CONTACT_DOWN,                // Touching
+    APP_GS_CONTACT_LIFTING,             // Reported once more with the tip switch cleared
+};
+
+// Contact paths
+enum app_gs_contact_path {
+    APP_GS_PATH_NONE,
+    APP_GS_PATH_LINE,
+    APP_GS_PATH_ARC,
+    APP_GS_PATH_CURVE,
+};
+
+// Instruction layout: byte field present, number of values
+typedef struct {
+    uint8_t has_byte;
+    uint8_t val_nb;
+} app_gs_layout_t;
+
+// Decoded instruction, values already resolved
+typedef struct {
+    uint8_t op;
+    uint8_t byte;
+    int16_t val[APP_GS_VAL_MAX];
+} app_gs_insn_t;
+
+typedef struct {
+    uint8_t state;
+    uint8_t path;
+    app_traj_point_t pos;
+    // Line: ctrl[0] -> ctrl[3], curve: ctrl[0..3], arc: ctrl[0] = center
+    app_traj_point_t ctrl[4];
+    uint16_t radius;
+    uint16_t start;                     // Binary angle
+    int16_t  turn;                      // Degrees
+} app_gs_contact_t;
+
+static const app_gs_layout_t gs_layout[APP_GS_OP_MAX] = {
+    [APP_GS_OP_END]   = {0, 0},
+    [APP_GS_OP_DOWN]  = {1, 2},
+    [APP_GS_OP_UP]    = {1, 0},
+    [APP_GS_OP_MOVE]  = {1, 2},
+    [APP_GS_OP_ARC]   = {1, 5},
+    [APP_GS_OP_CURVE] = {1, 6},
+    [APP_GS_OP_PLAY]  = {1, 1},
+    [APP_GS_OP_SYNC]  = {0, 0},
+    [APP_GS_OP_WAIT]  = {0, 1},
+    [APP_GS_OP_SET]   = {1, 1},
+    [APP_GS_OP_ADD]   = {1, 1},
+    [APP_GS_OP_SUB]   = {1, 1},
+    [APP_GS_OP_RAND]  = {1, 1},
+    [APP_GS_OP_LOOP]  = {0, 1},
+    [APP_GS_OP_NEXT]  = {0, 0},
+};
+
+// Interpreter state, one script runs at a time
+static const uint8_t* gs_code;
+static uint16_t gs_pc;
+static int16_t gs_reg[APP_GS_REG_NB];
+static struct {
+    uint16_t pc;                        // First instruction of the body
+    int16_t  count;                     // Remaining runs
+} gs_loop[APP_GS_LOOP_NB];
+static uint8_t gs_loop_nb;
+static app_gs_contact_t gs_contact[MAX_TOUCH_POINTS];
+// PLAY in progress
+static uint8_t gs_ease;
+static uint8_t gs_step;
+static uint8_t gs_steps;
+static uint32_t gs_frame_carry;
+static uint32_t gs_seed = 12345;
+
+// Script received through the upload report
+static uint8_t gs_upload[APP_GS_UPLOAD_MAX_LEN];
+static uint16_t gs_upload_len;
+static uint16_t gs_upload_expected;
+
+static bool app_gs_is_reg(int16_t raw)
+{
+    return (raw >= APP_GS_R(0)) && (raw < APP_GS_R(APP_GS_REG_NB));
+}
+
+static int16_t app_gs_saturate(int32_t value)
+{
+    return (value > INT16_MAX) ? INT16_MAX : ((value < INT16_MIN) ? INT16_MIN : (int16_t)value);
+}
+
+/**
+ * @brief Size of an instruction
+ * @return 0 if the opcode is unknown
+ */
+static uint8_t app_gs_size(uint8_t op)
+{
+    if (op >= APP_GS_OP_MAX) {
+        return 0;
+    }
+
+    return 1 + gs_layout[op].has_byte + 2 * gs_layout[op].val_nb;
+}
+
+/**
+ * @brief Decode the instruction at gs_pc and move gs_pc to the next one
+ */
+static void app_gs_fetch(app_gs_insn_t* insn)
+{
+    const uint8_t* p = &gs_code[gs_pc];
+
+    insn->op = *p++;
+    insn->byte = gs_layout[insn->op].has_byte ? *p++ : 0;
+
+    for (uint8_t i = 0; i < gs_layout[insn->op].val_nb; i++) {
+        int16_t raw = (int16_t)(p[0] | (p[1] << 8));
+
+        insn->val[i] = app_gs_is_reg(raw) ? gs_reg[raw - APP_GS_R(0)] : raw;
+        p += 2;
+    }
+
+    gs_pc += app_gs_size(insn->op);
+}
+
+static int16_t app_gs_random(int16_t range)
+{
+    if (range <= 0) {
+        return 0;
+    }
+
+    gs_seed = gs_seed * 1103515245 + 12345;
+    return (int16_t)((gs_seed / 65536) % range) - (range / 2);
+}
+
+/**
+ * @brief Position of a contact on its path
+ */
+static void app_gs_position(app_gs_contact_t* contact, uint16_t t)
+{
+    switch (contact->path) {
+        case APP_GS_PATH_LINE:
+            contact->pos.x = app_traj_lerp(contact->ctrl[0].x, contact->ctrl[3].x, t);
+            contact->pos.y = app_traj_lerp(contact->ctrl[0].y, contact->ctrl[3].y, t);
+            break;
+
+        case APP_GS_PATH_ARC:
+            app_traj_arc(contact->ctrl[0].x, contact->ctrl[0].y, contact->radius,
+                         contact->start + app_traj_turn(contact->turn, t), &contact->pos);
+            break;
+
+        case APP_GS_PATH_CURVE:
+            app_traj_bezier(contact->ctrl, t, &contact->pos);
+            break;
+
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief Send the contacts state, lifted contacts are reported once with the tip switch cleared
+ */
+static void app_gs_emit(app_gesture_send_t send)
+{
+    hid_touch_point_t touches[MAX_TOUCH_POINTS];
+    uint8_t count = 0;
+
+    for (uint8_t i = 0; i < MAX_TOUCH_POINTS; i++) {
+        app_gs_contact_t* contact = &gs_contact[i];
+
+        if (contact->state == APP_GS_CONTACT_UP) {
+            continue;
+        }
+
+        touches[count].tip_switch = (contact->state == APP_GS_CONTACT_DOWN);
+        touches[count].contact_id = i;
+        touches[count].x = (contact->pos.x < 0) ? 0 : ((contact->pos.x > SCREEN_WIDTH) ? SCREEN_WIDTH : contact->pos.x);
+        touches[count].y = (contact->pos.y < 0) ? 0 : ((contact->pos.y > SCREEN_HEIGHT) ? SCREEN_HEIGHT : contact->pos.y);
+        count++;
+
+        if (contact->state == APP_GS_CONTACT_LIFTING) {
+            contact->state = APP_GS_CONTACT_UP;
+        }
+    }
+
+    send((count != 0) ? touches : NULL, count);
+}
+
+/**
+ * @brief Set the path of a contact, starting from its current position
+ */
+static void app_gs_set_path(const app_gs_insn_t* insn)
+{
+    app_gs_contact_t* contact = &gs_contact[insn->byte];
+
+    contact->ctrl[0] = contact->pos;
+
+    switch (insn->op) {
+        case APP_GS_OP_MOVE:
+            contact->path = APP_GS_PATH_LINE;
+            contact->ctrl[3].x = insn->val[0];
+            contact->ctrl[3].y = insn->val[1];
+            break;
+
+        case APP_GS_OP_ARC:
+            contact->path = APP_GS_PATH_ARC;
+            contact->ctrl[0].x = insn->val[0];
+            contact->ctrl[0].y = insn->val[1];
+            contact->radius = (insn->val[2] > 0) ? insn->val[2] : 0;
+            contact->start = APP_TRAJ_DEG(insn->val[3]);
+            contact->turn = insn->val[4];
+            break;
+
+        default:
+            contact->path = APP_GS_PATH_CURVE;
+            for (uint8_t i = 0; i < 3; i++) {
+                contact->ctrl[i + 1].x = insn->val[2 * i];
+                contact->ctrl[i + 1].y = insn->val[2 * i + 1];
+            }
+            break;
+    }
+}
+
+/**
+ * @brief Emit the next PLAY frame
+ * @return true once the last frame has been sent
+ */
+static bool app_gs_frame(app_gesture_send_t send)
+{
+    uint16_t t;
+
+    gs_step++;
+    t = app_traj_ease(gs_ease, app_traj_progress(gs_step, gs_steps));
+
+    for (uint8_t i = 0; i < MAX_TOUCH_POINTS; i++) {
+        app_gs_position(&gs_contact[i], t);
+    }
+    app_gs_emit(send);
+
+    if (gs_step < gs_steps) {
+        return false;
+    }
+
+    for (uint8_t i = 0; i < MAX_TOUCH_POINTS; i++) {
+        gs_contact[i].path = APP_GS_PATH_NONE;
+    }
+    gs_steps = 0;
+    return true;
+}
+
+bool app_gesture_script_check(const uint8_t* code, uint16_t length)
+{
+    uint16_t pc = 0;
+    uint8_t depth = 0;
+
+    if (code == NULL) {
+        return false;
+    }
+
+    while (pc < length) {
+        uint8_t op = code[pc];
+        uint8_t size = app_gs_size(op);
+
+        if ((size == 0) || (pc + size > length)) {
+            return false;
+        }
+
+        if (gs_layout[op].has_byte) {
+            uint8_t byte = code[pc + 1];
+
+            if ((op >= APP_GS_OP_SET) && (op <= APP_GS_OP_RAND)) {
+                if (byte >= APP_GS_REG_NB) {
+                    return false;
+                }
+            } else if (op == APP_GS_OP_PLAY) {
+                if (byte > APP_TRAJ_EASE_IN_OUT) {
+                    return false;
+                }
+            } else if (byte >= MAX_TOUCH_POINTS) {
+                return false;
+            }
+        }
+
+        if (op == APP_GS_OP_LOOP) {
+            if (++depth > APP_GS_LOOP_NB) {
+                return false;
+            }
+        } else if (op == APP_GS_OP_NEXT) {
+            if (depth-- == 0) {
+                return false;
+            }
+        } else if (op == APP_GS_OP_END) {
+            return (depth == 0);
+        }
+
+        pc += size;
+    }
+
+    // No END
+    return false;
+}
+
+bool app_gesture_script_play(const uint8_t* code, uint16_t length, const int16_t* arg, uint8_t arg_nb)
+{
+    app_gesture_t gesture;
+
+    if ((arg_nb > APP_GESTURE_SCRIPT_ARG_NB) || ((arg == NULL) && (arg_nb != 0))) {
+        return false;
+    }
+
+    memset(&gesture, 0, sizeof(gesture));
+    gesture.path = APP_GESTURE_PATH_SCRIPT;
+    gesture.u.script.code = code;
+    gesture.u.script.length = length;
+    for (uint8_t i = 0; i < arg_nb; i++) {
+        gesture.u.script.arg[i] = arg[i];
+    }
+
+    return app_gesture_start(&gesture);
+}
+
+void app_gesture_script_upload(const uint8_t* data, uint16_t length)
+{
+    if (length == 0) {
+        return;
+    }
+
+    switch (data[0]) {
+        case APP_GS_UPLOAD_BEGIN:
+            // The buffer may be read by a queued script until the player is idle
+            if ((length < 3) || app_gesture_is_busy()) {
+                NS_LOG_WARNING("Gesture script: upload refused\r\n");
+                gs_upload_expected = 0;
+                break;
+            }
+            gs_upload_expected = data[1] | (data[2] << 8);
+            gs_upload_len = 0;
+            if (gs_upload_expected > APP_GS_UPLOAD_MAX_LEN) {
+                NS_LOG_WARNING("Gesture script: %d bytes too long\r\n", gs_upload_expected);
+                gs_upload_expected = 0;
+            }
+            break;
+
+        case APP_GS_UPLOAD_DATA:
+            if ((length < 2) || (data[1] > length - 2) || (gs_upload_len + data[1] > gs_upload_expected)) {
+                NS_LOG_WARNING("Gesture script: bad chunk\r\n");
+                gs_upload_expected = 0;
+                break;
+            }
+            memcpy(&gs_upload[gs_upload_len], &data[2], data[1]);
+            gs_upload_len += data[1];
+            break;
+
+        case APP_GS_UPLOAD_RUN:
+        {
+            int16_t arg[APP_GESTURE_SCRIPT_ARG_NB];
+            uint8_t arg_nb = (length >= 2) ? data[1] : 0;
+
+            if ((gs_upload_expected == 0) || (gs_upload_len != gs_upload_expected)
+                || (arg_nb > APP_GESTURE_SCRIPT_ARG_NB) || (length < 2 + 2 * arg_nb)
+                || !app_gesture_script_check(gs_upload, gs_upload_len)) {
+                NS_LOG_WARNING("Gesture script: nothing valid to run\r\n");
+                break;
+            }
+            for (uint8_t i = 0; i < arg_nb; i++) {
+                arg[i] = (int16_t)(data[2 + 2 * i] | (data[3 + 2 * i] << 8));
+            }
+            app_gesture_script_play(gs_upload, gs_upload_len, arg, arg_nb);
+            break;
+        }
+
+        default:
+            break;
+    }
+}
+
+void app_gesture_script_begin(const app_gesture_script_t* script)
+{
+    gs_code = script->code;
+    gs_pc = 0;
+    gs_loop_nb = 0;
+    gs_steps = 0;
+
+    memset(gs_reg, 0, sizeof(gs_reg));
+    memcpy(gs_reg, script->arg, sizeof(script->arg));
+    memset(gs_contact, 0, sizeof(gs_contact));
+}
+
+uint16_t app_gesture_script_step(app_gesture_send_t send)
+{
+    app_gs_insn_t insn;
+
+    if ((gs_steps != 0) && !app_gs_frame(send)) {
+        return app_hid_get_frame_delay(&gs_frame_carry);
+    }
+
+    for (uint8_t budget = 0; budget < APP_GS_STEP_BUDGET; budget++) {
+        // Checked by app_gesture_script_check(), END is always reached first
+        app_gs_fetch(&insn);
+
+        switch (insn.op) {
+            case APP_GS_OP_DOWN:
+                gs_contact[insn.byte].state = APP_GS_CONTACT_DOWN;
+                gs_contact[insn.byte].path = APP_GS_PATH_NONE;
+                gs_contact[insn.byte].pos.x = insn.val[0];
+                gs_contact[insn.byte].pos.y = insn.val[1];
+                break;
+
+            case APP_GS_OP_UP:
+                if (gs_contact[insn.byte].state == APP_GS_CONTACT_DOWN) {
+                    gs_contact[insn.byte].state = APP_GS_CONTACT_LIFTING;
+                }
+                break;
+
+            case APP_GS_OP_MOVE:
+            case APP_GS_OP_ARC:
+            case APP_GS_OP_CURVE:
+                app_gs_set_path(&insn);
+                break;
+
+            case APP_GS_OP_PLAY:
+            {
+                uint32_t duration_us = (insn.val[0] > 0) ? (uint32_t)insn.val[0] * 1000 : 0;
+                uint32_t period_us = app_hid_get_frame_period();
+                uint32_t steps;
+
+                steps = (duration_us + period_us / 2) / period_us;
+                gs_steps = (steps == 0) ? 1 : ((steps > UINT8_MAX) ? UINT8_MAX : steps);
+                gs_step = 0;
+                gs_ease = insn.byte;
+                gs_frame_carry = 0;
+                return app_hid_get_frame_delay(&gs_frame_carry);
+            }
+
+            case APP_GS_OP_SYNC:
+                app_gs_emit(send);
+                break;
+
+            case APP_GS_OP_WAIT:
+                if (insn.val[0] > 0) {
+                    return insn.val[0];
+                }
+                break;
+
+            case APP_GS_OP_SET:
+                gs_reg[insn.byte] = insn.val[0];
+                break;
+
+            case APP_GS_OP_ADD:
+                gs_reg[insn.byte] = app_gs_saturate((int32_t)gs_reg[insn.byte] + insn.val[0]);
+                break;
+
+            case APP_GS_OP_SUB:
+                gs_reg[insn.byte] = app_gs_saturate((int32_t)gs_reg[insn.byte] - insn.val[0]);
+                break;
+
+            case APP_GS_OP_RAND:
+                gs_reg[insn.byte] = app_gs_saturate((int32_t)gs_reg[insn.byte] + app_gs_random(insn.val[0]));
+                break;
+
+            case APP_GS_OP_LOOP:
+                // A count below 1 still runs the body once
+                gs_loop[gs_loop_nb].pc = gs_pc;
+                gs_loop[gs_loop_nb].count = insn.val[0];
+                gs_loop_nb++;
+                break;
+
+            case APP_GS_OP_NEXT:
+                if (--gs_loop[gs_loop_nb - 1].count > 0) {
+                    gs_pc = gs_loop[gs_loop_nb - 1].pc;
+                } else {
+                    gs_loop_nb--;
+                }
+                break;
+
+            default:
+            {
+                bool touching = false;
+
+                // END: whatever is still down is lifted
+                for (uint8_t i = 0; i < MAX_TOUCH_POINTS; i++) {
+                    if (gs_contact[i].state != APP_GS_CONTACT_UP) {
+                        gs_contact[i].state = APP_GS_CONTACT_LIFTING;
+                        touching = true;
+                    }
+                }
+                if (touching) {
+                    app_gs_emit(send);
+                }
+                return APP_GESTURE_SCRIPT_DONE;
+            }
+        }
+    }
+
+    // Long run without any delay, give the stack some time
+    return 1;
+}
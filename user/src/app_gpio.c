@@ -41,6 +41,7 @@
 #include "ns_log.h"
 #include "ns_timer.h"
 #include "ns_delay.h"
+#include "ns_sleep.h"
 #include "app_ble.h"
 /** @addtogroup 
  * @{
@@ -48,6 +49,7 @@
 /* Private typedef -----------------------------------------------------------*/
 /* Private define ------------------------------------------------------------*/
 #define KEY_PRESS_DELAY 100
+#define APP_SLEEP_HOLDER_KEY    NS_SLEEP_HOLDER_USER    // debounce busy waits
 /* Private macro -------------------------------------------------------------*/
 /* Private variables ---------------------------------------------------------*/
 uint8_t key1_irq_actived = 0;
@@ -418,6 +420,15 @@ void app_key_press_timeout_handler(void)
  */
 void EXTI4_12_IRQHandler(void)
 {
+	// also called for the BLE wakeup line, only key lines count as user input
+	uint8_t key_line = (EXTI_GetITStatus(KEY1_INPUT_EXTI_LINE) != RESET)
+	                || (EXTI_GetITStatus(KEY2_INPUT_EXTI_LINE) != RESET)
+	                || (EXTI_GetITStatus(KEY3_INPUT_EXTI_LINE) != RESET);
+
+	if(key_line){
+		ns_sleep_input_event();
+		ns_sleep_lock_acquire_by(APP_SLEEP_HOLDER_KEY);
+	}
 	if(key_enable != 0){
 		if ( EXTI_GetITStatus(KEY1_INPUT_EXTI_LINE)!= RESET)
 			{
@@ -498,6 +509,9 @@ void EXTI4_12_IRQHandler(void)
 					EXTI_ClrITPendBit(KEY3_INPUT_EXTI_LINE);
 			}
 	}		
+	if(key_line){
+		ns_sleep_lock_release_by(APP_SLEEP_HOLDER_KEY);
+	}
 }
 
 
@@ -36,7 +36,6 @@
 #include "app_hid_keyboard.h"
 #include <string.h>
 #include "app_hid.h"
-#include "ns_delay.h"
 #include "ns_log.h"
 
 /**
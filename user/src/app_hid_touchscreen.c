@@ -35,17 +35,10 @@
 
 #include "app_hid_touchscreen.h"
 #include <string.h>
-#include <math.h>
 #include "app_profile/app_hid.h"
-#include "ns_delay.h"
+#include "app_gesture.h"
+#include "app_gesture_script.h"
 #include "ns_log.h"
-#include "hogp/hogpd/api/hogpd_task.h"
-#include "prf.h"
-#include "ke_msg.h"
-#include "co_utils.h"
-
-// External HID environment
-extern struct app_hid_env_tag app_hid_env;
 
 /**
  * @brief Send multi-touch screen report via HID (supports 1-3 touches)
@@ -56,16 +49,11 @@ void app_hid_send_multitouch(const hid_touch_point_t* touches, uint8_t count)
 {
     NS_LOG_INFO("Multi-touch: count=%d\r\n", count);
 
-    if (app_hid_env.state != APP_HID_READY) {
+    if (!is_app_hid_ready()) {
         NS_LOG_WARNING("HID not ready for touchscreen\r\n");
         return;
     }
 
-    if (app_hid_env.nb_report == 0) {
-        NS_LOG_WARNING("No reports available for touchscreen\r\n");
-        return;
-    }
-
     // Validate count
     if (count > MAX_TOUCH_POINTS) {
         NS_LOG_WARNING("Too many touch points: %d (max %d)\r\n", count, MAX_TOUCH_POINTS);
@@ -107,26 +95,11 @@ void app_hid_send_multitouch(const hid_touch_point_t* touches, uint8_t count)
     // Last byte: Contact count
     
 
-    // Send the report using the HID profile
-    struct hogpd_report_upd_req * req = KE_MSG_ALLOC_DYN(HOGPD_REPORT_UPD_REQ,
-                                                      prf_get_task_from_id(TASK_ID_HOGPD),
-                                                      TASK_APP,
-                                                      hogpd_report_upd_req,
-                                                      APP_HID_MULTITOUCH_REPORT_LEN);
-
-    req->conidx = app_hid_env.conidx;
-    req->report.hid_idx = app_hid_env.conidx;
-    req->report.type = HOGPD_REPORT;
-    req->report.idx = 3;  // Report index 3 for Report ID 4
-    req->report.length = APP_HID_MULTITOUCH_REPORT_LEN;
-
-    memcpy(&req->report.value[0], report, APP_HID_MULTITOUCH_REPORT_LEN);
-
     NS_LOG_DEBUG("Sending multi-touch report to HOGPD: idx=%d, len=%d\r\n",
-                 req->report.idx, req->report.length);
+                 APP_HID_TOUCH_REPORT_IDX, APP_HID_MULTITOUCH_REPORT_LEN);
 
-    ke_msg_send(req);
-    app_hid_env.nb_report--;
+    // Send the report using the HID profile, queued if no credit is left
+    app_hid_send_report(APP_HID_TOUCH_REPORT_IDX, report, APP_HID_MULTITOUCH_REPORT_LEN);
 }
 
 /**
@@ -167,14 +140,20 @@ void app_hid_send_touchscreen(uint8_t contact_id, uint8_t is_touching,
  */
 void app_touchscreen_tap(uint16_t x, uint16_t y)
 {
+    app_gesture_t gesture;
+
     NS_LOG_INFO("Touchscreen TAP at (%d, %d)\r\n", x, y);
 
-    // Touch down
-    app_hid_send_touchscreen(0, 1, x, y, 100);
-    delay_n_ms(50);
+    // Touch down, hold 50ms, touch up
+    memset(&gesture, 0, sizeof(gesture));
+    gesture.path = APP_GESTURE_PATH_LINE;
+    gesture.contact_nb = 1;
+    gesture.steps = 0;
+    gesture.hold_ms = 50;
+    gesture.u.line[0].x_start = gesture.u.line[0].x_end = x;
+    gesture.u.line[0].y_start = gesture.u.line[0].y_end = y;
 
-    // Touch up
-    app_hid_send_touchscreen(0, 0, x, y, 0);
+    app_gesture_start(&gesture);
 }
 
 /**
@@ -187,33 +166,21 @@ void app_touchscreen_swipe(uint16_t x_start, uint16_t y_start,
     NS_LOG_INFO("Touchscreen SWIPE from (%d,%d) to (%d,%d)\r\n",
                 x_start, y_start, x_end, y_end);
 
-    uint8_t steps = 10;
-    uint16_t delay_per_step = duration_ms / steps;
-
-    int16_t x_step = (x_end - x_start) / steps;
-    int16_t y_step = (y_end - y_start) / steps;
-
-    uint16_t current_x = x_start;
-    uint16_t current_y = y_start;
-
-    // Touch down
-    app_hid_send_touchscreen(0, 1, current_x, current_y, 100);
-
-    // Move through intermediate points
-    for (uint8_t i = 1; i < steps; i++) {
-        current_x += x_step;
-        current_y += y_step;
-        app_hid_send_touchscreen(0, 1, current_x, current_y, 100);
-        delay_n_ms(delay_per_step);
-    }
-
-    // Final position
-    app_hid_send_touchscreen(0, 1, x_end, y_end, 100);
-
-    delay_n_ms(10);
-
-    // Touch up
-    app_hid_send_touchscreen(0, 0, x_end, y_end, 100);
+    app_gesture_t gesture;
+
+    // Touch down, 10 moves up to the final position, touch up 10ms later
+    memset(&gesture, 0, sizeof(gesture));
+    gesture.path = APP_GESTURE_PATH_LINE;
+    gesture.contact_nb = 1;
+    gesture.steps = 10;
+    gesture.frame_ms = duration_ms / gesture.steps;
+    gesture.hold_ms = 10;
+    gesture.u.line[0].x_start = x_start;
+    gesture.u.line[0].y_start = y_start;
+    gesture.u.line[0].x_end = x_end;
+    gesture.u.line[0].y_end = y_end;
+
+    app_gesture_start(&gesture);
 }
 
 void app_touchscreen_multi(uint8_t finger_count,
@@ -251,55 +218,30 @@ void app_multi_touchscreen_swipe(uint16_t count,uint16_t* x_start, uint16_t* y_s
 {
     NS_LOG_INFO("multiTouchscreen SWIPE");
 
-    uint8_t steps = 10;
-    uint16_t delay_per_step = duration_ms / steps;
-	
-		int16_t x_step[10];
-    int16_t y_step[10];
-		uint16_t current_x[3];
-    uint16_t current_y[3];
-		
-		for(int i=0; i<count; i++){
-			x_step[i] = (x_end[i] - x_start[i]) / steps;
-      y_step[i] = (y_end[i] - y_start[i]) / steps;
-		}
-
-		for(int i=0; i<count; i++){
-			current_x[i] = x_start[i];
-			current_y[i] = y_start[i];
-		}
-	
-    // Touch down
-		app_hid_send_multitouch(NULL, 0);
-		delay_n_ms(10);
-		
-		for(int i=0; i<count; i++){
-			app_touchscreen_multi(i+1,x_start,y_start);
-			delay_n_ms(10);
-		}
-		
-    // Move through intermediate points
-    for (uint8_t i = 1; i < steps; i++) {
-				for(int i=0; i<count; i++){
-					current_x[i] += x_step[i];
-					current_y[i] += y_step[i];
-				}
-        app_touchscreen_multi(count,current_x,current_y);
-        delay_n_ms(delay_per_step);
+    app_gesture_t gesture;
+
+    if (count == 0 || count > MAX_TOUCH_POINTS) {
+        NS_LOG_WARNING("Invalid finger count: %d\r\n", count);
+        return;
+    }
+
+    // Fingers land one by one, move together in 10 steps, lift 10ms after the end
+    memset(&gesture, 0, sizeof(gesture));
+    gesture.path = APP_GESTURE_PATH_LINE;
+    gesture.contact_nb = count;
+    gesture.steps = 10;
+    gesture.flags = APP_GESTURE_FLAG_STAGGER;
+    gesture.frame_ms = duration_ms / gesture.steps;
+    gesture.hold_ms = 10;
+
+    for (uint8_t i = 0; i < count; i++) {
+        gesture.u.line[i].x_start = x_start[i];
+        gesture.u.line[i].y_start = y_start[i];
+        gesture.u.line[i].x_end = x_end[i];
+        gesture.u.line[i].y_end = y_end[i];
     }
 
-    // Final position
-    app_touchscreen_multi(count,x_end,y_end);
-    delay_n_ms(10);
-
-    // Touch up
-//		for(int i=count-1; i>=0; i--){
-//			app_touchscreen_multi(i,x_end,y_end);
-//			delay_n_ms(10);
-//		}
-		
-		app_hid_send_multitouch(NULL, 0);
-		//app_hid_send_multitouch(NULL, 0);
+    app_gesture_start(&gesture);
 }
 
 /**
@@ -319,22 +261,21 @@ void app_touchscreen_multi_tap(uint8_t finger_count,
 
     NS_LOG_INFO("Multi-tap with %d fingers\r\n", finger_count);
 
-    hid_touch_point_t touches[MAX_TOUCH_POINTS];
+    app_gesture_t gesture;
+
+    // Touch down all fingers simultaneously, hold 100ms, touch up all fingers
+    memset(&gesture, 0, sizeof(gesture));
+    gesture.path = APP_GESTURE_PATH_LINE;
+    gesture.contact_nb = finger_count;
+    gesture.steps = 0;
+    gesture.hold_ms = 100;
 
-    // Prepare touch points
     for (uint8_t i = 0; i < finger_count; i++) {
-        touches[i].tip_switch = 1;
-        touches[i].contact_id = i;
-        touches[i].x = (x_coords[i] > SCREEN_WIDTH) ? SCREEN_WIDTH : x_coords[i];
-        touches[i].y = (y_coords[i] > SCREEN_HEIGHT) ? SCREEN_HEIGHT : y_coords[i];
+        gesture.u.line[i].x_start = gesture.u.line[i].x_end = x_coords[i];
+        gesture.u.line[i].y_start = gesture.u.line[i].y_end = y_coords[i];
     }
 
-    // Touch down all fingers simultaneously
-    app_hid_send_multitouch(touches, finger_count);
-    delay_n_ms(100);
-
-    // Touch up all fingers
-    app_hid_send_multitouch(NULL, 0);
+    app_gesture_start(&gesture);
 }
 
 /**
@@ -352,40 +293,24 @@ void app_touchscreen_pinch(uint16_t center_x, uint16_t center_y,
     NS_LOG_INFO("Pinch gesture at (%d,%d), distance %d->%d\r\n",
                 center_x, center_y, start_distance, end_distance);
 
-    uint8_t steps = 10;
-    uint16_t delay_per_step = duration_ms / steps;
-    int16_t distance_step = (end_distance - start_distance) / steps;
+    app_gesture_t gesture;
 
-    hid_touch_point_t touches[2];
-
-    // Initialize two fingers
-    touches[0].tip_switch = 1;
-    touches[0].contact_id = 0;
-    touches[1].tip_switch = 1;
-    touches[1].contact_id = 1;
-
-    // Perform pinch gesture with real multi-touch
-    for (uint8_t i = 0; i <= steps; i++) {
-        uint16_t current_distance = start_distance + (distance_step * i);
-
-        // Position fingers horizontally around center
-        touches[0].x = (center_x > current_distance/2) ? center_x - current_distance/2 : 0;
-        touches[0].y = center_y;
-        touches[1].x = (center_x + current_distance/2 > SCREEN_WIDTH) ? SCREEN_WIDTH : center_x + current_distance/2;
-        touches[1].y = center_y;
-
-        // Send both touches simultaneously
-        app_hid_send_multitouch(touches, 2);
-
-        if (i < steps) {
-            delay_n_ms(delay_per_step);
-        }
-    }
+    // Two fingers placed horizontally around the center, 10 steps, lift 50ms after the end
+    memset(&gesture, 0, sizeof(gesture));
+    gesture.path = APP_GESTURE_PATH_LINE;
+    gesture.contact_nb = 2;
+    gesture.steps = 10;
+    gesture.frame_ms = duration_ms / gesture.steps;
+    gesture.hold_ms = 50;
 
-    delay_n_ms(50);
+    gesture.u.line[0].x_start = (center_x > start_distance/2) ? center_x - start_distance/2 : 0;
+    gesture.u.line[0].x_end = (center_x > end_distance/2) ? center_x - end_distance/2 : 0;
+    gesture.u.line[1].x_start = (center_x + start_distance/2 > SCREEN_WIDTH) ? SCREEN_WIDTH : center_x + start_distance/2;
+    gesture.u.line[1].x_end = (center_x + end_distance/2 > SCREEN_WIDTH) ? SCREEN_WIDTH : center_x + end_distance/2;
+    gesture.u.line[0].y_start = gesture.u.line[0].y_end = center_y;
+    gesture.u.line[1].y_start = gesture.u.line[1].y_end = center_y;
 
-    // Release both fingers
-    app_hid_send_multitouch(NULL, 0);
+    app_gesture_start(&gesture);
 }
 
 /**
@@ -403,65 +328,106 @@ void app_touchscreen_rotate(uint16_t center_x, uint16_t center_y,
     NS_LOG_INFO("Rotate gesture at (%d,%d), radius %d, angle %d deg\r\n",
                 center_x, center_y, radius, angle_degrees);
 
-    uint8_t steps = 20;
-    uint16_t delay_per_step = duration_ms / steps;
-    float angle_step_radians = (angle_degrees * 3.14159f / 180.0f) / steps;
-
-    hid_touch_point_t touches[2];
-
-    // Initialize two fingers
-    touches[0].tip_switch = 1;
-    touches[0].contact_id = 0;
-    touches[1].tip_switch = 1;
-    touches[1].contact_id = 1;
-
-    // Perform rotate gesture with real multi-touch
-    for (uint8_t i = 0; i <= steps; i++) {
-        // Current rotation angle for this step
-        float current_angle = angle_step_radians * i;
-
-        // Finger 1: starts at 0 degrees (right side), rotates by current_angle
-        // In screen coordinates: X+ is right, Y+ is down
-        // Positive angle = clockwise rotation
-        float angle1 = current_angle;
-        int16_t x1 = center_x + (int16_t)(radius * cosf(angle1));
-        int16_t y1 = center_y + (int16_t)(radius * sinf(angle1));
-
-        // Finger 2: starts at 180 degrees (left side), rotates by same angle
-        float angle2 = 3.14159f + current_angle;
-        int16_t x2 = center_x + (int16_t)(radius * cosf(angle2));
-        int16_t y2 = center_y + (int16_t)(radius * sinf(angle2));
-
-        // Clamp to valid range
-        touches[0].x = (x1 < 0) ? 0 : ((x1 > SCREEN_WIDTH) ? SCREEN_WIDTH : x1);
-        touches[0].y = (y1 < 0) ? 0 : ((y1 > SCREEN_HEIGHT) ? SCREEN_HEIGHT : y1);
-        touches[1].x = (x2 < 0) ? 0 : ((x2 > SCREEN_WIDTH) ? SCREEN_WIDTH : x2);
-        touches[1].y = (y2 < 0) ? 0 : ((y2 > SCREEN_HEIGHT) ? SCREEN_HEIGHT : y2);
-
-        // Send both touches simultaneously
-        app_hid_send_multitouch(touches, 2);
-
-        if (i < steps) {
-            delay_n_ms(delay_per_step);
-        }
-    }
-
-    delay_n_ms(50);
-
-    // Release both fingers
-    app_hid_send_multitouch(NULL, 0);
+    app_gesture_t gesture;
+
+    // Finger 1 starts at 0 degrees (right side), finger 2 at 180 degrees (left side)
+    // In screen coordinates: X+ is right, Y+ is down, positive angle = clockwise rotation
+    memset(&gesture, 0, sizeof(gesture));
+    gesture.path = APP_GESTURE_PATH_ARC;
+    gesture.contact_nb = 2;
+    gesture.steps = 20;
+    gesture.frame_ms = duration_ms / gesture.steps;
+    gesture.hold_ms = 50;
+    gesture.u.arc.center_x = center_x;
+    gesture.u.arc.center_y = center_y;
+    gesture.u.arc.radius = radius;
+    gesture.u.arc.angle_degrees = angle_degrees;
+
+    app_gesture_start(&gesture);
 }
 
 // ============================================================================
 // High-Level Gesture APIs Implementation
 // ============================================================================
 
-// Simple pseudo-random number generator for offsets
-static uint32_t rand_seed = 12345;
-static int16_t get_random_offset(int16_t range) {
-    rand_seed = rand_seed * 1103515245 + 12345;
-    return (int16_t)((rand_seed / 65536) % range) - (range / 2);
-}
+// Built-in gesture scripts, see app_gesture_script.h for the encoding
+
+// R0 center x, R1 center y, R2 start half distance, R3 end half distance, R4 duration
+static const uint8_t gesture_script_zoom[] = {
+    APP_GS_SET(5, APP_GS_R(0)), APP_GS_SUB(5, APP_GS_R(2)),
+    APP_GS_SET(6, APP_GS_R(0)), APP_GS_ADD(6, APP_GS_R(2)),
+    APP_GS_DOWN(0, APP_GS_R(5), APP_GS_R(1)),
+    APP_GS_DOWN(1, APP_GS_R(6), APP_GS_R(1)),
+    APP_GS_SYNC(),
+    APP_GS_SET(5, APP_GS_R(0)), APP_GS_SUB(5, APP_GS_R(3)),
+    APP_GS_SET(6, APP_GS_R(0)), APP_GS_ADD(6, APP_GS_R(3)),
+    APP_GS_MOVE(0, APP_GS_R(5), APP_GS_R(1)),
+    APP_GS_MOVE(1, APP_GS_R(6), APP_GS_R(1)),
+    APP_GS_PLAY(APP_TRAJ_EASE_LINEAR, APP_GS_R(4)),
+    APP_GS_WAIT(50),
+    APP_GS_END(),
+};
+
+// R0 center x, R1 center y, R2 radius, R3 angle in degrees, R4 duration
+static const uint8_t gesture_script_rotate[] = {
+    APP_GS_SET(5, APP_GS_R(0)), APP_GS_ADD(5, APP_GS_R(2)),
+    APP_GS_SET(6, APP_GS_R(0)), APP_GS_SUB(6, APP_GS_R(2)),
+    APP_GS_DOWN(0, APP_GS_R(5), APP_GS_R(1)),
+    APP_GS_DOWN(1, APP_GS_R(6), APP_GS_R(1)),
+    APP_GS_SYNC(),
+    APP_GS_ARC(0, APP_GS_R(0), APP_GS_R(1), APP_GS_R(2), 0, APP_GS_R(3)),
+    APP_GS_ARC(1, APP_GS_R(0), APP_GS_R(1), APP_GS_R(2), 180, APP_GS_R(3)),
+    APP_GS_PLAY(APP_TRAJ_EASE_LINEAR, APP_GS_R(4)),
+    APP_GS_WAIT(50),
+    APP_GS_END(),
+};
+
+// One finger of the screenshot swipe: lands around its column, then aims at the end row
+#define GESTURE_SCRIPT_SCREENSHOT_FINGER(id) \
+    APP_GS_SET(5, (SCREEN_WIDTH / 4) * ((id) + 1)), APP_GS_RAND(5, 1000), \
+    APP_GS_SET(6, APP_GS_R(0)), APP_GS_RAND(6, 400), \
+    APP_GS_DOWN(id, APP_GS_R(5), APP_GS_R(6)), \
+    APP_GS_SYNC(), \
+    APP_GS_RAND(5, 200), \
+    APP_GS_SET(6, APP_GS_R(1)), APP_GS_RAND(6, 400), \
+    APP_GS_MOVE(id, APP_GS_R(5), APP_GS_R(6))
+
+// R0 start y, R1 end y
+static const uint8_t gesture_script_screenshot[] = {
+    GESTURE_SCRIPT_SCREENSHOT_FINGER(0),
+    APP_GS_WAIT(APP_GESTURE_STAGGER_MS),
+    GESTURE_SCRIPT_SCREENSHOT_FINGER(1),
+    APP_GS_WAIT(APP_GESTURE_STAGGER_MS),
+    GESTURE_SCRIPT_SCREENSHOT_FINGER(2),
+    APP_GS_PLAY(APP_TRAJ_EASE_LINEAR, 300),
+    APP_GS_WAIT(10),
+    APP_GS_END(),
+};
+
+// Single finger edge swipe, 400ms
+#define GESTURE_SCRIPT_EDGE_SWIPE(x_start, y_start, x_end, y_end) \
+    APP_GS_DOWN(0, x_start, y_start), \
+    APP_GS_SYNC(), \
+    APP_GS_MOVE(0, x_end, y_end), \
+    APP_GS_PLAY(APP_TRAJ_EASE_LINEAR, 400), \
+    APP_GS_WAIT(10), \
+    APP_GS_END()
+
+static const uint8_t gesture_script_swipe_up_from_bottom[] = {
+    GESTURE_SCRIPT_EDGE_SWIPE(SCREEN_WIDTH / 2, SCREEN_HEIGHT, SCREEN_WIDTH / 2, (SCREEN_HEIGHT * 7) / 10),
+};
+
+static const uint8_t gesture_script_swipe_down_from_top[] = {
+    GESTURE_SCRIPT_EDGE_SWIPE(SCREEN_WIDTH / 2, 0, SCREEN_WIDTH / 2, (SCREEN_HEIGHT * 2) / 10),
+};
+
+static const uint8_t gesture_script_swipe_right_from_left[] = {
+    GESTURE_SCRIPT_EDGE_SWIPE(0, SCREEN_HEIGHT / 2, (SCREEN_WIDTH * 5) / 10, SCREEN_HEIGHT / 2),
+};
+
+static const uint8_t gesture_script_swipe_left_from_right[] = {
+    GESTURE_SCRIPT_EDGE_SWIPE(SCREEN_WIDTH, SCREEN_HEIGHT / 2, (SCREEN_WIDTH * 5) / 10, SCREEN_HEIGHT / 2),
+};
 
 /**
  * @brief Perform zoom gesture (pinch in/out)
@@ -499,7 +465,8 @@ void app_gesture_zoom(uint8_t zoom_level, uint8_t is_zoom_in)
     NS_LOG_INFO("Zoom %s: level=%d, distance %d->%d\r\n",
                 is_zoom_in ? "IN" : "OUT", zoom_level, start_distance, end_distance);
 
-    app_touchscreen_pinch(center_x, center_y, start_distance, end_distance, duration_ms);
+    int16_t arg[5] = {center_x, center_y, start_distance / 2, end_distance / 2, duration_ms};
+    app_gesture_script_play(gesture_script_zoom, sizeof(gesture_script_zoom), arg, 5);
 }
 
 /**
@@ -524,7 +491,8 @@ void app_gesture_rotate(int16_t angle_degrees)
 
     NS_LOG_INFO("Rotate: angle=%d deg, duration=%d ms\r\n", angle_degrees, duration_ms);
 
-    app_touchscreen_rotate(center_x, center_y, radius, angle_degrees, duration_ms);
+    int16_t arg[5] = {center_x, center_y, radius, angle_degrees, duration_ms};
+    app_gesture_script_play(gesture_script_rotate, sizeof(gesture_script_rotate), arg, 5);
 }
 
 /**
@@ -540,33 +508,12 @@ void app_gesture_screenshot(uint8_t start_percent)
     uint16_t y_start = (uint32_t)SCREEN_HEIGHT * start_percent / 100;
     uint16_t y_end = y_start + (SCREEN_HEIGHT * 30 / 100);  // Swipe 30% of screen height
 
-    // X positions: evenly spaced across screen with random offsets
-    uint16_t base_spacing = SCREEN_WIDTH / 4;
-    uint16_t x_start[3], y_start_arr[3];
-    uint16_t x_end[3], y_end_arr[3];
-
-    for (uint8_t i = 0; i < 3; i++) {
-        // Add random offset (±500 pixels)
-        int16_t x_offset = get_random_offset(1000);
-        int16_t y_offset_start = get_random_offset(400);
-        int16_t y_offset_end = get_random_offset(400);
-
-        x_start[i] = base_spacing + (i * base_spacing) + x_offset;
-        y_start_arr[i] = y_start + y_offset_start;
-        x_end[i] = x_start[i] + get_random_offset(200);  // Small horizontal movement
-        y_end_arr[i] = y_end + y_offset_end;
-
-        // Clamp to screen bounds
-        if (x_start[i] > SCREEN_WIDTH) x_start[i] = SCREEN_WIDTH;
-        if (x_end[i] > SCREEN_WIDTH) x_end[i] = SCREEN_WIDTH;
-        if (y_start_arr[i] > SCREEN_HEIGHT) y_start_arr[i] = SCREEN_HEIGHT;
-        if (y_end_arr[i] > SCREEN_HEIGHT) y_end_arr[i] = SCREEN_HEIGHT;
-    }
-
     NS_LOG_INFO("Screenshot: 3-finger swipe from %d%% to %d%%\r\n",
                 start_percent, start_percent + 30);
 
-    app_multi_touchscreen_swipe(3, x_start, y_start_arr, x_end, y_end_arr, 300);
+    // X positions evenly spaced across the screen, random offsets added by the script
+    int16_t arg[2] = {y_start, y_end};
+    app_gesture_script_play(gesture_script_screenshot, sizeof(gesture_script_screenshot), arg, 2);
 }
 
 /**
@@ -618,14 +565,8 @@ void app_gesture_swipe(int16_t distance_pixels, uint8_t is_vertical)
  */
 void app_gesture_swipe_up_from_bottom(void)
 {
-    // Start from 90% of screen height, swipe up to 30%
-    uint16_t x_start = SCREEN_WIDTH / 2;
-    uint16_t x_end = x_start;
-    uint16_t y_start = (SCREEN_HEIGHT * 10) / 10;  // 90%
-    uint16_t y_end = (SCREEN_HEIGHT * 7) / 10;    // 30%
-
     NS_LOG_INFO("Gesture: Swipe UP from bottom edge\r\n");
-    app_touchscreen_swipe(x_start, y_start, x_end, y_end, 400);
+    app_gesture_script_play(gesture_script_swipe_up_from_bottom, sizeof(gesture_script_swipe_up_from_bottom), NULL, 0);
 }
 
 /**
@@ -633,14 +574,8 @@ void app_gesture_swipe_up_from_bottom(void)
  */
 void app_gesture_swipe_down_from_top(void)
 {
-    // Start from 10% of screen height, swipe down to 70%
-    uint16_t x_start = SCREEN_WIDTH / 2;
-    uint16_t x_end = x_start;
-    uint16_t y_start = 0;        // 10%
-    uint16_t y_end = (SCREEN_HEIGHT * 2) / 10;    // 70%
-
     NS_LOG_INFO("Gesture: Swipe DOWN from top edge\r\n");
-    app_touchscreen_swipe(x_start, y_start, x_end, y_end, 400);
+    app_gesture_script_play(gesture_script_swipe_down_from_top, sizeof(gesture_script_swipe_down_from_top), NULL, 0);
 }
 
 /**
@@ -648,14 +583,8 @@ void app_gesture_swipe_down_from_top(void)
  */
 void app_gesture_swipe_right_from_left(void)
 {
-    // Start from 10% of screen width, swipe right to 70%
-    uint16_t x_start = 0;         // 10%
-    uint16_t x_end = (SCREEN_WIDTH * 5) / 10;     // 70%
-    uint16_t y_start = SCREEN_HEIGHT / 2;
-    uint16_t y_end = y_start;
-
     NS_LOG_INFO("Gesture: Swipe RIGHT from left edge\r\n");
-    app_touchscreen_swipe(x_start, y_start, x_end, y_end, 400);
+    app_gesture_script_play(gesture_script_swipe_right_from_left, sizeof(gesture_script_swipe_right_from_left), NULL, 0);
 }
 
 /**
@@ -663,12 +592,6 @@ void app_gesture_swipe_right_from_left(void)
  */
 void app_gesture_swipe_left_from_right(void)
 {
-    // Start from 90% of screen width, swipe left to 30%
-    uint16_t x_start = SCREEN_WIDTH ;   // 90%
-    uint16_t x_end = (SCREEN_WIDTH * 5) / 10;     // 30%
-    uint16_t y_start = SCREEN_HEIGHT / 2;
-    uint16_t y_end = y_start;
-
     NS_LOG_INFO("Gesture: Swipe LEFT from right edge\r\n");
-    app_touchscreen_swipe(x_start, y_start, x_end, y_end, 400);
+    app_gesture_script_play(gesture_script_swipe_left_from_right, sizeof(gesture_script_swipe_left_from_right), NULL, 0);
 }
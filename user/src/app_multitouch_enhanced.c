@@ -5,21 +5,13 @@
 
 #include "app_hid_touchscreen.h"
 #include <string.h>
-#include <math.h>
 #include "app_profile/app_hid.h"
-#include "ns_delay.h"
+#include "app_gesture.h"
 #include "ns_log.h"
-#include "hogp/hogpd/api/hogpd_task.h"
-#include "prf.h"
-#include "ke_msg.h"
-#include "co_utils.h"
 
 // Enhanced report size for better compatibility
 #define ENHANCED_MULTITOUCH_REPORT_LEN  16
 
-// External HID environment
-extern struct app_hid_env_tag app_hid_env;
-
 // Touch state tracking for proper multi-touch
 typedef struct {
     uint8_t active;
@@ -38,7 +30,7 @@ void app_hid_send_enhanced_multitouch(const hid_touch_point_t* touches, uint8_t
 {
     NS_LOG_INFO("Enhanced Multi-touch: count=%d\r\n", count);
 
-    if (app_hid_env.state != APP_HID_READY) {
+    if (!is_app_hid_ready()) {
         NS_LOG_WARNING("HID not ready\r\n");
         return;
     }
@@ -97,23 +89,8 @@ void app_hid_send_enhanced_multitouch(const hid_touch_point_t* touches, uint8_t
     // Contact count in last byte
     report[15] = count;
 
-    // Send via HID profile
-    struct hogpd_report_upd_req * req = KE_MSG_ALLOC_DYN(HOGPD_REPORT_UPD_REQ,
-                                                      prf_get_task_from_id(TASK_ID_HOGPD),
-                                                      TASK_APP,
-                                                      hogpd_report_upd_req,
-                                                      ENHANCED_MULTITOUCH_REPORT_LEN);
-
-    req->conidx = app_hid_env.conidx;
-    req->report.hid_idx = app_hid_env.conidx;
-    req->report.type = HOGPD_REPORT;
-    req->report.idx = 3;  // Report ID 4
-    req->report.length = ENHANCED_MULTITOUCH_REPORT_LEN;
-
-    memcpy(&req->report.value[0], report, ENHANCED_MULTITOUCH_REPORT_LEN);
-
-    ke_msg_send(req);
-    app_hid_env.nb_report--;
+    // Send via HID profile, queued if no credit is left
+    app_hid_send_report(APP_HID_TOUCH_REPORT_IDX, report, ENHANCED_MULTITOUCH_REPORT_LEN);
 }
 
 /**
@@ -126,40 +103,27 @@ void app_touchscreen_two_finger_swipe(uint16_t start_x, uint16_t start_y,
     NS_LOG_INFO("Two-finger swipe: (%d,%d)->(%d,%d), spacing=%d\r\n",
                 start_x, start_y, end_x, end_y, finger_spacing);
 
-    uint8_t steps = 15;
-    uint16_t delay_per_step = duration_ms / steps;
-
-    hid_touch_point_t touches[2];
-
-    // Setup two fingers
-    touches[0].contact_id = 0;
-    touches[0].tip_switch = 1;
-    touches[1].contact_id = 1;
-    touches[1].tip_switch = 1;
-
-    for (uint8_t i = 0; i <= steps; i++) {
-        float progress = (float)i / steps;
-
-        // Interpolate positions
-        uint16_t current_x = start_x + (int16_t)((end_x - start_x) * progress);
-        uint16_t current_y = start_y + (int16_t)((end_y - start_y) * progress);
-
-        // Position two fingers with spacing
-        touches[0].x = (current_x > finger_spacing/2) ? current_x - finger_spacing/2 : 0;
-        touches[0].y = current_y;
-        touches[1].x = (current_x + finger_spacing/2 > 32767) ? 32767 : current_x + finger_spacing/2;
-        touches[1].y = current_y;
-
-        app_hid_send_enhanced_multitouch(touches, 2);
-
-        if (i < steps) {
-            delay_n_ms(delay_per_step);
-        }
+    app_gesture_t gesture;
+
+    memset(&gesture, 0, sizeof(gesture));
+    gesture.path = APP_GESTURE_PATH_LINE;
+    gesture.contact_nb = 2;
+    gesture.steps = 15;
+    gesture.frame_ms = duration_ms / gesture.steps;
+    gesture.hold_ms = 50;
+    gesture.send = app_hid_send_enhanced_multitouch;
+
+    // Position two fingers with spacing
+    gesture.u.line[0].x_start = (start_x > finger_spacing/2) ? start_x - finger_spacing/2 : 0;
+    gesture.u.line[0].x_end = (end_x > finger_spacing/2) ? end_x - finger_spacing/2 : 0;
+    gesture.u.line[1].x_start = (start_x + finger_spacing/2 > 32767) ? 32767 : start_x + finger_spacing/2;
+    gesture.u.line[1].x_end = (end_x + finger_spacing/2 > 32767) ? 32767 : end_x + finger_spacing/2;
+    for (uint8_t j = 0; j < 2; j++) {
+        gesture.u.line[j].y_start = start_y;
+        gesture.u.line[j].y_end = end_y;
     }
 
-    // Lift fingers
-    delay_n_ms(50);
-    app_hid_send_enhanced_multitouch(NULL, 0);
+    app_gesture_start(&gesture);
 }
 
 /**
@@ -172,43 +136,30 @@ void app_touchscreen_three_finger_swipe(uint16_t start_x, uint16_t start_y,
     NS_LOG_INFO("Three-finger swipe: (%d,%d)->(%d,%d)\r\n",
                 start_x, start_y, end_x, end_y);
 
-    uint8_t steps = 15;
-    uint16_t delay_per_step = duration_ms / steps;
     uint16_t finger_spacing = 3000; // Spacing between fingers
-
-    hid_touch_point_t touches[3];
-
-    // Setup three fingers
+    app_gesture_t gesture;
+
+    memset(&gesture, 0, sizeof(gesture));
+    gesture.path = APP_GESTURE_PATH_LINE;
+    gesture.contact_nb = 3;
+    gesture.steps = 15;
+    gesture.frame_ms = duration_ms / gesture.steps;
+    gesture.hold_ms = 50;
+    gesture.send = app_hid_send_enhanced_multitouch;
+
+    // Position three fingers horizontally
+    gesture.u.line[0].x_start = (start_x > finger_spacing) ? start_x - finger_spacing : 0;
+    gesture.u.line[0].x_end = (end_x > finger_spacing) ? end_x - finger_spacing : 0;
+    gesture.u.line[1].x_start = start_x;
+    gesture.u.line[1].x_end = end_x;
+    gesture.u.line[2].x_start = (start_x + finger_spacing > 32767) ? 32767 : start_x + finger_spacing;
+    gesture.u.line[2].x_end = (end_x + finger_spacing > 32767) ? 32767 : end_x + finger_spacing;
     for (uint8_t j = 0; j < 3; j++) {
-        touches[j].contact_id = j;
-        touches[j].tip_switch = 1;
-    }
-
-    for (uint8_t i = 0; i <= steps; i++) {
-        float progress = (float)i / steps;
-
-        // Interpolate positions
-        uint16_t current_x = start_x + (int16_t)((end_x - start_x) * progress);
-        uint16_t current_y = start_y + (int16_t)((end_y - start_y) * progress);
-
-        // Position three fingers horizontally
-        touches[0].x = (current_x > finger_spacing) ? current_x - finger_spacing : 0;
-        touches[0].y = current_y;
-        touches[1].x = current_x;
-        touches[1].y = current_y;
-        touches[2].x = (current_x + finger_spacing > 32767) ? 32767 : current_x + finger_spacing;
-        touches[2].y = current_y;
-
-        app_hid_send_enhanced_multitouch(touches, 3);
-
-        if (i < steps) {
-            delay_n_ms(delay_per_step);
-        }
+        gesture.u.line[j].y_start = start_y;
+        gesture.u.line[j].y_end = end_y;
     }
 
-    // Lift all fingers
-    delay_n_ms(50);
-    app_hid_send_enhanced_multitouch(NULL, 0);
+    app_gesture_start(&gesture);
 }
 
 /**
@@ -221,35 +172,25 @@ void app_touchscreen_enhanced_pinch(uint16_t center_x, uint16_t center_y,
     NS_LOG_INFO("Enhanced pinch: center(%d,%d), distance %d->%d\r\n",
                 center_x, center_y, start_distance, end_distance);
 
-    uint8_t steps = 20;
-    uint16_t delay_per_step = duration_ms / steps;
-
-    hid_touch_point_t touches[2];
-    touches[0].contact_id = 0;
-    touches[0].tip_switch = 1;
-    touches[1].contact_id = 1;
-    touches[1].tip_switch = 1;
-
-    for (uint8_t i = 0; i <= steps; i++) {
-        float progress = (float)i / steps;
-        uint16_t current_distance = start_distance +
-                                   (int16_t)((end_distance - start_distance) * progress);
-
-        // Position fingers symmetrically around center
-        touches[0].x = (center_x > current_distance/2) ? center_x - current_distance/2 : 0;
-        touches[0].y = center_y;
-        touches[1].x = (center_x + current_distance/2 > 32767) ? 32767 : center_x + current_distance/2;
-        touches[1].y = center_y;
-
-        app_hid_send_enhanced_multitouch(touches, 2);
-
-        if (i < steps) {
-            delay_n_ms(delay_per_step);
-        }
-    }
-
-    delay_n_ms(50);
-    app_hid_send_enhanced_multitouch(NULL, 0);
+    app_gesture_t gesture;
+
+    memset(&gesture, 0, sizeof(gesture));
+    gesture.path = APP_GESTURE_PATH_LINE;
+    gesture.contact_nb = 2;
+    gesture.steps = 20;
+    gesture.frame_ms = duration_ms / gesture.steps;
+    gesture.hold_ms = 50;
+    gesture.send = app_hid_send_enhanced_multitouch;
+
+    // Position fingers symmetrically around center
+    gesture.u.line[0].x_start = (center_x > start_distance/2) ? center_x - start_distance/2 : 0;
+    gesture.u.line[0].x_end = (center_x > end_distance/2) ? center_x - end_distance/2 : 0;
+    gesture.u.line[1].x_start = (center_x + start_distance/2 > 32767) ? 32767 : center_x + start_distance/2;
+    gesture.u.line[1].x_end = (center_x + end_distance/2 > 32767) ? 32767 : center_x + end_distance/2;
+    gesture.u.line[0].y_start = gesture.u.line[0].y_end = center_y;
+    gesture.u.line[1].y_start = gesture.u.line[1].y_end = center_y;
+
+    app_gesture_start(&gesture);
 }
 
 /**
@@ -262,43 +203,20 @@ void app_touchscreen_enhanced_rotate(uint16_t center_x, uint16_t center_y,
     NS_LOG_INFO("Enhanced rotate: center(%d,%d), radius=%d, angle=%d deg\r\n",
                 center_x, center_y, radius, angle_degrees);
 
-    uint8_t steps = 30;
-    uint16_t delay_per_step = duration_ms / steps;
-    float angle_radians = angle_degrees * 3.14159f / 180.0f;
-
-    hid_touch_point_t touches[2];
-    touches[0].contact_id = 0;
-    touches[0].tip_switch = 1;
-    touches[1].contact_id = 1;
-    touches[1].tip_switch = 1;
-
-    for (uint8_t i = 0; i <= steps; i++) {
-        float progress = (float)i / steps;
-        float current_angle = angle_radians * progress;
-
-        // Use simplified rotation calculation
-        // Finger 1 starts at (center_x + radius, center_y) and rotates
-        int16_t x1_offset = (int16_t)(radius * (1.0f - progress * 0.3f)); // Gradually reduce radius
-        int16_t y1_offset = (int16_t)(radius * progress * 0.7f); // Gradually increase Y
-
-        // Finger 2 is on opposite side
-        touches[0].x = (center_x + x1_offset > 32767) ? 32767 :
-                      ((center_x + x1_offset < 0) ? 0 : center_x + x1_offset);
-        touches[0].y = (center_y + y1_offset > 32767) ? 32767 :
-                      ((center_y + y1_offset < 0) ? 0 : center_y + y1_offset);
-
-        touches[1].x = (center_x - x1_offset > 32767) ? 32767 :
-                      ((center_x - x1_offset < 0) ? 0 : center_x - x1_offset);
-        touches[1].y = (center_y - y1_offset > 32767) ? 32767 :
-                      ((center_y - y1_offset < 0) ? 0 : center_y - y1_offset);
-
-        app_hid_send_enhanced_multitouch(touches, 2);
-
-        if (i < steps) {
-            delay_n_ms(delay_per_step);
-        }
-    }
-
-    delay_n_ms(50);
-    app_hid_send_enhanced_multitouch(NULL, 0);
-}
\ No newline at end of file
+    app_gesture_t gesture;
+
+    // Finger 1 starts at (center_x + radius, center_y), finger 2 is on opposite side
+    memset(&gesture, 0, sizeof(gesture));
+    gesture.path = APP_GESTURE_PATH_ARC;
+    gesture.contact_nb = 2;
+    gesture.steps = 30;
+    gesture.frame_ms = duration_ms / gesture.steps;
+    gesture.hold_ms = 50;
+    gesture.send = app_hid_send_enhanced_multitouch;
+    gesture.u.arc.center_x = center_x;
+    gesture.u.arc.center_y = center_y;
+    gesture.u.arc.radius = radius;
+    gesture.u.arc.angle_degrees = angle_degrees;
+
+    app_gesture_start(&gesture);
+}
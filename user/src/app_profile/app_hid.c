@@ -51,25 +51,65 @@
 #include "ns_sec.h"                // Application Security Module API
 #include "ns_ble_task.h"               // Application task definitions
 #include "app_hid.h"                // HID Application Module Definitions
-#include "hogp\hogpd\api\hogpd_task.h"             // HID Over GATT Profile Device Role Functions
+#include "hogp/hogpd/api/hogpd_task.h"             // HID Over GATT Profile Device Role Functions
 #include "prf_types.h"              // Profile common types Definition
 #include "arch.h"                    // Platform Definitions
 #include "prf.h"
 #include "ke_timer.h"
 #include "app_hid_touchscreen.h"
+#include "app_gesture_script.h"
 
 #if (NVDS_SUPPORT)
 #include "nvds.h"                   // NVDS Definitions
 #endif //(NVDS_SUPPORT)
-#include "hogp\hogpd\src\hogpd.h"
+#include "hogp/hogpd/src/hogpd.h"
 #include "co_utils.h"               // Common functions
 
-#if (KE_PROFILING)
-#include "ke_mem.h"
-#endif //(KE_PROFILING)
 #include "app_gpio.h"
 #include "app_ble.h" 
+#include "rwip.h"
+#include "ns_sleep.h"
+#include "ns_msg_pool.h"
 /* Private typedef -----------------------------------------------------------*/
+
+/// Report waiting for a notification credit
+struct app_hid_queued_report
+{
+    /// Enqueue sequence number, keeps the order between report instances
+    uint16_t seq;
+    /// Report length
+    uint8_t  length;
+    /// Report value
+    uint8_t  value[APP_HID_QUEUE_REPORT_MAX_LEN];
+};
+
+/// Pending report ring of one report instance
+struct app_hid_report_queue
+{
+    /// Report slots
+    struct app_hid_queued_report slot[APP_HID_QUEUE_DEPTH];
+    /// Index of the oldest pending report
+    uint8_t head;
+    /// Number of pending reports
+    uint8_t count;
+    /// Overflow policy (@see enum app_hid_queue_policy)
+    uint8_t policy;
+    /// Counters
+    struct app_hid_queue_stats stats;
+    /// Suppress reports identical to the last accepted one
+    bool suppress;
+    /// Coordinate tolerance of the touch report suppression
+    uint16_t dead_band;
+    /// Longest suppression time (in half-slots), 0 = never resend
+    uint32_t keepalive;
+    /// Time the last accepted report was taken (in half-slots)
+    uint32_t last_time;
+    /// Length of the last accepted report, 0 = none
+    uint8_t last_length;
+    /// Last accepted report
+    uint8_t last_value[APP_HID_QUEUE_REPORT_MAX_LEN];
+};
+
 /* Private define ------------------------------------------------------------*/
 
 
@@ -79,6 +119,11 @@
 /// HID Application Module Environment Structure
 struct app_hid_env_tag app_hid_env;
 
+/// Pending report queues, one per Input Report instance
+static struct app_hid_report_queue app_hid_queue[APP_HID_REPORT_NB];
+/// Next enqueue sequence number
+static uint16_t app_hid_queue_seq;
+
 // Calculate coordinate maximum bytes from screen dimension macros
 #define COORD_MAX_LOW_BYTE  (SCREEN_WIDTH & 0xFF)
 #define COORD_MAX_HIGH_BYTE ((SCREEN_WIDTH >> 8) & 0xFF)
@@ -333,6 +378,19 @@ static const uint8_t app_hid_mouse_report_map[] =
 
     
 
+    0xC0,              // End Collection
+
+    // Report ID 5: Gesture script upload (vendor defined Output)
+    0x06, 0x00, 0xFF,  // Usage Page (Vendor Defined 0xFF00)
+    0x09, 0x01,        // Usage (0x01)
+    0xA1, 0x01,        // Collection (Application)
+    0x85, 0x05,        //   Report ID (5)
+    0x09, 0x02,        //   Usage (0x02)
+    0x15, 0x00,        //   Logical Minimum (0)
+    0x26, 0xFF, 0x00,  //   Logical Maximum (255)
+    0x75, 0x08,        //   Report Size (8)
+    0x95, APP_HID_SCRIPT_REPORT_LEN, //   Report Count (APP_HID_SCRIPT_REPORT_LEN)
+    0x91, 0x02,        //   Output (Data,Var,Abs)
     0xC0,              // End Collection
 };
 
@@ -341,6 +399,425 @@ static const uint8_t app_hid_mouse_report_map[] =
 /* Private function prototypes -----------------------------------------------*/
 /* Private functions ---------------------------------------------------------*/
 
+/**
+ * @brief Send a report to HOGPD and consume one credit
+ */
+static void app_hid_report_ntf(uint8_t report_idx, const uint8_t* data, uint16_t len)
+{
+    uint8_t status = GAP_ERR_COMMAND_DISALLOWED;
+
+    #if (HOGPD_REPORT_CYCLES)
+    hogpd_report_cycles_start();
+    #endif
+
+    // Straight to GATT, unless it would overtake a request still waiting in HOGPD
+    if ((APP_HID_DIRECT_SEND) && (app_hid_env.nb_req_out == 0))
+    {
+        status = hogpd_report_send_direct(app_hid_env.conidx, app_hid_env.conidx, HOGPD_REPORT,
+                                          report_idx, data, len);
+    }
+
+    // HOGPD busy or report refused, the request path queues it or reports the error
+    if (status != GAP_ERR_NO_ERROR)
+    {
+        // Allocate the HOGPD_REPORT_UPD_REQ message, from the pool HOGPD keeps for reports
+        struct hogpd_report_upd_req * req = NS_MSG_POOL_ALLOC_DYN(HOGPD_REPORT_UPD_REQ,
+                                                          prf_get_task_from_id(TASK_ID_HOGPD),
+                                                          TASK_APP,
+                                                          hogpd_report_upd_req,
+                                                          len);
+
+        req->conidx  = app_hid_env.conidx;
+        //now fill report
+        req->report.hid_idx  = app_hid_env.conidx;
+        req->report.type     = HOGPD_REPORT;
+        req->report.idx      = report_idx;
+        req->report.length   = len;
+        memcpy(&req->report.value[0], data, len);
+
+        ke_msg_send(req);
+        app_hid_env.nb_req_out++;
+    }
+    ns_sleep_report_event();
+
+    app_hid_env.nb_out++;
+    app_hid_env.nb_report--;
+}
+
+/**
+ * @brief Take at most +/-max out of a relative movement
+ * @return Part of the movement that fits in the report
+ */
+static int16_t app_hid_mouse_clamp(int32_t *value, int16_t max)
+{
+    int16_t part = (*value > max) ? max : ((*value < -max) ? -max : (int16_t)*value);
+
+    *value -= part;
+    return part;
+}
+
+/**
+ * @brief Build a mouse report (Report ID 1 layout)
+ */
+static void app_hid_mouse_encode(uint8_t* buff, uint8_t buttons, int16_t x, int16_t y, int8_t w)
+{
+    buff[0] = buttons;
+    co_write16p(&buff[1], x);
+    co_write16p(&buff[3], y);
+    buff[5] = (uint8_t)w;
+}
+
+/**
+ * @brief Discard every pending report and the last accepted ones, counters are kept
+ */
+static void app_hid_queue_reset(void)
+{
+    for (uint8_t i = 0; i < APP_HID_REPORT_NB; i++)
+    {
+        app_hid_queue[i].head  = 0;
+        app_hid_queue[i].count = 0;
+        app_hid_queue[i].last_length = 0;
+    }
+}
+
+/**
+ * @brief Current time of the BLE core (in half-slots)
+ */
+static uint32_t app_hid_time_get(void)
+{
+    rwip_time_t now;
+
+    GLOBAL_INT_DISABLE();
+    now = rwip_time_get();
+    GLOBAL_INT_RESTORE();
+
+    return now.hs;
+}
+
+/**
+ * @brief Compare two touch reports, contacts moving less than the dead band are unchanged
+ */
+static bool app_hid_touch_unchanged(const uint8_t* last, const uint8_t* data, uint16_t len, uint16_t dead_band)
+{
+    for (uint16_t i = 0; i < len; i++)
+    {
+        // Contact: Tip Switch/Contact ID, X, Y
+        if ((i < APP_HID_MULTITOUCH_REPORT_LEN) && ((i % 5) != 0))
+        {
+            int32_t diff = (int32_t)co_read16p(&data[i]) - co_read16p(&last[i]);
+
+            if ((diff > dead_band) || (diff < -(int32_t)dead_band))
+            {
+                return false;
+            }
+            i++;
+        }
+        else if (last[i] != data[i])
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief Check if a report can be skipped, remember it otherwise
+ * @return true if the report does not need to be sent
+ */
+static bool app_hid_report_unchanged(uint8_t report_idx, const uint8_t* data, uint16_t len)
+{
+    struct app_hid_report_queue *queue = &app_hid_queue[report_idx];
+    uint32_t now = app_hid_time_get();
+    bool unchanged = false;
+
+    if (!queue->suppress)
+    {
+        return false;
+    }
+
+    if ((queue->last_length == len)
+        && ((queue->keepalive == 0) || (CLK_SUB(now, queue->last_time) < queue->keepalive)))
+    {
+        if ((report_idx == APP_HID_TOUCH_REPORT_IDX) && (queue->dead_band != 0))
+        {
+            unchanged = app_hid_touch_unchanged(&queue->last_value[0], data, len, queue->dead_band);
+        }
+        else
+        {
+            unchanged = (memcmp(&queue->last_value[0], data, len) == 0);
+        }
+    }
+
+    if (unchanged)
+    {
+        queue->stats.suppressed++;
+    }
+    else
+    {
+        queue->last_time   = now;
+        queue->last_length = len;
+        memcpy(&queue->last_value[0], data, len);
+    }
+
+    return unchanged;
+}
+
+/**
+ * @brief Check if two reports have the same contacts, a touch report only differing in
+ *        position can replace the other, a tip switch or contact change cannot
+ */
+static bool app_hid_report_same_state(uint8_t report_idx, const struct app_hid_queued_report* entry,
+                                      const uint8_t* data, uint16_t len)
+{
+    if (entry->length != len)
+    {
+        return false;
+    }
+    if (report_idx == APP_HID_TOUCH_REPORT_IDX)
+    {
+        // Contact: Tip Switch/Contact ID, X, Y
+        for (uint16_t i = 0; (i < len) && (i < APP_HID_MULTITOUCH_REPORT_LEN); i += 5)
+        {
+            if (entry->value[i] != data[i])
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief Make room in a full queue without losing a contact change
+ * @return true if the new report replaced the newest pending one
+ */
+static bool app_hid_queue_coalesce(uint8_t report_idx, const uint8_t* data, uint16_t len)
+{
+    struct app_hid_report_queue *queue = &app_hid_queue[report_idx];
+    struct app_hid_queued_report *entry = &queue->slot[(queue->head + queue->count - 1) % APP_HID_QUEUE_DEPTH];
+    uint8_t pos;
+
+    // Same contacts as the newest pending report, it keeps its place in the order
+    if (app_hid_report_same_state(report_idx, entry, data, len))
+    {
+        memcpy(&entry->value[0], data, len);
+        queue->stats.coalesced++;
+        return true;
+    }
+
+    // Drop the oldest report followed by one with the same contacts, it is only a position
+    for (pos = 0; pos < queue->count - 1; pos++)
+    {
+        struct app_hid_queued_report *next = &queue->slot[(queue->head + pos + 1) % APP_HID_QUEUE_DEPTH];
+
+        if (app_hid_report_same_state(report_idx, &queue->slot[(queue->head + pos) % APP_HID_QUEUE_DEPTH],
+                                      &next->value[0], next->length))
+        {
+            queue->stats.coalesced++;
+            break;
+        }
+    }
+
+    // Only contact changes are pending, the oldest one goes
+    if (pos == queue->count - 1)
+    {
+        pos = 0;
+        queue->stats.dropped++;
+    }
+
+    for (; pos < queue->count - 1; pos++)
+    {
+        queue->slot[(queue->head + pos) % APP_HID_QUEUE_DEPTH] =
+            queue->slot[(queue->head + pos + 1) % APP_HID_QUEUE_DEPTH];
+    }
+    queue->count--;
+
+    return false;
+}
+
+/**
+ * @brief Add the motion of a mouse report to a pending one, the buttons are not touched
+ * @return true if all of it fitted, otherwise the rest is left in x, y and w
+ */
+static bool app_hid_mouse_add(uint8_t* value, const uint8_t* data, int32_t *x, int32_t *y, int32_t *w)
+{
+    *x = (int16_t)co_read16p(&value[1]) + (int16_t)co_read16p(&data[1]);
+    *y = (int16_t)co_read16p(&value[3]) + (int16_t)co_read16p(&data[3]);
+    *w = (int8_t)value[5] + (int8_t)data[5];
+
+    app_hid_mouse_encode(&value[0], value[0],
+                         app_hid_mouse_clamp(x, APP_HID_MOUSE_XY_MAX),
+                         app_hid_mouse_clamp(y, APP_HID_MOUSE_XY_MAX),
+                         app_hid_mouse_clamp(w, APP_HID_MOUSE_WHEEL_MAX));
+
+    return (*x == 0) && (*y == 0) && (*w == 0);
+}
+
+/**
+ * @brief Make room in a full mouse queue without merging across a button edge: the oldest
+ *        two pending reports with the same buttons become one, or the oldest report goes
+ *        when every pending report is a button edge. The newest report keeps the buttons
+ *        the host ends with.
+ */
+static void app_hid_mouse_make_room(struct app_hid_report_queue *queue)
+{
+    uint8_t pos;
+
+    for (pos = 0; pos < queue->count - 1; pos++)
+    {
+        struct app_hid_queued_report *entry = &queue->slot[(queue->head + pos) % APP_HID_QUEUE_DEPTH];
+        struct app_hid_queued_report *next = &queue->slot[(queue->head + pos + 1) % APP_HID_QUEUE_DEPTH];
+
+        if (entry->value[0] == next->value[0])
+        {
+            int32_t x, y, w;
+
+            if (!app_hid_mouse_add(&entry->value[0], &next->value[0], &x, &y, &w))
+            {
+                queue->stats.dropped++;
+            }
+            queue->stats.coalesced++;
+            pos++;
+            break;
+        }
+    }
+
+    // Only button edges are pending, the oldest one goes
+    if (pos == queue->count - 1)
+    {
+        pos = 0;
+        queue->stats.dropped++;
+    }
+
+    for (; pos < queue->count - 1; pos++)
+    {
+        queue->slot[(queue->head + pos) % APP_HID_QUEUE_DEPTH] =
+            queue->slot[(queue->head + pos + 1) % APP_HID_QUEUE_DEPTH];
+    }
+    queue->count--;
+}
+
+/**
+ * @brief Store a report in the queue of its report instance
+ * @return false if the report has been refused
+ */
+static bool app_hid_queue_push(uint8_t report_idx, const uint8_t* data, uint16_t len)
+{
+    struct app_hid_report_queue *queue = &app_hid_queue[report_idx];
+    struct app_hid_queued_report *entry;
+    uint8_t overflow[APP_HID_MOUSE_REPORT_LEN];
+
+    if ((queue->policy == APP_HID_QUEUE_ACCUMULATE) && (queue->count != 0) && (len == APP_HID_MOUSE_REPORT_LEN))
+    {
+        entry = &queue->slot[(queue->head + queue->count - 1) % APP_HID_QUEUE_DEPTH];
+
+        // A button edge is always a report of its own
+        if (entry->value[0] == data[0])
+        {
+            int32_t x, y, w;
+
+            queue->stats.coalesced++;
+            if (app_hid_mouse_add(&entry->value[0], data, &x, &y, &w))
+            {
+                return true;
+            }
+
+            // The pending report is saturated, the rest goes in a new one
+            app_hid_mouse_encode(&overflow[0], data[0], x, y, w);
+            data = &overflow[0];
+        }
+    }
+
+    if (queue->count == APP_HID_QUEUE_DEPTH)
+    {
+        switch (queue->policy)
+        {
+            case APP_HID_QUEUE_ACCUMULATE:
+            {
+                if (len == APP_HID_MOUSE_REPORT_LEN)
+                {
+                    app_hid_mouse_make_room(queue);
+                    break;
+                }
+                queue->head = (queue->head + 1) % APP_HID_QUEUE_DEPTH;
+                queue->count--;
+                queue->stats.dropped++;
+            } break;
+
+            case APP_HID_QUEUE_COALESCE_LATEST:
+            {
+                if (app_hid_queue_coalesce(report_idx, data, len))
+                {
+                    return true;
+                }
+            } break;
+
+            case APP_HID_QUEUE_BLOCK:
+            {
+                queue->stats.dropped++;
+            } return false;
+
+            case APP_HID_QUEUE_DROP_OLDEST:
+            default:
+            {
+                queue->head = (queue->head + 1) % APP_HID_QUEUE_DEPTH;
+                queue->count--;
+                queue->stats.dropped++;
+            } break;
+        }
+    }
+
+    entry = &queue->slot[(queue->head + queue->count) % APP_HID_QUEUE_DEPTH];
+    entry->seq    = app_hid_queue_seq++;
+    entry->length = len;
+    memcpy(&entry->value[0], data, len);
+    queue->count++;
+    queue->stats.queued++;
+
+    if (queue->count > queue->stats.max_depth)
+    {
+        queue->stats.max_depth = queue->count;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Send pending reports, oldest first, while credits are available
+ */
+static void app_hid_queue_flush(void)
+{
+    while ((app_hid_env.nb_report != 0) && (app_hid_env.state == APP_HID_READY))
+    {
+        struct app_hid_report_queue *oldest = NULL;
+        uint8_t report_idx = 0;
+
+        for (uint8_t i = 0; i < APP_HID_REPORT_NB; i++)
+        {
+            struct app_hid_report_queue *queue = &app_hid_queue[i];
+
+            if ((queue->count != 0)
+                && ((oldest == NULL)
+                    || ((int16_t)(queue->slot[queue->head].seq - oldest->slot[oldest->head].seq) < 0)))
+            {
+                oldest = queue;
+                report_idx = i;
+            }
+        }
+
+        if (oldest == NULL)
+        {
+            break;
+        }
+
+        app_hid_report_ntf(report_idx, &oldest->slot[oldest->head].value[0],
+                           oldest->slot[oldest->head].length);
+        oldest->head = (oldest->head + 1) % APP_HID_QUEUE_DEPTH;
+        oldest->count--;
+    }
+}
 
 void app_hid_init(void)
 {
@@ -348,8 +825,20 @@ void app_hid_init(void)
     
     // Reset the environment
     memset(&app_hid_env, 0, sizeof(app_hid_env));
+    memset(&app_hid_queue[0], 0, sizeof(app_hid_queue));
+
+    // Lift-off and key release must not be lost, motion can be merged
+    app_hid_queue[APP_HID_MOUSE_REPORT_IDX].policy    = APP_HID_QUEUE_ACCUMULATE;
+    app_hid_queue[APP_HID_CONSUMER_REPORT_IDX].policy = APP_HID_QUEUE_DROP_OLDEST;
+    app_hid_queue[APP_HID_KEYBOARD_REPORT_IDX].policy = APP_HID_QUEUE_DROP_OLDEST;
+    app_hid_queue[APP_HID_TOUCH_REPORT_IDX].policy    = APP_HID_QUEUE_COALESCE_LATEST;
+
+    // Stationary contacts do not need a report every frame
+    app_hid_suppress_config(APP_HID_TOUCH_REPORT_IDX, true, 0, APP_HID_SUPPRESS_KEEPALIVE_MS);
 
     app_hid_env.nb_report = APP_HID_NB_SEND_REPORT;
+    // Until the central tells otherwise, assume the shortest interval we ask for
+    app_hid_env.con_interval = MSECS_TO_UNIT(MIN_CONN_INTERVAL, MSECS_UNIT_1_25_MS);
 
 
     app_hid_env.timeout = APP_HID_SILENCE_DURATION_1;
@@ -394,7 +883,7 @@ void app_hid_add_hids(void)
     db_cfg->cfg[0].svc_features = HOGPD_CFG_KEYBOARD | HOGPD_CFG_MOUSE; // Support both keyboard and mouse
 
     // Report Characteristics - Now includes touch screen with both Input and Feature reports
-    db_cfg->cfg[0].report_nb    = 5;  // 5 reports: mouse, multimedia, keyboard, touchscreen input, touchscreen feature
+    db_cfg->cfg[0].report_nb    = 6;  // 6 reports: mouse, multimedia, keyboard, touchscreen input, touchscreen feature, gesture script
 
     db_cfg->cfg[0].report_id[0] = 1;  // Mouse
     db_cfg->cfg[0].report_char_cfg[0] = HOGPD_CFG_REPORT_IN;
@@ -411,6 +900,9 @@ void app_hid_add_hids(void)
     db_cfg->cfg[0].report_id[4] = 4;  // Touch Screen (Feature Report - same Report ID!)
     db_cfg->cfg[0].report_char_cfg[4] = HOGPD_CFG_REPORT_FEAT;
 
+    db_cfg->cfg[0].report_id[APP_HID_SCRIPT_REPORT_IDX] = 5;  // Gesture script upload (Output Report)
+    db_cfg->cfg[0].report_char_cfg[APP_HID_SCRIPT_REPORT_IDX] = HOGPD_CFG_REPORT_OUT;
+
     // HID Information
     db_cfg->cfg[0].hid_info.bcdHID       = 0x0111;         // HID Version 1.11
     db_cfg->cfg[0].hid_info.bCountryCode = 0x00;
@@ -435,6 +927,10 @@ void app_hid_enable_prf(uint8_t conidx)
 
     // Store the connection handle
     app_hid_env.conidx = conidx;
+    // Reports queued for a previous link are meaningless now
+    app_hid_queue_reset();
+    app_hid_env.nb_out = 0;
+    app_hid_env.nb_req_out = 0;
 
     // Allocate the message
     struct hogpd_enable_req * req = KE_MSG_ALLOC(HOGPD_ENABLE_REQ,
@@ -486,79 +982,51 @@ void app_hid_send_mouse_report(struct ps2_mouse_msg report)
     {
         case (APP_HID_READY):
         {
-            // Check if the report can be sent
-            if (app_hid_env.nb_report)
+            // Buffer used to create the Report
+            uint8_t report_buff[APP_HID_MOUSE_REPORT_LEN];
+            // X, Y and wheel relative movements
+            int32_t x;
+            int32_t y;
+            int32_t w;
+
+            // If X value is negative
+            if (report.b & 0x10)
             {
-                // Buffer used to create the Report
-                uint8_t report_buff[APP_HID_MOUSE_REPORT_LEN];
-                // X, Y and wheel relative movements
-                int16_t x;
-                int16_t y;
-
-                // Clean the report buffer
-                memset(&report_buff[0], 0, APP_HID_MOUSE_REPORT_LEN);
-
-                // Set the button states
-                report_buff[0] = (report.b & 0x07);
-
-                // If X value is negative
-                if (report.b & 0x10)
-                {
-                    report.x = ~report.x;
-                    report.x += 1;
-                    x = (int16_t)report.x;
-                    x *= (-1);
-                }
-                else
-                {
-                    x = (int16_t)report.x;
-                }
-
-                // If Y value is negative
-                if (report.b & 0x20)
-                {
-                    report.y = ~report.y;
-                    report.y += 1;
-                    y = (int16_t)report.y;
-                }
-                else
-                {
-                    y = (int16_t)report.y;
-                    y *= (-1);
-                }
-
-
-                // Set the X and Y movement value in the report
-                co_write16p(&report_buff[1], x);
-                co_write16p(&report_buff[3], y);
-                report_buff[5] =(signed char) (-1) * report.w;
-
-                // Allocate the HOGPD_REPORT_UPD_REQ message
-                struct hogpd_report_upd_req * req = KE_MSG_ALLOC_DYN(HOGPD_REPORT_UPD_REQ,
-                                                                  prf_get_task_from_id(TASK_ID_HOGPD),
-                                                                  TASK_APP,
-                                                                  hogpd_report_upd_req,
-                                                                  APP_HID_MOUSE_REPORT_LEN);
+                report.x = ~report.x;
+                report.x += 1;
+                x = (int16_t)report.x;
+                x *= (-1);
+            }
+            else
+            {
+                x = (int16_t)report.x;
+            }
 
-                req->conidx  = app_hid_env.conidx;
-                //now fill report
-                req->report.hid_idx  = app_hid_env.conidx;
-                req->report.type     = HOGPD_REPORT; //HOGPD_BOOT_MOUSE_INPUT_REPORT;//
-                req->report.idx      = 0; //0 for boot reports and report map
-                req->report.length   = APP_HID_MOUSE_REPORT_LEN;
-                memcpy(&req->report.value[0], &report_buff[0], APP_HID_MOUSE_REPORT_LEN);
+            // If Y value is negative
+            if (report.b & 0x20)
+            {
+                report.y = ~report.y;
+                report.y += 1;
+                y = (int16_t)report.y;
+            }
+            else
+            {
+                y = (int16_t)report.y;
+                y *= (-1);
+            }
 
-                ke_msg_send(req);
+            w = (signed char) (-1) * report.w;
 
-                app_hid_env.nb_report--;
+            // Movements out of the descriptor range are split over several reports
+            do
+            {
+                app_hid_mouse_encode(&report_buff[0], (report.b & 0x07),
+                                     app_hid_mouse_clamp(&x, APP_HID_MOUSE_XY_MAX),
+                                     app_hid_mouse_clamp(&y, APP_HID_MOUSE_XY_MAX),
+                                     app_hid_mouse_clamp(&w, APP_HID_MOUSE_WHEEL_MAX));
 
-                // Restart the mouse timeout timer if needed
-                if (app_hid_env.timeout != 0)
-                {
-                    ke_timer_set(APP_HID_MOUSE_TIMEOUT_TIMER, TASK_APP, (uint16_t)(app_hid_env.timeout));
-                    app_hid_env.timer_enabled = true;
-                }
-            }
+                app_hid_send_report(APP_HID_MOUSE_REPORT_IDX, &report_buff[0], APP_HID_MOUSE_REPORT_LEN);
+            } while ((x != 0) || (y != 0) || (w != 0));
         } break;
 
         case (APP_HID_WAIT_REP):
@@ -616,35 +1084,8 @@ void app_hid_send_consumer_report(uint8_t* report)
     {
         case (APP_HID_READY):
         {
-            // Check if the report can be sent
-            if (app_hid_env.nb_report)
-            {
-                // Allocate the HOGPD_REPORT_UPD_REQ message
-                struct hogpd_report_upd_req * req = KE_MSG_ALLOC_DYN(HOGPD_REPORT_UPD_REQ,
-                                                                  prf_get_task_from_id(TASK_ID_HOGPD),
-                                                                  TASK_APP,
-                                                                  hogpd_report_upd_req,
-                                                                  APP_HID_CONSUMER_REPORT_LEN);
-
-                req->conidx  = app_hid_env.conidx;
-                //now fill report
-                req->report.hid_idx  = app_hid_env.conidx;
-                req->report.type     = HOGPD_REPORT; //HOGPD_BOOT_MOUSE_INPUT_REPORT;//
-                req->report.idx      = 1; //repoort id 2 report map
-                req->report.length   = APP_HID_CONSUMER_REPORT_LEN;
-                memcpy(&req->report.value[0], &report[0],APP_HID_CONSUMER_REPORT_LEN);
-								NS_LOG_WARNING("\r\n%d ,%d\r\n",req->report.value[0],req->report.value[1]);
-                ke_msg_send(req);
-
-                app_hid_env.nb_report--;
-
-                // Restart the mouse timeout timer if needed
-                if (app_hid_env.timeout != 0)
-                {
-                    ke_timer_set(APP_HID_MOUSE_TIMEOUT_TIMER, TASK_APP, (uint16_t)(app_hid_env.timeout));
-                    app_hid_env.timer_enabled = true;
-                }
-            }
+								NS_LOG_WARNING("\r\n%d ,%d\r\n",report[0],report[1]);
+            app_hid_send_report(APP_HID_CONSUMER_REPORT_IDX, report, APP_HID_CONSUMER_REPORT_LEN);
         } break;
 
         case (APP_HID_WAIT_REP):
@@ -687,11 +1128,6 @@ void app_hid_send_consumer_report(uint8_t* report)
             // Drop the message
         } break;
     }
-#if (KE_PROFILING)
-//    app_display_hdl_env_size(0xFFFF, ke_get_mem_usage(KE_MEM_ENV));
-//    app_display_hdl_db_size(0xFFFF, ke_get_mem_usage(KE_MEM_ATT_DB));
-//    app_display_hdl_msg_size((uint16_t)ke_get_max_mem_usage(), ke_get_mem_usage(KE_MEM_KE_MSG));
-    #endif //(KE_PROFILING)
 }
 
 /*
@@ -713,40 +1149,11 @@ void app_hid_send_keyboard_report(uint8_t* report)
     {
         case (APP_HID_READY):
         {
-            // Check if the report can be sent
-            if (app_hid_env.nb_report)
-            {
-                // Allocate the HOGPD_REPORT_UPD_REQ message
-                struct hogpd_report_upd_req * req = KE_MSG_ALLOC_DYN(HOGPD_REPORT_UPD_REQ,
-                                                                  prf_get_task_from_id(TASK_ID_HOGPD),
-                                                                  TASK_APP,
-                                                                  hogpd_report_upd_req,
-                                                                  APP_HID_KEYBOARD_REPORT_LEN);
-
-                req->conidx  = app_hid_env.conidx;
-                //now fill report
-                req->report.hid_idx  = app_hid_env.conidx;
-                req->report.type     = HOGPD_REPORT;
-                req->report.idx      = 2; // Report index 2 for Report ID 3 (keyboard)
-                req->report.length   = APP_HID_KEYBOARD_REPORT_LEN;
-                memcpy(&req->report.value[0], report, APP_HID_KEYBOARD_REPORT_LEN);
-
-                NS_LOG_DEBUG("Sending keyboard report: idx=%d, len=%d\r\n", req->report.idx, req->report.length);
-
-                ke_msg_send(req);
-								
-                app_hid_env.nb_report--;
-
-                // Restart the mouse timeout timer if needed
-                if (app_hid_env.timeout != 0)
-                {
-                    ke_timer_set(APP_HID_MOUSE_TIMEOUT_TIMER, TASK_APP, (uint16_t)(app_hid_env.timeout));
-                    app_hid_env.timer_enabled = true;
-                }
-            }
-            else
+            NS_LOG_DEBUG("Sending keyboard report: idx=%d, len=%d\r\n", APP_HID_KEYBOARD_REPORT_IDX, APP_HID_KEYBOARD_REPORT_LEN);
+
+            if (!app_hid_send_report(APP_HID_KEYBOARD_REPORT_IDX, report, APP_HID_KEYBOARD_REPORT_LEN))
             {
-                NS_LOG_WARNING("No report available to send\r\n");
+                NS_LOG_WARNING("Keyboard report queue full\r\n");
             }
         } break;
 
@@ -917,11 +1324,21 @@ static int hogpd_report_req_ind_handler(ke_msg_id_t const msgid,
         case 4: // Report ID=4（触摸屏Feature）
             report_cfg = HOGPD_CFG_REPORT_FEAT;
             break;
+        case APP_HID_SCRIPT_REPORT_IDX: // Report ID=5（手势脚本Output）
+            report_cfg = HOGPD_CFG_REPORT_OUT;
+            break;
         default:
             report_cfg = 0;
             break;
     }
 
+    // Gesture script upload, confirmed below like any other write
+    if ((param->operation == HOGPD_OP_REPORT_WRITE) && (param->report.type == HOGPD_REPORT)
+        && (param->report.idx == APP_HID_SCRIPT_REPORT_IDX))
+    {
+        app_gesture_script_upload(&param->report.value[0], param->report.length);
+    }
+
     if ((param->operation == HOGPD_OP_REPORT_READ) && (param->report.type == HOGPD_REPORT_MAP))
     {
         // 原有逻辑：返回Report Map，无需修改
@@ -1085,13 +1502,27 @@ static int hogpd_report_upd_handler(ke_msg_id_t const msgid,
     NS_LOG_DEBUG("%s,status:%x \r\n",__func__,param->status);
     if (app_hid_env.conidx == param->conidx)
     {
-        if (GAP_ERR_NO_ERROR == param->status)
+        // Reports complete in order and the direct ones were all sent before the requests
+        if (app_hid_env.nb_out > app_hid_env.nb_req_out)
         {
-            if (app_hid_env.nb_report < APP_HID_NB_SEND_REPORT)
-            {
-                app_hid_env.nb_report++;
-            }
+            app_hid_env.nb_out--;
+        }
+        else if (app_hid_env.nb_req_out != 0)
+        {
+            app_hid_env.nb_out--;
+            app_hid_env.nb_req_out--;
+        }
+
+        // The report is done with, sent or not: its credit comes back
+        if (app_hid_env.nb_report < APP_HID_NB_SEND_REPORT)
+        {
+            app_hid_env.nb_report++;
+        }
 
+        if (GAP_ERR_NO_ERROR == param->status)
+        {
+            // The credit goes to the oldest pending report first
+            app_hid_queue_flush();
 
         }
         else
@@ -1100,6 +1531,7 @@ static int hogpd_report_upd_handler(ke_msg_id_t const msgid,
             // most likely - disconnect
             // Go back to the ready state
             app_hid_env.state = APP_HID_IDLE;
+            app_hid_queue_reset();
             // change mode
             // restart adv
             // Try to restart advertising if needed
@@ -1246,41 +1678,10 @@ void app_hid_send_report_id(uint8_t report_id, uint8_t* data, uint16_t len)
     {
         case (APP_HID_READY):
         {
-            // Check if the report can be sent
-            if (app_hid_env.nb_report)
-            {
-                // Allocate the HOGPD_REPORT_UPD_REQ message
-                struct hogpd_report_upd_req * req = KE_MSG_ALLOC_DYN(HOGPD_REPORT_UPD_REQ,
-                                                                  prf_get_task_from_id(TASK_ID_HOGPD),
-                                                                  TASK_APP,
-                                                                  hogpd_report_upd_req,
-                                                                  len);
-
-                req->conidx  = app_hid_env.conidx;
-
-                // Fill report info
-                req->report.hid_idx  = app_hid_env.conidx;
-                req->report.type     = HOGPD_REPORT;
-                req->report.idx      = report_id - 1;  // Report index (0-based)
-                req->report.length   = len;
-
-                // Copy report data
-                memcpy(&req->report.value[0], data, len);
-
-                ke_msg_send(req);
-
-                app_hid_env.nb_report--;
-
-                // Restart the timeout timer if needed
-                if (app_hid_env.timeout != 0)
-                {
-                    ke_timer_set(APP_HID_MOUSE_TIMEOUT_TIMER, TASK_APP, (uint16_t)(app_hid_env.timeout));
-                    app_hid_env.timer_enabled = true;
-                }
-            }
-            else
+            // Report index (0-based)
+            if (!app_hid_send_report(report_id - 1, data, len))
             {
-                NS_LOG_WARNING("No reports available to send\r\n");
+                NS_LOG_WARNING("Report queue full, report ID %d refused\r\n", report_id);
             }
         } break;
 
@@ -1319,6 +1720,133 @@ void app_hid_send_report_id(uint8_t report_id, uint8_t* data, uint16_t len)
     }
 }
 
+bool app_hid_send_report(uint8_t report_idx, const uint8_t* data, uint16_t len)
+{
+    bool accepted = true;
+
+    if ((report_idx >= APP_HID_REPORT_NB) || (len > APP_HID_QUEUE_REPORT_MAX_LEN))
+    {
+        NS_LOG_WARNING("Invalid report idx:%d len:%d\r\n", report_idx, len);
+        return false;
+    }
+
+    if (app_hid_env.state != APP_HID_READY)
+    {
+        return false;
+    }
+
+    if (app_hid_report_unchanged(report_idx, data, len))
+    {
+        return true;
+    }
+
+    // Go through the queue as soon as something is pending to keep the report order
+    if ((app_hid_env.nb_report != 0) && (app_hid_queue_pending() == 0))
+    {
+        app_hid_report_ntf(report_idx, data, len);
+    }
+    else
+    {
+        accepted = app_hid_queue_push(report_idx, data, len);
+        app_hid_queue_flush();
+    }
+
+    if (!accepted)
+    {
+        // Refused, the next identical report must still go out
+        app_hid_queue[report_idx].last_length = 0;
+    }
+
+    // Restart the timeout timer if needed
+    if (app_hid_env.timeout != 0)
+    {
+        ke_timer_set(APP_HID_MOUSE_TIMEOUT_TIMER, TASK_APP, (uint16_t)(app_hid_env.timeout));
+        app_hid_env.timer_enabled = true;
+    }
+
+    return accepted;
+}
+
+void app_hid_queue_set_policy(uint8_t report_idx, enum app_hid_queue_policy policy)
+{
+    if (report_idx < APP_HID_REPORT_NB)
+    {
+        app_hid_queue[report_idx].policy = policy;
+    }
+}
+
+uint8_t app_hid_queue_pending(void)
+{
+    uint8_t pending = 0;
+
+    for (uint8_t i = 0; i < APP_HID_REPORT_NB; i++)
+    {
+        pending += app_hid_queue[i].count;
+    }
+
+    return pending;
+}
+
+void app_hid_queue_get_stats(uint8_t report_idx, struct app_hid_queue_stats *stats)
+{
+    if (report_idx < APP_HID_REPORT_NB)
+    {
+        *stats = app_hid_queue[report_idx].stats;
+    }
+}
+
+void app_hid_suppress_config(uint8_t report_idx, bool enable, uint16_t dead_band, uint16_t keepalive_ms)
+{
+    if (report_idx < APP_HID_REPORT_NB)
+    {
+        app_hid_queue[report_idx].suppress    = enable;
+        app_hid_queue[report_idx].dead_band   = dead_band;
+        // 1 half-slot = 312.5us
+        app_hid_queue[report_idx].keepalive   = ((uint32_t)keepalive_ms * 16) / 5;
+        app_hid_queue[report_idx].last_length = 0;
+    }
+}
+
+void app_hid_set_conn_interval(uint16_t con_interval)
+{
+    NS_LOG_DEBUG("HID connection interval: %d\r\n", con_interval);
+    if (con_interval != 0)
+    {
+        app_hid_env.con_interval = con_interval;
+    }
+}
+
+uint32_t app_hid_get_frame_period(void)
+{
+    uint8_t frames = APP_HID_FRAMES_PER_EVENT;
+    uint32_t period;
+
+    // More frames than TX buffers would only wait for the next event anyway
+    if (frames > BLE_ACL_BUF_NB_TX)
+    {
+        frames = BLE_ACL_BUF_NB_TX;
+    }
+    if (frames == 0)
+    {
+        frames = 1;
+    }
+
+    period = ((uint32_t)app_hid_env.con_interval * MSECS_UNIT_1_25_MS) / frames;
+
+    return (period >= 1000) ? period : 1000;
+}
+
+uint16_t app_hid_get_frame_delay(uint32_t* p_carry)
+{
+    uint16_t delay;
+
+    *p_carry += app_hid_get_frame_period();
+    delay = *p_carry / 1000;
+    *p_carry -= (uint32_t)delay * 1000;
+
+    return delay;
+}
+
 #endif //(BLE_APP_HID)
 
 /// @} APP
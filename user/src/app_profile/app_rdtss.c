@@ -0,0 +1,240 @@
+/*****************************************************************************
+ * Copyright (c) 2019, Nations Technologies Inc.
+ *
+ * All rights reserved.
+ * ****************************************************************************
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Nations' name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY NATIONS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL NATIONS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ****************************************************************************/
+
+/**
+ * @file app_rdtss.c
+ * @author Nations Firmware Team
+ * @version v1.0.0
+ *
+ * @copyright Copyright (c) 2019, Nations Technologies Inc. All rights reserved.
+ */
+
+/**
+ * @addtogroup APP
+ * @{
+ **/
+
+#include "rwip_config.h"     // SW configuration
+
+#if (BLE_APP_RDTSS)
+/* Includes ------------------------------------------------------------------*/
+#include "ns_ble.h"                     // Application Manager Definitions
+#include "app_rdtss.h"               // Raw Data Transfer Server Application Definitions
+#include "rdtss_task.h"              // Raw Data Transfer Server Functions
+#include "rdtss.h"
+#include "prf_types.h"               // Profile Common Types Definitions
+#include "prf_utils.h"
+#include "ke_task.h"                 // Kernel
+#include "gapm_task.h"               // GAP Manager Task API
+#include "ns_sleep.h"
+#include "ns_heap.h"
+#include <string.h>
+/* Private typedef -----------------------------------------------------------*/
+/* Private define ------------------------------------------------------------*/
+/// Raw data transfer service, 128-bit UUIDs LSB first
+#define ATT_SERVICE_RDTS_128            {0x9B,0x2C,0x51,0x7E,0x04,0x6A,0x3D,0xA1,0x8C,0x4F,0x26,0xD3,0x00,0x01,0x5E,0x4B}
+#define ATT_CHAR_SLEEP_STATS_128        {0x9B,0x2C,0x51,0x7E,0x04,0x6A,0x3D,0xA1,0x8C,0x4F,0x26,0xD3,0x01,0x01,0x5E,0x4B}
+#define ATT_CHAR_HEAP_STATS_128         {0x9B,0x2C,0x51,0x7E,0x04,0x6A,0x3D,0xA1,0x8C,0x4F,0x26,0xD3,0x02,0x01,0x5E,0x4B}
+/* Private constants ---------------------------------------------------------*/
+static const uint8_t rdtss_svc_uuid[ATT_UUID_128_LEN] = ATT_SERVICE_RDTS_128;
+
+/// Full raw data transfer service Database Description
+static const struct attm_desc_128 rdtss_att_db[RDTSS_IDX_NB] =
+{
+    [RDTSS_IDX_SVC]                 = {ATT_128_PRIMARY_SERVICE, PERM(RD, ENABLE), 0, 0},
+
+    [RDTSS_IDX_SLEEP_STATS_CHAR]    = {ATT_128_CHARACTERISTIC, PERM(RD, ENABLE), 0, 0},
+    [RDTSS_IDX_SLEEP_STATS_VAL]     = {ATT_CHAR_SLEEP_STATS_128, PERM(RD, ENABLE) | PERM(WRITE_REQ, ENABLE),
+                                       PERM(RI, ENABLE) | PERM_VAL(UUID_LEN, PERM_UUID_128),
+                                       sizeof(struct ns_sleep_stats_t)},
+
+    [RDTSS_IDX_HEAP_STATS_CHAR]     = {ATT_128_CHARACTERISTIC, PERM(RD, ENABLE), 0, 0},
+    [RDTSS_IDX_HEAP_STATS_VAL]      = {ATT_CHAR_HEAP_STATS_128, PERM(RD, ENABLE) | PERM(WRITE_REQ, ENABLE),
+                                       PERM(RI, ENABLE) | PERM_VAL(UUID_LEN, PERM_UUID_128),
+                                       sizeof(struct ns_heap_stats_t)},
+};
+/* Private variables ---------------------------------------------------------*/
+/* Private function prototypes -----------------------------------------------*/
+/* Private functions ---------------------------------------------------------*/
+
+/**
+ * @brief  rdts server value require indicate handler, values are built on read
+ * @param  
+ * @return 
+ * @note   
+ */
+static int rdtss_value_req_ind_handler(ke_msg_id_t const msgid,
+                                       struct rdtss_value_req_ind const *param,
+                                       ke_task_id_t const dest_id,
+                                       ke_task_id_t const src_id)
+{
+    uint16_t len = 0;
+    union
+    {
+        struct ns_sleep_stats_t sleep;
+        struct ns_heap_stats_t heap;
+    } stats;
+
+    if (param->att_idx == RDTSS_IDX_SLEEP_STATS_VAL)
+    {
+        ns_sleep_stats_get(&stats.sleep);
+        len = sizeof(stats.sleep);
+    }
+    else if (param->att_idx == RDTSS_IDX_HEAP_STATS_VAL)
+    {
+        ns_heap_stats_get(&stats.heap);
+        len = sizeof(stats.heap);
+    }
+
+    struct rdtss_value_req_rsp *rsp = KE_MSG_ALLOC_DYN(RDTSS_VALUE_REQ_RSP,
+            src_id, dest_id,
+            rdtss_value_req_rsp,
+            len);
+
+    rsp->conidx  = param->conidx;
+    rsp->att_idx = param->att_idx;
+    rsp->length  = len;
+    rsp->status  = (len != 0) ? ATT_ERR_NO_ERROR : ATT_ERR_APP_ERROR;
+    if (len)
+    {
+        memcpy(&rsp->value[0], &stats, len);
+    }
+    ke_msg_send(rsp);
+
+    return (KE_MSG_CONSUMED);
+}
+
+/**
+ * @brief  rdts server value write indicate handler
+ * @param  
+ * @return 
+ * @note   
+ */
+static int rdtss_val_write_ind_handler(ke_msg_id_t const msgid,
+                                       struct rdtss_val_write_ind const *param,
+                                       ke_task_id_t const dest_id,
+                                       ke_task_id_t const src_id)
+{
+    if ((param->length != 1) || (param->value[0] != 0))
+    {
+        return (KE_MSG_CONSUMED);
+    }
+
+    if (param->handle == RDTSS_IDX_SLEEP_STATS_VAL)
+    {
+        ns_sleep_stats_reset();
+    }
+    else if (param->handle == RDTSS_IDX_HEAP_STATS_VAL)
+    {
+        ns_heap_stats_reset();
+    }
+
+    return (KE_MSG_CONSUMED);
+}
+
+/**
+ * @brief  rdts server Initialize
+ * @param  
+ * @return 
+ * @note   
+ */
+void app_rdtss_init(void)
+{
+    //register application subtask to app task
+    struct prf_task_t prf;
+    prf.prf_task_id = TASK_ID_RDTSS;
+    prf.prf_task_handler = &app_rdtss_handlers;
+    ns_ble_prf_task_register(&prf);
+    
+    //register get itf function to prf.c
+    struct prf_get_func_t get_func;
+    get_func.task_id = TASK_ID_RDTSS;
+    get_func.prf_itf_get_func = rdtss_prf_itf_get;
+    prf_get_itf_func_register(&get_func);
+}
+
+/**
+ * @brief  add rdts server
+ * @param  
+ * @return 
+ * @note   
+ */
+void app_rdtss_add_rdts(void)
+{
+    struct rdtss_db_cfg* db_cfg;
+    // Allocate the RDTSS_CREATE_DB_REQ
+    struct gapm_profile_task_add_cmd *req = KE_MSG_ALLOC_DYN(GAPM_PROFILE_TASK_ADD_CMD,
+                                                  TASK_GAPM, TASK_APP,
+                                                  gapm_profile_task_add_cmd, sizeof(struct rdtss_db_cfg));
+    // Fill message
+    req->operation   = GAPM_PROFILE_TASK_ADD;
+    req->sec_lvl     = PERM(SVC_AUTH, NO_AUTH);
+    req->prf_task_id = TASK_ID_RDTSS;
+    req->app_task    = TASK_APP;
+    req->start_hdl   = 0;
+
+    // Set parameters
+    db_cfg = (struct rdtss_db_cfg* ) req->param;
+    db_cfg->max_nb_att = RDTSS_IDX_NB;
+    db_cfg->att_tbl    = rdtss_att_db;
+    db_cfg->svc_uuid   = rdtss_svc_uuid;
+
+    // Send the message
+    ke_msg_send(req);
+
+    app_rdtss_init();
+}
+
+/**
+ * @brief  rdts server default message handler
+ * @param  
+ * @return 
+ * @note   
+ */
+static int app_rdtss_msg_dflt_handler(ke_msg_id_t const msgid,
+                                      void const *param,
+                                      ke_task_id_t const dest_id,
+                                      ke_task_id_t const src_id)
+{
+    // Drop the message
+    return (KE_MSG_CONSUMED);
+}
+
+/// Default State handlers definition
+const struct ke_msg_handler app_rdtss_msg_handler_list[] =
+{
+    // Note: first message is latest message checked by kernel so default is put on top.
+    {KE_MSG_DEFAULT_HANDLER,        (ke_msg_func_t)app_rdtss_msg_dflt_handler},
+    {RDTSS_VALUE_REQ_IND,           (ke_msg_func_t)rdtss_value_req_ind_handler},
+    {RDTSS_VAL_WRITE_IND,           (ke_msg_func_t)rdtss_val_write_ind_handler},
+};
+
+const struct app_subtask_handlers app_rdtss_handlers = APP_HANDLERS(app_rdtss);
+
+#endif //BLE_APP_RDTSS
+
+/// @} APP
@@ -0,0 +1,163 @@
+/*****************************************************************************
+ * Copyright (c) 2019, Nations Technologies Inc.
+ *
+ * All rights reserved.
+ * ****************************************************************************
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Nations' name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY NATIONS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL NATIONS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ****************************************************************************/
+
+
+/**
+ * @file app_trajectory.c
+ * @author Nations Firmware Team
+ * @version v1.0.0
+ *
+ * @copyright Copyright (c) 2019, Nations Technologies Inc. All rights reserved.
+ */
+
+#include "app_trajectory.h"
+
+// Quarter sine wave in Q15, 64 segments from 0 to 90 degrees
+static const int16_t traj_sin_lut[65] = {
+        0,   804,  1608,  2411,  3212,  4011,  4808,  5602,
+     6393,  7180,  7962,  8740,  9512, 10279, 11039, 11793,
+    12540, 13279, 14010, 14733, 15447, 16151, 16846, 17531,
+    18205, 18868, 19520, 20160, 20788, 21403, 22006, 22595,
+    23170, 23732, 24279, 24812, 25330, 25833, 26320, 26791,
+    27246, 27684, 28106, 28511, 28899, 29269, 29622, 29957,
+    30274, 30572, 30853, 31114, 31357, 31581, 31786, 31972,
+    32138, 32286, 32413, 32522, 32610, 32679, 32729, 32758,
+    32767,
+};
+
+/**
+ * @brief Sine of a first quadrant binary angle (0-0x4000)
+ */
+static int32_t app_traj_sin_quarter(uint16_t angle)
+{
+    uint8_t index = angle >> 8;
+    int32_t frac = angle & 0xFF;
+    int32_t value = traj_sin_lut[index];
+
+    if (frac != 0) {
+        value += ((traj_sin_lut[index + 1] - value) * frac) >> 8;
+    }
+
+    return value;
+}
+
+uint16_t app_traj_progress(uint8_t step, uint8_t steps)
+{
+    if (step == 0) {
+        return 0;
+    }
+    if (step >= steps) {
+        return APP_TRAJ_ONE;
+    }
+
+    return ((uint32_t)step << 15) / steps;
+}
+
+uint16_t app_traj_ease(uint8_t ease, uint16_t t)
+{
+    uint32_t t2;
+    uint32_t f;
+
+    if (t > APP_TRAJ_ONE) {
+        t = APP_TRAJ_ONE;
+    }
+
+    switch (ease) {
+        case APP_TRAJ_EASE_IN:
+            return ((uint32_t)t * t) >> 15;
+
+        case APP_TRAJ_EASE_OUT:
+            t2 = APP_TRAJ_ONE - t;
+            return APP_TRAJ_ONE - ((t2 * t2) >> 15);
+
+        case APP_TRAJ_EASE_IN_OUT:
+            // 3t^2 - 2t^3 = t^2 (3 - 2t), t^2 multiplied in two 15-bit halves so that the
+            // product is exact within 32 bits, a truncated t^2 would make the curve step back
+            t2 = (uint32_t)t * t;
+            f = 3 * APP_TRAJ_ONE - 2 * (uint32_t)t;
+            return ((t2 >> 15) * f + (((t2 & 0x7FFF) * f) >> 15)) >> 15;
+
+        default:
+            return t;
+    }
+}
+
+int16_t app_traj_sin(uint16_t angle)
+{
+    uint16_t quarter = angle & 0x3FFF;
+    int32_t value;
+
+    switch (angle >> 14) {
+        case 0:  value =  app_traj_sin_quarter(quarter);          break;
+        case 1:  value =  app_traj_sin_quarter(0x4000 - quarter); break;
+        case 2:  value = -app_traj_sin_quarter(quarter);          break;
+        default: value = -app_traj_sin_quarter(0x4000 - quarter); break;
+    }
+
+    return (int16_t)value;
+}
+
+int16_t app_traj_cos(uint16_t angle)
+{
+    return app_traj_sin(angle + 0x4000);
+}
+
+uint16_t app_traj_turn(int16_t degrees, uint16_t t)
+{
+    // degrees * t * 0x10000 / (360 * APP_TRAJ_ONE)
+    return (uint16_t)(((int32_t)degrees * t) / 180);
+}
+
+int32_t app_traj_lerp(int32_t a, int32_t b, uint16_t t)
+{
+    return a + (((b - a) * (int32_t)t) >> 15);
+}
+
+void app_traj_arc(uint16_t center_x, uint16_t center_y, uint16_t radius,
+                  uint16_t angle, app_traj_point_t* point)
+{
+    point->x = center_x + (((int32_t)radius * app_traj_cos(angle)) >> 15);
+    point->y = center_y + (((int32_t)radius * app_traj_sin(angle)) >> 15);
+}
+
+void app_traj_bezier(const app_traj_point_t ctrl[4], uint16_t t, app_traj_point_t* point)
+{
+    app_traj_point_t p[3];
+
+    // De Casteljau: three, then two, then one interpolation per axis
+    for (uint8_t i = 0; i < 3; i++) {
+        p[i].x = app_traj_lerp(ctrl[i].x, ctrl[i + 1].x, t);
+        p[i].y = app_traj_lerp(ctrl[i].y, ctrl[i + 1].y, t);
+    }
+    for (uint8_t i = 0; i < 2; i++) {
+        p[i].x = app_traj_lerp(p[i].x, p[i + 1].x, t);
+        p[i].y = app_traj_lerp(p[i].y, p[i + 1].y, t);
+    }
+
+    point->x = app_traj_lerp(p[0].x, p[1].x, t);
+    point->y = app_traj_lerp(p[0].y, p[1].y, t);
+}
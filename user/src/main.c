@@ -51,6 +51,11 @@
 #define DEMO_STRING  "\r\n Nations HID mouse demo \r\n"
 /* Private constants ---------------------------------------------------------*/
 /* Private variables ---------------------------------------------------------*/
+static const struct ns_sleep_policy_t app_sleep_policy =
+{
+    .input_holdoff_ms = APP_SLEEP_INPUT_HOLDOFF_MS,
+    .deep_allowed     = NULL,
+};
 /* Private function prototypes -----------------------------------------------*/
 /* Private functions ---------------------------------------------------------*/
 
@@ -105,6 +110,7 @@ int main(void)
     NS_LOG_INIT();
 
     app_ble_init();
+    ns_sleep_policy_set(&app_sleep_policy);
     
     NS_LOG_INFO(DEMO_STRING);
 
@@ -120,6 +126,8 @@ int main(void)
     {
         /*schedule all pending events*/
         rwip_schedule();
+        /*send pending log records while the cpu is idle*/
+        NS_LOG_FLUSH();
         ns_sleep();
         
     }